@@ -592,8 +592,12 @@ namespace Pii
     return func;
   }
 
+  // Defined in PiiRandom.cc
+  PII_CORE_EXPORT std::size_t uniformRandomIndex(std::size_t max);
+
   /**
-   * Randomize the order of elements in a sequence.
+   * Randomize the order of elements in a sequence. Each permutation
+   * is equally likely (Fisher-Yates shuffle).
    *
    * @param begin an iterator to the beginning of the random access
    * sequence to shuffle
@@ -602,13 +606,12 @@ namespace Pii
    */
   template <class Iterator> void shuffleN(Iterator begin, std::size_t n)
   {
-    for (std::size_t i=0; i<n; ++i)
+    for (std::size_t i=n; i>1; --i)
       {
-        // PENDING rand() limits iNewIndex to RAND_MAX
-        // Randomize a new location for each element
-        std::size_t iNewIndex = std::size_t(std::rand()) % n;
-        if (iNewIndex != i)
-          qSwap(begin[i], begin[iNewIndex]);
+        // Pick a random element among the first i and move it last.
+        std::size_t iNewIndex = uniformRandomIndex(i);
+        if (iNewIndex != i-1)
+          qSwap(begin[i-1], begin[iNewIndex]);
       }
   }
 
@@ -48,6 +48,14 @@
 #  define PII_PRINTF_ATTR(first,rest)
 #endif
 
+// Storage class for thread-local POD variables. Left undefined if the
+// compiler has no support.
+#if defined(_MSC_VER)
+#  define PII_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#  define PII_THREAD_LOCAL __thread
+#endif
+
 #define PII_D_FUNC \
   inline Data* _d() { return static_cast<Data*>(this->d); } \
   inline const Data* _d() const { return static_cast<const Data*>(this->d); } \
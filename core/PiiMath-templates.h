@@ -21,9 +21,11 @@
 #include <algorithm>
 #include <functional>
 #include <QCoreApplication>
+#include <QVector>
 #include "PiiIeeeFloat.h"
 #include "PiiTransposedMatrix.h"
 #include "PiiMathException.h"
+#include "PiiParallel.h"
 
 namespace Pii
 {
@@ -548,19 +550,68 @@ namespace Pii
     return matVar;
   }
 
+  // Accumulates the upper triangle of the scatter matrix for a block
+  // of rows. Each block has its own result matrix.
+  template <class T> struct ScatterAccumulator
+  {
+    ScatterAccumulator(const PiiMatrix<T>& mat, const PiiMatrix<double>& mean, int blockCount) :
+      mat(mat), mean(mean), vecResults(blockCount)
+    {}
+
+    void operator() (int block, int firstRow, int lastRow)
+    {
+      const int iCols = mat.columns();
+      PiiMatrix<double> matResult(iCols, iCols);
+      PiiMatrix<double> matDiff(PiiMatrix<double>::uninitialized(1, iCols));
+      double* pDiff = matDiff.row(0);
+      const double* pMean = mean.row(0);
+      for (int r=firstRow; r<lastRow; ++r)
+        {
+          const T* pRow = mat.row(r);
+          for (int c=0; c<iCols; ++c)
+            pDiff[c] = double(pRow[c]) - pMean[c];
+          // Rank-one update of the upper triangle
+          for (int i=0; i<iCols; ++i)
+            {
+              double* pResult = matResult.row(i);
+              const double dDiff = pDiff[i];
+              for (int j=i; j<iCols; ++j)
+                pResult[j] += dDiff * pDiff[j];
+            }
+        }
+      vecResults[block] = matResult;
+    }
+
+    const PiiMatrix<T>& mat;
+    const PiiMatrix<double>& mean;
+    QVector<PiiMatrix<double> > vecResults;
+  };
+
+  template <class T> PiiMatrix<double> scatterMatrix(const PiiMatrix<T>& mat, const PiiMatrix<double>& mean)
+  {
+    const int iCols = mat.columns();
+    // Make the blocks large enough to amortize the reduction.
+    int iBlocks = parallelBlockCount(mat.rows(), qMax(iCols, 64));
+    ScatterAccumulator<T> accumulator(mat, mean, iBlocks);
+    parallelForBlocks(0, mat.rows(), iBlocks, accumulator);
+
+    PiiMatrix<double> matResult(iCols, iCols);
+    for (int i=0; i<accumulator.vecResults.size(); ++i)
+      if (!accumulator.vecResults[i].isEmpty())
+        matResult += accumulator.vecResults[i];
+    // Mirror the upper triangle
+    for (int r=1; r<iCols; ++r)
+      for (int c=0; c<r; ++c)
+        matResult(r,c) = matResult(c,r);
+    return matResult;
+  }
+
   template <class T> PiiMatrix<double> covariance(const PiiMatrix<T>& mat,
                                                   PiiMatrix<double>* meanMatrix)
   {
     // Mean of all dimensions
     PiiMatrix<double> mu = mean<double>(mat, Vertically);
-    PiiMatrix<double> result(mat.columns(), mat.columns());
-    for (int r=mat.rows(); r--; )
-      {
-        PiiMatrix<double> x(mat(r,0,1,-1));
-        x -= mu;
-        // (x-mu)' * (x-mu) produces a M-by-M matrix
-        result += transpose(x) * x;
-      }
+    PiiMatrix<double> result(scatterMatrix(mat, mu));
     result /= (mat.rows() - 1);
     // Store mean value
     if (meanMatrix != 0)
@@ -1029,6 +1029,24 @@ namespace Pii
    */
   template <class T> PiiMatrix<double> covariance(const PiiMatrix<T>& mat, PiiMatrix<double>* mean = 0);
 
+  /**
+   * Calculates the scatter matrix of a set of measurements about
+   * *mean*. The scatter matrix is the sum of \((x-\mu)^T (x-\mu)\)
+   * over all rows *x* of *mat*. Dividing it by the number of
+   * measurements minus one gives the covariance matrix.
+   *
+   * The rows of large matrices are divided into blocks that are
+   * accumulated in parallel, and only the upper triangle of the
+   * symmetric result is calculated.
+   *
+   * @param mat a NxM input matrix
+   *
+   * @param mean a 1xM row matrix
+   *
+   * @return a MxM scatter matrix
+   */
+  template <class T> PiiMatrix<double> scatterMatrix(const PiiMatrix<T>& mat, const PiiMatrix<double>& mean);
+
   /**
    * Calculates the mean of matrix elements in the specified direction.
    * If Pii::Horizontally is specified, a column matrix
@@ -2380,6 +2398,47 @@ namespace Pii
       initialValue += square(T(*begin1) - T(*begin2));
     return initialValue;
   }
+
+  // Calculates a block of rows in a matrix product. The inner loop
+  // runs along the rows of both the result and the right-hand
+  // operand, and the right-hand operand is processed in panels that
+  // fit in cache. Each result element is accumulated in the same
+  // order as in an inner product.
+  template <class T, class Result> struct MatrixProduct
+  {
+    enum { PanelSize = 128 };
+
+    MatrixProduct(const PiiMatrix<T>& a, const PiiMatrix<T>& b, Result& result) :
+      a(a), b(b), result(result)
+    {}
+
+    void operator() (int firstRow, int lastRow)
+    {
+      const int iInner = a.columns(), iCols = b.columns();
+      for (int r=firstRow; r<lastRow; ++r)
+        fillN(result[r], iCols, T(0));
+      for (int iPanelStart=0; iPanelStart<iInner; iPanelStart += PanelSize)
+        {
+          const int iPanelEnd = qMin(iPanelStart + int(PanelSize), iInner);
+          for (int r=firstRow; r<lastRow; ++r)
+            {
+              T* pResult = result[r];
+              const T* pA = a[r];
+              for (int k=iPanelStart; k<iPanelEnd; ++k)
+                {
+                  const T* pB = b[k];
+                  const T value = pA[k];
+                  for (int c=0; c<iCols; ++c)
+                    pResult[c] += value * pB[c];
+                }
+            }
+        }
+    }
+
+    const PiiMatrix<T>& a;
+    const PiiMatrix<T>& b;
+    Result& result;
+  };
 }
 
 /**
@@ -2401,7 +2460,17 @@ operator* (const PiiConceptualMatrix<Matrix1>& mat1,
   const int iRows1 = m1.rows(), iCols2 = m2.columns();
 
   typedef PII_COMBINE_TYPES(typename Matrix1::value_type, typename Matrix2::value_type) T;
-  PiiMatrix<T, Matrix1::staticRows, Matrix2::staticColumns> result(PiiMatrix<T>::uninitialized(iRows1, iCols2));
+  typedef PiiMatrix<T, Matrix1::staticRows, Matrix2::staticColumns> ResultType;
+  ResultType result(PiiMatrix<T>::uninitialized(iRows1, iCols2));
+  // Large products are calculated in parallel with a cache-friendly
+  // kernel. Copying the operands is cheap compared to the product.
+  if (iCols2 >= 8 && double(iRows1) * iCols1 * iCols2 >= 65536.0)
+    {
+      const PiiMatrix<T> matA(m1), matB(m2);
+      Pii::MatrixProduct<T, ResultType> product(matA, matB, result);
+      Pii::parallelFor(0, iRows1, product, qMax(1, 16384 / qMax(iCols1 * iCols2, 1)));
+      return result;
+    }
   for (int r=0; r<iRows1; ++r)
     {
       T* pRow = result[r];
@@ -18,6 +18,12 @@
 
 
 #include <PiiMatrix.h>
+#include "PiiMath.h"
+#include "PiiParallel.h"
+#include <QVector>
+#include <QPair>
+#include <QtAlgorithms>
+#include <limits>
 
 /*
  * The routines are adapted from TNT(template numerical toolkit),
@@ -117,6 +123,26 @@ namespace Pii
     /** Symmetric tridiagonal QL algorithm  (Adapted from TNT function Eigenvalue::tql2()) */
     static void tql2(const int n, Array1D& d, Array1D& e, Array2D& V);
 
+    /**
+     * Symmetric tridiagonal divide-and-conquer algorithm. The
+     * diagonal is in *d* and the *n*-1 subdiagonal elements in *e*.
+     * Stores the eigenvalues in ascending order to *d* and the
+     * corresponding eigenvectors to the columns of *Z*. Destroys *e*.
+     */
+    static void divideAndConquer(const int n, Real* d, Real* e, Array2D& Z);
+
+    /**
+     * Solves the eigensystem of diag(Q1,Q2) (diag(d) + rho z z')
+     * diag(Q1,Q2)', where d contains the eigenvalues of the two
+     * subproblems and z is formed from the last row of *Q1* and the
+     * first row of *Q2*.
+     */
+    static void mergeRankOne(const int n, Real rho, Real* d,
+                             const Array2D& Q1, const Array2D& Q2, Array2D& Z);
+
+    struct SubproblemSolver;
+    struct SecularEquationSolver;
+
     /** Nonsymmetric reduction to Hessenberg form (adapted from TNT function Eigenvalue::orthes()) */
     static void orthes(const int n, Array2D& V, Array2D& H);
 
@@ -434,6 +460,314 @@ namespace Pii
 
 
 
+  // Solves the two halves of a divide-and-conquer step, possibly in
+  // parallel.
+  template<class T, class Real>
+  struct EigenSystem<T, Real>::SubproblemSolver
+  {
+    SubproblemSolver(int n1, Real* d1, Real* e1, Array2D& Z1,
+                     int n2, Real* d2, Real* e2, Array2D& Z2)
+    {
+      aN[0] = n1; aD[0] = d1; aE[0] = e1; apZ[0] = &Z1;
+      aN[1] = n2; aD[1] = d2; aE[1] = e2; apZ[1] = &Z2;
+    }
+
+    void operator() (int /*block*/, int first, int last)
+    {
+      for (int i = first; i < last; ++i)
+        divideAndConquer(aN[i], aD[i], aE[i], *apZ[i]);
+    }
+
+    int aN[2];
+    Real* aD[2];
+    Real* aE[2];
+    Array2D* apZ[2];
+  };
+
+  // Finds the roots of the secular equation 1 + rho sum(z_j^2/(d_j -
+  // lambda)) = 0, where d is strictly increasing and rho > 0. The
+  // i'th root is in (d_i, d_{i+1}) (or (d_K, d_K + rho |z|^2] for the
+  // last one). It is solved relative to the nearer pole to retain
+  // the accuracy of d_j - lambda_i, which is stored to
+  // pDelta[j*K+i].
+  template<class T, class Real>
+  struct EigenSystem<T, Real>::SecularEquationSolver
+  {
+    SecularEquationSolver(int k, const Real* d, const Real* z, Real rho,
+                          Real* lambda, Real* delta) :
+      K(k), pD(d), pZ(z), dRho(rho), pLambda(lambda), pDelta(delta)
+    {}
+
+    // Evaluates the secular function at origin + tau.
+    Real value(Real origin, Real tau, Real* derivative = 0) const
+    {
+      Real dF = 1, dFp = 0;
+      for (int j = 0; j < K; ++j)
+        {
+          Real dQ = pZ[j] / ((pD[j] - origin) - tau);
+          dF += dRho * pZ[j] * dQ;
+          dFp += dRho * dQ * dQ;
+        }
+      if (derivative != 0)
+        *derivative = dFp;
+      return dF;
+    }
+
+    void operator() (int first, int last)
+    {
+      const Real dEps = std::numeric_limits<Real>::epsilon();
+      for (int i = first; i < last; ++i)
+        {
+          int iOrigin = i;
+          Real dLow = 0, dHigh;
+          if (i < K-1)
+            {
+              Real dMid = (pD[i+1] - pD[i]) / 2;
+              if (value(pD[i], dMid) >= 0)
+                dHigh = dMid;
+              else
+                {
+                  iOrigin = i+1;
+                  dLow = -dMid;
+                  dHigh = 0;
+                }
+            }
+          else
+            {
+              Real dNorm = 0;
+              for (int j = 0; j < K; ++j)
+                dNorm += pZ[j] * pZ[j];
+              dHigh = dRho * dNorm;
+            }
+          const Real dOrigin = pD[iOrigin];
+          // Safeguarded Newton iteration. The function is increasing
+          // within the bracket.
+          Real dTau = (dLow + dHigh) / 2;
+          for (int iIteration = 0; iIteration < 256; ++iIteration)
+            {
+              Real dDerivative;
+              Real dF = value(dOrigin, dTau, &dDerivative);
+              if (dF == 0)
+                break;
+              if (dF < 0)
+                dLow = dTau;
+              else
+                dHigh = dTau;
+              Real dNext = dTau - dF / dDerivative;
+              if (!(dNext > dLow && dNext < dHigh))
+                dNext = (dLow + dHigh) / 2;
+              bool bConverged = abs(dNext - dTau) <= 2 * dEps * abs(dNext) ||
+                dHigh - dLow <= 2 * dEps * max(abs(dLow), abs(dHigh));
+              dTau = dNext;
+              if (bConverged)
+                break;
+            }
+          pLambda[i] = dOrigin + dTau;
+          for (int j = 0; j < K; ++j)
+            pDelta[j*K+i] = (pD[j] - dOrigin) - dTau;
+        }
+    }
+
+    int K;
+    const Real* pD;
+    const Real* pZ;
+    Real dRho;
+    Real* pLambda;
+    Real* pDelta;
+  };
+
+  template<class T, class Real>
+  void EigenSystem<T, Real>::divideAndConquer(const int n, Real* d, Real* e, Array2D& Z)
+  {
+    // Small problems are solved directly with QL.
+    if (n <= 25)
+      {
+        Z.resize(n, n);
+        setIdentity(Z);
+        // tql2() expects the subdiagonal at e[1...n-1]
+        QVector<Real> vecE(n, Real(0));
+        for (int i = 1; i < n; ++i)
+          vecE[i] = e[i-1];
+        Real* const pE = vecE.data();
+        tql2(n, d, pE, Z);
+        return;
+      }
+
+    // Split into two tridiagonal matrices and a rank-one correction.
+    const int k = n/2;
+    const Real beta = e[k-1];
+    d[k-1] -= beta;
+    d[k] -= beta;
+
+    Array2D matQ1, matQ2;
+    SubproblemSolver solver(k, d, e, matQ1, n-k, d+k, e+k, matQ2);
+    parallelForBlocks(0, 2, n >= 256 ? 2 : 1, solver);
+
+    mergeRankOne(n, beta, d, matQ1, matQ2, Z);
+  }
+
+  template<class T, class Real>
+  void EigenSystem<T, Real>::mergeRankOne(const int n, Real rho, Real* d,
+                                           const Array2D& Q1, const Array2D& Q2, Array2D& Z)
+  {
+    // This is the rank-one update of Cuppen's method with the
+    // deflation strategy and eigenvector computation of Gu and
+    // Eisenstat.
+    const int k = Q1.rows();
+    const Real dEps = std::numeric_limits<Real>::epsilon();
+
+    Array2D matQ(n, n);
+    for (int r = 0; r < k; ++r)
+      for (int c = 0; c < k; ++c)
+        matQ(r,c) = Q1(r,c);
+    for (int r = k; r < n; ++r)
+      for (int c = k; c < n; ++c)
+        matQ(r,c) = Q2(r-k,c-k);
+
+    // Normalize z to unit length.
+    QVector<Real> vecZ(n), vecD(n);
+    const Real dScale = Real(1) / sqrt(Real(2));
+    for (int j = 0; j < k; ++j)
+      vecZ[j] = Q1(k-1,j) * dScale;
+    for (int j = k; j < n; ++j)
+      vecZ[j] = Q2(0,j-k) * dScale;
+    rho *= 2;
+
+    // Negative rho is handled by negating the whole problem.
+    const bool bNegate = rho < 0;
+    for (int j = 0; j < n; ++j)
+      vecD[j] = bNegate ? -d[j] : d[j];
+    if (bNegate)
+      rho = -rho;
+
+    QVector<QPair<Real,int> > vecOrder(n);
+    Real dMaxD = 0;
+    for (int j = 0; j < n; ++j)
+      {
+        vecOrder[j] = qMakePair(vecD[j], j);
+        dMaxD = max(dMaxD, abs(vecD[j]));
+      }
+    qSort(vecOrder);
+    const Real dTolerance = 8 * dEps * max(dMaxD, rho);
+
+    // Deflate eigenpairs whose z component is negligible or whose
+    // eigenvalue is close to the previous one. In the latter case, a
+    // Givens rotation is used to zero out one of the z components.
+    QVector<int> vecKept, vecDeflated;
+    int iPrevious = -1;
+    for (int i = 0; i < n; ++i)
+      {
+        const int j = vecOrder[i].second;
+        if (rho * abs(vecZ[j]) <= dTolerance)
+          {
+            vecDeflated << j;
+            continue;
+          }
+        if (iPrevious >= 0)
+          {
+            const int p = iPrevious;
+            const Real tau = hypotenuse(vecZ[p], vecZ[j]);
+            const Real c = vecZ[j] / tau, s = -vecZ[p] / tau;
+            if (abs(c * s * (vecD[j] - vecD[p])) <= dTolerance)
+              {
+                vecZ[j] = tau;
+                vecZ[p] = 0;
+                const Real dP = c*c*vecD[p] + s*s*vecD[j];
+                vecD[j] = s*s*vecD[p] + c*c*vecD[j];
+                vecD[p] = dP;
+                for (int r = 0; r < n; ++r)
+                  {
+                    const Real dQp = matQ(r,p), dQj = matQ(r,j);
+                    matQ(r,p) = c*dQp + s*dQj;
+                    matQ(r,j) = -s*dQp + c*dQj;
+                  }
+                vecDeflated << p;
+                iPrevious = j;
+                continue;
+              }
+            vecKept << p;
+          }
+        iPrevious = j;
+      }
+    if (iPrevious >= 0)
+      vecKept << iPrevious;
+
+    // Solve the secular equation for the remaining K eigenvalues.
+    const int K = vecKept.size();
+    QVector<Real> vecDk(K), vecZk(K), vecLambda(K), vecDelta(K*K);
+    for (int i = 0; i < K; ++i)
+      {
+        vecDk[i] = vecD[vecKept[i]];
+        vecZk[i] = vecZ[vecKept[i]];
+      }
+    SecularEquationSolver secularSolver(K, vecDk.constData(), vecZk.constData(), rho,
+                                        vecLambda.data(), vecDelta.data());
+    parallelFor(0, K, secularSolver, qMax(1, 4096 / qMax(K, 1)));
+
+    // Recompute z so that the eigenvectors are numerically orthogonal
+    // (Gu & Eisenstat). delta(i,j) = d_i - lambda_j.
+    const Real* pDelta = vecDelta.constData();
+    QVector<Real> vecZHat(K);
+    for (int i = 0; i < K; ++i)
+      {
+        Real dProduct = -pDelta[i*K+i] / rho;
+        for (int j = 0; j < K; ++j)
+          if (j != i)
+            dProduct *= -pDelta[i*K+j] / (vecDk[j] - vecDk[i]);
+        vecZHat[i] = sqrt(max(dProduct, Real(0)));
+        if (vecZk[i] < 0)
+          vecZHat[i] = -vecZHat[i];
+      }
+
+    Array2D matU(K, K);
+    for (int i = 0; i < K; ++i)
+      {
+        Real dNorm = 0;
+        for (int j = 0; j < K; ++j)
+          {
+            const Real dU = vecZHat[j] / pDelta[j*K+i];
+            matU(j,i) = dU;
+            dNorm += dU * dU;
+          }
+        dNorm = Real(1) / sqrt(dNorm);
+        for (int j = 0; j < K; ++j)
+          matU(j,i) *= dNorm;
+      }
+
+    Array2D matQk(n, K);
+    for (int r = 0; r < n; ++r)
+      for (int i = 0; i < K; ++i)
+        matQk(r,i) = matQ(r,vecKept[i]);
+    const Array2D matV(matQk * matU);
+
+    // Collect all eigenpairs and sort by eigenvalue.
+    const Real dSign = bNegate ? -1 : 1;
+    QVector<QPair<Real,int> > vecEigen;
+    vecEigen.reserve(n);
+    for (int i = 0; i < K; ++i)
+      vecEigen << qMakePair(dSign * vecLambda[i], i);
+    for (int i = 0; i < vecDeflated.size(); ++i)
+      vecEigen << qMakePair(dSign * vecD[vecDeflated[i]], K + i);
+    qSort(vecEigen);
+
+    Z.resize(n, n);
+    for (int c = 0; c < n; ++c)
+      {
+        const int iSource = vecEigen[c].second;
+        d[c] = vecEigen[c].first;
+        if (iSource < K)
+          for (int r = 0; r < n; ++r)
+            Z(r,c) = matV(r,iSource);
+        else
+          {
+            const int iColumn = vecDeflated[iSource-K];
+            for (int r = 0; r < n; ++r)
+              Z(r,c) = matQ(r,iColumn);
+          }
+      }
+  }
+
+
   template<class T, class Real>
   void EigenSystem<T, Real>::orthes(const int n, Array2D& V, Array2D& H)
   {
@@ -1088,8 +1422,21 @@ namespace Pii
       tred2(n, realArray, imagArray, *pV);
 
       // Diagonalize.
-      // Symmetric tridiagonal QL algorithm.
-      tql2(n, realArray, imagArray, *pV);
+      if (n >= 64)
+        {
+          // Divide and conquer is considerably faster than QL for
+          // large matrices and parallelizes well.
+          for (int i = 1; i < n; i++)
+            imagArray[i-1] = imagArray[i];
+          Array2D matZ;
+          divideAndConquer(n, realArray, imagArray, matZ);
+          *pV = *pV * matZ;
+          for (int i = 0; i < n; i++)
+            imagArray[i] = 0;
+        }
+      else
+        // Symmetric tridiagonal QL algorithm.
+        tql2(n, realArray, imagArray, *pV);
     }
     else //Non symmetric matrix.
     {
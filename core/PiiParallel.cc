@@ -0,0 +1,109 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "PiiParallel.h"
+#include "PiiAtomicInt.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QWaitCondition>
+
+// The state is shared between the calling thread and the runners.
+// Runners may be started by the thread pool only after the task has
+// already been completed by other threads. Therefore, the state is
+// reference-counted and a runner never touches the task unless it
+// manages to reserve a block.
+class PiiParallelTask::State
+{
+public:
+  State(PiiParallelTask* task, int blockCount) :
+    iRefCount(1),
+    iNextBlock(0),
+    iFinishedBlocks(0),
+    iBlockCount(blockCount),
+    pTask(task)
+  {}
+
+  void release()
+  {
+    if (iRefCount.deref() == 0)
+      delete this;
+  }
+
+  // Processes blocks until there are no more left.
+  void work()
+  {
+    int iBlock;
+    while ((iBlock = iNextBlock++) < iBlockCount)
+      {
+        pTask->runBlock(iBlock);
+        QMutexLocker lock(&mutex);
+        if (++iFinishedBlocks == iBlockCount)
+          allFinished.wakeAll();
+      }
+  }
+
+  PiiAtomicInt iRefCount, iNextBlock;
+  int iFinishedBlocks, iBlockCount;
+  PiiParallelTask* pTask;
+  QMutex mutex;
+  QWaitCondition allFinished;
+};
+
+class PiiParallelTask::Runner : public QRunnable
+{
+public:
+  Runner(State* state) : _pState(state) { _pState->iRefCount.ref(); }
+  ~Runner() { _pState->release(); }
+
+  void run() { _pState->work(); }
+
+private:
+  State* _pState;
+};
+
+PiiParallelTask::~PiiParallelTask()
+{}
+
+void PiiParallelTask::run(int blockCount)
+{
+  State* pState = new State(this, blockCount);
+  QThreadPool* pPool = QThreadPool::globalInstance();
+  // The calling thread takes care of one block.
+  for (int i=1; i<blockCount; ++i)
+    pPool->start(new Runner(pState));
+
+  pState->work();
+
+  pState->mutex.lock();
+  while (pState->iFinishedBlocks < blockCount)
+    pState->allFinished.wait(&pState->mutex);
+  pState->mutex.unlock();
+
+  pState->release();
+}
+
+namespace Pii
+{
+  int parallelBlockCount(int size, int minBlockSize, int maxThreads)
+  {
+    int iThreads = QThread::idealThreadCount();
+    if (maxThreads > 0)
+      iThreads = qMin(iThreads, maxThreads);
+    return qBound(1, size / qMax(minBlockSize, 1), qMax(iThreads, 1));
+  }
+}
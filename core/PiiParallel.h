@@ -0,0 +1,168 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIPARALLEL_H
+#define _PIIPARALLEL_H
+
+#include "PiiGlobal.h"
+
+/// @hide
+#ifndef PII_NO_QT
+/* A task that is split into a fixed number of blocks. The blocks are
+   processed by the calling thread and a number of helper threads
+   taken from the global thread pool. Since the calling thread takes
+   part in the work, parallel loops can be safely nested: if no
+   helper threads are available, the caller just processes all
+   blocks by itself.
+ */
+class PII_CORE_EXPORT PiiParallelTask
+{
+public:
+  virtual ~PiiParallelTask();
+
+  /* Runs runBlock() for block indices 0, ..., blockCount-1 and
+     returns once all of them have been processed. */
+  void run(int blockCount);
+
+protected:
+  virtual void runBlock(int block) = 0;
+
+private:
+  class State;
+  class Runner;
+};
+#endif
+
+namespace Pii
+{
+#ifndef PII_NO_QT
+  template <class Function> class ParallelBlockTask : public PiiParallelTask
+  {
+  public:
+    ParallelBlockTask(int begin, int end, int blockCount, Function& function) :
+      _iBegin(begin), _iSize(end - begin), _iBlockCount(blockCount), _function(function)
+    {}
+
+  protected:
+    void runBlock(int block)
+    {
+      _function(block,
+                _iBegin + int(qint64(_iSize) * block / _iBlockCount),
+                _iBegin + int(qint64(_iSize) * (block + 1) / _iBlockCount));
+    }
+
+  private:
+    int _iBegin, _iSize, _iBlockCount;
+    Function& _function;
+  };
+#endif
+
+  template <class Function> struct ParallelRangeAdaptor
+  {
+    ParallelRangeAdaptor(Function& f) : function(f) {}
+    void operator() (int /*block*/, int first, int last) { function(first, last); }
+    Function& function;
+  };
+}
+/// @endhide
+
+namespace Pii
+{
+  /**
+   * Returns the number of blocks a range of *size* items should be
+   * divided into for parallel processing. The result is at least one
+   * and at most the number of processor cores available (or
+   * *maxThreads*, if it is positive). Each block will contain at
+   * least *minBlockSize* items.
+   *
+   * ~~~(c++)
+   * // Use per-thread buffers
+   * int iBlocks = Pii::parallelBlockCount(matImage.rows(), 16);
+   * QVector<PiiMatrix<int> > vecHistograms(iBlocks, PiiMatrix<int>(1,256));
+   * ~~~
+   */
+#ifdef PII_NO_QT
+  inline int parallelBlockCount(int, int = 1, int = 0) { return 1; }
+#else
+  PII_CORE_EXPORT int parallelBlockCount(int size, int minBlockSize = 1, int maxThreads = 0);
+#endif
+
+  /**
+   * Divides the range [*begin*, *end*) into *blockCount* contiguous
+   * blocks of (almost) equal size and calls *function* for each of
+   * them in parallel. The function is called as `function(block,
+   * first, last)`, where *block* is the zero-based index of the block
+   * and [*first*, *last*) is the range of indices it covers. This
+   * makes it easy to maintain per-block state that is merged after
+   * the call.
+   *
+   * This function blocks until all blocks have been processed. The
+   * calling thread processes blocks as well, which makes it safe to
+   * call this function from within another parallel loop. The
+   * function object is shared between threads, and it must not throw
+   * exceptions.
+   *
+   * If the library is compiled without Qt (PII_NO_QT), the blocks
+   * are processed sequentially in the calling thread.
+   *
+   * @see parallelBlockCount()
+   */
+  template <class Function> void parallelForBlocks(int begin, int end, int blockCount, Function& function)
+  {
+    if (end <= begin)
+      return;
+    blockCount = qBound(1, blockCount, end - begin);
+#ifdef PII_NO_QT
+    for (int i=0; i<blockCount; ++i)
+      function(i,
+               begin + int(qint64(end - begin) * i / blockCount),
+               begin + int(qint64(end - begin) * (i + 1) / blockCount));
+#else
+    if (blockCount == 1)
+      function(0, begin, end);
+    else
+      ParallelBlockTask<Function>(begin, end, blockCount, function).run(blockCount);
+#endif
+  }
+
+  /**
+   * Calls `function(first, last)` in parallel for sub-ranges of
+   * [*begin*, *end*). The range is divided into as many blocks as
+   * there are processor cores, but each block will contain at least
+   * *minBlockSize* items. Use a large enough *minBlockSize* to
+   * prevent threading overhead from dominating in small problems.
+   *
+   * ~~~(c++)
+   * struct RowScaler
+   * {
+   *   RowScaler(PiiMatrix<float>& m) : mat(m) {}
+   *   void operator() (int firstRow, int lastRow)
+   *   {
+   *     for (int r=firstRow; r<lastRow; ++r)
+   *       Pii::map(mat[r], mat.columns(), std::bind2nd(std::multiplies<float>(), 2.0f));
+   *   }
+   *   PiiMatrix<float>& mat;
+   * } scaler(matImage);
+   * Pii::parallelFor(0, matImage.rows(), scaler, 32);
+   * ~~~
+   */
+  template <class Function> void parallelFor(int begin, int end, Function& function, int minBlockSize = 1)
+  {
+    ParallelRangeAdaptor<Function> adaptor(function);
+    parallelForBlocks(begin, end, parallelBlockCount(end - begin, minBlockSize), adaptor);
+  }
+}
+
+#endif //_PIIPARALLEL_H
@@ -15,45 +15,340 @@
 
 #include "PiiRandom.h"
 #include "PiiMath.h"
+#include "PiiParallel.h"
+#include "PiiAtomicInt.h"
 #include <QDateTime>
 #include <algorithm>
+#include <cmath>
+
+#ifndef PII_NO_QT
+#  include <QThreadStorage>
+#  include <QMutex>
+#endif
+
+namespace
+{
+  inline quint64 splitMix64(quint64& x)
+  {
+    quint64 z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  inline double gaussian(double x) { return std::exp(-0.5 * x * x); }
+
+  // Ziggurat tables for N(0,1). The area under exp(-x^2/2) is
+  // divided into 128 layers of equal area dArea. Layer i is a
+  // rectangle between heights aHeight[i] and aHeight[i+1] that spans
+  // [-aEdge[i], aEdge[i]]. The base layer (0) includes the tail
+  // beyond dTailStart, and its width is virtual.
+  const double dTailStart = 3.442619855899;
+  const double dArea = 9.91256303526217e-3;
+
+  struct ZigguratTables
+  {
+    ZigguratTables()
+    {
+      aEdge[0] = dArea / gaussian(dTailStart);
+      aEdge[1] = dTailStart;
+      for (int i=1; i<127; ++i)
+        aEdge[i+1] = std::sqrt(-2.0 * std::log(gaussian(aEdge[i]) + dArea / aEdge[i]));
+      aEdge[128] = 0;
+      for (int i=0; i<128; ++i)
+        {
+          aRatio[i] = aEdge[i+1] / aEdge[i];
+          aHeight[i] = gaussian(aEdge[i]);
+        }
+      aHeight[128] = 1.0;
+    }
+
+    double aEdge[129], aRatio[128], aHeight[129];
+  } zigguratTables;
+
+  // Seeds are shared by all threads. Each change increments the
+  // generation, which makes thread engines reseed themselves. The
+  // generation can be checked without locking, but the seed, the
+  // stream counter and the generation are changed and read together
+  // under seedMutex.
+  quint64 iGlobalSeed = 0;
+  int iNextStream = 1;
+  PiiAtomicInt iSeedGeneration(1);
+
+#ifndef PII_NO_QT
+  QMutex seedMutex;
+#endif
+
+  struct SeedLocker
+  {
+#ifndef PII_NO_QT
+    SeedLocker() { seedMutex.lock(); }
+    ~SeedLocker() { seedMutex.unlock(); }
+#endif
+  };
+
+  struct ThreadEngine
+  {
+    ThreadEngine() : iGeneration(0) {}
+    PiiRandomEngine engine;
+    int iGeneration;
+  };
+
+#ifndef PII_NO_QT
+  QThreadStorage<ThreadEngine*> threadEngines;
+#  ifdef PII_THREAD_LOCAL
+  // Caches the pointer stored in threadEngines. QThreadStorage owns
+  // the engine and deletes it when the thread exits.
+  PII_THREAD_LOCAL ThreadEngine* pCachedEngine = 0;
+#  endif
+#else
+  ThreadEngine globalEngine;
+#endif
+
+  inline ThreadEngine* threadEngine()
+  {
+#ifndef PII_NO_QT
+#  ifdef PII_THREAD_LOCAL
+    if (pCachedEngine != 0)
+      return pCachedEngine;
+#  endif
+    if (!threadEngines.hasLocalData())
+      threadEngines.setLocalData(new ThreadEngine);
+    ThreadEngine* pEngine = threadEngines.localData();
+#  ifdef PII_THREAD_LOCAL
+    pCachedEngine = pEngine;
+#  endif
+    return pEngine;
+#else
+    return &globalEngine;
+#endif
+  }
+
+  // Fills blocks of matrix rows, each with its own engine.
+  struct RandomMatrixFiller
+  {
+    RandomMatrixFiller(PiiMatrix<double>& matrix, QVector<PiiRandomEngine>& engines,
+                       bool normal, double min, double max) :
+      mat(matrix), vecEngines(engines), bNormal(normal), dMin(min), dMax(max)
+    {}
+
+    void operator() (int block, int firstRow, int lastRow)
+    {
+      PiiRandomEngine& engine = vecEngines[block];
+      for (int r=firstRow; r<lastRow; ++r)
+        {
+          if (bNormal)
+            engine.fillNormal(mat[r], mat.columns());
+          else
+            engine.fillUniform(mat[r], mat.columns(), dMin, dMax);
+        }
+    }
+
+    PiiMatrix<double>& mat;
+    QVector<PiiRandomEngine>& vecEngines;
+    bool bNormal;
+    double dMin, dMax;
+  };
+
+  PiiMatrix<double> randomMatrix(int rows, int columns, bool normal, double min, double max)
+  {
+    PiiMatrix<double> result(PiiMatrix<double>::uninitialized(rows, columns));
+    if (rows <= 0 || columns <= 0)
+      return result;
+    // The number of blocks depends only on the size of the matrix,
+    // which makes the result independent of the number of threads.
+    const int iBlockSize = 1 << 16;
+    int iBlocks = qBound(1, int(qint64(rows) * columns / iBlockSize), rows);
+    // Each block gets a non-overlapping subsequence.
+    PiiRandomEngine& engine = Pii::randomEngine();
+    QVector<PiiRandomEngine> vecEngines(iBlocks);
+    for (int i=0; i<iBlocks; ++i)
+      {
+        vecEngines[i] = engine;
+        engine.jump();
+      }
+    RandomMatrixFiller filler(result, vecEngines, normal, min, max);
+    Pii::parallelForBlocks(0, rows, iBlocks, filler);
+    return result;
+  }
+}
+
+PiiRandomEngine::PiiRandomEngine(quint64 seed, quint64 stream)
+{
+  this->seed(seed, stream);
+}
+
+void PiiRandomEngine::seed(quint64 seed, quint64 stream)
+{
+  quint64 iSeed = seed, iStream = stream;
+  quint64 iMixed = splitMix64(iSeed) ^ (splitMix64(iStream) * 0xd1342543de82ef95ULL);
+  for (int i=0; i<4; ++i)
+    _aState[i] = splitMix64(iMixed);
+  // An all-zero state would only produce zeros.
+  if ((_aState[0] | _aState[1] | _aState[2] | _aState[3]) == 0)
+    _aState[0] = 1;
+}
+
+quint64 PiiRandomEngine::streamId(const QString& name)
+{
+  // FNV-1a. qHash() is not stable across Qt versions.
+  quint64 iHash = 0xcbf29ce484222325ULL;
+  for (const char* p = piiPrintable(name); *p; ++p)
+    iHash = (iHash ^ quint64(static_cast<unsigned char>(*p))) * 0x100000001b3ULL;
+  return iHash;
+}
+
+quint32 PiiRandomEngine::uniformInt(quint32 max)
+{
+  // Lemire's multiply-and-reject method
+  quint64 iProduct = (next() >> 32) * max;
+  quint32 iLow = quint32(iProduct);
+  if (iLow < max)
+    {
+      const quint32 iThreshold = quint32(-max) % max;
+      while (iLow < iThreshold)
+        {
+          iProduct = (next() >> 32) * max;
+          iLow = quint32(iProduct);
+        }
+    }
+  return quint32(iProduct >> 32);
+}
+
+double PiiRandomEngine::normal()
+{
+  for (;;)
+    {
+      const quint64 iBits = next();
+      // The lowest seven bits select the layer, the highest 53 bits
+      // make up a uniform number in [-1,1).
+      const int iLayer = int(iBits & 127);
+      const double dU = double(iBits >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+      // Fast path: inside the rectangle that is entirely under the
+      // curve. This happens about 99% of the time.
+      if (std::fabs(dU) < zigguratTables.aRatio[iLayer])
+        return dU * zigguratTables.aEdge[iLayer];
+      double dX;
+      if (normalOutside(dU, iLayer, &dX))
+        return dX;
+    }
+}
+
+bool PiiRandomEngine::normalOutside(double u, int layer, double* result)
+{
+  if (layer == 0)
+    {
+      // Marsaglia's tail algorithm
+      double dX, dY;
+      do
+        {
+          dX = -std::log(1.0 - uniform()) / dTailStart;
+          dY = -std::log(1.0 - uniform());
+        }
+      while (dY + dY < dX * dX);
+      *result = u > 0 ? dTailStart + dX : -dTailStart - dX;
+      return true;
+    }
+  const double dX = u * zigguratTables.aEdge[layer];
+  const double dY = zigguratTables.aHeight[layer] +
+    uniform() * (zigguratTables.aHeight[layer+1] - zigguratTables.aHeight[layer]);
+  *result = dX;
+  return dY < gaussian(dX);
+}
+
+void PiiRandomEngine::fillUniform(double* data, int n, double min, double max)
+{
+  const double dScale = (max - min) * (1.0 / 9007199254740992.0);
+  for (int i=0; i<n; ++i)
+    data[i] = double(next() >> 11) * dScale + min;
+}
+
+void PiiRandomEngine::fillNormal(double* data, int n)
+{
+  for (int i=0; i<n; ++i)
+    data[i] = normal();
+}
+
+void PiiRandomEngine::jump()
+{
+  static const quint64 aJump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                   0xa9582618e03fc9aaULL, 0x39abdc4575b82ec0ULL };
+  quint64 aState[4] = { 0, 0, 0, 0 };
+  for (int i=0; i<4; ++i)
+    for (int b=0; b<64; ++b)
+      {
+        if (aJump[i] & (quint64(1) << b))
+          for (int j=0; j<4; ++j)
+            aState[j] ^= _aState[j];
+        next();
+      }
+  for (int j=0; j<4; ++j)
+    _aState[j] = aState[j];
+}
 
 namespace Pii
 {
+  PiiRandomEngine& randomEngine()
+  {
+    ThreadEngine* pEngine = threadEngine();
+    if (pEngine->iGeneration != iSeedGeneration.load())
+      {
+        quint64 iSeed, iStream;
+        int iGeneration;
+        {
+          SeedLocker lock;
+          iGeneration = iSeedGeneration.load();
+          iSeed = iGlobalSeed;
+          iStream = quint64(iNextStream++);
+        }
+        pEngine->engine.seed(iSeed, iStream);
+        pEngine->iGeneration = iGeneration;
+      }
+    return pEngine->engine;
+  }
+
   void seedRandom()
   {
     QDateTime now(QDateTime::currentDateTime());
     seedRandom(now.toTime_t() ^ now.time().msec());
   }
 
-  PiiMatrix<double> uniformRandomMatrix(int rows, int columns)
+  void seedRandom(long value)
   {
-    PiiMatrix<double> result(PiiMatrix<double>::uninitialized(rows, columns));
-    for (PiiMatrix<double>::iterator i=result.begin(); i != result.end(); ++i)
-      *i = uniformRandom();
-    return result;
+    int iGeneration;
+    {
+      SeedLocker lock;
+      iGlobalSeed = quint64(value);
+      iNextStream = 1;
+      iGeneration = ++iSeedGeneration;
+    }
+    ThreadEngine* pEngine = threadEngine();
+    pEngine->engine.seed(quint64(value), 0);
+    pEngine->iGeneration = iGeneration;
   }
 
-  PiiMatrix<double> uniformRandomMatrix(int rows, int columns,
-                                        double min, double max)
+  std::size_t uniformRandomIndex(std::size_t max)
   {
-    PiiMatrix<double> result(PiiMatrix<double>::uninitialized(rows, columns));
-    for (PiiMatrix<double>::iterator i=result.begin(); i != result.end(); ++i)
-      *i = uniformRandom(min,max);
-    return result;
+    PiiRandomEngine& engine = randomEngine();
+    if (max <= 0xffffffffU)
+      return engine.uniformInt(quint32(max));
+    return std::size_t(engine.next() % max);
+  }
+
+  PiiMatrix<double> uniformRandomMatrix(int rows, int columns)
+  {
+    return randomMatrix(rows, columns, false, 0.0, 1.0);
   }
 
-  double normalRandom()
+  PiiMatrix<double> uniformRandomMatrix(int rows, int columns,
+                                        double min, double max)
   {
-    return erf(uniformRandom());
+    return randomMatrix(rows, columns, false, min, max);
   }
 
   PiiMatrix<double> normalRandomMatrix(int rows, int columns)
   {
-    PiiMatrix<double> result(PiiMatrix<double>::uninitialized(rows, columns));
-    for (PiiMatrix<double>::iterator i=result.begin(); i != result.end(); ++i)
-      *i = normalRandom();
-    return result;
+    return randomMatrix(rows, columns, true, 0.0, 1.0);
   }
 
   void selectRandomly(QVector<int>& indices, int n, int max)
@@ -64,7 +359,8 @@ namespace Pii
     else if (n < max/2)
       {
         indices.reserve(n);
-        int iRandom = std::rand() % max;
+        PiiRandomEngine& engine = randomEngine();
+        int iRandom = int(engine.uniformInt(quint32(max)));
         // The first one cannot already be there
         indices.append(iRandom);
         // The rest can. Generate n-1 distinct indices.
@@ -73,13 +369,13 @@ namespace Pii
             QVector<int>::iterator i;
             do
               {
-                iRandom = std::rand() % max;
+                iRandom = int(engine.uniformInt(quint32(max)));
                 // Binary search
                 i = std::lower_bound(indices.begin(),
                                      indices.end(),
                                      iRandom);
               }
-            while (*i == iRandom);
+            while (i != indices.end() && *i == iRandom);
             indices.insert(i, iRandom);
           }
       }
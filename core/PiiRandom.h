@@ -21,44 +21,173 @@
 #include <PiiMatrix.h>
 #include <QVector>
 
+/**
+ * A fast pseudo-random number generator. The engine implements the
+ * xoshiro256** algorithm, which has a period of 2^256-1, passes all
+ * standard statistical tests and produces a 64-bit number in a few
+ * clock cycles. Normally distributed numbers are generated with the
+ * ziggurat method.
+ *
+ * The engine has no shared state, which makes it possible to
+ * generate random numbers in many threads without locking. The
+ * global functions in the [random] group use a separate engine for
+ * each thread (see [Pii::randomEngine()]). An operation that needs a
+ * reproducible sequence of random numbers independent of the number
+ * of threads and the scheduling order should have its own engine:
+ *
+ * ~~~(c++)
+ * // In MyOperation::check()
+ * d->random.seed(d->iRandomSeed, PiiRandomEngine::streamId(objectName()));
+ * // In MyOperation::process()
+ * double dNoise = d->random.normal() * d->dNoiseLevel;
+ * ~~~
+ *
+ * The class is not thread-safe.
+ */
+class PII_CORE_EXPORT PiiRandomEngine
+{
+public:
+  /**
+   * Creates a new engine and initializes it with [seed()].
+   */
+  PiiRandomEngine(quint64 seed = 0, quint64 stream = 0);
+
+  /**
+   * Initializes the state of the engine. Engines initialized with
+   * the same *seed* but a different *stream* produce statistically
+   * independent sequences.
+   */
+  void seed(quint64 seed, quint64 stream = 0);
+
+  /**
+   * Returns a stream identifier derived from *name*. This makes it
+   * easy to give each operation its own stream based on its object
+   * name.
+   */
+  static quint64 streamId(const QString& name);
+
+  /**
+   * Returns the next 64-bit random number.
+   */
+  inline quint64 next()
+  {
+    const quint64 iResult = rotate(_aState[1] * 5, 7) * 9;
+    const quint64 iT = _aState[1] << 17;
+    _aState[2] ^= _aState[0];
+    _aState[3] ^= _aState[1];
+    _aState[1] ^= _aState[2];
+    _aState[0] ^= _aState[3];
+    _aState[2] ^= iT;
+    _aState[3] = rotate(_aState[3], 45);
+    return iResult;
+  }
+
+  /**
+   * Returns a uniformly distributed random number in [0,1).
+   */
+  inline double uniform()
+  {
+    // 53 random bits fill the mantissa of a double.
+    return double(next() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  /**
+   * Returns a uniformly distributed random number in [*min*,
+   * *max*).
+   */
+  inline double uniform(double min, double max)
+  {
+    return uniform() * (max - min) + min;
+  }
+
+  /**
+   * Returns a uniformly distributed random integer in [0, *max*).
+   * Unlike `std::rand() % max`, the result is unbiased.
+   */
+  quint32 uniformInt(quint32 max);
+
+  /**
+   * Returns a random number from N(0,1).
+   */
+  double normal();
+
+  /**
+   * Fills *n* consecutive elements starting at *data* with uniformly
+   * distributed random numbers in [*min*, *max*).
+   */
+  void fillUniform(double* data, int n, double min = 0.0, double max = 1.0);
+
+  /**
+   * Fills *n* consecutive elements starting at *data* with numbers
+   * from N(0,1).
+   */
+  void fillNormal(double* data, int n);
+
+  /**
+   * Advances the state by 2^128 steps. This is equivalent to 2^128
+   * calls to [next()], and can be used to generate 2^128
+   * non-overlapping subsequences from a single seed.
+   */
+  void jump();
+
+private:
+  static inline quint64 rotate(quint64 x, int k) { return (x << k) | (x >> (64 - k)); }
+  bool normalOutside(double u, int layer, double* result);
+
+  quint64 _aState[4];
+};
+
 namespace Pii
 {
   /**
    * @group random Random Number Generation
    *
-   * Functions for generating different types of random numbers.
+   * Functions for generating different types of random numbers. All
+   * functions use [randomEngine()] and can be called from many
+   * threads simultaneously.
    */
 
   /**
-   * Returns a uniformly distributed random number in [0,1].
+   * Returns the random number engine of the calling thread. The
+   * engine is created and seeded on first use. The engine of the
+   * thread that calls [seedRandom()] uses stream 0 of the given seed.
+   * Other threads are assigned streams 1, 2, ... in the order they
+   * first generate random numbers after the seed has been set. Thus,
+   * single-threaded programs get a reproducible sequence, but
+   * multi-threaded ones only if the threads start in a fixed order.
+   * If reproducibility is important, use a dedicated
+   * [PiiRandomEngine] instead.
+   */
+  PII_CORE_EXPORT PiiRandomEngine& randomEngine();
+
+  /**
+   * Returns a uniformly distributed random number in [0,1).
    */
   inline double uniformRandom()
   {
-#if defined(Q_OS_WIN) || defined(__TI_COMPILER_VERSION__)
-    return double(std::rand()) * 1.0/RAND_MAX;
-#else
-    return drand48();
-#endif
+    return randomEngine().uniform();
   }
 
   /**
    * Returns a *rows* x *columns* matrix filled with uniformly
-   * distributed random numbers in [0,1].
+   * distributed random numbers in [0,1).
    */
   PII_CORE_EXPORT PiiMatrix<double> uniformRandomMatrix(int rows, int columns);
 
   /**
    * Returns a uniformly distributed random number in [*min*,
-   * *max*].
+   * *max*).
    */
   inline double uniformRandom(double min, double max)
   {
-    return uniformRandom() * (max-min) + min;
+    return randomEngine().uniform(min, max);
   }
 
   /**
    * Returns a *rows* x *columns* matrix filled with uniformly
-   * distributed random numbers in [*min*, *max*].
+   * distributed random numbers in [*min*, *max*). Large matrices
+   * are filled in parallel. The result depends only on the state of
+   * the calling thread's engine, not on the number of threads.
    */
   PII_CORE_EXPORT PiiMatrix<double> uniformRandomMatrix(int rows, int columns,
                                                         double min, double max);
@@ -66,17 +195,26 @@ namespace Pii
   /**
    * Returns a random number from a distribution that follows N(0,1)
    * (zero mean, unit variance Gaussian distribution). To convert x in
-   * N(0,1) to N(m,v), where m is a non-zero mean and v a non-unit
-   * variance, calculate x*v+m.
+   * N(0,1) to N(m,s^2), where m is a non-zero mean and s a non-unit
+   * standard deviation, calculate x*s+m.
    */
-  PII_CORE_EXPORT double normalRandom();
+  inline double normalRandom()
+  {
+    return randomEngine().normal();
+  }
 
   /**
    * Returns a *rows* x *columns* matrix filled with normally
-   * distributed random numbers.
+   * distributed random numbers. Large matrices are filled in
+   * parallel.
    */
   PII_CORE_EXPORT PiiMatrix<double> normalRandomMatrix(int rows, int columns);
 
+  /**
+   * Returns a uniformly distributed random integer in [0, *max*).
+   */
+  PII_CORE_EXPORT std::size_t uniformRandomIndex(std::size_t max);
+
   /**
    * Initializes the random number generator from system clock. Note
    * that successive inits within the same millisecond have no effect.
@@ -87,16 +225,13 @@ namespace Pii
   PII_CORE_EXPORT void seedRandom();
 
   /**
-   * Seeds the random number generator with your favourite value.
+   * Seeds the random number generator with your favourite value. The
+   * engine of the calling thread is reseeded immediately. The engines
+   * of other threads will be reseeded when they next generate a
+   * random number.
    */
-  inline void seedRandom(long value)
-  {
-#if defined(Q_OS_WIN) || defined(__TI_COMPILER_VERSION__)
-    std::srand(static_cast<unsigned int>(value));
-#else
-    srand48(value);
-#endif
-  }
+  PII_CORE_EXPORT void seedRandom(long value);
+
   /**
    * Randomize the order of elements in a collection.
    *
@@ -0,0 +1,299 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "PiiThreadUtil.h"
+
+#include <QStringList>
+#include <QThread>
+#include <QDir>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#  include <pthread.h>
+#  include <sched.h>
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#  include <sys/mman.h>
+// Memory policies from <linux/mempolicy.h>. Defined here to avoid a
+// dependency on libnuma.
+#  define PII_MPOL_DEFAULT 0
+#  define PII_MPOL_PREFERRED 1
+#  ifndef SCHED_IDLE
+#    define SCHED_IDLE 5
+#  endif
+#  define PII_SCHED_DEADLINE 6
+// The sched_attr structure of sched_setattr(2). glibc provides
+// neither the structure nor a wrapper for the system call.
+struct PiiSchedAttr
+{
+  quint32 size;
+  quint32 schedPolicy;
+  quint64 schedFlags;
+  qint32 schedNice;
+  quint32 schedPriority;
+  quint64 schedRuntime;
+  quint64 schedDeadline;
+  quint64 schedPeriod;
+};
+#elif defined(Q_OS_WIN)
+#  include <windows.h>
+#endif
+
+namespace Pii
+{
+  QList<int> parseCpuList(const QString& cpus)
+  {
+    QList<int> lstResult;
+    QStringList lstParts = cpus.split(',', QString::SkipEmptyParts);
+    for (int i=0; i<lstParts.size(); ++i)
+      {
+        QStringList lstRange = lstParts[i].trimmed().split('-');
+        bool bOk1 = false, bOk2 = false;
+        int iFirst = lstRange[0].trimmed().toInt(&bOk1), iLast = iFirst;
+        if (lstRange.size() == 2)
+          iLast = lstRange[1].trimmed().toInt(&bOk2);
+        else
+          bOk2 = lstRange.size() == 1;
+        if (!bOk1 || !bOk2 || iFirst < 0 || iLast < iFirst)
+          continue;
+        for (int j=iFirst; j<=iLast; ++j)
+          if (!lstResult.contains(j))
+            lstResult << j;
+      }
+    std::sort(lstResult.begin(), lstResult.end());
+    return lstResult;
+  }
+
+  QString cpuListToString(const QList<int>& cpus)
+  {
+    QList<int> lstCpus(cpus);
+    std::sort(lstCpus.begin(), lstCpus.end());
+    lstCpus.erase(std::unique(lstCpus.begin(), lstCpus.end()), lstCpus.end());
+    QStringList lstParts;
+    for (int i=0; i<lstCpus.size(); )
+      {
+        int j = i+1;
+        while (j < lstCpus.size() && lstCpus[j] == lstCpus[j-1] + 1)
+          ++j;
+        if (j - i > 1)
+          lstParts << QString("%1-%2").arg(lstCpus[i]).arg(lstCpus[j-1]);
+        else
+          lstParts << QString::number(lstCpus[i]);
+        i = j;
+      }
+    return lstParts.join(",");
+  }
+
+  int cpuCount()
+  {
+    return qMax(QThread::idealThreadCount(), 1);
+  }
+
+  bool setThreadAffinity(const QList<int>& cpus)
+  {
+#if defined(Q_OS_LINUX)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (cpus.isEmpty())
+      {
+        for (int i=0; i<CPU_SETSIZE; ++i)
+          CPU_SET(i, &cpuSet);
+      }
+    else
+      {
+        for (int i=0; i<cpus.size(); ++i)
+          if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE)
+            CPU_SET(cpus[i], &cpuSet);
+      }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#elif defined(Q_OS_WIN)
+    DWORD_PTR mask = 0;
+    if (cpus.isEmpty())
+      {
+        DWORD_PTR systemMask = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &systemMask))
+          return false;
+      }
+    else
+      {
+        for (int i=0; i<cpus.size(); ++i)
+          if (cpus[i] >= 0 && cpus[i] < int(sizeof(DWORD_PTR)*8))
+            mask |= DWORD_PTR(1) << cpus[i];
+      }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    Q_UNUSED(cpus);
+    return false;
+#endif
+  }
+
+  QList<int> threadAffinity()
+  {
+    QList<int> lstResult;
+#if defined(Q_OS_LINUX)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0)
+      {
+        for (int i=0; i<CPU_SETSIZE; ++i)
+          if (CPU_ISSET(i, &cpuSet))
+            lstResult << i;
+      }
+#elif defined(Q_OS_WIN)
+    // Windows has no GetThreadAffinityMask(). Setting the mask
+    // returns the previous one, which is then restored.
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+      {
+        DWORD_PTR mask = SetThreadAffinityMask(GetCurrentThread(), processMask);
+        if (mask != 0)
+          {
+            SetThreadAffinityMask(GetCurrentThread(), mask);
+            for (int i=0; i<int(sizeof(DWORD_PTR)*8); ++i)
+              if (mask & (DWORD_PTR(1) << i))
+                lstResult << i;
+          }
+      }
+#endif
+    return lstResult;
+  }
+
+  int numaNodeOf(int cpu)
+  {
+#if defined(Q_OS_LINUX)
+    // Each CPU directory in sysfs contains a link to the node it
+    // belongs to.
+    QStringList lstNodes = QDir(QString("/sys/devices/system/cpu/cpu%1").arg(cpu))
+      .entryList(QStringList() << "node*", QDir::Dirs | QDir::NoDotAndDotDot);
+    if (!lstNodes.isEmpty())
+      return lstNodes[0].mid(4).toInt();
+#else
+    Q_UNUSED(cpu);
+#endif
+    return 0;
+  }
+
+  QList<int> numaNodesOf(const QList<int>& cpus)
+  {
+    QList<int> lstNodes;
+    for (int i=0; i<cpus.size(); ++i)
+      {
+        int iNode = numaNodeOf(cpus[i]);
+        if (!lstNodes.contains(iNode))
+          lstNodes << iNode;
+      }
+    std::sort(lstNodes.begin(), lstNodes.end());
+    return lstNodes;
+  }
+
+  bool setThreadMemoryNode(int node)
+  {
+#if defined(Q_OS_LINUX) && defined(SYS_set_mempolicy)
+    if (node < 0)
+      return syscall(SYS_set_mempolicy, PII_MPOL_DEFAULT, 0, 0) == 0;
+    const int iBitsPerWord = int(sizeof(unsigned long) * 8);
+    if (node >= iBitsPerWord * 16)
+      return false;
+    unsigned long aNodeMask[16] = { 0 };
+    aNodeMask[node / iBitsPerWord] = 1UL << (node % iBitsPerWord);
+    return syscall(SYS_set_mempolicy, PII_MPOL_PREFERRED, aNodeMask, iBitsPerWord * 16) == 0;
+#else
+    Q_UNUSED(node);
+    return false;
+#endif
+  }
+
+  bool bindThread(const QList<int>& cpus)
+  {
+    if (!setThreadAffinity(cpus))
+      return false;
+    QList<int> lstNodes = numaNodesOf(cpus);
+    setThreadMemoryNode(lstNodes.size() == 1 ? lstNodes[0] : -1);
+    return true;
+  }
+
+  bool setThreadScheduling(SchedulingPolicy policy, int priority)
+  {
+#if defined(Q_OS_LINUX)
+    sched_param param;
+    param.sched_priority = 0;
+    switch (policy)
+      {
+      case NormalScheduling:
+        return pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) == 0;
+      case FifoScheduling:
+        param.sched_priority = qBound(sched_get_priority_min(SCHED_FIFO),
+                                      priority,
+                                      sched_get_priority_max(SCHED_FIFO));
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+      case BackgroundScheduling:
+        return pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0;
+      default:
+        return false;
+      }
+#elif defined(Q_OS_WIN)
+    Q_UNUSED(priority);
+    switch (policy)
+      {
+      case NormalScheduling:
+        return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL) != 0;
+      case FifoScheduling:
+        return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+      case BackgroundScheduling:
+        return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE) != 0;
+      default:
+        return false;
+      }
+#else
+    Q_UNUSED(policy);
+    Q_UNUSED(priority);
+    return false;
+#endif
+  }
+
+  bool setThreadDeadline(qint64 runtime, qint64 deadline, qint64 period)
+  {
+#if defined(Q_OS_LINUX) && defined(SYS_sched_setattr)
+    if (runtime <= 0 || deadline < runtime || period < deadline)
+      return false;
+    PiiSchedAttr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.schedPolicy = PII_SCHED_DEADLINE;
+    // The kernel wants nanoseconds.
+    attr.schedRuntime = quint64(runtime) * 1000;
+    attr.schedDeadline = quint64(deadline) * 1000;
+    attr.schedPeriod = quint64(period) * 1000;
+    return syscall(SYS_sched_setattr, 0, &attr, 0) == 0;
+#else
+    Q_UNUSED(runtime);
+    Q_UNUSED(deadline);
+    Q_UNUSED(period);
+    return false;
+#endif
+  }
+
+  bool lockProcessMemory(bool lock)
+  {
+#if defined(Q_OS_LINUX) && defined(MCL_CURRENT)
+    return (lock ? mlockall(MCL_CURRENT | MCL_FUTURE) : munlockall()) == 0;
+#else
+    Q_UNUSED(lock);
+    return false;
+#endif
+  }
+}
@@ -0,0 +1,193 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIITHREADUTIL_H
+#define _PIITHREADUTIL_H
+
+#include <QList>
+#include <QString>
+#include "PiiGlobal.h"
+
+/**
+ * Functions for controlling the placement of threads on processor
+ * cores and memory nodes. All functions operate on the calling
+ * thread. CPU indices are zero-based logical processor numbers as
+ * reported by the operating system.
+ *
+ * Thread placement is fully supported on Linux. On Windows, CPU
+ * affinity is supported for the first 64 logical processors, but
+ * NUMA memory placement is not. On other platforms, the functions
+ * do nothing and return `false`.
+ */
+namespace Pii
+{
+  /**
+   * Parses a CPU list. The list is a comma-separated list of CPU
+   * indices or index ranges, in the format used by Linux tools such
+   * as `taskset`. Duplicate entries are ignored and the result is
+   * sorted. Invalid entries are ignored. An empty string yields an
+   * empty list.
+   *
+   * ~~~(c++)
+   * QList<int> lstCpus = Pii::parseCpuList("0-3,8,10-11");
+   * // lstCpus = (0, 1, 2, 3, 8, 10, 11)
+   * ~~~
+   */
+  PII_CORE_EXPORT QList<int> parseCpuList(const QString& cpus);
+
+  /**
+   * Converts a list of CPU indices to a compact string
+   * representation understood by [parseCpuList()]. The input need
+   * not be sorted, and duplicates are ignored.
+   *
+   * ~~~(c++)
+   * QString strCpus = Pii::cpuListToString(QList<int>() << 3 << 0 << 1 << 2 << 8 << 8);
+   * // strCpus = "0-3,8"
+   * ~~~
+   */
+  PII_CORE_EXPORT QString cpuListToString(const QList<int>& cpus);
+
+  /**
+   * Returns the number of logical processors in the system.
+   */
+  PII_CORE_EXPORT int cpuCount();
+
+  /**
+   * Restricts the calling thread to run only on the given *cpus*. If
+   * *cpus* is empty, the thread will be allowed to run on all
+   * processors.
+   *
+   * @return `true` on success, `false` if the affinity could not be
+   * changed.
+   */
+  PII_CORE_EXPORT bool setThreadAffinity(const QList<int>& cpus);
+
+  /**
+   * Returns the CPUs the calling thread is allowed to run on. If the
+   * affinity cannot be determined, returns an empty list.
+   */
+  PII_CORE_EXPORT QList<int> threadAffinity();
+
+  /**
+   * Returns the NUMA node *cpu* belongs to. If the system is not a
+   * NUMA system or the node cannot be determined, returns 0.
+   */
+  PII_CORE_EXPORT int numaNodeOf(int cpu);
+
+  /**
+   * Returns the NUMA nodes the given *cpus* belong to, in ascending
+   * order.
+   */
+  PII_CORE_EXPORT QList<int> numaNodesOf(const QList<int>& cpus);
+
+  /**
+   * Makes memory allocations of the calling thread preferably use the
+   * given NUMA *node*. Memory will still be allocated from other
+   * nodes if the preferred node runs out of memory. Passing -1 as
+   * the node restores the system default policy (allocate on the node
+   * the thread is currently running on).
+   *
+   * Note that the policy is applied when physical pages are first
+   * touched, not when address space is reserved. Since the
+   * data of a matrix is initialized by the thread that creates it,
+   * this makes [PiiMatrix] data local to the thread that produces it.
+   *
+   * @return `true` on success, `false` otherwise.
+   */
+  PII_CORE_EXPORT bool setThreadMemoryNode(int node);
+
+  /**
+   * Binds the calling thread to *cpus*. If all of the CPUs belong to
+   * the same NUMA node, memory allocations of the thread will be
+   * preferably served from that node. If *cpus* is empty, both the
+   * CPU affinity and the memory policy will be reset.
+   *
+   * @return `true` if the CPU affinity was successfully changed,
+   * `false` otherwise.
+   *
+   * @see setThreadAffinity()
+   * @see setThreadMemoryNode()
+   */
+  PII_CORE_EXPORT bool bindThread(const QList<int>& cpus);
+
+  /**
+   * Scheduling policies for [setThreadScheduling()].
+   *
+   * - `NormalScheduling` - the default time-sharing policy of the
+   *   operating system.
+   *
+   * - `FifoScheduling` - a fixed-priority real-time policy. A
+   *   runnable thread with this policy preempts all normal threads
+   *   and runs until it blocks or a higher-priority real-time thread
+   *   becomes runnable. Corresponds to `SCHED_FIFO` on Linux and
+   *   `THREAD_PRIORITY_TIME_CRITICAL` on Windows.
+   *
+   * - `DeadlineScheduling` - an earliest deadline first policy with
+   *   bandwidth reservation (`SCHED_DEADLINE`, Linux only).
+   *
+   * - `BackgroundScheduling` - the thread only runs when the
+   *   processor would otherwise be idle. Corresponds to `SCHED_IDLE`
+   *   on Linux and `THREAD_PRIORITY_IDLE` on Windows.
+   */
+  enum SchedulingPolicy
+  {
+    NormalScheduling,
+    FifoScheduling,
+    DeadlineScheduling,
+    BackgroundScheduling
+  };
+
+  /**
+   * Changes the scheduling policy of the calling thread. Real-time
+   * policies usually require special privileges (`CAP_SYS_NICE` or
+   * an appropriate `RLIMIT_RTPRIO` on Linux).
+   *
+   * @param policy the scheduling policy
+   *
+   * @param priority the real-time priority (1-99) with
+   * `FifoScheduling`. Ignored with other policies.
+   *
+   * @return `true` on success, `false` if the policy is not supported
+   * or permitted. Use [setThreadDeadline()] to enable
+   * `DeadlineScheduling`; passing it to this function returns
+   * `false`.
+   */
+  PII_CORE_EXPORT bool setThreadScheduling(SchedulingPolicy policy, int priority = 50);
+
+  /**
+   * Puts the calling thread under deadline scheduling. The kernel
+   * guarantees the thread *runtime* microseconds of CPU time within
+   * *deadline* microseconds from the beginning of each *period*. The
+   * request is subject to admission control and fails if the total
+   * reserved bandwidth would exceed the capacity of the system.
+   *
+   * @return `true` on success, `false` if deadline scheduling is not
+   * supported, not permitted, or the reservation was rejected.
+   */
+  PII_CORE_EXPORT bool setThreadDeadline(qint64 runtime, qint64 deadline, qint64 period);
+
+  /**
+   * Locks (or unlocks) all current and future memory pages of the
+   * process into physical memory. Locked memory is never swapped
+   * out, which prevents page faults on latency-critical code paths.
+   * The size of lockable memory is usually limited by
+   * `RLIMIT_MEMLOCK`.
+   *
+   * @return `true` on success, `false` otherwise.
+   */
+  PII_CORE_EXPORT bool lockProcessMemory(bool lock = true);
+}
+
+#endif //_PIITHREADUTIL_H
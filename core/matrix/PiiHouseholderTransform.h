@@ -133,6 +133,47 @@ namespace Pii
   }
 
 
+  // Reflects a block of columns. The matrix is traversed row by row,
+  // which makes the loops cache-friendly and vectorizable.
+  template <class Matrix, class InputIterator> struct ColumnReflector
+  {
+    typedef typename Matrix::value_type Real;
+
+    ColumnReflector(Matrix& A, InputIterator v, Real tau, Real* bfr) :
+      A(A), v(v), tau(tau), bfr(bfr)
+    {}
+
+    void operator() (int firstColumn, int lastColumn)
+    {
+      const int iRows = A.rows(), iCols = lastColumn - firstColumn;
+      Real* pBfr = bfr + firstColumn;
+
+      // tmp = (A' * v)'
+      fillN(pBfr, iCols, Real(0));
+      for (int r=0; r<iRows; ++r)
+        {
+          typename Matrix::row_iterator row = A.rowBegin(r) + firstColumn;
+          const Real value = v[r];
+          for (int c=0; c<iCols; ++c)
+            pBfr[c] += Real(row[c]) * value;
+        }
+
+      // A << A - tau * v * tmp
+      for (int r=0; r<iRows; ++r)
+        {
+          typename Matrix::row_iterator row = A.rowBegin(r) + firstColumn;
+          const Real scale = v[r]*tau;
+          for (int c=0; c<iCols; ++c)
+            row[c] -= pBfr[c] * scale;
+        }
+    }
+
+    Matrix& A;
+    InputIterator v;
+    Real tau;
+    Real* bfr;
+  };
+
   /**
    * Applies a reflection transform to a rectangular matrix from the
    * left. This function uses the vector representation of a
@@ -162,28 +203,17 @@ namespace Pii
                       typename Matrix::value_type tau,
                       typename Matrix::value_type* bfr)
   {
-    typedef typename Matrix::value_type Real;
-
     if (tau == 0)
       return;
 
     const int iRows = A.rows(), iCols = A.columns();
-
-    // tmp = (A' * v)'
-    for (int i=0; i<iCols; ++i)
-      bfr[i] = innerProductN(A.columnBegin(i), iRows, v, Real(0));
-
-
-    // A << A - tau * v * tmp
-    for (int i=0; i<iRows; ++i)
-    {
-      mapN(A.rowBegin(i), iCols,
-           bfr,
-           binaryCompose(std::minus<Real>(),
-                         Identity<Real>(),
-                         std::bind2nd(std::multiplies<Real>(),
-                                      v[i]*tau)));
-    }
+    ColumnReflector<Matrix, InputIterator> reflector(A, v, tau, bfr);
+    // Columns are independent of each other. Large matrices are
+    // processed in parallel.
+    if (iRows * iCols >= 65536)
+      parallelFor(0, iCols, reflector, qMax(16, 16384 / qMax(iRows, 1)));
+    else
+      reflector(0, iCols);
   }
 
   template <class Matrix, class InputIterator>
@@ -197,6 +227,34 @@ namespace Pii
     delete[] pBfr;
   }
 
+  // Reflects a block of rows.
+  template <class Matrix, class InputIterator> struct RowReflector
+  {
+    typedef typename Matrix::value_type Real;
+
+    RowReflector(Matrix& A, InputIterator v, Real tau) :
+      A(A), v(v), tau(tau)
+    {}
+
+    void operator() (int firstRow, int lastRow)
+    {
+      const int iCols = A.columns();
+      for (int r=firstRow; r<lastRow; ++r)
+        // a_i = a_i - v_i * <A, V> * tau
+        // Get it? In reality, C++ is just an ugly dialect of Lisp.
+        mapN(A.rowBegin(r), iCols, v,
+             binaryCompose(std::minus<Real>(),
+                           Identity<Real>(),
+                           std::bind2nd(std::multiplies<Real>(),
+                                        innerProductN(A.rowBegin(r), iCols,  v,
+                                                      Real(0)) * tau)));
+    }
+
+    Matrix& A;
+    InputIterator v;
+    Real tau;
+  };
+
   /**
    * Applies a reflection transform to a rectangular matrix from the
    * right. The algorithm is functionally equivalent to \(A \gets
@@ -222,22 +280,15 @@ namespace Pii
                    InputIterator v,
                    typename Matrix::value_type tau)
   {
-    typedef typename Matrix::value_type Real;
-
     if (tau == 0)
       return;
 
     const int iRows = A.rows(), iCols = A.columns();
-
-    for (int r=0; r<iRows; ++r)
-      // a_i = a_i - v_i * <A, V> * tau
-      // Get it? In reality, C++ is just an ugly dialect of Lisp.
-      mapN(A.rowBegin(r), iCols, v,
-           binaryCompose(std::minus<Real>(),
-                         Identity<Real>(),
-                         std::bind2nd(std::multiplies<Real>(),
-                                      innerProductN(A.rowBegin(r), iCols,  v,
-                                                    Real(0)) * tau)));
+    RowReflector<Matrix, InputIterator> reflector(A, v, tau);
+    if (iRows * iCols >= 65536)
+      parallelFor(0, iRows, reflector, qMax(16, 16384 / qMax(iCols, 1)));
+    else
+      reflector(0, iRows);
   }
 
   /**
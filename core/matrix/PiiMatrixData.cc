@@ -18,6 +18,37 @@
 #include <cstring>
 #include <new>
 
+#ifdef PII_THREAD_LOCAL
+namespace
+{
+  PII_THREAD_LOCAL PiiMatrixTraffic* pThreadTraffic = 0;
+}
+#  define PII_COUNT_TRAFFIC(COUNTER, AMOUNT) if (pThreadTraffic != 0) pThreadTraffic->COUNTER += (AMOUNT)
+#else
+#  define PII_COUNT_TRAFFIC(COUNTER, AMOUNT)
+#endif
+
+PiiMatrixTraffic* PiiMatrixData::setThreadTraffic(PiiMatrixTraffic* traffic)
+{
+#ifdef PII_THREAD_LOCAL
+  PiiMatrixTraffic* pPrevious = pThreadTraffic;
+  pThreadTraffic = traffic;
+  return pPrevious;
+#else
+  Q_UNUSED(traffic);
+  return 0;
+#endif
+}
+
+PiiMatrixTraffic* PiiMatrixData::threadTraffic()
+{
+#ifdef PII_THREAD_LOCAL
+  return pThreadTraffic;
+#else
+  return 0;
+#endif
+}
+
 PiiMatrixData* PiiMatrixData::sharedNull()
 {
   static PiiMatrixData nullData;
@@ -32,16 +63,20 @@ PiiMatrixData* PiiMatrixData::allocate(int rows, int columns, std::size_t stride
 
 PiiMatrixData* PiiMatrixData::reallocate(PiiMatrixData* d, int rows)
 {
+  PII_COUNT_TRAFFIC(iReallocations, 1);
+  PII_COUNT_TRAFFIC(iAllocatedBytes, qint64(qMax(rows - d->iCapacity, 0)) * qint64(d->iStride));
   // This may move the contents of d into a new memory location
   d = static_cast<PiiMatrixData*>(std::realloc(d, headerSize() + rows * d->iStride));
   // If the data buffer is internal, we need to fix the data pointer
   if (d->bufferType == InternalBuffer)
     d->pBuffer = d->bufferAddress();
+  d->iCapacity = rows;
   return d;
 }
 
 void PiiMatrixData::destroy()
 {
+  PII_COUNT_TRAFFIC(iReleases, 1);
   if (bufferType == ExternalOwnBuffer)
     std::free(pBuffer);
   else if (pSourceData != 0)
@@ -54,6 +89,8 @@ PiiMatrixData* PiiMatrixData::createUninitializedData(int rows, int columns, std
   if (stride < bytesPerRow)
     stride = alignedWidth(bytesPerRow);
   PiiMatrixData* pData = allocate(rows, columns, stride);
+  PII_COUNT_TRAFFIC(iAllocations, 1);
+  PII_COUNT_TRAFFIC(iAllocatedBytes, qint64(rows) * qint64(stride));
   pData->bufferType = InternalBuffer;
   if (rows*columns != 0)
     pData->pBuffer = pData->bufferAddress();
@@ -99,6 +136,8 @@ PiiMatrixData* PiiMatrixData::clone(int capacity, std::size_t bytesPerRow)
       for (int i=0; i<iRows; ++i)
         std::memcpy(pData->row(i), row(i), bytesPerRow);
     }
+  PII_COUNT_TRAFFIC(iClones, 1);
+  PII_COUNT_TRAFFIC(iCopiedBytes, qint64(iRows) * qint64(pData->iStride == iStride ? iStride : bytesPerRow));
   pData->iRows = iRows;
   return pData;
 }
@@ -19,6 +19,50 @@
 #include <PiiGlobal.h>
 #include <PiiAtomicInt.h>
 
+/**
+ * Counters for memory traffic caused by [PiiMatrix] data. If a thread
+ * has installed a set of counters with
+ * [PiiMatrixData::setThreadTraffic()], all matrix allocations, clones
+ * (deep copies), reallocations and releases made by the thread will be
+ * recorded. The counters are not synchronized; each thread must use
+ * its own instance.
+ */
+struct PII_CORE_EXPORT PiiMatrixTraffic
+{
+  PiiMatrixTraffic() :
+    iAllocations(0),
+    iAllocatedBytes(0),
+    iClones(0),
+    iCopiedBytes(0),
+    iReallocations(0),
+    iReleases(0)
+  {}
+
+  /// The number of data buffers allocated.
+  qint64 iAllocations;
+  /// The total size of the allocated data buffers in bytes.
+  qint64 iAllocatedBytes;
+  /// The number of times matrix data has been deep-copied.
+  qint64 iClones;
+  /// The number of bytes copied while cloning.
+  qint64 iCopiedBytes;
+  /// The number of times a buffer has been resized.
+  qint64 iReallocations;
+  /// The number of data buffers released.
+  qint64 iReleases;
+
+  PiiMatrixTraffic& operator+= (const PiiMatrixTraffic& other)
+  {
+    iAllocations += other.iAllocations;
+    iAllocatedBytes += other.iAllocatedBytes;
+    iClones += other.iClones;
+    iCopiedBytes += other.iCopiedBytes;
+    iReallocations += other.iReallocations;
+    iReleases += other.iReleases;
+    return *this;
+  }
+};
+
 /// @internal
 struct PII_CORE_EXPORT PiiMatrixData
 {
@@ -98,6 +142,15 @@ struct PII_CORE_EXPORT PiiMatrixData
   static PiiMatrixData* createReferenceData(int rows, int columns, std::size_t stride, void* buffer);
 
   void destroy();
+
+  // Installs *traffic* as the memory traffic counters of the calling
+  // thread and returns the previously installed counters. Null
+  // disables accounting. If the compiler doesn't support thread-local
+  // storage, accounting is not available and this function does
+  // nothing.
+  static PiiMatrixTraffic* setThreadTraffic(PiiMatrixTraffic* traffic);
+  // Returns the counters installed for the calling thread or null.
+  static PiiMatrixTraffic* threadTraffic();
 };
 
 #endif //_PIIMATRIXDATA_H
@@ -17,6 +17,8 @@
 #define _PIIPRINCIPALCOMPONENTS_H
 
 #include "PiiSvDecomposition.h"
+#include <PiiMath.h>
+#include <PiiRandom.h>
 
 namespace Pii
 {
@@ -82,6 +84,248 @@ namespace Pii
     transformRows(matU, matS[0], std::multiplies<T>());
     return matU;
   }
+
+  /**
+   * Returns the first *count* PCA base vectors for a data set in *X*
+   * using a randomized truncated SVD. The input is first projected to
+   * a random subspace of *count* + *oversampling* dimensions whose
+   * basis is refined with *powerIterations* rounds of subspace
+   * iteration. The SVD is then calculated in the small subspace.
+   *
+   * The cost is proportional to m*n*(count + oversampling), which
+   * makes this function much faster than [principalComponents()] if
+   * only a few components of a large matrix are needed. The result is
+   * an approximation whose accuracy improves with *oversampling* and
+   * *powerIterations*. If the singular values decay slowly, increase
+   * *powerIterations*.
+   *
+   * @param X the input data (m-by-n), stored as rows. The input data
+   * must have a zero mean.
+   *
+   * @param count the number of components to calculate
+   *
+   * @param S an optional output parameter that will store the *count*
+   * largest singular values of X as a row vector.
+   *
+   * @param oversampling the number of extra dimensions in the random
+   * subspace
+   *
+   * @param powerIterations the number of subspace iterations
+   *
+   * @return an n-by-*count* matrix whose columns are the principal
+   * components.
+   *
+   * ~~~(c++)
+   * PiiMatrix<double> matData(...); // 100000 x 500
+   * Pii::subtractMean(matData, Pii::Vertically);
+   * PiiMatrix<double> matBase(Pii::randomizedPrincipalComponents(matData, 10));
+   * PiiMatrix<double> matReduced(matData * matBase); // 100000 x 10
+   * ~~~
+   */
+  template <class Matrix>
+  PiiMatrix<typename Matrix::value_type> randomizedPrincipalComponents(const Matrix& X,
+                                                                       int count,
+                                                                       PiiMatrix<typename Matrix::value_type>* S = 0,
+                                                                       int oversampling = 10,
+                                                                       int powerIterations = 2)
+  {
+    typedef typename Matrix::value_type Real;
+    const PiiMatrix<Real> matX(X);
+    const int iMinSize = qMin(matX.rows(), matX.columns());
+    count = qBound(1, count, iMinSize);
+    const int iSubspaceSize = qMin(count + qMax(oversampling, 0), iMinSize);
+
+    // Orthonormal basis for the range of X*Omega
+    PiiMatrix<Real> matQ(qrDecompose(PiiMatrix<Real>(matX * PiiMatrix<Real>(normalRandomMatrix(matX.columns(),
+                                                                                               iSubspaceSize)))));
+    // Re-orthonormalize between the multiplications to avoid losing
+    // the smaller components to round-off errors.
+    for (int i=0; i<powerIterations; ++i)
+      {
+        PiiMatrix<Real> matZ(qrDecompose(PiiMatrix<Real>(transpose(matX) * matQ)));
+        matQ = qrDecompose(PiiMatrix<Real>(matX * matZ));
+      }
+
+    // X ~ QQ'X = Q(USV') -> V of the small matrix Q'X is that of X
+    PiiMatrix<Real> matV;
+    PiiMatrix<Real> matS(svDecompose(PiiMatrix<Real>(transpose(matQ) * matX), 0, &matV, SvdThinV));
+    if (S != 0)
+      *S = PiiMatrix<Real>(matS(0, 0, 1, count));
+    return PiiMatrix<Real>(matV(0, 0, -1, count));
+  }
 }
 
+/**
+ * Incremental (streaming) principal component analysis. This class
+ * accumulates the mean and the scatter matrix of the samples given
+ * to it in batches without storing the samples themselves. The
+ * principal components can be recalculated at any time, which makes
+ * it possible to refresh a dimensionality reduction online as new
+ * samples come in.
+ *
+ * The statistics of each batch are calculated in parallel and merged
+ * to the running totals using the pairwise update formula of Chan et
+ * al., which is numerically stable even if the mean of the data
+ * drifts. Two accumulators that have been fed with different data
+ * can be combined with [merge()].
+ *
+ * ~~~(c++)
+ * PiiIncrementalPca<double> pca;
+ * while (readBatch(matSamples))
+ *   {
+ *     pca.addSamples(matSamples);
+ *     PiiMatrix<double> matBase(pca.components(8));
+ *     PiiMatrix<double> matReduced(pca.project(matSamples, matBase));
+ *     // ...
+ *   }
+ * ~~~
+ *
+ * The memory and time required by [components()] grow with the
+ * square and the cube of the number of dimensions, respectively. Use
+ * Pii::randomizedPrincipalComponents() if the dimensionality is very
+ * high and all samples fit into memory.
+ */
+template <class T> class PiiIncrementalPca
+{
+public:
+  /**
+   * Creates an empty accumulator. The number of dimensions is fixed
+   * by the first batch of samples.
+   */
+  PiiIncrementalPca() : _iSampleCount(0) {}
+
+  /**
+   * Adds a batch of *samples* to the statistics. Each row in
+   * *samples* is an observation. The number of columns must match
+   * that of previously added samples.
+   *
+   * @exception PiiMathException& if the number of dimensions does
+   * not match
+   */
+  void addSamples(const PiiMatrix<T>& samples)
+  {
+    if (samples.rows() == 0)
+      return;
+    PiiMatrix<double> matMean(Pii::mean<double>(samples, Pii::Vertically));
+    merge(samples.rows(), matMean, Pii::scatterMatrix(samples, matMean));
+  }
+
+  /**
+   * Merges the statistics collected by *other* to this accumulator.
+   *
+   * @exception PiiMathException& if the number of dimensions does
+   * not match
+   */
+  void merge(const PiiIncrementalPca& other)
+  {
+    if (other._iSampleCount > 0)
+      merge(other._iSampleCount, other._matMean, other._matScatter);
+  }
+
+  /**
+   * Clears all collected statistics.
+   */
+  void reset()
+  {
+    _iSampleCount = 0;
+    _matMean = PiiMatrix<double>();
+    _matScatter = PiiMatrix<double>();
+  }
+
+  /**
+   * Returns the number of samples added so far.
+   */
+  int sampleCount() const { return _iSampleCount; }
+  /**
+   * Returns the number of dimensions, or zero if no samples have been
+   * added.
+   */
+  int dimensions() const { return _matMean.columns(); }
+  /**
+   * Returns the mean of all samples as a row vector.
+   */
+  PiiMatrix<double> mean() const { return _matMean; }
+
+  /**
+   * Returns the covariance matrix of all samples. At least two
+   * samples are needed for a non-zero result.
+   */
+  PiiMatrix<double> covariance() const
+  {
+    if (_iSampleCount < 2)
+      return PiiMatrix<double>(dimensions(), dimensions());
+    return PiiMatrix<double>(_matScatter / double(_iSampleCount - 1));
+  }
+
+  /**
+   * Calculates the principal components of the samples added so far.
+   *
+   * @param count the number of components to return. Zero or a
+   * negative value means all.
+   *
+   * @param variances an optional output parameter that will store
+   * the variance of the data along each returned component as a row
+   * vector, in descending order.
+   *
+   * @return a matrix whose columns are the principal components
+   * (dimensions-by-*count*).
+   */
+  PiiMatrix<T> components(int count = 0, PiiMatrix<T>* variances = 0) const
+  {
+    const int iDimensions = dimensions();
+    if (iDimensions == 0)
+      return PiiMatrix<T>();
+    if (count <= 0 || count > iDimensions)
+      count = iDimensions;
+    // The covariance matrix is symmetric and positive semidefinite.
+    // Thus, its singular values are its eigenvalues and U = V.
+    PiiMatrix<double> matV;
+    PiiMatrix<double> matEigenValues(Pii::svDecompose(covariance(), 0, &matV, Pii::SvdFullV));
+    if (variances != 0)
+      *variances = PiiMatrix<T>(matEigenValues(0, 0, 1, count));
+    return PiiMatrix<T>(matV(0, 0, -1, count));
+  }
+
+  /**
+   * Projects *samples* to the principal components in *base*, which
+   * is usually obtained with [components()]. The mean of the
+   * collected samples is subtracted first.
+   */
+  PiiMatrix<T> project(const PiiMatrix<T>& samples, const PiiMatrix<T>& base) const
+  {
+    PiiMatrix<T> matCentered(samples);
+    if (!_matMean.isEmpty())
+      {
+        PiiMatrix<T> matMean(_matMean);
+        Pii::transformRows(matCentered, matMean.rowBegin(0), std::minus<T>());
+      }
+    return matCentered * base;
+  }
+
+private:
+  void merge(int count, const PiiMatrix<double>& mean, const PiiMatrix<double>& scatter)
+  {
+    if (_iSampleCount == 0)
+      {
+        _iSampleCount = count;
+        _matMean = mean;
+        _matScatter = scatter;
+        return;
+      }
+    if (mean.columns() != _matMean.columns())
+      PII_THROW(PiiMathException, QCoreApplication::translate("PiiIncrementalPca", "The number of dimensions does not match."));
+
+    // M = Ma + Mb + d'd * na*nb/n, where d = mean_b - mean_a
+    const double dTotal = double(_iSampleCount) + count;
+    PiiMatrix<double> matDelta(mean - _matMean);
+    _matScatter += scatter;
+    _matScatter += (Pii::transpose(matDelta) * matDelta) * (double(_iSampleCount) * count / dTotal);
+    _matMean += matDelta * (count / dTotal);
+    _iSampleCount += count;
+  }
+
+  int _iSampleCount;
+  PiiMatrix<double> _matMean, _matScatter;
+};
+
 #endif //_PIIPRINCIPALCOMPONENTS_H
@@ -285,7 +285,7 @@ namespace Pii
       (A12) = A2
       (A22)
     */
-    static const int iBlockSize = 8;
+    static const int iBlockSize = 32;
 
     const int iRows = A.rows(), iCols = A.columns(),
       iMinDimension = qMin(iRows, iCols);
@@ -360,14 +360,18 @@ namespace Pii
                    We are doing this:
 
                    A2 <- (I + A1 T'A1') A2
-                   A2 <- A2 + A1 T'A1'A2
+                   A2 <- A2 + A1 (T' (A1'A2))
+
+                   The products are evaluated right to left so that
+                   the intermediate results are only b rows high,
+                   where b is the block size.
                 */
 
-                A(iBlockStart, iBlockStart + iCurrentBlockSize, -1, -1) +=      // A2  +=
-                  matA1 *                                                       // A1  *
-                  transpose(matT(0,0, iCurrentBlockSize, iCurrentBlockSize)) *  // T'  *
-                  transpose(matA1) *                                            // A1' *
-                  A(iBlockStart, iBlockStart + iCurrentBlockSize, -1, -1);      // A2
+                A(iBlockStart, iBlockStart + iCurrentBlockSize, -1, -1) +=          // A2  +=
+                  matA1 *                                                           // A1  *
+                  (transpose(matT(0,0, iCurrentBlockSize, iCurrentBlockSize)) *     // (T' *
+                   (transpose(matA1) *                                              // (A1' *
+                    A(iBlockStart, iBlockStart + iCurrentBlockSize, -1, -1)));      // A2))
               }
             // The remaining part is small. Use the reflector vectors
             // directly.
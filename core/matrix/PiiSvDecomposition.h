@@ -18,15 +18,36 @@
 
 #include "PiiPlaneRotation.h"
 #include "PiiQrDecomposition.h"
+#include <QVector>
+#include <QPair>
+#include <QtAlgorithms>
 
 namespace Pii
 {
+  /**
+   * Options for [svDecompose()].
+   *
+   * - `SvdThinU`, `SvdThinV` - calculate only the first min(m,n)
+   *   columns of U and V.
+   *
+   * - `SvdFullU`, `SvdFullV` - calculate U and V as full square
+   *   matrices.
+   *
+   * - `SvdOneSidedJacobi` - use the one-sided Jacobi algorithm. It
+   *   orthogonalizes the columns of the (QR-reduced) input with
+   *   plane rotations. Independent pairs of columns are rotated in
+   *   parallel, and each rotation accesses memory contiguously. This
+   *   is faster than the default two-sided method on large matrices
+   *   and multi-core machines. The results are equal up to
+   *   round-off errors.
+   */
   enum SvdOption
     {
       SvdThinU = 0,
       SvdThinV = 0,
       SvdFullU = 1,
-      SvdFullV = 2
+      SvdFullV = 2,
+      SvdOneSidedJacobi = 4
     };
   Q_DECLARE_FLAGS(SvdOptions, SvdOption);
 }
@@ -60,6 +81,225 @@ namespace Pii
     leftRotation = rotation * transpose(rightRotation);
   }
 
+  // Rotates the pairs of rows of W given in *pairs* so that they
+  // become orthogonal and applies the same rotations to the rows of V
+  // (one-sided Jacobi). The pairs must be disjoint so that they can be
+  // processed in parallel.
+  template <class Real> struct JacobiRowRotator
+  {
+    JacobiRowRotator(PiiMatrix<Real>& W, PiiMatrix<Real>& V, const int* pairs, Real tolerance, int* rotations) :
+      W(W), V(V), pairs(pairs), tolerance(tolerance), rotations(rotations)
+    {}
+
+    static void rotate(Real* p, Real* q, int n, Real c, Real s)
+    {
+      for (int i=0; i<n; ++i)
+        {
+          const Real tmp = p[i];
+          p[i] = c * tmp - s * q[i];
+          q[i] = s * tmp + c * q[i];
+        }
+    }
+
+    void operator() (int block, int firstPair, int lastPair)
+    {
+      const int iRows = W.rows(), iCols = W.columns();
+      int iRotations = 0;
+      for (int i=firstPair; i<lastPair; ++i)
+        {
+          const int p = pairs[2*i], q = pairs[2*i+1];
+          // Odd sizes are padded with a dummy row.
+          if (p >= iRows || q >= iRows)
+            continue;
+          Real* pP = W[p], *pQ = W[q];
+          Real alpha = 0, beta = 0, gamma = 0;
+          for (int c=0; c<iCols; ++c)
+            {
+              alpha += pP[c] * pP[c];
+              beta += pQ[c] * pQ[c];
+              gamma += pP[c] * pQ[c];
+            }
+          if (gamma == 0 || abs(gamma) <= tolerance * Pii::sqrt(alpha * beta))
+            continue;
+          ++iRotations;
+          const Real zeta = (beta - alpha) / (2 * gamma);
+          const Real t = (zeta >= 0 ? Real(1) : Real(-1)) / (abs(zeta) + Pii::sqrt(1 + zeta * zeta));
+          const Real c = Real(1) / Pii::sqrt(1 + t * t), s = c * t;
+          rotate(pP, pQ, iCols, c, s);
+          rotate(V[p], V[q], V.columns(), c, s);
+        }
+      rotations[block] += iRotations;
+    }
+
+    PiiMatrix<Real>& W;
+    PiiMatrix<Real>& V;
+    const int* pairs;
+    Real tolerance;
+    int* rotations;
+  };
+
+  /// @internal
+  template <class Real>
+  PiiMatrix<Real> jacobiSvDecomposeSquare(PiiMatrix<Real>& R, PiiMatrix<Real>* U, PiiMatrix<Real>* V)
+  {
+    const int iSize = R.rows();
+    // Columns of R are stored as the rows of W, and the rotations are
+    // accumulated to the rows of V'.
+    PiiMatrix<Real> matW(transpose(R));
+    PiiMatrix<Real> matVt(iSize, iSize);
+    setIdentity(matVt);
+
+    /* Round-robin ordering: every pair of indices is visited once in
+       iPlayers-1 rounds, and the iPlayers/2 pairs of each round are
+       disjoint.
+    */
+    const int iPlayers = iSize + (iSize & 1), iPairs = iPlayers / 2;
+    QVector<int> vecPairs;
+    QVector<int> vecPlayers(iPlayers);
+    for (int i=0; i<iPlayers; ++i)
+      vecPlayers[i] = i;
+    for (int iRound=0; iRound<iPlayers-1; ++iRound)
+      {
+        for (int i=0; i<iPairs; ++i)
+          vecPairs << qMin(vecPlayers[i], vecPlayers[iPlayers-1-i])
+                   << qMax(vecPlayers[i], vecPlayers[iPlayers-1-i]);
+        // Keep the first one fixed and rotate the rest.
+        int iLast = vecPlayers[iPlayers-1];
+        for (int i=iPlayers-1; i>1; --i)
+          vecPlayers[i] = vecPlayers[i-1];
+        if (iPlayers > 1)
+          vecPlayers[1] = iLast;
+      }
+
+    const int iBlocks = parallelBlockCount(iPairs, qMax(1, 8192 / qMax(iSize, 1)));
+    QVector<int> vecRotations(iBlocks);
+    const Real tolerance = epsilon<Real>() * qMax(iSize, 2);
+    for (int iSweep=0; iSweep<100; ++iSweep)
+      {
+        int iTotalRotations = 0;
+        for (int iRound=0; iRound<iPlayers-1; ++iRound)
+          {
+            vecRotations.fill(0);
+            JacobiRowRotator<Real> rotator(matW, matVt, vecPairs.constData() + iRound*iPlayers,
+                                           tolerance, vecRotations.data());
+            parallelForBlocks(0, iPairs, iBlocks, rotator);
+            for (int i=0; i<iBlocks; ++i)
+              iTotalRotations += vecRotations[i];
+          }
+        if (iTotalRotations == 0)
+          break;
+      }
+
+    // The singular values are the norms of the columns. Sort them in
+    // descending order.
+    PiiMatrix<Real> matSingularValues(1, iSize);
+    QVector<QPair<Real,int> > vecOrder(iSize);
+    for (int i=0; i<iSize; ++i)
+      vecOrder[i] = qMakePair(-Pii::sqrt(innerProductN(matW[i], iSize, matW[i], Real(0))), i);
+    qSort(vecOrder);
+
+    if (U != 0)
+      U->resize(iSize, iSize);
+    if (V != 0)
+      V->resize(iSize, iSize);
+    for (int i=0; i<iSize; ++i)
+      {
+        const Real singularValue = -vecOrder[i].first;
+        const int iSource = vecOrder[i].second;
+        matSingularValues(0,i) = singularValue;
+        if (V != 0)
+          copyN(matVt[iSource], iSize, V->columnBegin(i));
+        if (U != 0)
+          {
+            typename PiiMatrix<Real>::column_iterator column = U->columnBegin(i);
+            const Real* pW = matW[iSource];
+            for (int r=0; r<iSize; ++r)
+              column[r] = singularValue != 0 ? pW[r] / singularValue : Real(0);
+          }
+      }
+
+    // Complete U with an orthonormal basis for the null space.
+    if (U != 0)
+      {
+        for (int i=0; i<iSize; ++i)
+          {
+            if (matSingularValues(0,i) != 0)
+              continue;
+            for (int j=0; j<iSize; ++j)
+              {
+                typename PiiMatrix<Real>::column_iterator column = U->columnBegin(i);
+                fillN(column, iSize, Real(0));
+                column[j] = 1;
+                // Gram-Schmidt twice for numerical stability
+                for (int iPass=0; iPass<2; ++iPass)
+                  for (int k=0; k<iSize; ++k)
+                    if (k != i && (k < i || matSingularValues(0,k) != 0))
+                      {
+                        Real dot = innerProductN(U->columnBegin(k), iSize, column, Real(0));
+                        for (int r=0; r<iSize; ++r)
+                          column[r] -= dot * (*U)(r,k);
+                      }
+                Real norm = Pii::sqrt(innerProductN(column, iSize, column, Real(0)));
+                if (norm > Real(0.5))
+                  {
+                    for (int r=0; r<iSize; ++r)
+                      column[r] /= norm;
+                    break;
+                  }
+              }
+          }
+      }
+    return matSingularValues;
+  }
+
+  /**
+   * Calculates the Singular Value Decomposition of *A* using the
+   * one-sided Jacobi method. Usually, this function is called
+   * through [svDecompose()] with the `SvdOneSidedJacobi` option. The
+   * parameters are the same as those of [svDecompose()].
+   */
+  template <class Matrix>
+  PiiMatrix<typename Matrix::value_type> jacobiSvDecompose(const Matrix& A,
+                                                           PiiMatrix<typename Matrix::value_type>* U,
+                                                           PiiMatrix<typename Matrix::value_type>* V,
+                                                           SvdOptions options = SvdFullU | SvdFullV)
+  {
+    typedef typename Matrix::value_type Real;
+    const int iRows = A.rows(), iCols = A.columns();
+    // A' = VSU'
+    if (iRows < iCols)
+      {
+        SvdOptions transposedOptions = 0;
+        if (options & SvdFullU) transposedOptions |= SvdFullV;
+        if (options & SvdFullV) transposedOptions |= SvdFullU;
+        return jacobiSvDecompose(PiiMatrix<Real>(transpose(A)), V, U, transposedOptions);
+      }
+
+    if (iRows == iCols)
+      {
+        PiiMatrix<Real> matR(A);
+        return jacobiSvDecomposeSquare(matR, U, V);
+      }
+
+    // Reduce to a square problem: A = QR = Q(U_r S V') -> U = QU_r
+    PiiMatrix<Real> matR;
+    PiiMatrix<Real> matQ(qrDecompose(A, &matR, options & SvdFullU ? UnpackFullQR : UnpackEconomyQR));
+    matR.resize(iCols, iCols);
+    PiiMatrix<Real> matUr;
+    PiiMatrix<Real> matSingularValues(jacobiSvDecomposeSquare(matR, U != 0 ? &matUr : 0, V));
+    if (U != 0)
+      {
+        if (options & SvdFullU)
+          {
+            *U = matQ;
+            (*U)(0, 0, -1, iCols) << PiiMatrix<Real>(matQ(0, 0, -1, iCols) * matUr);
+          }
+        else
+          *U = matQ * matUr;
+      }
+    return matSingularValues;
+  }
+
   /**
    *
    * This version requires a preallocated temporary storage *tmp*, a
@@ -73,6 +313,9 @@ namespace Pii
                                                      SvdOptions options = SvdFullU | SvdFullV)
   {
     typedef typename Matrix::value_type Real;
+    if (options & SvdOneSidedJacobi)
+      return jacobiSvDecompose(A, U, V, options);
+
     const int iRows = A.rows(), iCols = A.columns();
     const int iMinSize = tmp.rows();
     // 2 * epsilon is enough
@@ -57,6 +57,15 @@ class PiiNetworkClient;
   }
 #define PII_CREATE_REMOTE_CALL(N, PARAMS) PII_CREATE_REMOTE_CALL_IMPL(call, N, PARAMS)
 #define PII_CREATE_REMOTE_CALLBACK(N, PARAMS) PII_CREATE_REMOTE_CALL_IMPL(callBack, N, PARAMS)
+#define PII_CREATE_REMOTE_ASYNC_CALL(N, PARAMS)                         \
+  template <PII_FOR_N_SEP(PII_REMOTE_CALL_TPL_PARAM, PII_COMMA_SEP, N, PARAMS) > \
+  PiiRemoteFuture callAsync(const QString& function                     \
+                            PII_FOR_N(PII_REMOTE_CALL_FUNC_PARAM, N, PARAMS)) \
+  {                                                                     \
+    QVariantList lstParams;                                             \
+    lstParams PII_FOR_N(PII_REMOTE_CALL_LIST_PARAM, N, PARAMS);         \
+    return callListAsync(function, lstParams);                          \
+  }
 /// @endhide
 class PiiGenericFunction;
 
@@ -16,6 +16,7 @@
 #include "PiiNetworkServer.h"
 #include "PiiNetworkServerThread.h"
 #include <QIODevice>
+#include <PiiThreadUtil.h>
 
 PiiNetworkServer::Data::Data(PiiNetworkProtocol* protocol) :
   iMinWorkers(0), iMaxWorkers(10),
@@ -73,6 +74,7 @@ bool PiiNetworkServer::start()
     {
       PiiNetworkServerThread *newWorker = createWorker(d->pProtocol);
       newWorker->setController(this);
+      newWorker->setCpus(d->lstCpus);
       d->lstFreeThreads << newWorker;
     }
 
@@ -197,6 +199,7 @@ void PiiNetworkServer::incomingConnection(PiiGenericSocketDescriptor socketDescr
       // separately for each client.
       PiiNetworkServerThread *newWorker = createWorker(d->pProtocol);
       newWorker->setController(this);
+      newWorker->setCpus(d->lstCpus);
       newWorker->startRequest(socketDescriptor);
       d->lstAllThreads << newWorker;
     }
@@ -244,4 +247,6 @@ void PiiNetworkServer::setMaxPendingConnections(int maxPendingConnections) { d->
 int PiiNetworkServer::maxPendingConnections() const { return d->iMaxPendingConnections; }
 void PiiNetworkServer::setBusyMessage(const QString& busyMessage) { d->aBusyMessage = busyMessage.toUtf8(); }
 QString PiiNetworkServer::busyMessage() const { return QString::fromUtf8(d->aBusyMessage.constData(), d->aBusyMessage.size()); }
+void PiiNetworkServer::setCpuAffinity(const QString& cpuAffinity) { d->lstCpus = Pii::parseCpuList(cpuAffinity); }
+QString PiiNetworkServer::cpuAffinity() const { return Pii::cpuListToString(d->lstCpus); }
 PiiNetworkProtocol* PiiNetworkServer::protocol() const { return d->pProtocol; }
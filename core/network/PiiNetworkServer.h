@@ -96,6 +96,15 @@ class PII_NETWORK_EXPORT PiiNetworkServer :
    */
   Q_PROPERTY(QString busyMessage READ busyMessage WRITE setBusyMessage);
 
+  /**
+   * The processor cores worker threads are allowed to run on, for
+   * example "0-3,8". See [Pii::parseCpuList()] for the format. An
+   * empty string (the default) lets the operating system freely
+   * place the threads. Changes take effect on worker threads created
+   * after the change.
+   */
+  Q_PROPERTY(QString cpuAffinity READ cpuAffinity WRITE setCpuAffinity);
+
 public:
   /**
    * Interrupts all open connections and destroys the server.
@@ -141,6 +150,8 @@ public:
   int maxPendingConnections() const;
   void setBusyMessage(const QString& busyMessage);
   QString busyMessage() const;
+  void setCpuAffinity(const QString& cpuAffinity);
+  QString cpuAffinity() const;
 
   /**
    * Get the communication protocol.
@@ -174,6 +185,7 @@ protected:
     int iWorkerMaxIdleTime;
     int iMaxPendingConnections;
     QByteArray aBusyMessage;
+    QList<int> lstCpus;
 
     QMutex threadListLock;
     QList<PiiNetworkServerThread*> lstFreeThreads, lstAllThreads, lstFinishedThreads;
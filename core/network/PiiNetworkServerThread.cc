@@ -16,6 +16,7 @@
 #include "PiiNetworkServerThread.h"
 #include <QIODevice>
 #include <QCoreApplication>
+#include <PiiThreadUtil.h>
 
 PiiNetworkServerThread::Data::Data(PiiNetworkProtocol* protocol) :
   pProtocol(protocol->clone()),
@@ -70,6 +71,9 @@ bool PiiNetworkServerThread::canContinue(double /*percentage*/) const
 
 void PiiNetworkServerThread::run()
 {
+  if (!d->lstCpus.isEmpty())
+    Pii::bindThread(d->lstCpus);
+
   while (d->bRunning)
     {
       // Wait for a wake-up signal. If we got no new clients within
@@ -98,3 +102,5 @@ void PiiNetworkServerThread::setController(Controller* controller) { d->pControl
 PiiNetworkServerThread::Controller* PiiNetworkServerThread::controller() const { return d->pController; }
 void PiiNetworkServerThread::setMaxIdleTime(int maxIdleTime) { d->iMaxIdleTime = maxIdleTime; }
 int PiiNetworkServerThread::maxIdleTime() const { return d->iMaxIdleTime; }
+void PiiNetworkServerThread::setCpus(const QList<int>& cpus) { d->lstCpus = cpus; }
+QList<int> PiiNetworkServerThread::cpus() const { return d->lstCpus; }
@@ -133,6 +133,16 @@ public:
    */
   int maxIdleTime() const;
 
+  /**
+   * Sets the CPUs the thread will be bound to when it starts. An
+   * empty list (the default) leaves the thread unbound.
+   */
+  void setCpus(const QList<int>& cpus);
+  /**
+   * Returns the CPUs the thread will be bound to.
+   */
+  QList<int> cpus() const;
+
 protected:
   void run();
 
@@ -149,6 +159,7 @@ private:
     PiiWaitCondition requestCondition;
     volatile bool bRunning, bInterrupted;
     int iMaxIdleTime;
+    QList<int> lstCpus;
   } *d;
 };
 
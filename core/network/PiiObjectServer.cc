@@ -118,7 +118,7 @@ void PiiObjectServer::removeFunctions(FunctionList& lst)
 
 QStringList PiiObjectServer::listRoot() const
 {
-  return QStringList() << "functions/" << "callbacks/" << "channels/" << "ping" << "id";
+  return QStringList() << "functions/" << "callbacks/" << "channels/" << "ping" << "id" << "batch";
 }
 
 // handles requests to /channels/
@@ -195,6 +195,75 @@ void PiiObjectServer::createExceptionResponse(PiiHttpDevice* dev, const PiiExcep
     }
 }
 
+void PiiObjectServer::handleBatch(PiiHttpDevice* dev)
+{
+  QVariantList lstCalls;
+  try
+    {
+      lstCalls = PiiNetwork::fromByteArray<QVariantList>(dev->readBody());
+    }
+  catch (PiiSerializationException& ex)
+    {
+      PII_THROW_HTTP_ERROR_MSG(BadRequestStatus, ex.message() + " (" + ex.info() + ")");
+    }
+
+  QVariantList lstResults;
+  for (int i=0; i<lstCalls.size(); ++i)
+    {
+      QVariantList lstCall = lstCalls[i].toList();
+      if (lstCall.size() != 2)
+        PII_THROW_HTTP_ERROR_MSG(BadRequestStatus, tr("Batch entry %1 is not a (path, parameters) pair.").arg(i));
+
+      QString strPath = lstCall[0].toString();
+      QVariantList lstParams = lstCall[1].toList();
+      int iStatus = PiiHttpProtocol::OkStatus;
+      QVariant varResult;
+      // Each call succeeds or fails independently of the others.
+      try
+        {
+          varResult = callBatched(dev, strPath, lstParams);
+        }
+      catch (PiiHttpException& ex)
+        {
+          iStatus = ex.statusCode();
+          varResult = ex.message();
+        }
+      catch (PiiException& ex)
+        {
+          try
+            {
+              varResult = PiiNetwork::toByteArray(&ex, PiiNetwork::BinaryFormat);
+              iStatus = PiiNetwork::RemoteExceptionStatus;
+            }
+          catch (PiiException& ex2)
+            {
+              iStatus = PiiHttpProtocol::InternalServerErrorStatus;
+              varResult = tr("Could not encode the exception thrown by a function.\n"
+                             "%1\n"
+                             "The original error was: %2")
+                .arg(ex2.message())
+                .arg(ex.message());
+            }
+        }
+      catch (...)
+        {
+          iStatus = PiiHttpProtocol::InternalServerErrorStatus;
+          varResult = tr("Uncaught exception while processing function call.");
+        }
+      lstResults << QVariant(QVariantList() << iStatus << varResult);
+    }
+
+  dev->write(PiiNetwork::toByteArray(lstResults, PiiNetwork::BinaryFormat));
+}
+
+QVariant PiiObjectServer::callBatched(PiiHttpDevice* dev, const QString& path, QVariantList& params)
+{
+  Q_UNUSED(dev);
+  if (path.startsWith("functions/") && path.size() > 10)
+    return call(path.mid(10), params);
+  PII_THROW_HTTP_ERROR(NotFoundStatus);
+}
+
 void PiiObjectServer::handleRequest(const QString& uri, PiiHttpDevice* dev,
                                     PiiHttpProtocol::TimeLimiter* controller)
 {
@@ -227,6 +296,12 @@ void PiiObjectServer::handleRequest(const QString& uri, PiiHttpDevice* dev,
           dev->print(id());
           return;
         }
+      if (strRequestPath == "batch")
+        {
+          PII_REQUIRE_HTTP_METHOD("POST");
+          handleBatch(dev); // may throw
+          return;
+        }
       PII_THROW_HTTP_ERROR(NotFoundStatus);
     }
 
@@ -92,6 +92,7 @@
  * channels/
  * ping
  * id
+ * batch
  * ~~~
  *
  *
@@ -236,6 +237,26 @@
  * sure it is talking to the right object instance even after lost or
  * rerouted connection. Making a GET request to /id will return the ID
  * of the remote object.
+ *
+ * Batches
+ * -------
+ *
+ * Many calls can be executed with a single request by POSTing them
+ * to /batch. The body of the request is a binary-encoded
+ * QVariantList (see [PiiNetwork::toByteArray()]) whose entries are
+ * (path, parameters) pairs, each stored as a QVariantList. The path
+ * is relative to the root of the server object, e.g.
+ * "functions/plus". The calls are executed in order, and the server
+ * responds with a QVariantList that contains a (status, value) pair
+ * for each call. If the status is 200, the value is the return value
+ * of the call. If the call threw an exception, the status is
+ * [PiiNetwork::RemoteExceptionStatus] and the value is the
+ * serialized exception as a QByteArray. Otherwise, the value is an
+ * error message. A failing call does not prevent the rest of the
+ * batch from being executed.
+ *
+ * By default, only function calls can be batched. Subclasses can
+ * make other resources available by overriding [callBatched()].
  */
 class PII_NETWORK_EXPORT PiiObjectServer :
   public QObject,
@@ -593,6 +614,30 @@ protected:
    */
   virtual QVariant call(const QString& function, QVariantList& params);
 
+  /**
+   * Executes a single entry of a batch request (see [Batches]). The
+   * default implementation passes "functions/name" to [call()].
+   * Subclasses can override this function to make other resources
+   * accessible in batches.
+   *
+   * @param dev the device that received the batch request. The
+   * request body has already been read.
+   *
+   * @param path the path of the resource relative to the root of the
+   * server, e.g. "functions/plus".
+   *
+   * @param params call parameters, may be modified by the call
+   *
+   * @return the result of the call, or an invalid variant if there
+   * is none.
+   *
+   * @exception PiiHttpException& with `NotFoundStatus` if *path*
+   * cannot be batched.
+   *
+   * @exception Any other exception if the call fails.
+   */
+  virtual QVariant callBatched(PiiHttpDevice* dev, const QString& path, QVariantList& params);
+
   /**
    * Connects the pushable the source identified by *sourceId* to
    * *channel*. The default implementation assumes that *sourceId* is
@@ -665,6 +710,7 @@ protected:
 private:
   void init();
   void createExceptionResponse(PiiHttpDevice* dev, const PiiException& ex);
+  void handleBatch(PiiHttpDevice* dev);
   QString createNewChannel(const QString& clientId);
   inline ChannelImpl* channelById(const QString& id);
   void killChannels();
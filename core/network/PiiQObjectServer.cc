@@ -450,25 +450,13 @@ void PiiQObjectServer::handleRequest(const QString& uri, PiiHttpDevice* dev,
             dev->decodeVariant(dev->readBody()) :
             dev->decodeVariant(QUrl::fromPercentEncoding(dev->queryString().toUtf8()));
 
-          QVariant varFinalValue = setObjectProperty(strPropName, varInputValue);
+          QVariant varFinalValue = changeProperty(dev, strPropName, varInputValue); // may throw
           // TODO volatile property values don't need to be sent back
-          if (!varFinalValue.isValid())
-            PII_THROW_HTTP_ERROR(BadRequestStatus);
 
           // If the value wasn't set to the received value, tell the
           // client the real value.
           if (!Pii::equals(varInputValue, varFinalValue))
             dev->write(dev->encode(varFinalValue)); // TODO: check if we could use binary format
-
-          // Inform all other clients about the change, if the
-          // property is implicity notified (has no native
-          // notification signal).
-          QMap<QString, QString>::const_iterator it = d->mapNotifiedProps.constFind(strPropName);
-          if (it != d->mapNotifiedProps.constEnd())
-            sendToOtherClients(dev->requestHeader().value("X-Client-ID"),
-                               "signals/" + *it,
-                               PiiNetwork::toByteArray(QVariantList() << varFinalValue,
-                                                       PiiNetwork::BinaryFormat));
         }
     }
   else if (strRequestPath.startsWith("signals/"))
@@ -515,6 +503,43 @@ void PiiQObjectServer::handleRequest(const QString& uri, PiiHttpDevice* dev,
     PiiObjectServer::handleRequest(uri, dev, controller);
 }
 
+QVariant PiiQObjectServer::changeProperty(PiiHttpDevice* dev, const QString& name, const QVariant& value)
+{
+  PII_D;
+  QVariant varFinalValue = setObjectProperty(name, value);
+  if (!varFinalValue.isValid())
+    PII_THROW_HTTP_ERROR(BadRequestStatus);
+
+  // Inform all other clients about the change, if the property is
+  // implicity notified (has no native notification signal).
+  QMap<QString, QString>::const_iterator it = d->mapNotifiedProps.constFind(name);
+  if (it != d->mapNotifiedProps.constEnd())
+    sendToOtherClients(dev->requestHeader().value("X-Client-ID"),
+                       "signals/" + *it,
+                       PiiNetwork::toByteArray(QVariantList() << varFinalValue,
+                                               PiiNetwork::BinaryFormat));
+  return varFinalValue;
+}
+
+QVariant PiiQObjectServer::callBatched(PiiHttpDevice* dev, const QString& path, QVariantList& params)
+{
+  PII_D;
+  // properties/name reads a property, properties/name with a single
+  // parameter sets it and returns the final value.
+  if (path.startsWith("properties/") && path.size() > 11)
+    {
+      if (!(d->features & (ExposeProperties | ExposeDynamicProperties)))
+        PII_THROW_HTTP_ERROR(NotFoundStatus);
+      QString strPropName = path.mid(11);
+      if (params.isEmpty())
+        return objectProperty(strPropName);
+      if (params.size() != 1)
+        PII_THROW_HTTP_ERROR(BadRequestStatus);
+      return changeProperty(dev, strPropName, params[0]);
+    }
+  return PiiObjectServer::callBatched(dev, path, params);
+}
+
 QStringList PiiQObjectServer::listRoot() const
 {
   QStringList lstFolders = PiiObjectServer::listRoot();
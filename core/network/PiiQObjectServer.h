@@ -374,6 +374,14 @@ public:
   }
 
 protected:
+  /**
+   * Makes properties accessible in batch requests in addition to
+   * functions. A batch entry with the path "properties/name" and no
+   * parameters reads a property, and one with a single parameter
+   * sets it. The final value of the property will be returned in
+   * both cases.
+   */
+  QVariant callBatched(PiiHttpDevice* dev, const QString& path, QVariantList& params);
   void connectToChannel(Channel* channel, const QString& sourceId);
   void disconnectFromChannel(Channel* channel, const QString& sourceId);
   void channelDeleted(Channel* channel);
@@ -455,6 +463,7 @@ private:
   QVariant objectProperty(const QString& name);
   bool setObjectProperties(const QVariantMap& props);
   QVariant setObjectProperty(const QString& name, const QVariant& value);
+  QVariant changeProperty(PiiHttpDevice* dev, const QString& name, const QVariant& value);
   ChannelSlot* findSlot(const QString& signal) const;
   template <class Enum> Enum stringToEnum(const char* enumName, const QString& str) const;
 };
@@ -0,0 +1,134 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "PiiRemoteFuture.h"
+#include "PiiNetworkException.h"
+
+#include <PiiTimer.h>
+
+#include "PiiNetworkEncoding.h"
+
+PiiRemoteFuture::Data::Data(bool finished) :
+  bFinished(finished)
+{}
+
+PiiRemoteFuture::PiiRemoteFuture() :
+  d(new Data(true))
+{}
+
+PiiRemoteFuture::PiiRemoteFuture(bool finished) :
+  d(new Data(finished))
+{}
+
+PiiRemoteFuture::PiiRemoteFuture(const PiiRemoteFuture& other) :
+  d(other.d)
+{
+  d->reserve();
+}
+
+PiiRemoteFuture::~PiiRemoteFuture()
+{
+  d->release();
+}
+
+PiiRemoteFuture& PiiRemoteFuture::operator= (const PiiRemoteFuture& other)
+{
+  other.d->assignTo(d);
+  return *this;
+}
+
+bool PiiRemoteFuture::isFinished() const
+{
+  QMutexLocker lock(&d->mutex);
+  return d->bFinished;
+}
+
+bool PiiRemoteFuture::waitForFinished(int msecs) const
+{
+  QMutexLocker lock(&d->mutex);
+  if (msecs < 0)
+    {
+      while (!d->bFinished)
+        d->finishedCondition.wait(&d->mutex);
+    }
+  else
+    {
+      PiiTimer timer;
+      int iElapsed = 0;
+      while (!d->bFinished && (iElapsed = timer.milliseconds()) < msecs)
+        d->finishedCondition.wait(&d->mutex, msecs - iElapsed);
+    }
+  return d->bFinished;
+}
+
+QVariant PiiRemoteFuture::result() const
+{
+  waitForFinished();
+  // The result never changes once the call has finished.
+  if (!d->aException.isEmpty())
+    {
+      PiiException* pException = PiiNetwork::fromByteArray<PiiException*>(d->aException); // may throw
+      pException->throwIt(); // throws
+    }
+  if (!d->strError.isEmpty())
+    PII_THROW(PiiNetworkException, d->strError);
+  return d->varResult;
+}
+
+void PiiRemoteFuture::setResult(const QVariant& result)
+{
+  QMutexLocker lock(&d->mutex);
+  d->varResult = result;
+  finish();
+}
+
+void PiiRemoteFuture::setException(const QByteArray& exceptionData)
+{
+  QMutexLocker lock(&d->mutex);
+  if (!exceptionData.isEmpty())
+    d->aException = exceptionData;
+  else
+    d->strError = tr("The remote function threw an exception, but no data was received.");
+  finish();
+}
+
+void PiiRemoteFuture::setException(const PiiException& exception)
+{
+  QByteArray aData;
+  try
+    {
+      aData = PiiNetwork::toByteArray(&exception, PiiNetwork::BinaryFormat);
+    }
+  catch (PiiException&)
+    {
+      setError(exception.message());
+      return;
+    }
+  setException(aData);
+}
+
+void PiiRemoteFuture::setError(const QString& message)
+{
+  QMutexLocker lock(&d->mutex);
+  d->strError = message;
+  finish();
+}
+
+// d->mutex must be held when calling this function
+void PiiRemoteFuture::finish()
+{
+  d->bFinished = true;
+  d->finishedCondition.wakeAll();
+}
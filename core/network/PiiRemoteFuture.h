@@ -0,0 +1,114 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIREMOTEFUTURE_H
+#define _PIIREMOTEFUTURE_H
+
+#include "PiiNetwork.h"
+#include <PiiSharedD.h>
+#include <PiiException.h>
+
+#include <QVariant>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QCoreApplication>
+
+/**
+ * The result of an asynchronous remote call. PiiRemoteFuture is
+ * returned by [PiiRemoteObject::callAsync()] and
+ * [PiiRemoteObject::callBatch()]. The result becomes available once
+ * the server has responded. Copies of a future share the same
+ * result.
+ *
+ * ~~~(c++)
+ * PiiRemoteObject obj("tcp://localhost:3142/myClass/");
+ * PiiRemoteFuture sum = obj.callAsync("functions/plus", 1, 2);
+ * PiiRemoteFuture hello = obj.callAsync("functions/hello");
+ * // Do something else meanwhile...
+ * int iSum = sum.value<int>();
+ * QString strHello = hello.value<QString>();
+ * ~~~
+ */
+class PII_NETWORK_EXPORT PiiRemoteFuture
+{
+public:
+  /**
+   * Creates a finished future with an invalid result.
+   */
+  PiiRemoteFuture();
+  PiiRemoteFuture(const PiiRemoteFuture& other);
+  ~PiiRemoteFuture();
+
+  PiiRemoteFuture& operator= (const PiiRemoteFuture& other);
+
+  /**
+   * Returns `true` if the call has finished, either successfully or
+   * with an error, and `false` otherwise.
+   */
+  bool isFinished() const;
+
+  /**
+   * Waits until the call has finished or *msecs* milliseconds have
+   * passed. If *msecs* is negative, waits forever. Returns `true` if
+   * the call has finished and `false` on time-out.
+   */
+  bool waitForFinished(int msecs = -1) const;
+
+  /**
+   * Waits until the call has finished and returns its return value.
+   * If the function has no return value, an invalid QVariant will be
+   * returned.
+   *
+   * @exception PiiException& if the remote function threw one. The
+   * type of the exception is retained as in [PiiRemoteObject::call()].
+   *
+   * @exception PiiNetworkException& if the call failed.
+   */
+  QVariant result() const;
+
+  /**
+   * Waits until the call has finished and returns its return value
+   * as an object of type `R`, which may be `void`. See [result()].
+   */
+  template <class R> R value() const { return PiiNetwork::returnValue<R>(result()); }
+
+private:
+  friend class PiiRemoteObject;
+
+  explicit PiiRemoteFuture(bool finished);
+
+  void setResult(const QVariant& result);
+  void setException(const QByteArray& exceptionData);
+  void setException(const PiiException& exception);
+  void setError(const QString& message);
+  void finish();
+
+  class Data : public PiiSharedD<Data>
+  {
+  public:
+    Data(bool finished);
+
+    QMutex mutex;
+    QWaitCondition finishedCondition;
+    bool bFinished;
+    QVariant varResult;
+    QByteArray aException;
+    QString strError;
+  } *d;
+
+  inline static QString tr(const char* s) { return QCoreApplication::translate("PiiRemoteFuture", s); }
+};
+
+#endif //_PIIREMOTEFUTURE_H
@@ -378,6 +378,52 @@ void PiiRemoteMetaObject::findPropertyChangeNotifiers()
     }
 }
 
+void PiiRemoteMetaObject::prefetchProperties(const QStringList& propertyNames)
+{
+  PII_D;
+  QList<Property*> lstProperties;
+  QList<QPair<QString,QVariantList> > lstCalls;
+  for (int i = 0; i < d->lstProperties.size(); ++i)
+    {
+      Property* pProp = d->lstProperties[i];
+      if (pProp->bVolatile ||
+          (!propertyNames.isEmpty() && !propertyNames.contains(pProp->strName)))
+        continue;
+      bool bCached = false;
+      synchronized (pProp->mutex) bCached = pProp->cachedValue.isValid();
+      if (bCached)
+        continue;
+      lstProperties << pProp;
+      lstCalls << qMakePair("properties/" + pProp->strName, QVariantList());
+    }
+  if (lstCalls.isEmpty())
+    return;
+
+  QList<PiiRemoteFuture> lstResults = callBatch(lstCalls);
+  for (int i = 0; i < lstProperties.size(); ++i)
+    {
+      Property& prop = *lstProperties[i];
+      QVariant varValue;
+      try
+        {
+          varValue = lstResults[i].result();
+        }
+      catch (PiiException& ex)
+        {
+          piiWarning(tr("Could not prefetch %1: %2").arg(prop.strName).arg(ex.message()));
+          continue;
+        }
+      QMutexLocker lock(&prop.mutex);
+      prop.cachedValue = varValue;
+      // Listen to changes to keep the cache up to date.
+      if (!prop.bListening)
+        {
+          prop.bListening = true;
+          connectSignal(prop.iNotifierIndex);
+        }
+    }
+}
+
 void PiiRemoteMetaObject::clearPropertyCache()
 {
   PII_D;
@@ -49,6 +49,16 @@ public:
 
   ~PiiRemoteMetaObject();
 
+  /**
+   * Reads the values of the given non-volatile properties from the
+   * server in a single request and stores them to the property
+   * cache. Properties that are already cached will not be read
+   * again. If *propertyNames* is empty, all non-volatile properties
+   * will be fetched. This function is useful if many properties are
+   * going to be accessed at once, because reading an uncached
+   * property otherwise requires a round trip to the server.
+   */
+  void prefetchProperties(const QStringList& propertyNames = QStringList());
   /**
    * Clears all cached properties.
    */
@@ -41,7 +41,11 @@ PiiRemoteObject::Data::Data() :
   iRetryDelay(2000),
   iMaxFailureCount(-1),
   strClientId(QUuid::createUuid().toString()),
-  pLocalServer(0)
+  pLocalServer(0),
+  pDispatcherThread(0),
+  bDispatching(false),
+  iMaxBatchSize(64),
+  bBatchSupported(true)
 {}
 
 PiiRemoteObject::PiiRemoteObject() : d(new Data)
@@ -62,6 +66,9 @@ PiiRemoteObject::PiiRemoteObject(Data* data, const QString& serverUri) : d(data)
 
 PiiRemoteObject::~PiiRemoteObject()
 {
+  // Pending asynchronous calls will still be sent.
+  stopDispatcher();
+
   // Explicitly close the channel on server side.
   synchronized (d->channelMutex)
     if (d->bChannelRunning)
@@ -515,6 +522,7 @@ void PiiRemoteObject::setServerUriImpl(const QString& uri)
 
   d->networkClient.setServerAddress(uriExp.cap(1));
   d->strPath = uriExp.cap(2);
+  d->bBatchSupported = true;
   if (d->strPath[d->strPath.size()-1] != '/')
     d->strPath.append('/');
 
@@ -612,6 +620,176 @@ QVariant PiiRemoteObject::callList(const QString& uri, const QVariantList& param
     }
 }
 
+PiiRemoteFuture PiiRemoteObject::callListAsync(const QString& uri, const QVariantList& params)
+{
+  QList<PendingCall> lstCalls;
+  lstCalls << PendingCall(uri, params, PiiRemoteFuture(false));
+
+  // A local server may need the main thread to process the call.
+  // Waiting for the future in the main thread would deadlock.
+  if (d->pLocalServer &&
+      QThread::currentThread() == qApp->thread())
+    {
+      executeCalls(lstCalls);
+      return lstCalls[0].future;
+    }
+
+  QMutexLocker lock(&d->asyncMutex);
+  if (d->pDispatcherThread == 0)
+    {
+      d->bDispatching = true;
+      d->pDispatcherThread = Pii::createAsyncCall(this, &PiiRemoteObject::dispatchCalls);
+      d->pDispatcherThread->start();
+    }
+  d->lstPendingCalls << lstCalls[0];
+  d->asyncCondition.wakeOne();
+  return lstCalls[0].future;
+}
+
+QList<PiiRemoteFuture> PiiRemoteObject::callBatch(const QList<QPair<QString,QVariantList> >& calls)
+{
+  QList<PendingCall> lstCalls;
+  QList<PiiRemoteFuture> lstResults;
+  for (int i=0; i<calls.size(); ++i)
+    {
+      lstCalls << PendingCall(calls[i].first, calls[i].second, PiiRemoteFuture(false));
+      lstResults << lstCalls[i].future;
+    }
+  executeCalls(lstCalls);
+  return lstResults;
+}
+
+void PiiRemoteObject::dispatchCalls()
+{
+  QMutexLocker lock(&d->asyncMutex);
+  forever
+    {
+      while (d->bDispatching && d->lstPendingCalls.isEmpty())
+        d->asyncCondition.wait(&d->asyncMutex);
+      // Send everything queued before stopping.
+      if (d->lstPendingCalls.isEmpty())
+        break;
+
+      // Everything that has accumulated while the previous request
+      // was in flight goes to the same batch.
+      QList<PendingCall> lstBatch = d->lstPendingCalls.mid(0, qMax(d->iMaxBatchSize, 1));
+      d->lstPendingCalls.erase(d->lstPendingCalls.begin(),
+                               d->lstPendingCalls.begin() + lstBatch.size());
+      lock.unlock();
+      executeCalls(lstBatch);
+      lock.relock();
+    }
+}
+
+void PiiRemoteObject::stopDispatcher()
+{
+  QMutexLocker lock(&d->asyncMutex);
+  if (d->pDispatcherThread == 0)
+    return;
+  d->bDispatching = false;
+  d->asyncCondition.wakeOne();
+  lock.unlock();
+  d->pDispatcherThread->wait();
+  lock.relock();
+  delete d->pDispatcherThread;
+  d->pDispatcherThread = 0;
+}
+
+void PiiRemoteObject::executeCalls(QList<PendingCall>& calls)
+{
+  if (calls.size() > 1 && d->bBatchSupported)
+    {
+      try
+        {
+          if (sendBatch(calls))
+            return;
+          // The server doesn't know about batches. Don't try again.
+          d->bBatchSupported = false;
+        }
+      catch (PiiException& ex)
+        {
+          addFailure();
+          closeConnection();
+          for (int i=0; i<calls.size(); ++i)
+            calls[i].future.setException(ex);
+          return;
+        }
+    }
+
+  for (int i=0; i<calls.size(); ++i)
+    {
+      try
+        {
+          calls[i].future.setResult(callList(calls[i].strUri, calls[i].lstParams));
+        }
+      catch (PiiException& ex)
+        {
+          calls[i].future.setException(ex);
+        }
+      catch (...)
+        {
+          calls[i].future.setError(tr("Unknown error in remote call."));
+        }
+    }
+}
+
+// Returns false if the server doesn't support batches.
+bool PiiRemoteObject::sendBatch(QList<PendingCall>& calls)
+{
+  QVariantList lstCalls;
+  for (int i=0; i<calls.size(); ++i)
+    lstCalls << QVariant(QVariantList() << calls[i].strUri << QVariant(calls[i].lstParams));
+
+  HttpDevicePtr pDev = openConnection();
+
+  pDev->setRequest("POST", d->strPath + "batch");
+  pDev->startOutputFiltering(new PiiStreamBuffer);
+  try { pDev->write(PiiNetwork::toByteArray(lstCalls, PiiNetwork::BinaryFormat)); }
+  catch (...) { finishRequest(pDev); throw; }
+  finishRequest(pDev);
+
+  PII_THROW_IF_NOT_CONNECTED;
+  if (!pDev->readHeader())
+    PII_THROW(PiiNetworkException, tr(PiiNetwork::pErrorReadingResponseHeader));
+
+  if (pDev->status() == PiiHttpProtocol::NotFoundStatus)
+    {
+      pDev->discardBody();
+      return false;
+    }
+  if (pDev->status() != PiiHttpProtocol::OkStatus)
+    PII_THROW(PiiNetworkException, tr(PiiNetwork::pServerRepliedWithStatus).arg(pDev->status()));
+
+  QVariantList lstResults = PiiNetwork::fromByteArray<QVariantList>(pDev->readBody()); // may throw
+  if (lstResults.size() != calls.size())
+    PII_THROW(PiiNetworkException, tr("Server returned %1 results to a batch of %2 calls.")
+              .arg(lstResults.size()).arg(calls.size()));
+
+  for (int i=0; i<calls.size(); ++i)
+    {
+      QVariantList lstResult = lstResults[i].toList();
+      int iStatus = lstResult.value(0).toInt();
+      QVariant varValue = lstResult.value(1);
+      switch (iStatus)
+        {
+        case PiiHttpProtocol::OkStatus:
+          calls[i].future.setResult(varValue);
+          break;
+        case PiiNetwork::RemoteExceptionStatus:
+          calls[i].future.setException(varValue.toByteArray());
+          break;
+        default:
+          {
+            QString strError = tr(PiiNetwork::pServerRepliedWithStatus).arg(iStatus);
+            if (!varValue.toString().isEmpty())
+              strError += " " + varValue.toString();
+            calls[i].future.setError(strError);
+          }
+        }
+    }
+  return true;
+}
+
 void PiiRemoteObject::setRetryCount(int retryCount) { d->iRetryCount = qBound(0,retryCount,5); }
 int PiiRemoteObject::retryCount() const { return d->iRetryCount; }
 void PiiRemoteObject::setRetryDelay(int retryDelay) { d->iRetryDelay = qBound(0,retryDelay,2000); }
@@ -626,4 +804,7 @@ void PiiRemoteObject::addFailure() { d->iFailureCount.ref(); }
 void PiiRemoteObject::setMaxFailureCount(int maxFailureCount) { d->iMaxFailureCount = maxFailureCount; }
 int PiiRemoteObject::maxFailureCount() const { return d->iMaxFailureCount; }
 
+void PiiRemoteObject::setMaxBatchSize(int maxBatchSize) { synchronized (d->asyncMutex) d->iMaxBatchSize = maxBatchSize; }
+int PiiRemoteObject::maxBatchSize() const { return d->iMaxBatchSize; }
+
 QString PiiRemoteObject::serverId() const { return d->strServerId; }
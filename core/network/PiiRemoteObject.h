@@ -35,6 +35,7 @@
 #include "PiiNetworkClient.h"
 #include "PiiHttpDevice.h"
 #include "PiiObjectServer.h"
+#include "PiiRemoteFuture.h"
 
 /**
  * PiiRemoteObject is a client for PiiObjectServer. It is used to call
@@ -61,6 +62,40 @@
  * obj.addCallback("callback", &h, &MyHandler::callback);
  * ~~~
  *
+ * Asynchronous calls
+ * ------------------
+ *
+ * Each call made with [call()] waits for a response from the server
+ * before returning. If many calls need to be made, the network
+ * round-trip time easily dominates. [callAsync()] returns
+ * immediately with a [PiiRemoteFuture] that will receive the result
+ * later. Asynchronous calls are sent to the server in order by a
+ * background thread that shares the persistent connection with
+ * synchronous calls. All calls that have been queued while the
+ * previous request was in flight are combined into a single batch
+ * request (see [PiiObjectServer]), up to [maxBatchSize()] calls at a
+ * time. If the server does not support batches, the calls will be
+ * sent one by one.
+ *
+ * ~~~(c++)
+ * QList<PiiRemoteFuture> lstResults;
+ * for (int i=0; i<100; ++i)
+ *   lstResults << obj.callAsync("functions/plus", i, 1);
+ * for (int i=0; i<lstResults.size(); ++i)
+ *   piiDebug("%d", lstResults[i].value<int>());
+ * ~~~
+ *
+ * [callBatch()] sends an explicitly given set of calls as a single
+ * request and waits for the results. With [PiiQObjectServer],
+ * properties can be read and written in the same request.
+ *
+ * ~~~(c++)
+ * QList<QPair<QString,QVariantList> > lstCalls;
+ * lstCalls << qMakePair(QString("properties/number"), QVariantList())
+ *          << qMakePair(QString("functions/hello"), QVariantList());
+ * QList<PiiRemoteFuture> lstResults = obj.callBatch(lstCalls);
+ * int iNumber = lstResults[0].value<int>();
+ * ~~~
  */
 class PII_NETWORK_EXPORT PiiRemoteObject :
   private PiiProgressController
@@ -203,6 +238,61 @@ public:
 
   QVariant callList(const QString& function, const QVariantList& params);
 
+  /**
+   * @decl PiiRemoteFuture callAsync(const QString& function, ...)
+   *
+   * Calls the remote *function* with a variable number of parameters
+   * without waiting for the result. The call will be queued and sent
+   * to the server by a background thread. The returned future
+   * receives the return value of the function or the exception it
+   * threw. Calls are executed in the order they were made.
+   *
+   * If the server lives in the same process and the calling thread
+   * is the main thread, the call is executed synchronously, and the
+   * returned future is already finished.
+   *
+   * @exception PiiSerializationException& if function parameters
+   * could not be encoded. Errors in sending the call will be
+   * reported through the future.
+   */
+
+  /// @hide
+  PiiRemoteFuture callAsync(const QString& function)
+  {
+    return callListAsync(function, QVariantList());
+  }
+  PII_CREATE_REMOTE_ASYNC_CALL(1, (P1))
+  PII_CREATE_REMOTE_ASYNC_CALL(2, (P1,P2))
+  PII_CREATE_REMOTE_ASYNC_CALL(3, (P1,P2,P3))
+  PII_CREATE_REMOTE_ASYNC_CALL(4, (P1,P2,P3,P4))
+  PII_CREATE_REMOTE_ASYNC_CALL(5, (P1,P2,P3,P4,P5))
+  PII_CREATE_REMOTE_ASYNC_CALL(6, (P1,P2,P3,P4,P5,P6))
+  PII_CREATE_REMOTE_ASYNC_CALL(7, (P1,P2,P3,P4,P5,P6,P7))
+  PII_CREATE_REMOTE_ASYNC_CALL(8, (P1,P2,P3,P4,P5,P6,P7,P8))
+  /// @endhide
+
+  PiiRemoteFuture callListAsync(const QString& function, const QVariantList& params);
+
+  /**
+   * Sends all *calls* to the server in a single request and waits
+   * for the response. Each call is a pair of a path relative to the
+   * server's root (e.g. "functions/plus" or "properties/number") and
+   * a parameter list. Returns a finished future for each call in the
+   * same order. A failing call does not prevent the others from
+   * being executed.
+   *
+   * If the server does not support batches, the calls will be made
+   * one by one.
+   */
+  QList<PiiRemoteFuture> callBatch(const QList<QPair<QString,QVariantList> >& calls);
+
+  /**
+   * Sets the maximum number of queued asynchronous calls that will be
+   * combined into a single request. The default is 64.
+   */
+  void setMaxBatchSize(int maxBatchSize);
+  int maxBatchSize() const;
+
   /**
    * Returns the number of failures in remote calls since construction
    * or last reset. The count is incremented each time a remote
@@ -225,6 +315,17 @@ public:
   int maxFailureCount() const;
 
 protected:
+  /// @internal
+  struct PendingCall
+  {
+    PendingCall(const QString& uri, const QVariantList& params, const PiiRemoteFuture& f) :
+      strUri(uri), lstParams(params), future(f)
+    {}
+    QString strUri;
+    QVariantList lstParams;
+    PiiRemoteFuture future;
+  };
+
   /// @internal
   class PII_NETWORK_EXPORT Data
   {
@@ -251,6 +352,14 @@ protected:
     QString strServerId;
     QPointer<PiiObjectServer> pLocalServer;
     QBuffer buffer;
+
+    QMutex asyncMutex; // Must be held when accessing the fields below
+    QWaitCondition asyncCondition;
+    QThread* pDispatcherThread;
+    bool bDispatching;
+    QList<PendingCall> lstPendingCalls;
+    int iMaxBatchSize;
+    volatile bool bBatchSupported;
   } *d;
   /// @internal
   PiiRemoteObject(Data*);
@@ -334,6 +443,10 @@ private:
   bool canContinue(double progressPercentage) const;
   void setServerUriImpl(const QString& uri);
   void handleException(PiiHttpDevice* dev);
+  void dispatchCalls();
+  void stopDispatcher();
+  void executeCalls(QList<PendingCall>& calls);
+  bool sendBatch(QList<PendingCall>& calls);
 };
 
 
@@ -172,8 +172,8 @@ void PiiImageListModel::updateThumbnail(const QString& fileName, const QImage& i
     if (d->lstItems[i].fileName() == fileName)
       {
         d->lstItems[i].setIcon(QIcon(QPixmap::fromImage(image)));
-        //QModelIndex index = createIndex(i,0);
-        emit layoutChanged();
+        QModelIndex changedIndex(QAbstractListModel::index(i));
+        emit dataChanged(changedIndex, changedIndex);
       }
 }
 
@@ -184,3 +184,14 @@ QModelIndex PiiImageListModel::index(const QString& fileName) const
       return QAbstractListModel::index(i);
   return QModelIndex();
 }
+
+void PiiImageListModel::prioritizeThumbnails(const QList<int>& rows)
+{
+  QStringList lstFileNames;
+  for (int i=0; i<rows.size(); ++i)
+    if (rows[i] >= 0 && rows[i] < d->lstItems.size())
+      lstFileNames << d->lstItems[rows[i]].fileName();
+  d->thumbnailLoader.prioritize(lstFileNames);
+}
+
+PiiThumbnailLoader* PiiImageListModel::thumbnailLoader() const { return &d->thumbnailLoader; }
@@ -103,6 +103,19 @@ public:
    */
   QModelIndex index(const QString& fileName) const;
 
+  /**
+   * Moves the thumbnails of the given *rows* to the front of the
+   * thumbnail loading queue. Views call this function to get visible
+   * thumbnails loaded first.
+   */
+  void prioritizeThumbnails(const QList<int>& rows);
+
+  /**
+   * Returns the loader that creates thumbnails for the model. The
+   * loader can be used to configure thumbnail size and caching.
+   */
+  PiiThumbnailLoader* thumbnailLoader() const;
+
 public slots:
   /**
    * Update an icon to the item by the given fileName.
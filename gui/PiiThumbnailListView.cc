@@ -15,6 +15,7 @@
 
 #include "PiiThumbnailListView.h"
 #include <QMenu>
+#include <climits>
 
 #include <QtDebug>
 
@@ -32,6 +33,12 @@ PiiThumbnailListView::PiiThumbnailListView(QWidget *parent) :
 
   connect(this, SIGNAL(activated(const QModelIndex&)), this, SLOT(itemSelected(const QModelIndex&)));
   connect(this, SIGNAL(clicked(const QModelIndex&)), this, SLOT(itemSelected(const QModelIndex&)));
+
+  // Scrolling produces bursts of events. The visible items are
+  // prioritized once the view has settled.
+  d->prioritizationTimer.setSingleShot(true);
+  d->prioritizationTimer.setInterval(50);
+  connect(&d->prioritizationTimer, SIGNAL(timeout()), this, SLOT(prioritizeVisible()));
 }
 
 PiiThumbnailListView::~PiiThumbnailListView()
@@ -43,6 +50,73 @@ void PiiThumbnailListView::setModel(PiiImageListModel *model)
 {
   d->pModel = model;
   QListView::setModel(model);
+  if (model != 0)
+    connect(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)), this, SLOT(schedulePrioritization()));
+}
+
+void PiiThumbnailListView::scrollContentsBy(int dx, int dy)
+{
+  QListView::scrollContentsBy(dx, dy);
+  schedulePrioritization();
+}
+
+void PiiThumbnailListView::resizeEvent(QResizeEvent *e)
+{
+  QListView::resizeEvent(e);
+  schedulePrioritization();
+}
+
+void PiiThumbnailListView::schedulePrioritization()
+{
+  d->prioritizationTimer.start();
+}
+
+// Finds the item closest to *corner* by walking diagonally towards
+// the opposite corner of *rect*. The exact corner may hit the spacing
+// between items or empty space after the last one.
+static QModelIndex indexNear(const QAbstractItemView* view, const QRect& rect,
+                             const QPoint& corner, int dx, int dy)
+{
+  for (QPoint pt(corner); rect.contains(pt); pt += QPoint(dx, dy))
+    {
+      QModelIndex index(view->indexAt(pt));
+      if (index.isValid())
+        return index;
+    }
+  return QModelIndex();
+}
+
+void PiiThumbnailListView::prioritizeVisible()
+{
+  if (d->pModel == 0)
+    return;
+  QRect viewRect(viewport()->rect());
+  const int iStepX = qMax(1, gridSize().width() / 2),
+    iStepY = qMax(1, gridSize().height() / 2);
+
+  // Items are laid out in model order both in rows and in columns.
+  // The visible items thus lie between the first and the last item at
+  // the corners of the viewport.
+  QModelIndex corners[] =
+    {
+      indexNear(this, viewRect, viewRect.topLeft(), iStepX, iStepY),
+      indexNear(this, viewRect, viewRect.topRight(), -iStepX, iStepY),
+      indexNear(this, viewRect, viewRect.bottomLeft(), iStepX, -iStepY),
+      indexNear(this, viewRect, viewRect.bottomRight(), -iStepX, -iStepY)
+    };
+  int iFirst = INT_MAX, iLast = -1;
+  for (int i=0; i<4; ++i)
+    if (corners[i].isValid())
+      {
+        iFirst = qMin(iFirst, corners[i].row());
+        iLast = qMax(iLast, corners[i].row());
+      }
+
+  QList<int> lstRows;
+  for (int i=iFirst; i<=iLast; ++i)
+    if (visualRect(d->pModel->index(i, 0)).intersects(viewRect))
+      lstRows << i;
+  d->pModel->prioritizeThumbnails(lstRows);
 }
 
 void PiiThumbnailListView::mousePressEvent(QMouseEvent *e)
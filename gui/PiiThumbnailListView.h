@@ -19,6 +19,7 @@
 #include <QListView>
 #include <QPoint>
 #include <QMouseEvent>
+#include <QTimer>
 #include "PiiImageListModel.h"
 
 class PII_GUI_EXPORT PiiThumbnailListView : public QListView
@@ -46,10 +47,14 @@ signals:
 
 protected:
   void mousePressEvent(QMouseEvent *e);
+  void scrollContentsBy(int dx, int dy);
+  void resizeEvent(QResizeEvent *e);
 
 private slots:
   void removeCurrent();
   void itemSelected(const QModelIndex& index);
+  void schedulePrioritization();
+  void prioritizeVisible();
 
 private:
   void showMenu(const QPoint& point);
@@ -57,7 +62,9 @@ private:
   class Data
   {
   public:
+    Data() : pModel(0) {}
     PiiImageListModel *pModel;
+    QTimer prioritizationTimer;
   } *d;
 };
 
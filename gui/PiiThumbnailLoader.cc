@@ -16,44 +16,213 @@
 #include "PiiThumbnailLoader.h"
 #include <PiiQImage.h>
 
-PiiThumbnailLoader::PiiThumbnailLoader(QObject *parent) : QThread(parent), _bRunning(false)
+#include <QImageReader>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QRunnable>
+#include <QSet>
+#if QT_VERSION >= 0x050000
+#  include <QStandardPaths>
+#else
+#  include <QDesktopServices>
+#endif
+
+class PiiThumbnailLoader::Worker : public QRunnable
+{
+public:
+  Worker(PiiThumbnailLoader* loader) : _pLoader(loader) {}
+
+  void run()
+  {
+    QString strFileName;
+    while (_pLoader->takeNext(&strFileName))
+      emit _pLoader->thumbnailReady(strFileName, _pLoader->loadThumbnail(strFileName));
+  }
+
+private:
+  PiiThumbnailLoader* _pLoader;
+};
+
+PiiThumbnailLoader::PiiThumbnailLoader(QObject *parent) :
+  QThread(parent),
+  _bRunning(false),
+  _bQuit(false),
+  _thumbnailSize(70,90),
+  _iWorkerCount(QThread::idealThreadCount()),
+  _strCacheDirectory(defaultCacheDirectory()),
+  _bCacheEnabled(true),
+  _iMaxCacheSize(64 << 20)
 {
 }
 
+PiiThumbnailLoader::~PiiThumbnailLoader()
+{
+  _loadingMutex.lock();
+  _bRunning = false;
+  _bQuit = true;
+  _loadingCondition.wakeOne();
+  _loadingMutex.unlock();
+  wait();
+}
+
 void PiiThumbnailLoader::run()
 {
-  while (_bRunning)
+  QMutexLocker lock(&_loadingMutex);
+  while (!_bQuit)
     {
-      _loadingMutex.lock();
-      if (_lstFileNames.isEmpty())
+      if (_bRunning && !_lstFileNames.isEmpty())
         {
-          _bRunning = false;
-          _loadingMutex.unlock();
-          break;
+          const int iWorkerCount = qMax(_iWorkerCount, 1);
+          lock.unlock();
+          _workerPool.setMaxThreadCount(iWorkerCount);
+          for (int i=iWorkerCount; i--; )
+            _workerPool.start(new Worker(this));
+          _workerPool.waitForDone();
+          pruneCache();
+          lock.relock();
         }
-      QString strFileName = _lstFileNames.takeFirst();
-      _loadingMutex.unlock();
-
-      QImage image(strFileName);
-      if (image.format() == QImage::Format_ARGB32)
-        Pii::setQImageFormat(&image, QImage::Format_RGB32);
-      emit thumbnailReady(strFileName, image.scaled(70,90,Qt::KeepAspectRatio));
-
-      _loadingMutex.lock();
-      if (_lstFileNames.isEmpty())
-        _bRunning = false;
-      _loadingMutex.unlock();
+      else
+        {
+          // Loading is finished or stopped. The thread is kept alive
+          // so that restarting never needs to wait for it to exit.
+          // New files may have been added after the workers ran out
+          // of work; the loop checks the list again before sleeping.
+          _loadingCondition.wait(&_loadingMutex);
+        }
+    }
+}
+
+bool PiiThumbnailLoader::takeNext(QString* fileName)
+{
+  QMutexLocker lock(&_loadingMutex);
+  if (!_bRunning || _lstFileNames.isEmpty())
+    return false;
+  *fileName = _lstFileNames.takeFirst();
+  return true;
+}
+
+PiiThumbnailLoader::Settings PiiThumbnailLoader::settings() const
+{
+  QMutexLocker lock(&_loadingMutex);
+  Settings result;
+  result.thumbnailSize = _thumbnailSize;
+  result.strCacheDirectory = _strCacheDirectory;
+  result.bCacheEnabled = _bCacheEnabled;
+  return result;
+}
+
+QImage PiiThumbnailLoader::loadThumbnail(const QString& fileName) const
+{
+  // Settings may change while the thumbnail is being created.
+  const Settings settings(this->settings());
+  const QSize thumbnailSize(settings.thumbnailSize);
+  QFileInfo info(fileName);
+  QString strCacheFile;
+  if (settings.bCacheEnabled && info.exists())
+    {
+      strCacheFile = cacheFileName(info, settings);
+      QImage cachedImage(strCacheFile, "PNG");
+      if (!cachedImage.isNull())
+        return cachedImage;
+    }
+
+  // Let the decoder scale the image down if it can. JPEG decoders
+  // can skip most of the work at reduced sizes.
+  QImageReader reader(fileName);
+  QSize originalSize = reader.size();
+  if (originalSize.isValid() &&
+      (originalSize.width() > thumbnailSize.width() ||
+       originalSize.height() > thumbnailSize.height()))
+    reader.setScaledSize(originalSize.scaled(thumbnailSize, Qt::KeepAspectRatio));
+
+  QImage image(reader.read());
+  if (image.isNull())
+    return image;
+  if (image.format() == QImage::Format_ARGB32)
+    Pii::setQImageFormat(&image, QImage::Format_RGB32);
+  if (image.size() != image.size().scaled(thumbnailSize, Qt::KeepAspectRatio))
+    image = image.scaled(thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+  if (!strCacheFile.isEmpty() && QDir().mkpath(settings.strCacheDirectory))
+    {
+      // Write to a temporary file first so that other processes never
+      // see a partially written thumbnail.
+      QString strTempFile = strCacheFile +
+        QString(".%1.tmp").arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+      if (!image.save(strTempFile, "PNG") || !QFile::rename(strTempFile, strCacheFile))
+        QFile::remove(strTempFile);
+    }
+  return image;
+}
+
+QString PiiThumbnailLoader::cacheFileName(const QFileInfo& info, const Settings& settings)
+{
+  QString strKey = QString("%1|%2|%3|%4x%5")
+    .arg(info.absoluteFilePath())
+    .arg(info.lastModified().toTime_t())
+    .arg(info.size())
+    .arg(settings.thumbnailSize.width())
+    .arg(settings.thumbnailSize.height());
+  return settings.strCacheDirectory + '/' +
+    QCryptographicHash::hash(strKey.toUtf8(), QCryptographicHash::Sha1).toHex() + ".png";
+}
+
+QFileInfoList PiiThumbnailLoader::cachedFiles() const
+{
+  // Newest first
+  return QDir(cacheDirectory()).entryInfoList(QStringList() << "*.png", QDir::Files, QDir::Time);
+}
+
+void PiiThumbnailLoader::pruneCache()
+{
+  const qint64 iMaxSize = maxCacheSize();
+  if (iMaxSize <= 0)
+    return;
+  QFileInfoList lstFiles(cachedFiles());
+  qint64 iTotalSize = 0;
+  for (int i=0; i<lstFiles.size(); ++i)
+    {
+      iTotalSize += lstFiles[i].size();
+      if (iTotalSize > iMaxSize)
+        QFile::remove(lstFiles[i].absoluteFilePath());
     }
 }
 
+void PiiThumbnailLoader::clearCache()
+{
+  QFileInfoList lstFiles(cachedFiles());
+  for (int i=0; i<lstFiles.size(); ++i)
+    QFile::remove(lstFiles[i].absoluteFilePath());
+}
+
+QString PiiThumbnailLoader::defaultCacheDirectory()
+{
+#if QT_VERSION >= 0x050000
+  QString strBase = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+#else
+  QString strBase = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+#endif
+  if (strBase.isEmpty())
+    strBase = QDir::tempPath();
+  return strBase + "/thumbnails";
+}
+
+QStringList PiiThumbnailLoader::fileNames() const
+{
+  QMutexLocker lock(&_loadingMutex);
+  return _lstFileNames;
+}
+
 void PiiThumbnailLoader::setFileNames(const QStringList& fileNames)
 {
   _loadingMutex.lock();
   _lstFileNames = fileNames;
   _loadingMutex.unlock();
 
-  if (!_bRunning)
-    startLoading();
+  startLoading();
 }
 
 void PiiThumbnailLoader::addFileName(const QString& fileName)
@@ -62,18 +231,109 @@ void PiiThumbnailLoader::addFileName(const QString& fileName)
   _lstFileNames << fileName;
   _loadingMutex.unlock();
 
-  if (!_bRunning)
-    startLoading();
+  startLoading();
+}
+
+void PiiThumbnailLoader::prioritize(const QStringList& fileNames)
+{
+  QSet<QString> setPriority;
+  for (int i=0; i<fileNames.size(); ++i)
+    setPriority << fileNames[i];
+
+  QMutexLocker lock(&_loadingMutex);
+  // Rebuild the list in one pass instead of searching for each file.
+  QSet<QString> setWaiting;
+  QStringList lstOthers;
+  for (int i=0; i<_lstFileNames.size(); ++i)
+    {
+      if (setPriority.contains(_lstFileNames[i]))
+        setWaiting << _lstFileNames[i];
+      else
+        lstOthers << _lstFileNames[i];
+    }
+  if (setWaiting.isEmpty())
+    return;
+
+  QStringList lstFirst;
+  for (int i=0; i<fileNames.size(); ++i)
+    if (setWaiting.remove(fileNames[i]))
+      lstFirst << fileNames[i];
+  _lstFileNames = lstFirst + lstOthers;
 }
 
 void PiiThumbnailLoader::startLoading()
 {
+  _loadingMutex.lock();
   _bRunning = true;
-  start();
+  _loadingCondition.wakeOne();
+  _loadingMutex.unlock();
+  // The thread only exits in the destructor.
+  if (!isRunning())
+    start();
 }
 
 void PiiThumbnailLoader::stopLoading()
 {
+  QMutexLocker lock(&_loadingMutex);
   _bRunning = false;
 }
 
+void PiiThumbnailLoader::setThumbnailSize(const QSize& thumbnailSize)
+{
+  QMutexLocker lock(&_loadingMutex);
+  _thumbnailSize = thumbnailSize;
+}
+
+QSize PiiThumbnailLoader::thumbnailSize() const
+{
+  QMutexLocker lock(&_loadingMutex);
+  return _thumbnailSize;
+}
+
+void PiiThumbnailLoader::setWorkerCount(int workerCount)
+{
+  QMutexLocker lock(&_loadingMutex);
+  _iWorkerCount = workerCount;
+}
+
+int PiiThumbnailLoader::workerCount() const
+{
+  QMutexLocker lock(&_loadingMutex);
+  return _iWorkerCount;
+}
+
+void PiiThumbnailLoader::setCacheDirectory(const QString& cacheDirectory)
+{
+  QMutexLocker lock(&_loadingMutex);
+  _strCacheDirectory = cacheDirectory;
+}
+
+QString PiiThumbnailLoader::cacheDirectory() const
+{
+  QMutexLocker lock(&_loadingMutex);
+  return _strCacheDirectory;
+}
+
+void PiiThumbnailLoader::setCacheEnabled(bool cacheEnabled)
+{
+  QMutexLocker lock(&_loadingMutex);
+  _bCacheEnabled = cacheEnabled;
+}
+
+bool PiiThumbnailLoader::isCacheEnabled() const
+{
+  QMutexLocker lock(&_loadingMutex);
+  return _bCacheEnabled;
+}
+
+void PiiThumbnailLoader::setMaxCacheSize(qint64 maxCacheSize)
+{
+  QMutexLocker lock(&_loadingMutex);
+  _iMaxCacheSize = maxCacheSize;
+}
+
+qint64 PiiThumbnailLoader::maxCacheSize() const
+{
+  QMutexLocker lock(&_loadingMutex);
+  return _iMaxCacheSize;
+}
@@ -19,26 +19,57 @@
 #include <QThread>
 #include <QImage>
 #include <QMutex>
+#include <QWaitCondition>
 #include <QStringList>
+#include <QThreadPool>
+#include <QSize>
+#include <QFileInfo>
 
 #include "PiiGui.h"
 
+/**
+ * Creates thumbnails of image files in the background. The loader
+ * decodes images in a pool of worker threads. If the image format
+ * supports it (e.g. JPEG), images are decoded directly at reduced
+ * size, which is much faster than decoding the full image and
+ * scaling it down.
+ *
+ * Thumbnails are stored in an on-disk cache (see [cacheDirectory()])
+ * keyed by the absolute path, modification time and size of the
+ * image file and the thumbnail size. Revisiting a directory thus
+ * only needs to read the small cached thumbnails. The size of the
+ * cache is limited by [maxCacheSize()]: whenever a batch of files has
+ * been loaded, the oldest thumbnails are removed until the cache fits
+ * into the limit.
+ *
+ * Files are processed in the order they were added, but
+ * [prioritize()] can be used to move files to the front of the
+ * queue, e.g. when they become visible in a view.
+ */
 class PII_GUI_EXPORT PiiThumbnailLoader : public QThread
 {
   Q_OBJECT
 
 public:
   PiiThumbnailLoader(QObject *parent = 0);
+  /**
+   * Stops loading and waits for the workers to finish.
+   */
+  ~PiiThumbnailLoader();
 
   void run();
 
   /**
-   * Start the loading thread.
+   * Start loading thumbnails. The loading thread is started on first
+   * call. Later, it sleeps when there is nothing to load and is woken
+   * up by this function. Never blocks the caller.
    */
   void startLoading();
 
   /**
-   * Stop the loading thread.
+   * Stop the loading thread. Thumbnails that are currently being
+   * created will be finished, but no new ones will be started. The
+   * waiting list is retained.
    */
   void stopLoading();
 
@@ -59,17 +90,112 @@ public:
    */
   void addFileName(const QString& fileName);
 
+  /**
+   * Moves *fileNames* to the front of the waiting list in the given
+   * order. File names that are not in the waiting list (already
+   * loaded or never added) are ignored. Duplicate entries of the
+   * moved file names are removed from the list.
+   */
+  void prioritize(const QStringList& fileNames);
+
+  /**
+   * Creates a thumbnail for *fileName* in the calling thread. The
+   * thumbnail is read from the cache if possible. Otherwise, it is
+   * created and stored in the cache. Returns a null image if the
+   * file cannot be read.
+   */
+  QImage loadThumbnail(const QString& fileName) const;
+
+  /**
+   * Sets the maximum size of thumbnails. Images are scaled to fit
+   * into this size, retaining aspect ratio. The default is 70x90.
+   */
+  void setThumbnailSize(const QSize& thumbnailSize);
+  QSize thumbnailSize() const;
+
+  /**
+   * Sets the number of worker threads. The default is the number of
+   * processor cores. Changes take effect when loading is restarted.
+   */
+  void setWorkerCount(int workerCount);
+  int workerCount() const;
+
+  /**
+   * Sets the directory thumbnails are cached in. The directory will
+   * be created if it does not exist. The default is
+   * [defaultCacheDirectory()].
+   */
+  void setCacheDirectory(const QString& cacheDirectory);
+  QString cacheDirectory() const;
+
+  /**
+   * Enables or disables the on-disk cache. The cache is enabled by
+   * default.
+   */
+  void setCacheEnabled(bool cacheEnabled);
+  bool isCacheEnabled() const;
+
+  /**
+   * Sets the maximum total size of the cached thumbnails in bytes.
+   * Zero means no limit. The default is 64 MB. The limit is enforced
+   * by [pruneCache()].
+   */
+  void setMaxCacheSize(qint64 maxCacheSize);
+  qint64 maxCacheSize() const;
+
+  /**
+   * Removes the oldest thumbnails from the cache directory until the
+   * total size of the remaining ones is at most [maxCacheSize()].
+   * The loader calls this function automatically whenever it runs out
+   * of files to load.
+   */
+  void pruneCache();
+
+  /**
+   * Removes all thumbnails from the cache directory.
+   */
+  void clearCache();
+
+  /**
+   * Returns the platform-specific default cache directory for
+   * thumbnails.
+   */
+  static QString defaultCacheDirectory();
+
 signals:
   /**
    * This signal was emitted just after we have created the thumbnail
-   * by the file name.
+   * by the file name. The signal is emitted from a worker thread.
    */
   void thumbnailReady(const QString& fileName, const QImage& image);
 
 private:
-  bool _bRunning;
-  QMutex _loadingMutex;
+  class Worker;
+
+  // Settings used while creating a single thumbnail.
+  struct Settings
+  {
+    QSize thumbnailSize;
+    QString strCacheDirectory;
+    bool bCacheEnabled;
+  };
+
+  bool takeNext(QString* fileName);
+  Settings settings() const;
+  static QString cacheFileName(const QFileInfo& info, const Settings& settings);
+  QFileInfoList cachedFiles() const;
+
+  bool _bRunning, _bQuit;
+  // Protects the waiting list, the state flags and the settings.
+  mutable QMutex _loadingMutex;
+  QWaitCondition _loadingCondition;
   QStringList _lstFileNames;
+  QSize _thumbnailSize;
+  int _iWorkerCount;
+  QString _strCacheDirectory;
+  bool _bCacheEnabled;
+  qint64 _iMaxCacheSize;
+  QThreadPool _workerPool;
 };
 
 #endif //_PIITHUMBNAILLOADER_H
@@ -30,7 +30,8 @@ template <class T> void PiiTriggerSource::emitValue(T value)
 {
   QMutexLocker lock(&_d()->stateMutex);
 
-  if (state() == Running)
+  // Drop the trigger if the pipeline cannot keep up.
+  if (state() == Running && !shedLoad())
     emitObject(value);
 }
 
@@ -28,6 +28,9 @@
  * operation is useful when one needs to send values from a user
  * interface to the analysis engine.
  *
+ * If [overloadPolicy] is set to `DropWhenOverloaded`, triggers are
+ * discarded while the receiving operations are overloaded.
+ *
  * Outputs
  * -------
  *
@@ -30,7 +30,7 @@ public:
     _dpFiberThickness(new double[_iBundleWidth]),
     _dpThicknessChange(new double[_iBundleWidth]),
     _iLineCount(0),
-    _iNextUpdate(rand() % 50)
+    _iNextUpdate(int(Pii::uniformRandomIndex(50)))
   {
     double mean = (_pParent->_iMinThickness + _pParent->_iMaxThickness) / 2;
     for (int i=_iBundleWidth; i--; )
@@ -77,7 +77,7 @@ public:
     if (_iLineCount == _iNextUpdate)
       {
         _iLineCount = 0;
-        _iNextUpdate = rand() % 50;
+        _iNextUpdate = int(Pii::uniformRandomIndex(50));
         updateChanges();
       }
     else
@@ -637,7 +637,7 @@ bool PiiLineScanEmulator::newDefect()
    images. Else the program will crash. */
 int PiiLineScanEmulator::getRandomImage()
 {
-  return rand() % _lstImages.size();
+  return int(Pii::uniformRandomIndex(_lstImages.size()));
 }
 
   /* This is a private function, which returns a random coordinate for
@@ -654,7 +654,7 @@ QPoint PiiLineScanEmulator::getRandomCoord(const QImage& image)
   int maxX = _iWidth - image.width();
   if (maxX <= 0)
     return QPoint(0,0); // The image doesn't fit in the web.
-  return QPoint(rand() % maxX, 0);
+  return QPoint(int(Pii::uniformRandomIndex(maxX)), 0);
 }
 
 /* Genarates a new line in the buffer. If there are images in _lstCurrDefImages
@@ -737,7 +737,7 @@ double PiiLineScanEmulator::updateEdgePos(double pos, QPoint& targetPoint, int l
   // If we passed the target point, generate new coordinates
   if (_iLineCounter >= targetPoint.y())
     {
-      targetPoint.rx() = rand() % limit;
+      targetPoint.rx() = int(Pii::uniformRandomIndex(limit));
       targetPoint.ry() += 100;
     }
   // Update edge position
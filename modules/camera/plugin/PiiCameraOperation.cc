@@ -21,10 +21,13 @@
 #include <PiiYdinResources.h>
 
 #include <QSettings>
+#include <QThread>
 
 #include <PiiLog.h>
 #include <QFile>
 
+#include <cstdlib>
+
 PiiCameraOperation::Data::Data() :
   pCameraDriver(0),
   strCameraId(""),
@@ -36,7 +39,8 @@ PiiCameraOperation::Data::Data() :
   iFrameCount(-1),
   bWaitPause(false),
   bMissedFrames(false),
-  iMaxMissedIndex(0)
+  iMaxMissedIndex(0),
+  boundThreadId(0)
 {
 }
 
@@ -111,6 +115,7 @@ void PiiCameraOperation::check(bool reset)
     }
 
   PiiImageReaderOperation::check(reset);
+  d->boundThreadId = 0;
 }
 
 void PiiCameraOperation::process()
@@ -169,6 +174,14 @@ void PiiCameraOperation::frameCaptured(uint frameIndex, void *frameBuffer, qint6
 {
   PII_D;
 
+  // Frames are delivered from the capture thread of the driver. Bind
+  // it to the CPU affinity of this operation on the first frame.
+  if (QThread::currentThreadId() != d->boundThreadId)
+    {
+      d->boundThreadId = QThread::currentThreadId();
+      bindCurrentThread();
+    }
+
   QMutexLocker lock(&d->pauseMutex);
   if (d->bWaitPause)
     {
@@ -184,6 +197,17 @@ void PiiCameraOperation::frameCaptured(uint frameIndex, void *frameBuffer, qint6
       d->bMissedFrames = false;
     }
 
+  // In free-running mode, drop the whole frame if the receivers
+  // cannot keep up. In triggered mode, load is shed by the trigger
+  // source. A buffer passed by the driver is owned by us and must be
+  // released; otherwise the driver recycles its own buffer.
+  if (!d->bTriggered && shedLoad())
+    {
+      if (frameBuffer != 0)
+        std::free(frameBuffer);
+      return;
+    }
+
   if (frameIndex >= 0)
     {
       Pii::PtrOwnership ownership = frameBuffer != 0 ? Pii::ReleaseOwnership : Pii::RetainOwnership;
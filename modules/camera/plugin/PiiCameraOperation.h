@@ -163,6 +163,8 @@ protected:
     PiiWaitCondition pauseWaitCondition;
     int iMaxMissedIndex;
     QMutex pauseMutex;
+    // The driver thread that was last bound to the CPU affinity.
+    Qt::HANDLE boundThreadId;
 
   };
   PII_D_FUNC;
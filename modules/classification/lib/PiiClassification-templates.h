@@ -18,6 +18,7 @@
 #endif
 
 #include <PiiMathDefs.h>
+#include <PiiRandom.h>
 
 namespace PiiClassification
 {
@@ -221,9 +222,7 @@ namespace PiiClassification
 
     // First initialize the centroids by random selection
     for (int i=k; i--; )
-      // OK, this is a bad thing, but we don't need a really good random
-      // number here.
-      PiiSampleSet::append(resultSet, PiiSampleSet::sampleAt(samples,rand() % iSamples));
+      PiiSampleSet::append(resultSet, PiiSampleSet::sampleAt(samples, int(Pii::uniformRandomIndex(iSamples))));
 
     // Allocate storage for temporary mean vectors
     SampleSet centroidSet(resultSet);
@@ -265,9 +264,7 @@ namespace PiiClassification
                                                              double maximum)
   {
     typedef typename PiiSampleSet::Traits<SampleSet>::FeatureType T;
-    double dRange = maximum - minimum;
-    double dScale = dRange/RAND_MAX;
-
+    PiiRandomEngine& engine = Pii::randomEngine();
     SampleSet result = PiiSampleSet::create<SampleSet>(samples, features);
 
     for (int s=0; s<samples; ++s)
@@ -275,7 +272,7 @@ namespace PiiClassification
         typename PiiSampleSet::Traits<SampleSet>::FeatureIterator sample =
           PiiSampleSet::sampleAt(result, s);
         for (int f=0; f<features; ++f)
-          sample[f] = T(dScale * rand() + minimum);
+          sample[f] = T(engine.uniform(minimum, maximum));
       }
     return result;
   }
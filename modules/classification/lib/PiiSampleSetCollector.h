@@ -17,6 +17,7 @@
 #define _PIISAMPLESETCOLLECTOR_H
 
 #include "PiiLearningAlgorithm.h"
+#include <PiiRandom.h>
 
 /**
  * A learning algorithm that just collects all incoming data into a
@@ -410,8 +411,9 @@ double PiiSampleSetCollector<SampleSet>::learnOne(ConstFeatureIterator featureVe
   // No room -> overwrite one of the old ones if needed
   else if (d->fullBufferBehavior != PiiClassification::DiscardNewSample)
     {
-      int iOverwriteIndex = ((d->fullBufferBehavior == PiiClassification::OverwriteRandomSample) ?
-                             rand() : d->iSampleIndex) % PiiSampleSet::sampleCount(sampleSet);
+      const int iSamples = PiiSampleSet::sampleCount(sampleSet);
+      int iOverwriteIndex = (d->fullBufferBehavior == PiiClassification::OverwriteRandomSample) ?
+        int(Pii::uniformRandomIndex(iSamples)) : d->iSampleIndex % iSamples;
 
       PiiSampleSet::setSampleAt(sampleSet, iOverwriteIndex, featureVector);
       if (d->bCollectLabels)
@@ -20,6 +20,7 @@
 #include <PiiAlgorithm.h>
 #include <PiiAsyncCall.h>
 #include <PiiMath.h>
+#include <PiiRandom.h>
 
 PiiFeatureCombiner::Data::Data() :
   iTotalLength(0),
@@ -213,8 +214,9 @@ template <class T> void PiiFeatureCombiner::emitCompound(int totalLength)
       else
         {
           int iOverwriteIndex = (d->fullBufferBehavior == OverwriteRandomSample) ?
-            rand() : d->iSampleIndex;
-          pNewRow = d->matBuffer[iOverwriteIndex % d->matBuffer.rows()];
+            int(Pii::uniformRandomIndex(d->matBuffer.rows())) :
+            d->iSampleIndex % d->matBuffer.rows();
+          pNewRow = d->matBuffer[iOverwriteIndex];
         }
       if (pNewRow != 0)
         Pii::copyN(pBegin, d->iTotalLength, pNewRow);
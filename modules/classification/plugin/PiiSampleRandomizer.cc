@@ -17,14 +17,14 @@
 
 #include <PiiYdinTypes.h>
 #include <QtAlgorithms>
-#include <cstdlib>
 #include <PiiUtil.h>
 
 PiiSampleRandomizer::Data::Data() :
   iClassIndex(0),
   iMaxSamples(0),
   iCurrentSampleIndex(0),
-  bRandomSampling(false)
+  bRandomSampling(false),
+  iRandomSeed(0)
 {
 }
 
@@ -97,16 +97,24 @@ void PiiSampleRandomizer::check(bool reset)
     {
       d->iCurrentSampleIndex = 0;
       d->iClassIndex = 0;
+      if (d->iRandomSeed != 0)
+        d->random.seed(quint64(d->iRandomSeed), PiiRandomEngine::streamId(objectName()));
     }
 }
 
+PiiRandomEngine& PiiSampleRandomizer::randomEngine()
+{
+  PII_D;
+  return d->iRandomSeed != 0 ? d->random : Pii::randomEngine();
+}
+
 void PiiSampleRandomizer::emitFromClass(int classIndex)
 {
   PII_D;
   QStringList& names = d->lstSampleNames[classIndex];
   // Select a sample randomly from the class names
   if (d->bRandomSampling)
-    emitObject(names[::rand() % names.size()]);
+    emitObject(names[randomEngine().uniformInt(names.size())]);
   else
     {
       emitObject(names[d->lstSampleIndices[classIndex]]);
@@ -124,7 +132,7 @@ void PiiSampleRandomizer::process()
   // Weights are set -> select randomly
   if (d->lstCumulativeWeights.size() > 0)
     {
-      double p = double(::rand())/RAND_MAX; // p is in [0,1]
+      double p = randomEngine().uniform(); // p is in [0,1)
 
       for (int i=0; i<d->lstCumulativeWeights.size(); ++i)
         if (p <= d->lstCumulativeWeights[i])
@@ -150,4 +158,6 @@ void PiiSampleRandomizer::setRandomSampling(bool randomSampling) { _d()->bRandom
 bool PiiSampleRandomizer::randomSampling() const { return _d()->bRandomSampling; }
 void PiiSampleRandomizer::setMaxSamples(int maxSamples) { _d()->iMaxSamples = maxSamples; }
 int PiiSampleRandomizer::maxSamples() const { return _d()->iMaxSamples; }
+void PiiSampleRandomizer::setRandomSeed(int randomSeed) { _d()->iRandomSeed = randomSeed; }
+int PiiSampleRandomizer::randomSeed() const { return _d()->iRandomSeed; }
 int PiiSampleRandomizer::currentSampleIndex() const { return _d()->iCurrentSampleIndex; }
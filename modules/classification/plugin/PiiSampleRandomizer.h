@@ -17,6 +17,7 @@
 #define _PIISAMPLERANDOMIZER_H
 
 #include <PiiDefaultOperation.h>
+#include <PiiRandom.h>
 
 /**
  * An operation that stores names of samples belonging to N different
@@ -82,6 +83,17 @@ class PiiSampleRandomizer : public PiiDefaultOperation
    */
   Q_PROPERTY(int maxSamples READ maxSamples WRITE setMaxSamples);
 
+  /**
+   * The seed of the random number generator. If non-zero, the
+   * operation uses a private generator initialized with this seed and
+   * a stream derived from the operation's object name whenever the
+   * operation is reset. Two randomizers with different names thus
+   * produce different but reproducible sequences. Zero means that the
+   * shared random number generator of the processing thread will be
+   * used (see [Pii::randomEngine()]). The default is zero.
+   */
+  Q_PROPERTY(int randomSeed READ randomSeed WRITE setRandomSeed);
+
   /**
    * The zero-based index of the next sample to be emitted.
    */
@@ -103,6 +115,9 @@ public:
   void setMaxSamples(int maxSamples);
   int maxSamples() const;
 
+  void setRandomSeed(int randomSeed);
+  int randomSeed() const;
+
   int currentSampleIndex() const;
 
 protected:
@@ -111,6 +126,7 @@ protected:
 
 private:
   void emitFromClass(int classIndex);
+  PiiRandomEngine& randomEngine();
 
   /// @internal
   class Data : public PiiDefaultOperation::Data
@@ -125,6 +141,8 @@ private:
     int iMaxSamples;
     int iCurrentSampleIndex;
     bool bRandomSampling;
+    int iRandomSeed;
+    PiiRandomEngine random;
   };
   PII_D_FUNC;
 };
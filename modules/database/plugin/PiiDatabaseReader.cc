@@ -16,14 +16,29 @@
 #include "PiiDatabaseReader.h"
 
 #include <PiiYdinTypes.h>
+#include <PiiAsyncCall.h>
 
 #include <QSqlQuery>
 #include <QSqlDriver>
 #include <QFile>
+#include <QThread>
+
+// The number of bytes read from a CSV file at once.
+static const int iCsvChunkSize = 65536;
 
 PiiDatabaseReader::Data::Data() :
   pQuery(0),
-  pFile(0)
+  pFile(0),
+  iPrefetchSize(1024),
+  iFetchSize(128),
+  iBlockSize(0),
+  bSourceOpen(false),
+  pSourceThread(0),
+  iCsvPosition(0),
+  bCsvEof(false),
+  pPrefetchThread(0),
+  bPrefetching(false),
+  bPrefetchFinished(true)
 {
 }
 
@@ -31,19 +46,60 @@ PiiDatabaseReader::Data::~Data()
 {
   delete pQuery;
   delete pFile;
+  delete pPrefetchThread;
 }
 
 PiiDatabaseReader::PiiDatabaseReader() : PiiDatabaseOperation(new Data)
 {
+  PII_D;
+  d->pPrefetchThread = Pii::createAsyncCall(this, &PiiDatabaseReader::prefetch);
+
   setProtectionLevel("columnNames", WriteWhenStoppedOrPaused);
   setProtectionLevel("defaultValues", WriteWhenStoppedOrPaused);
+  setProtectionLevel("prefetchSize", WriteWhenStopped);
+  setProtectionLevel("fetchSize", WriteWhenStoppedOrPaused);
+  setProtectionLevel("blockSize", WriteWhenStoppedOrPaused);
+}
+
+PiiDatabaseReader::~PiiDatabaseReader()
+{
+  stopPrefetching();
+}
+
+void PiiDatabaseReader::check(bool reset)
+{
+  PII_D;
+  PiiDatabaseOperation::check(reset);
+  if (reset)
+    {
+      stopPrefetching();
+      d->queRows.clear();
+      if (d->iPrefetchSize > 0)
+        startPrefetching();
+    }
 }
 
 void PiiDatabaseReader::aboutToChangeState(State state)
 {
   PII_D;
   if (state == Stopped)
-    delete d->pFile, d->pFile = 0;
+    {
+      stopPrefetching();
+      d->queRows.clear();
+      // If rows were read in a processing thread, the source is
+      // still open. The connection must be closed in the thread that
+      // opened it. If the state changes in another thread,
+      // closeSource() will be called when the processing thread
+      // finishes.
+      bool bOpenElsewhere;
+      synchronized (d->sourceMutex)
+        bOpenElsewhere = d->bSourceOpen &&
+          d->pSourceThread != 0 &&
+          d->pSourceThread != QThread::currentThread();
+      if (bOpenElsewhere)
+        return;
+      closeSource();
+    }
   PiiDatabaseOperation::aboutToChangeState(state);
 }
 
@@ -82,7 +138,6 @@ QSqlDatabase* PiiDatabaseReader::createDatabase(const QString& driver,
 void PiiDatabaseReader::createQuery()
 {
   PII_D;
-  // PENDING
   QSqlDriver* pDriver = db()->driver();
   QString strQuery("SELECT ");
   for (int i=0; i<d->lstColumnNames.size(); ++i)
@@ -94,50 +149,383 @@ void PiiDatabaseReader::createQuery()
   strQuery.append(" FROM ");
   strQuery.append(pDriver->escapeIdentifier(d->strTableName, QSqlDriver::TableName));
   d->pQuery = new QSqlQuery(*db());
+  // Rows are read only once. This lets the driver stream the result
+  // set instead of caching all of it.
+  d->pQuery->setForwardOnly(true);
   d->pQuery->prepare(strQuery);
 }
 
-void PiiDatabaseReader::process()
+bool PiiDatabaseReader::openSource()
 {
   PII_D;
-  if (!isConnected() && d->pFile == 0)
+  d->aCsvBuffer.clear();
+  d->iCsvPosition = 0;
+  d->bCsvEof = false;
+  synchronized (d->sourceMutex)
+    d->bSourceOpen = true;
+
+  if (!openConnection())
+    return d->pFile != 0;
+  createQuery();
+  if (!exec(*d->pQuery))
     {
       delete d->pQuery, d->pQuery = 0;
-      if (openConnection())
-        createQuery();
-    }
-  else if (d->pFile != 0)
-    {
-      QString strLine(d->pFile->readLine());
-      if (!strLine.isEmpty() && strLine[strLine.size()-1] == '\n')
-        strLine.chop(1);
-      if (!strLine.isEmpty() && strLine[strLine.size()-1] == '\r')
-        strLine.chop(1);
-      if (strLine.isEmpty())
-        operationStopped(); // throws
-      QStringList lstParts = Pii::splitQuoted(strLine, QChar(';'));
-      if (lstParts.size() != d->lstColumnNames.size())
+      return false;
+    }
+  return true;
+}
+
+void PiiDatabaseReader::closeSource()
+{
+  PII_D;
+  QMutexLocker lock(&d->sourceMutex);
+  if (!d->bSourceOpen)
+    return;
+  delete d->pQuery, d->pQuery = 0;
+  delete d->pFile, d->pFile = 0;
+  d->aCsvBuffer.clear();
+  // Must be called in the thread that opened the connection.
+  closeConnection();
+  d->bSourceOpen = false;
+  if (d->pSourceThread != 0)
+    {
+      disconnect(d->pSourceThread, SIGNAL(finished()), this, SLOT(closeSource()));
+      d->pSourceThread = 0;
+    }
+}
+
+int PiiDatabaseReader::readRows(QQueue<Row>& rows, int maxRows)
+{
+  PII_D;
+  if (d->pFile != 0)
+    return readCsvRows(rows, maxRows);
+  if (d->pQuery == 0)
+    return 0;
+
+  const int iColumns = d->lstColumnNames.size();
+  int iCount = 0;
+  for (; iCount < maxRows && d->pQuery->next(); ++iCount)
+    {
+      Row row(iColumns);
+      for (int i=0; i<iColumns; ++i)
+        row[i] = sqlValue(d->pQuery->value(i), i);
+      rows.enqueue(row);
+    }
+  return iCount;
+}
+
+int PiiDatabaseReader::readCsvRows(QQueue<Row>& rows, int maxRows)
+{
+  PII_D;
+  const int iColumns = d->lstColumnNames.size();
+  QVarLengthArray<CsvField,32> vecFields;
+  int iCount = 0;
+  while (iCount < maxRows)
+    {
+      const char* pBuffer = d->aCsvBuffer.constData();
+      const char* pBegin = pBuffer + d->iCsvPosition, *pEnd = pBuffer + d->aCsvBuffer.size();
+      if (pBegin == pEnd)
+        {
+          if (d->bCsvEof || !fillCsvBuffer())
+            break;
+          continue;
+        }
+
+      const char* pNext = parseCsvRecord(pBegin, pEnd, vecFields);
+      // The record continues beyond the buffer.
+      if (pNext == 0)
+        {
+          fillCsvBuffer();
+          continue;
+        }
+      d->iCsvPosition = pNext - pBuffer;
+
+      // Skip empty lines
+      if (vecFields.size() == 1 && vecFields[0].iLength == 0)
+        continue;
+
+      if (vecFields.size() != iColumns)
         PII_THROW(PiiExecutionException,
                   tr("CSV file has %1 data fields, expected %2.")
-                  .arg(lstParts.size())
-                  .arg(d->lstColumnNames.size()));
-      for (int i=0; i<lstParts.size(); ++i)
+                  .arg(vecFields.size())
+                  .arg(iColumns));
+
+      Row row(iColumns);
+      for (int i=0; i<iColumns; ++i)
+        row[i] = csvValue(vecFields[i], i);
+      rows.enqueue(row);
+      ++iCount;
+    }
+  return iCount;
+}
+
+bool PiiDatabaseReader::fillCsvBuffer()
+{
+  PII_D;
+  d->aCsvBuffer.remove(0, d->iCsvPosition);
+  d->iCsvPosition = 0;
+  QByteArray aData(d->pFile->read(iCsvChunkSize));
+  if (aData.isEmpty())
+    {
+      d->bCsvEof = true;
+      return false;
+    }
+  d->aCsvBuffer.append(aData);
+  return true;
+}
+
+const char* PiiDatabaseReader::parseCsvRecord(const char* begin, const char* end,
+                                              QVarLengthArray<CsvField,32>& fields)
+{
+  // Fields are separated by semicolons and may be quoted. Quotes
+  // may be escaped with a backslash within a quoted field, and
+  // quoted fields may contain line feeds. This is the same format
+  // Pii::splitQuoted() accepts.
+  const bool bEof = _d()->bCsvEof;
+  const char* p = begin;
+  fields.clear();
+  forever
+    {
+      CsvField field;
+      // White space before a quote is ignored.
+      const char* pQuote = p;
+      while (pQuote < end && *pQuote == ' ') ++pQuote;
+      if (pQuote < end && *pQuote == '"')
+        {
+          field.pBegin = ++pQuote;
+          while (pQuote < end && *pQuote != '"')
+            pQuote += *pQuote == '\\' ? 2 : 1;
+          if (pQuote >= end)
+            {
+              // No matching quote -> use the rest of the data.
+              if (!bEof)
+                return 0;
+              pQuote = end;
+            }
+          field.iLength = pQuote - field.pBegin;
+          p = pQuote < end ? pQuote + 1 : end;
+          while (p < end && *p != ';' && *p != '\n') ++p;
+        }
+      else
+        {
+          field.pBegin = p;
+          while (p < end && *p != ';' && *p != '\n') ++p;
+          field.iLength = p - field.pBegin;
+          if (field.iLength > 0 && field.pBegin[field.iLength-1] == '\r')
+            --field.iLength;
+        }
+
+      if (p >= end)
+        {
+          if (!bEof)
+            return 0;
+          fields.append(field);
+          return end;
+        }
+      fields.append(field);
+      if (*p++ == '\n')
+        return p;
+    }
+}
+
+PiiVariant PiiDatabaseReader::csvValue(const CsvField& field, int column) const
+{
+  const PiiVariant& defaultValue = _d()->vecDefaultValues[column];
+  if (field.iLength == 0)
+    return defaultValue;
+
+  // Numbers are converted without copying the data.
+  switch (defaultValue.type())
+    {
+    case PiiVariant::IntType:
+      return PiiVariant(QByteArray::fromRawData(field.pBegin, field.iLength).trimmed().toInt());
+    case PiiVariant::DoubleType:
+      return PiiVariant(QByteArray::fromRawData(field.pBegin, field.iLength).trimmed().toDouble());
+    default:
+      return PiiVariant(QString::fromUtf8(field.pBegin, field.iLength));
+    }
+}
+
+PiiVariant PiiDatabaseReader::sqlValue(const QVariant& value, int column) const
+{
+  const PiiVariant& defaultValue = _d()->vecDefaultValues[column];
+  if (value.isNull())
+    return defaultValue;
+
+  switch (defaultValue.type())
+    {
+    case PiiVariant::IntType:
+      return PiiVariant(value.toInt());
+    case PiiVariant::DoubleType:
+      return PiiVariant(value.toDouble());
+    case PiiYdin::QStringType:
+      return PiiVariant(value.toString());
+    default:
+      break;
+    }
+
+  // No default value, use the type of the database column.
+  switch (value.type())
+    {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Bool:
+      return PiiVariant(value.toInt());
+    case QVariant::Double:
+      return PiiVariant(value.toDouble());
+    default:
+      return PiiVariant(value.toString());
+    }
+}
+
+void PiiDatabaseReader::startPrefetching()
+{
+  PII_D;
+  d->quePrefetchedRows.clear();
+  d->strPrefetchError.clear();
+  d->bPrefetchFinished = false;
+  d->bPrefetching = true;
+  d->pPrefetchThread->start();
+}
+
+void PiiDatabaseReader::stopPrefetching()
+{
+  PII_D;
+  synchronized (d->prefetchMutex)
+    {
+      d->bPrefetching = false;
+      d->spaceAvailable.wakeAll();
+    }
+  d->pPrefetchThread->wait();
+  d->quePrefetchedRows.clear();
+}
+
+void PiiDatabaseReader::prefetch()
+{
+  PII_D;
+  try
+    {
+      if (openSource())
         {
-          QString strPart(lstParts[i]);
-          switch (d->vecDefaultValues[i].type())
+          QQueue<Row> queBatch;
+          while (d->bPrefetching && readRows(queBatch, qMax(d->iFetchSize, 1)) > 0)
             {
-            case PiiVariant::IntType:
-              emitObject(strPart.isEmpty() ? d->vecDefaultValues[i] : PiiVariant(strPart.toInt()), i);
-              break;
-            case PiiVariant::DoubleType:
-              emitObject(strPart.isEmpty() ? d->vecDefaultValues[i] : PiiVariant(strPart.toDouble()), i);
-              break;
-            default:
-              emitObject(strPart.isEmpty() ? d->vecDefaultValues[i] : PiiVariant(strPart), i);
-              break;
+              QMutexLocker lock(&d->prefetchMutex);
+              while (d->bPrefetching && d->quePrefetchedRows.size() >= d->iPrefetchSize)
+                d->spaceAvailable.wait(&d->prefetchMutex);
+              d->quePrefetchedRows.append(queBatch);
+              queBatch.clear();
+              d->rowsAvailable.wakeOne();
             }
         }
     }
+  catch (PiiException& ex)
+    {
+      QMutexLocker lock(&d->prefetchMutex);
+      d->strPrefetchError = ex.message();
+    }
+  closeSource();
+
+  QMutexLocker lock(&d->prefetchMutex);
+  d->bPrefetchFinished = true;
+  d->rowsAvailable.wakeOne();
+}
+
+bool PiiDatabaseReader::fetchRows()
+{
+  PII_D;
+  if (d->iPrefetchSize == 0)
+    {
+      if (!d->bSourceOpen)
+        {
+          // QThread::finished() is emitted in the finishing thread.
+          // This ensures the source is closed in this thread even if
+          // the operation is stopped from another one.
+          synchronized (d->sourceMutex)
+            d->pSourceThread = QThread::currentThread();
+          connect(d->pSourceThread, SIGNAL(finished()), SLOT(closeSource()),
+                  Qt::ConnectionType(Qt::DirectConnection | Qt::UniqueConnection));
+          if (!openSource())
+            return false;
+        }
+      return readRows(d->queRows, qMax(d->iFetchSize, 1)) > 0;
+    }
+
+  QMutexLocker lock(&d->prefetchMutex);
+  while (d->quePrefetchedRows.isEmpty() && !d->bPrefetchFinished)
+    d->rowsAvailable.wait(&d->prefetchMutex);
+  if (!d->strPrefetchError.isEmpty())
+    PII_THROW(PiiExecutionException, d->strPrefetchError);
+  // Take all buffered rows at once.
+  qSwap(d->queRows, d->quePrefetchedRows);
+  d->spaceAvailable.wakeOne();
+  return !d->queRows.isEmpty();
+}
+
+void PiiDatabaseReader::process()
+{
+  if (_d()->iBlockSize > 0)
+    emitBlock();
+  else
+    emitRow();
+}
+
+void PiiDatabaseReader::emitRow()
+{
+  PII_D;
+  if (d->queRows.isEmpty() && !fetchRows())
+    operationStopped(); // throws
+
+  const Row row(d->queRows.dequeue());
+  for (int i=0; i<row.size(); ++i)
+    emitObject(row[i], i);
+}
+
+void PiiDatabaseReader::emitBlock()
+{
+  PII_D;
+  QVector<Row> vecRows;
+  vecRows.reserve(d->iBlockSize);
+  while (vecRows.size() < d->iBlockSize &&
+         (!d->queRows.isEmpty() || fetchRows()))
+    vecRows << d->queRows.dequeue();
+  if (vecRows.isEmpty())
+    operationStopped(); // throws
+
+  const int iRows = vecRows.size(), iColumns = d->lstColumnNames.size();
+  for (int i=0; i<iColumns; ++i)
+    {
+      // The first row determines the type of the whole block.
+      switch (vecRows[0][i].type())
+        {
+        case PiiVariant::IntType:
+          {
+            PiiMatrix<int> matValues(PiiMatrix<int>::uninitialized(iRows, 1));
+            for (int r=0; r<iRows; ++r)
+              matValues(r,0) = vecRows[r][i].type() == PiiVariant::IntType ? vecRows[r][i].valueAs<int>() : 0;
+            emitObject(matValues, i);
+          }
+          break;
+        case PiiVariant::DoubleType:
+          {
+            PiiMatrix<double> matValues(PiiMatrix<double>::uninitialized(iRows, 1));
+            for (int r=0; r<iRows; ++r)
+              matValues(r,0) = vecRows[r][i].type() == PiiVariant::DoubleType ? vecRows[r][i].valueAs<double>() : 0.0;
+            emitObject(matValues, i);
+          }
+          break;
+        default:
+          {
+            QStringList lstValues;
+            for (int r=0; r<iRows; ++r)
+              lstValues << (vecRows[r][i].type() == PiiYdin::QStringType ?
+                            vecRows[r][i].valueAs<QString>() : QString());
+            emitObject(lstValues, i);
+          }
+        }
+    }
 }
 
 void PiiDatabaseReader::setColumnNames(const QStringList& columnNames)
@@ -187,3 +575,10 @@ void PiiDatabaseReader::initializeDefaults()
 }
 
 QVariantMap PiiDatabaseReader::defaultValues() const { return _d()->mapDefaultValues; }
+
+void PiiDatabaseReader::setPrefetchSize(int prefetchSize) { _d()->iPrefetchSize = qMax(prefetchSize, 0); }
+int PiiDatabaseReader::prefetchSize() const { return _d()->iPrefetchSize; }
+void PiiDatabaseReader::setFetchSize(int fetchSize) { _d()->iFetchSize = qMax(fetchSize, 1); }
+int PiiDatabaseReader::fetchSize() const { return _d()->iFetchSize; }
+void PiiDatabaseReader::setBlockSize(int blockSize) { _d()->iBlockSize = qMax(blockSize, 0); }
+int PiiDatabaseReader::blockSize() const { return _d()->iBlockSize; }
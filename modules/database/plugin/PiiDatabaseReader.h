@@ -18,9 +18,14 @@
 
 #include "PiiDatabaseOperation.h"
 #include <QSqlDatabase>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVarLengthArray>
 
 class QFile;
 class QSqlQuery;
+class QThread;
 
 /**
  * PiiDatabaseReader description
@@ -38,7 +43,14 @@ class QSqlQuery;
  * [output()] function. The type of data emitted through the output
  * depends on the type of the database column. With CSV input, the
  * type is always QString unless explicitly changed with the
- * [defaultValues] property.
+ * [defaultValues] property. If [blockSize] is non-zero, the outputs
+ * emit blocks of rows: integer and double columns as N-by-1
+ * `PiiMatrix<int>` and `PiiMatrix<double>`, and other columns as a
+ * QStringList.
+ *
+ * By default, rows are read in a background thread that keeps a
+ * buffer of [prefetchSize] rows filled while the processing thread
+ * emits them. SQL tables are read with a forward-only query.
  *
  */
 class PiiDatabaseReader : public PiiDatabaseOperation
@@ -80,11 +92,47 @@ class PiiDatabaseReader : public PiiDatabaseOperation
    */
   Q_PROPERTY(QVariantMap defaultValues READ defaultValues WRITE setDefaultValues);
 
+  /**
+   * The maximum number of rows buffered by the background reader
+   * thread. If this value is zero, no background thread will be used,
+   * and rows will be read in the processing thread. The default is
+   * 1024.
+   */
+  Q_PROPERTY(int prefetchSize READ prefetchSize WRITE setPrefetchSize);
+
+  /**
+   * The number of rows read from the database at once. The rows are
+   * moved to the prefetch buffer as a batch, which reduces locking
+   * overhead. The default is 128.
+   */
+  Q_PROPERTY(int fetchSize READ fetchSize WRITE setFetchSize);
+
+  /**
+   * The number of rows emitted at once. If this value is zero (the
+   * default), each column value is emitted separately. Otherwise, the
+   * values of up to `blockSize` rows are collected into a matrix or a
+   * string list and emitted as a single object. The last block may
+   * be smaller than `blockSize`.
+   *
+   * ~~~(c++)
+   * // Emit 1000 feature values at a time
+   * reader->setProperty("columnNames", QStringList() << "feature" << "label");
+   * QVariantMap values;
+   * values["feature"] = 0.0;
+   * values["label"] = 0;
+   * reader->setProperty("defaultValues", values);
+   * reader->setProperty("blockSize", 1000);
+   * ~~~
+   */
+  Q_PROPERTY(int blockSize READ blockSize WRITE setBlockSize);
+
   PII_OPERATION_SERIALIZATION_FUNCTION
 public:
   PiiDatabaseReader();
+  ~PiiDatabaseReader();
 
 protected:
+  void check(bool reset);
   void process();
   void aboutToChangeState(State state);
 
@@ -106,7 +154,25 @@ protected:
   QVariantMap defaultValues() const;
   void setDefaultValues(const QVariantMap& defaultValues);
 
+  int prefetchSize() const;
+  void setPrefetchSize(int prefetchSize);
+
+  int fetchSize() const;
+  void setFetchSize(int fetchSize);
+
+  int blockSize() const;
+  void setBlockSize(int blockSize);
+
 private:
+  typedef QVector<PiiVariant> Row;
+
+  // The location of a field in the CSV read buffer.
+  struct CsvField
+  {
+    const char* pBegin;
+    int iLength;
+  };
+
   /// @internal
   class Data : public PiiDatabaseOperation::Data
   {
@@ -120,11 +186,54 @@ private:
     QSqlQuery *pQuery;
     QFile *pFile;
     QVector<PiiVariant> vecDefaultValues;
+    int iPrefetchSize, iFetchSize, iBlockSize;
+
+    // Rows waiting to be emitted. Accessed by the processing thread
+    // only.
+    QQueue<Row> queRows;
+    // bSourceOpen and pSourceThread (the processing thread that
+    // opened the source if rows are not prefetched) are protected by
+    // sourceMutex.
+    bool bSourceOpen;
+    QThread* pSourceThread;
+    QMutex sourceMutex;
+
+    // Unparsed bytes read from a CSV file.
+    QByteArray aCsvBuffer;
+    int iCsvPosition;
+    bool bCsvEof;
+
+    // Shared between the prefetch thread and the processing thread.
+    QThread* pPrefetchThread;
+    QMutex prefetchMutex;
+    QWaitCondition rowsAvailable, spaceAvailable;
+    QQueue<Row> quePrefetchedRows;
+    bool bPrefetching, bPrefetchFinished;
+    QString strPrefetchError;
   };
   PII_D_FUNC;
 
   void initializeDefaults();
   void createQuery();
+
+  bool openSource();
+  int readRows(QQueue<Row>& rows, int maxRows);
+  int readCsvRows(QQueue<Row>& rows, int maxRows);
+  bool fillCsvBuffer();
+  const char* parseCsvRecord(const char* begin, const char* end, QVarLengthArray<CsvField,32>& fields);
+  PiiVariant csvValue(const CsvField& field, int column) const;
+  PiiVariant sqlValue(const QVariant& value, int column) const;
+
+  void prefetch();
+  void startPrefetching();
+  void stopPrefetching();
+  bool fetchRows();
+
+  void emitRow();
+  void emitBlock();
+
+private slots:
+  void closeSource();
 };
 
 #endif //_PIIDATABASEREADER_H
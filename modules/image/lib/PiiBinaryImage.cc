@@ -0,0 +1,91 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "PiiBinaryImage.h"
+
+PiiBinaryImage::PiiBinaryImage() :
+  _iRows(0), _iColumns(0), _iWordsPerRow(0)
+{}
+
+PiiBinaryImage::PiiBinaryImage(int rows, int columns) :
+  _iRows(rows), _iColumns(columns),
+  _iWordsPerRow((columns + BitsPerWord - 1) / BitsPerWord),
+  _vecWords(rows * _iWordsPerRow, 0)
+{}
+
+int PiiBinaryImage::count() const
+{
+  int iCount = 0;
+  const Word* pWords = _vecWords.constData();
+  for (int i=_vecWords.size(); i--; ++pWords)
+    {
+      // Clear the lowest set bit until nothing remains.
+      for (Word word = *pWords; word != 0; word &= word - 1)
+        ++iCount;
+    }
+  return iCount;
+}
+
+PiiBinaryImage& PiiBinaryImage::operator|= (const PiiBinaryImage& other)
+{
+  Word* pWords = _vecWords.data();
+  const Word* pOther = other._vecWords.constData();
+  for (int i=_vecWords.size(); i--; )
+    pWords[i] |= pOther[i];
+  return *this;
+}
+
+PiiBinaryImage& PiiBinaryImage::operator&= (const PiiBinaryImage& other)
+{
+  Word* pWords = _vecWords.data();
+  const Word* pOther = other._vecWords.constData();
+  for (int i=_vecWords.size(); i--; )
+    pWords[i] &= pOther[i];
+  return *this;
+}
+
+PiiBinaryImage& PiiBinaryImage::operator-= (const PiiBinaryImage& other)
+{
+  Word* pWords = _vecWords.data();
+  const Word* pOther = other._vecWords.constData();
+  for (int i=_vecWords.size(); i--; )
+    pWords[i] &= ~pOther[i];
+  return *this;
+}
+
+bool PiiBinaryImage::operator== (const PiiBinaryImage& other) const
+{
+  return _iRows == other._iRows &&
+    _iColumns == other._iColumns &&
+    _vecWords == other._vecWords;
+}
+
+void PiiBinaryImage::invert()
+{
+  Word* pWords = _vecWords.data();
+  for (int i=_vecWords.size(); i--; )
+    pWords[i] = ~pWords[i];
+  clearPadding();
+}
+
+void PiiBinaryImage::clearPadding()
+{
+  const int iUsedBits = _iColumns % BitsPerWord;
+  if (iUsedBits == 0)
+    return;
+  const Word lastMask = (Word(1) << iUsedBits) - 1;
+  for (int r=0; r<_iRows; ++r)
+    row(r)[_iWordsPerRow-1] &= lastMask;
+}
@@ -0,0 +1,190 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIBINARYIMAGE_H
+#define _PIIBINARYIMAGE_H
+
+#include "PiiImageGlobal.h"
+#include <PiiMatrix.h>
+#include <QVector>
+
+/**
+ * A bit-packed binary image. Each row is stored as an array of
+ * 64-bit words so that one word holds 64 adjacent pixels. The least
+ * significant bit of the first word on a row is the leftmost pixel.
+ * Compared to a PiiMatrix, the memory footprint is 1/8 of a
+ * `PiiMatrix<unsigned char>`, and morphological operations (see
+ * [PiiImage::erode()], [PiiImage::dilate()] and
+ * [PiiImage::hitAndMiss()]) process 64 pixels at a time.
+ *
+ * Bits beyond the last column on each row are always zero.
+ * PiiBinaryImage is implicitly shared.
+ *
+ * ~~~(c++)
+ * PiiMatrix<unsigned char> matMask = ...;
+ * PiiBinaryImage mask(matMask);
+ * mask = PiiImage::erode(mask, PiiImage::createMask(PiiImage::RectangularMask, 5));
+ * matMask = mask.toMatrix<unsigned char>(255);
+ * ~~~
+ */
+class PII_IMAGE_EXPORT PiiBinaryImage
+{
+public:
+  typedef quint64 Word;
+  enum { BitsPerWord = 64 };
+
+  /**
+   * Creates an empty image with zero size.
+   */
+  PiiBinaryImage();
+  /**
+   * Creates a *rows* -by- *columns* image with all pixels set to
+   * zero.
+   */
+  PiiBinaryImage(int rows, int columns);
+  /**
+   * Creates a binary image out of *image*. Non-zero entries in
+   * *image* will be set to one.
+   */
+  template <class T> explicit PiiBinaryImage(const PiiMatrix<T>& image);
+
+  /**
+   * Converts the image to a matrix. Set pixels will be assigned
+   * *value*, others zero.
+   */
+  template <class T> PiiMatrix<T> toMatrix(T value = T(1)) const;
+
+  /**
+   * Returns the number of rows.
+   */
+  int rows() const { return _iRows; }
+  /**
+   * Returns the number of columns.
+   */
+  int columns() const { return _iColumns; }
+  /**
+   * Returns the number of words used for storing one row.
+   */
+  int wordsPerRow() const { return _iWordsPerRow; }
+
+  /**
+   * Returns a pointer to the first word on *row*.
+   */
+  const Word* row(int row) const { return _vecWords.constData() + row * _iWordsPerRow; }
+  /**
+   * Returns a pointer to the first word on *row*. Detaches the
+   * image.
+   */
+  Word* row(int row) { return _vecWords.data() + row * _iWordsPerRow; }
+
+  /**
+   * Returns `true` if the pixel at (*r*, *c*) is set.
+   */
+  bool testBit(int r, int c) const
+  {
+    return (row(r)[c / BitsPerWord] >> (c % BitsPerWord)) & 1;
+  }
+  /**
+   * Sets the pixel at (*r*, *c*) to *value*.
+   */
+  void setBit(int r, int c, bool value = true)
+  {
+    const Word mask = Word(1) << (c % BitsPerWord);
+    if (value)
+      row(r)[c / BitsPerWord] |= mask;
+    else
+      row(r)[c / BitsPerWord] &= ~mask;
+  }
+
+  /**
+   * Returns the number of set pixels.
+   */
+  int count() const;
+
+  /**
+   * Sets all pixels that are set in *other* and returns a reference
+   * to this image. Both images must be of the same size.
+   */
+  PiiBinaryImage& operator|= (const PiiBinaryImage& other);
+  /**
+   * Clears all pixels that are not set in *other*.
+   */
+  PiiBinaryImage& operator&= (const PiiBinaryImage& other);
+  /**
+   * Clears all pixels that are set in *other*.
+   */
+  PiiBinaryImage& operator-= (const PiiBinaryImage& other);
+
+  bool operator== (const PiiBinaryImage& other) const;
+  bool operator!= (const PiiBinaryImage& other) const { return !operator==(other); }
+
+  /**
+   * Inverts all pixels.
+   */
+  void invert();
+
+  /**
+   * Clears the bits beyond the last column on each row. This function
+   * must be called after whole words have been written through
+   * [row()] unless the padding bits are known to be zero.
+   */
+  void clearPadding();
+
+private:
+  int _iRows, _iColumns, _iWordsPerRow;
+  QVector<Word> _vecWords;
+};
+
+template <class T> PiiBinaryImage::PiiBinaryImage(const PiiMatrix<T>& image) :
+  _iRows(image.rows()), _iColumns(image.columns()),
+  _iWordsPerRow((image.columns() + BitsPerWord - 1) / BitsPerWord),
+  _vecWords(_iRows * _iWordsPerRow, 0)
+{
+  for (int r=0; r<_iRows; ++r)
+    {
+      const T* pSource = image[r];
+      Word* pTarget = row(r);
+      for (int c=0; c<_iColumns; c+=BitsPerWord, ++pTarget)
+        {
+          const int iEnd = qMin(int(BitsPerWord), _iColumns - c);
+          Word word = 0;
+          for (int b=0; b<iEnd; ++b)
+            if (pSource[c+b] != 0)
+              word |= Word(1) << b;
+          *pTarget = word;
+        }
+    }
+}
+
+template <class T> PiiMatrix<T> PiiBinaryImage::toMatrix(T value) const
+{
+  PiiMatrix<T> result(_iRows, _iColumns);
+  for (int r=0; r<_iRows; ++r)
+    {
+      const Word* pSource = row(r);
+      T* pTarget = result[r];
+      for (int c=0; c<_iColumns; c+=BitsPerWord, ++pSource)
+        {
+          Word word = *pSource;
+          // Skip empty words quickly
+          for (int b=c; word != 0; ++b, word >>= 1)
+            if (word & 1)
+              pTarget[b] = value;
+        }
+    }
+  return result;
+}
+
+#endif //_PIIBINARYIMAGE_H
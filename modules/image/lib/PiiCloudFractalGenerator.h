@@ -17,10 +17,10 @@
 #define _PIICLOUDFRACTALGENERATOR_H
 
 #include <PiiMath.h>
-#include <cstdlib>
+#include <PiiRandom.h>
 
-// Generate a randon number between -roughness and roughness.
-#define PII_FRAC_RAND(roughness)      ((rand() - RAND_MAX/2) % int(roughness))
+// Generate a random number between -roughness and roughness.
+#define PII_FRAC_RAND(roughness)      (int(Pii::uniformRandomIndex(2*int(roughness)-1)) - int(roughness) + 1)
 // Truncate a value to allowed range
 #define PII_FRAC_TRUNC(a)             ((a) < _iMinimum ? _iMinimum : (a) > _iMaximum ? _iMaximum : T(a))
 // Given three points a,b,c so that b is midway between a and c,
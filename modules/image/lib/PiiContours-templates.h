@@ -0,0 +1,446 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIICONTOURS_H
+# error "Never use <PiiContours-templates.h> directly; include <PiiContours.h> instead."
+#endif
+
+#include <PiiParallel.h>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+
+namespace PiiImage
+{
+  /// @internal
+  namespace Contours
+  {
+    // Directions of boundary cracks, clockwise. Objects are always on
+    // the right-hand side of a crack.
+    enum Direction { East, South, West, North };
+
+    // A horizontal or vertical segment of cracks. Vertical segments
+    // are always one pixel long.
+    struct Edge
+    {
+      Edge() {}
+      Edge(int x, int y, int length, int direction) :
+        x(x), y(y), length(length), direction(direction), used(false)
+      {}
+
+      bool operator< (const Edge& other) const { return x < other.x; }
+
+      int endX() const { return direction == East ? x + length : direction == West ? x - length : x; }
+      int endY() const { return direction == South ? y + 1 : direction == North ? y - 1 : y; }
+
+      int x, y, length, direction;
+      bool used;
+    };
+
+    // Stores the runs of object pixels on each row as (start, end)
+    // pairs. Runs of row r are at runs[starts[r]] ... runs[starts[r+1]-1].
+    template <class T> void findRuns(const PiiMatrix<T>& image, double level,
+                                     QVector<QPair<int,int> >& runs, QVector<int>& starts)
+    {
+      const int iRows = image.rows(), iColumns = image.columns();
+      starts.resize(iRows + 1);
+      for (int r=0; r<iRows; ++r)
+        {
+          starts[r] = runs.size();
+          const T* pRow = image[r];
+          for (int c=0; c<iColumns; )
+            {
+              while (c < iColumns && !(pRow[c] > level)) ++c;
+              if (c == iColumns)
+                break;
+              const int iStart = c;
+              while (c < iColumns && pRow[c] > level) ++c;
+              runs.append(qMakePair(iStart, c));
+            }
+        }
+      starts[iRows] = runs.size();
+    }
+
+    // Adds a horizontal edge for each interval covered by runs in
+    // first but not in second.
+    inline void subtractRuns(const QPair<int,int>* first, const QPair<int,int>* firstEnd,
+                             const QPair<int,int>* second, const QPair<int,int>* secondEnd,
+                             int y, int direction, QVector<Edge>& edges)
+    {
+      for (; first != firstEnd; ++first)
+        {
+          int iStart = first->first;
+          const int iEnd = first->second;
+          // Skip runs that end before this one starts.
+          while (second != secondEnd && second->second <= iStart) ++second;
+          for (const QPair<int,int>* pSecond = second;
+               pSecond != secondEnd && pSecond->first < iEnd && iStart < iEnd;
+               ++pSecond)
+            {
+              if (pSecond->first > iStart)
+                {
+                  if (direction == East)
+                    edges.append(Edge(iStart, y, pSecond->first - iStart, East));
+                  else
+                    edges.append(Edge(pSecond->first, y, pSecond->first - iStart, West));
+                }
+              iStart = qMax(iStart, pSecond->second);
+            }
+          if (iStart < iEnd)
+            {
+              if (direction == East)
+                edges.append(Edge(iStart, y, iEnd - iStart, East));
+              else
+                edges.append(Edge(iEnd, y, iEnd - iStart, West));
+            }
+        }
+    }
+
+    // Finds the edge that starts at (x,y) and continues a contour
+    // arriving in the given direction. At a vertex shared by two
+    // diagonally touching objects, the contour turns left if the
+    // objects are connected and right otherwise.
+    inline int findNextEdge(const QVector<Edge>& edges, const QVector<int>& rowStarts,
+                            int x, int y, int direction, bool connect8)
+    {
+      const Edge* pBegin = edges.constData() + rowStarts[y];
+      const Edge* pEnd = edges.constData() + rowStarts[y+1];
+      const Edge* pEdge = std::lower_bound(pBegin, pEnd, Edge(x, y, 0, 0));
+      if (pEdge + 1 < pEnd && pEdge[1].x == x)
+        {
+          const int iTurn = connect8 ? (direction + 3) & 3 : (direction + 1) & 3;
+          if (pEdge->direction != iTurn)
+            ++pEdge;
+        }
+      return pEdge - edges.constData();
+    }
+
+    // Places a point between the centers of an object pixel and a
+    // background pixel where the interpolated value equals level.
+    template <class T> inline void addCrossing(const PiiMatrix<T>& image, double level,
+                                               int objectX, int objectY, int backgroundX, int backgroundY,
+                                               QVector<double>& points)
+    {
+      double dT = 0.5;
+      if (backgroundX >= 0 && backgroundX < image.columns() &&
+          backgroundY >= 0 && backgroundY < image.rows())
+        {
+          const double dObject = double(image(objectY, objectX));
+          const double dBackground = double(image(backgroundY, backgroundX));
+          dT = (level - dBackground) / (dObject - dBackground);
+        }
+      points.append(backgroundX + 0.5 + dT * (objectX - backgroundX));
+      points.append(backgroundY + 0.5 + dT * (objectY - backgroundY));
+    }
+
+    template <class T> void addCrossings(const PiiMatrix<T>& image, double level,
+                                         const Edge& edge, QVector<double>& points)
+    {
+      switch (edge.direction)
+        {
+        case East:
+          for (int c=edge.x; c<edge.x + edge.length; ++c)
+            addCrossing(image, level, c, edge.y, c, edge.y-1, points);
+          break;
+        case South:
+          addCrossing(image, level, edge.x-1, edge.y, edge.x, edge.y, points);
+          break;
+        case West:
+          for (int c=edge.x-1; c>=edge.x - edge.length; --c)
+            addCrossing(image, level, c, edge.y-1, c, edge.y, points);
+          break;
+        case North:
+          addCrossing(image, level, edge.x, edge.y-1, edge.x-1, edge.y-1, points);
+          break;
+        }
+    }
+
+    // Squared distance from (x,y) to the line segment (x1,y1)-(x2,y2).
+    inline double squaredSegmentDistance(double x, double y, double x1, double y1, double x2, double y2)
+    {
+      const double dDx = x2 - x1, dDy = y2 - y1;
+      const double dLength = dDx*dDx + dDy*dDy;
+      double dT = dLength > 0 ? ((x - x1) * dDx + (y - y1) * dDy) / dLength : 0;
+      dT = qBound(0.0, dT, 1.0);
+      const double dX = x1 + dT * dDx - x, dY = y1 + dT * dDy - y;
+      return dX*dX + dY*dY;
+    }
+
+    // Marks the vertices to retain between first and last. The flag
+    // of vertex i is stored at keep[i - offset].
+    template <class T> void reduce(const PiiMatrix<T>& points, int first, int last,
+                                   double tolerance, QVector<bool>& keep, int offset)
+    {
+      QVector<QPair<int,int> > vecStack;
+      vecStack.append(qMakePair(first, last));
+      while (!vecStack.isEmpty())
+        {
+          const QPair<int,int> range = vecStack.last();
+          vecStack.removeLast();
+          const T* pFirst = points[range.first], *pLast = points[range.second];
+          double dMaxDistance = -1;
+          int iMaxIndex = -1;
+          for (int i=range.first+1; i<range.second; ++i)
+            {
+              const T* pPoint = points[i];
+              const double dDistance = squaredSegmentDistance(pPoint[0], pPoint[1],
+                                                              pFirst[0], pFirst[1],
+                                                              pLast[0], pLast[1]);
+              if (dDistance > dMaxDistance)
+                {
+                  dMaxDistance = dDistance;
+                  iMaxIndex = i;
+                }
+            }
+          if (dMaxDistance > tolerance)
+            {
+              keep[iMaxIndex - offset] = true;
+              vecStack.append(qMakePair(range.first, iMaxIndex));
+              vecStack.append(qMakePair(iMaxIndex, range.second));
+            }
+        }
+    }
+
+    inline double cross(const double* o, const double* a, const double* b)
+    {
+      return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+    }
+
+    inline bool pointLess(const double* a, const double* b)
+    {
+      return a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]);
+    }
+
+    // Calculates perimeter, area and convexity for each polygon
+    // in a block.
+    template <class T> struct PropertyCalculator
+    {
+      PropertyCalculator(const PiiMatrix<T>& points, const PiiMatrix<int>& limits,
+                         PiiMatrix<double>& properties) :
+        points(points), limits(limits), properties(properties)
+      {}
+
+      void operator() (int firstPolygon, int lastPolygon)
+      {
+        QVector<const double*> vecSorted, vecHull;
+        QVector<double> vecCoordinates;
+        for (int i=firstPolygon; i<lastPolygon; ++i)
+          {
+            const int iStart = i > 0 ? limits(0,i-1) : 0, iEnd = limits(0,i);
+            double dPerimeter = 0, dArea = 0;
+            for (int p=iStart+1; p<iEnd; ++p)
+              {
+                const T* pPrevious = points[p-1], *pCurrent = points[p];
+                const double dDx = double(pCurrent[0]) - pPrevious[0], dDy = double(pCurrent[1]) - pPrevious[1];
+                dPerimeter += std::sqrt(dDx*dDx + dDy*dDy);
+                dArea += double(pPrevious[0]) * pCurrent[1] - double(pCurrent[0]) * pPrevious[1];
+              }
+            dArea /= 2;
+
+            // Convex hull with Andrew's monotone chain. The last
+            // point repeats the first one and is skipped.
+            const int iPoints = iEnd - iStart - 1;
+            double dHullArea = 0;
+            if (iPoints >= 3)
+              {
+                vecCoordinates.resize(iPoints * 2);
+                vecSorted.resize(iPoints);
+                for (int p=0; p<iPoints; ++p)
+                  {
+                    vecCoordinates[2*p] = double(points(iStart+p, 0));
+                    vecCoordinates[2*p+1] = double(points(iStart+p, 1));
+                    vecSorted[p] = vecCoordinates.constData() + 2*p;
+                  }
+                std::sort(vecSorted.begin(), vecSorted.end(), pointLess);
+                vecHull.resize(2 * iPoints);
+                int k = 0;
+                for (int p=0; p<iPoints; ++p)
+                  {
+                    while (k >= 2 && cross(vecHull[k-2], vecHull[k-1], vecSorted[p]) <= 0) --k;
+                    vecHull[k++] = vecSorted[p];
+                  }
+                for (int p=iPoints-2, iLower=k+1; p>=0; --p)
+                  {
+                    while (k >= iLower && cross(vecHull[k-2], vecHull[k-1], vecSorted[p]) <= 0) --k;
+                    vecHull[k++] = vecSorted[p];
+                  }
+                for (int p=1; p<k; ++p)
+                  dHullArea += vecHull[p-1][0] * vecHull[p][1] - vecHull[p][0] * vecHull[p-1][1];
+                dHullArea = qAbs(dHullArea) / 2;
+              }
+
+            double* pProperties = properties[i];
+            pProperties[0] = dPerimeter;
+            pProperties[1] = dArea;
+            pProperties[2] = dHullArea > 0 ? qMin(qAbs(dArea) / dHullArea, 1.0) : 1.0;
+          }
+      }
+
+      const PiiMatrix<T>& points;
+      const PiiMatrix<int>& limits;
+      PiiMatrix<double>& properties;
+    };
+  }
+
+  template <class T> PiiMatrix<double> findContours(const PiiMatrix<T>& image,
+                                                    double level,
+                                                    ContourType type,
+                                                    Connectivity connectivity,
+                                                    PiiMatrix<int>* limits)
+  {
+    using namespace Contours;
+    const int iRows = image.rows();
+
+    QVector<QPair<int,int> > vecRuns;
+    QVector<int> vecRunStarts;
+    findRuns(image, level, vecRuns, vecRunStarts);
+
+    // Collect the edges that start on each row of pixel corners.
+    // Edges are sorted by their start column within a row.
+    QVector<Edge> vecEdges;
+    QVector<int> vecEdgeStarts(iRows + 2);
+    const QPair<int,int>* pRuns = vecRuns.constData();
+    for (int y=0; y<=iRows; ++y)
+      {
+        vecEdgeStarts[y] = vecEdges.size();
+        const QPair<int,int>* pCurrent = pRuns + (y < iRows ? vecRunStarts[y] : vecRunStarts[iRows]);
+        const QPair<int,int>* pCurrentEnd = pRuns + (y < iRows ? vecRunStarts[y+1] : vecRunStarts[iRows]);
+        const QPair<int,int>* pPrevious = pRuns + (y > 0 ? vecRunStarts[y-1] : 0);
+        const QPair<int,int>* pPreviousEnd = pRuns + (y > 0 ? vecRunStarts[y] : 0);
+
+        // Top edges of this row and bottom edges of the previous one
+        subtractRuns(pCurrent, pCurrentEnd, pPrevious, pPreviousEnd, y, East, vecEdges);
+        subtractRuns(pPrevious, pPreviousEnd, pCurrent, pCurrentEnd, y, West, vecEdges);
+        // Right ends of runs go down, left ends up.
+        for (const QPair<int,int>* pRun = pCurrent; pRun != pCurrentEnd; ++pRun)
+          vecEdges.append(Edge(pRun->second, y, 1, South));
+        for (const QPair<int,int>* pRun = pPrevious; pRun != pPreviousEnd; ++pRun)
+          vecEdges.append(Edge(pRun->first, y, 1, North));
+
+        std::sort(vecEdges.begin() + vecEdgeStarts[y], vecEdges.end());
+      }
+    vecEdgeStarts[iRows+1] = vecEdges.size();
+
+    // Chain the edges into closed contours. Each edge belongs to
+    // exactly one contour.
+    QVector<double> vecPoints;
+    vecPoints.reserve(vecEdges.size() * (type == CrackContour ? 2 : 4));
+    QVector<int> vecLimits;
+    const bool bConnect8 = connectivity == Connect8;
+    Edge* pEdges = vecEdges.data();
+    for (int iFirst=0; iFirst<vecEdges.size(); ++iFirst)
+      {
+        if (pEdges[iFirst].used)
+          continue;
+        const int iFirstPoint = vecPoints.size();
+        int iDirection = -1;
+        for (int i=iFirst; !pEdges[i].used; )
+          {
+            Edge& edge = pEdges[i];
+            edge.used = true;
+            if (type == CrackContour)
+              {
+                // Only corners are stored.
+                if (edge.direction != iDirection)
+                  {
+                    vecPoints.append(edge.x);
+                    vecPoints.append(edge.y);
+                  }
+              }
+            else
+              addCrossings(image, level, edge, vecPoints);
+            iDirection = edge.direction;
+            i = findNextEdge(vecEdges, vecEdgeStarts, edge.endX(), edge.endY(), iDirection, bConnect8);
+          }
+        // Close the contour
+        vecPoints.append(vecPoints[iFirstPoint]);
+        vecPoints.append(vecPoints[iFirstPoint+1]);
+        vecLimits.append(vecPoints.size() / 2);
+      }
+
+    if (limits != 0)
+      {
+        *limits = PiiMatrix<int>(PiiMatrix<int>::uninitialized(1, vecLimits.size()));
+        std::copy(vecLimits.constBegin(), vecLimits.constEnd(), limits->row(0));
+      }
+    PiiMatrix<double> matPoints(PiiMatrix<double>::uninitialized(vecPoints.size() / 2, 2));
+    for (int r=0; r<matPoints.rows(); ++r)
+      {
+        matPoints(r,0) = vecPoints[2*r];
+        matPoints(r,1) = vecPoints[2*r+1];
+      }
+    return matPoints;
+  }
+
+  template <class T> PiiMatrix<double> calculateContourProperties(const PiiMatrix<T>& points,
+                                                                  const PiiMatrix<int>& limits)
+  {
+    PiiMatrix<double> matProperties(PiiMatrix<double>::uninitialized(limits.columns(), 3));
+    Contours::PropertyCalculator<T> calculator(points, limits, matProperties);
+    Pii::parallelFor(0, limits.columns(), calculator, 64);
+    return matProperties;
+  }
+
+  template <class T> PiiMatrix<T> approximatePolygons(const PiiMatrix<T>& points,
+                                                      const PiiMatrix<int>& limits,
+                                                      double tolerance,
+                                                      PiiMatrix<int>* polygonLimits)
+  {
+    PiiMatrix<T> matResult(0,2);
+    matResult.reserve(points.rows() / 4 + 16);
+    if (polygonLimits != 0)
+      *polygonLimits = PiiMatrix<int>(PiiMatrix<int>::uninitialized(1, limits.columns()));
+
+    const double dTolerance = tolerance * tolerance;
+    QVector<bool> vecKeep;
+    for (int i=0; i<limits.columns(); ++i)
+      {
+        const int iStart = i > 0 ? limits(0,i-1) : 0, iEnd = limits(0,i);
+        const int iPoints = iEnd - iStart;
+        if (iPoints <= 4)
+          {
+            for (int p=iStart; p<iEnd; ++p)
+              matResult.appendRow(points[p]);
+          }
+        else
+          {
+            // Split at the point farthest from the start point.
+            const T* pStart = points[iStart];
+            int iFarthest = iStart + 1;
+            double dMaxDistance = -1;
+            for (int p=iStart+1; p<iEnd-1; ++p)
+              {
+                const double dDx = double(points(p,0)) - pStart[0], dDy = double(points(p,1)) - pStart[1];
+                if (dDx*dDx + dDy*dDy > dMaxDistance)
+                  {
+                    dMaxDistance = dDx*dDx + dDy*dDy;
+                    iFarthest = p;
+                  }
+              }
+            vecKeep.fill(false, iPoints);
+            vecKeep[0] = vecKeep[iFarthest - iStart] = vecKeep[iPoints-1] = true;
+            Contours::reduce(points, iStart, iFarthest, dTolerance, vecKeep, iStart);
+            Contours::reduce(points, iFarthest, iEnd-1, dTolerance, vecKeep, iStart);
+            for (int p=0; p<iPoints; ++p)
+              if (vecKeep[p])
+                matResult.appendRow(points[iStart + p]);
+          }
+        if (polygonLimits != 0)
+          (*polygonLimits)(0,i) = matResult.rows();
+      }
+    return matResult;
+  }
+}
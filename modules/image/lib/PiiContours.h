@@ -0,0 +1,126 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIICONTOURS_H
+#define _PIICONTOURS_H
+
+#include "PiiImageGlobal.h"
+#include <PiiMatrix.h>
+
+namespace PiiImage
+{
+  /**
+   * Extracts the outer and inner contours of all objects in *image*
+   * in a single pass. Pixels whose value is larger than *level* are
+   * objects. The image is first converted to runs of object pixels
+   * row by row. Each contour is then built by chaining the edges
+   * between the runs of successive rows. The time used depends on
+   * the number of runs and boundary cracks, not on the object pixels
+   * themselves, and no boundary mask is needed.
+   *
+   * Contour coordinates are given in a frame where pixel (x,y) covers
+   * the square from (x,y) to (x+1,y+1). Outer contours go clockwise on
+   * the screen and have a positive area in
+   * [calculateContourProperties()]. Holes go counter-clockwise and
+   * have a negative area.
+   *
+   * @param image the input image
+   *
+   * @param level the threshold. With `SubPixelContour`, this is also
+   * the level of the interpolated crossing points. Use 0.5 for binary
+   * images to place the points in the middle of the cracks.
+   *
+   * @param type the type of the contour points
+   *
+   * @param connectivity object connectivity. If two object pixels
+   * touch each other only diagonally, `Connect8` joins them into one
+   * contour and `Connect4` separates them.
+   *
+   * @param limits if non-zero, a 1-by-N matrix that stores the end
+   * indices of the N contours will be stored here. The first contour
+   * starts at zero, the second at `limits(0)` etc.
+   *
+   * @return the points of all contours as an M-by-2 matrix. Each row
+   * stores the (x,y) coordinates of a point. The last point of each
+   * contour is equal to its first point.
+   *
+   * ~~~(c++)
+   * PiiMatrix<int> matLimits;
+   * PiiMatrix<double> matPoints = PiiImage::findContours(matBinary, 0.5,
+   *                                                      PiiImage::SubPixelContour,
+   *                                                      PiiImage::Connect8,
+   *                                                      &matLimits);
+   * // Perimeter, area and convexity of each contour
+   * PiiMatrix<double> matProperties = PiiImage::calculateContourProperties(matPoints, matLimits);
+   * // Reduce each contour to a polygon that deviates at most one pixel
+   * PiiMatrix<int> matPolygonLimits;
+   * PiiMatrix<double> matPolygons = PiiImage::approximatePolygons(matPoints, matLimits,
+   *                                                               1.0, &matPolygonLimits);
+   * ~~~
+   */
+  template <class T> PiiMatrix<double> findContours(const PiiMatrix<T>& image,
+                                                    double level,
+                                                    ContourType type = CrackContour,
+                                                    Connectivity connectivity = Connect8,
+                                                    PiiMatrix<int>* limits = 0);
+
+  /**
+   * Calculates geometric properties of closed polygons. The polygons
+   * are processed in parallel.
+   *
+   * @param points the vertices of all polygons as an M-by-2 matrix,
+   * as returned by [findContours()]. The last point of each polygon
+   * must be equal to its first point.
+   *
+   * @param limits the end indices of the polygons in *points* as a
+   * 1-by-N matrix.
+   *
+   * @return an N-by-3 matrix. Each row stores the perimeter, the
+   * signed area and the convexity of a polygon, in this order.
+   * Convexity is the ratio of the (absolute) area to the area of the
+   * convex hull of the polygon. It is one for convex polygons.
+   */
+  template <class T> PiiMatrix<double> calculateContourProperties(const PiiMatrix<T>& points,
+                                                                  const PiiMatrix<int>& limits);
+
+  /**
+   * Approximates closed polygons with fewer vertices using the
+   * Douglas-Peucker algorithm. Each polygon is first split at the
+   * point farthest from its start point, and the two halves are then
+   * simplified separately.
+   *
+   * @param points the vertices of all polygons as an M-by-2 matrix.
+   * The last point of each polygon must be equal to its first point.
+   *
+   * @param limits the end indices of the polygons in *points*
+   *
+   * @param tolerance the maximum distance between a removed vertex
+   * and the approximating polygon. Note that unlike
+   * PiiGeometry::reduceVertices(), the distance is not squared.
+   *
+   * @param polygonLimits if non-zero, the end indices of the
+   * approximated polygons will be stored here.
+   *
+   * @return the vertices of the approximated polygons
+   */
+  template <class T> PiiMatrix<T> approximatePolygons(const PiiMatrix<T>& points,
+                                                      const PiiMatrix<int>& limits,
+                                                      double tolerance,
+                                                      PiiMatrix<int>* polygonLimits = 0);
+}
+
+#include "PiiContours-templates.h"
+
+#endif //_PIICONTOURS_H
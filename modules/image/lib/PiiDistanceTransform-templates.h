@@ -0,0 +1,225 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIDISTANCETRANSFORM_H
+# error "Never use <PiiDistanceTransform-templates.h> directly; include <PiiDistanceTransform.h> instead."
+#endif
+
+#include <PiiParallel.h>
+#include <QVarLengthArray>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+
+namespace PiiImage
+{
+  /// @internal
+  namespace DistanceTransform
+  {
+    // A distance that is larger than any real distance but small
+    // enough not to overflow when squared in double precision.
+    const float fInfinity = 1e9f;
+
+    // Calculates the distance to the closest zero pixel on each
+    // column. Columns are processed in blocks, row by row, so that
+    // the inner loops run over contiguous memory.
+    template <class T> struct ColumnPass
+    {
+      ColumnPass(const PiiMatrix<T>& image, PiiMatrix<float>& distances) :
+        image(image), distances(distances)
+      {}
+
+      void operator() (int firstColumn, int lastColumn)
+      {
+        const int iRows = image.rows();
+        for (int r=0; r<iRows; ++r)
+          {
+            const T* pSource = image[r];
+            float* pDistance = distances[r];
+            const float* pPrevious = r > 0 ? distances[r-1] : 0;
+            for (int c=firstColumn; c<lastColumn; ++c)
+              pDistance[c] = pSource[c] == 0 ? 0 : (pPrevious ? pPrevious[c] + 1 : fInfinity);
+          }
+        for (int r=iRows-1; r--; )
+          {
+            float* pDistance = distances[r];
+            const float* pNext = distances[r+1];
+            for (int c=firstColumn; c<lastColumn; ++c)
+              pDistance[c] = qMin(pDistance[c], pNext[c] + 1);
+          }
+      }
+
+      const PiiMatrix<T>& image;
+      PiiMatrix<float>& distances;
+    };
+
+    // Combines vertical distances along rows. Each row is replaced by
+    // the lower envelope of parabolas rooted at (c, distance(c)^2).
+    struct RowPass
+    {
+      RowPass(PiiMatrix<float>& distances) : distances(distances) {}
+
+      void operator() (int firstRow, int lastRow)
+      {
+        const int iColumns = distances.columns();
+        QVarLengthArray<double,1024> vecHeights(iColumns), vecBoundaries(iColumns+1);
+        QVarLengthArray<int,1024> vecRoots(iColumns);
+        double* f = vecHeights.data(), *z = vecBoundaries.data();
+        int* v = vecRoots.data();
+
+        for (int r=firstRow; r<lastRow; ++r)
+          {
+            float* pDistance = distances[r];
+            for (int c=0; c<iColumns; ++c)
+              f[c] = double(pDistance[c]) * pDistance[c];
+
+            // Build the lower envelope.
+            int k = 0;
+            v[0] = 0;
+            z[0] = -HUGE_VAL;
+            z[1] = HUGE_VAL;
+            for (int q=1; q<iColumns; ++q)
+              {
+                double s = intersection(f, q, v[k]);
+                while (s <= z[k])
+                  s = intersection(f, q, v[--k]);
+                ++k;
+                v[k] = q;
+                z[k] = s;
+                z[k+1] = HUGE_VAL;
+              }
+
+            // Sample the envelope.
+            k = 0;
+            for (int q=0; q<iColumns; ++q)
+              {
+                while (z[k+1] < q)
+                  ++k;
+                const double dDistance = double(q - v[k]) * (q - v[k]) + f[v[k]];
+                pDistance[q] = dDistance >= double(fInfinity) * fInfinity ? FLT_MAX : float(std::sqrt(dDistance));
+              }
+          }
+      }
+
+      // The column at which the parabolas rooted at p and q intersect.
+      static double intersection(const double* f, int q, int p)
+      {
+        return ((f[q] + double(q)*q) - (f[p] + double(p)*p)) / (2.0 * (q - p));
+      }
+
+      PiiMatrix<float>& distances;
+    };
+
+    // Two-pass raster scan with integer weights for orthogonal and
+    // diagonal steps. A diagonal weight of zero disables diagonal
+    // steps.
+    template <class T> void chamfer(const PiiMatrix<T>& image, PiiMatrix<float>& result,
+                                    int orthogonal, int diagonal)
+    {
+      const int iRows = image.rows(), iColumns = image.columns();
+      const int iInfinity = INT_MAX / 2;
+      const int iDiagonal = diagonal > 0 ? diagonal : iInfinity;
+      PiiMatrix<int> matDistances(PiiMatrix<int>::uninitialized(iRows, iColumns));
+
+      for (int r=0; r<iRows; ++r)
+        {
+          const T* pSource = image[r];
+          int* pRow = matDistances[r];
+          const int* pAbove = r > 0 ? matDistances[r-1] : 0;
+          for (int c=0; c<iColumns; ++c)
+            {
+              if (pSource[c] == 0)
+                {
+                  pRow[c] = 0;
+                  continue;
+                }
+              int iDistance = iInfinity;
+              if (c > 0)
+                iDistance = qMin(iDistance, pRow[c-1] + orthogonal);
+              if (pAbove)
+                {
+                  iDistance = qMin(iDistance, pAbove[c] + orthogonal);
+                  if (c > 0)
+                    iDistance = qMin(iDistance, pAbove[c-1] + iDiagonal);
+                  if (c < iColumns-1)
+                    iDistance = qMin(iDistance, pAbove[c+1] + iDiagonal);
+                }
+              pRow[c] = qMin(iDistance, iInfinity);
+            }
+        }
+
+      for (int r=iRows; r--; )
+        {
+          int* pRow = matDistances[r];
+          const int* pBelow = r < iRows-1 ? matDistances[r+1] : 0;
+          for (int c=iColumns; c--; )
+            {
+              int iDistance = pRow[c];
+              if (iDistance == 0)
+                continue;
+              if (c < iColumns-1)
+                iDistance = qMin(iDistance, pRow[c+1] + orthogonal);
+              if (pBelow)
+                {
+                  iDistance = qMin(iDistance, pBelow[c] + orthogonal);
+                  if (c < iColumns-1)
+                    iDistance = qMin(iDistance, pBelow[c+1] + iDiagonal);
+                  if (c > 0)
+                    iDistance = qMin(iDistance, pBelow[c-1] + iDiagonal);
+                }
+              pRow[c] = qMin(iDistance, iInfinity);
+            }
+        }
+
+      const float fScale = 1.0f / orthogonal;
+      for (int r=0; r<iRows; ++r)
+        {
+          const int* pDistance = matDistances[r];
+          float* pResult = result[r];
+          for (int c=0; c<iColumns; ++c)
+            pResult[c] = pDistance[c] >= iInfinity ? FLT_MAX : pDistance[c] * fScale;
+        }
+    }
+  }
+
+  template <class T> PiiMatrix<float> distanceTransform(const PiiMatrix<T>& image, DistanceType type)
+  {
+    PiiMatrix<float> matResult(PiiMatrix<float>::uninitialized(image.rows(), image.columns()));
+    if (image.rows() == 0 || image.columns() == 0)
+      return matResult;
+
+    switch (type)
+      {
+      case EuclideanDistance:
+        {
+          DistanceTransform::ColumnPass<T> columnPass(image, matResult);
+          Pii::parallelFor(0, image.columns(), columnPass, 64);
+          DistanceTransform::RowPass rowPass(matResult);
+          Pii::parallelFor(0, image.rows(), rowPass, 16);
+        }
+        break;
+      case ChamferDistance:
+        DistanceTransform::chamfer(image, matResult, 3, 4);
+        break;
+      case CityBlockDistance:
+        DistanceTransform::chamfer(image, matResult, 1, 0);
+        break;
+      case ChessboardDistance:
+        DistanceTransform::chamfer(image, matResult, 1, 1);
+        break;
+      }
+    return matResult;
+  }
+}
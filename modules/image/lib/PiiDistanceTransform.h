@@ -0,0 +1,56 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIDISTANCETRANSFORM_H
+#define _PIIDISTANCETRANSFORM_H
+
+#include "PiiImageGlobal.h"
+#include <PiiMatrix.h>
+
+namespace PiiImage
+{
+  /**
+   * Calculates the distance from each non-zero pixel in *image* to
+   * the closest zero pixel. Zero pixels will be zero in the result.
+   * If there are no zero pixels in the image, all distances will be
+   * set to `FLT_MAX`.
+   *
+   * All distance types are calculated in time linear to the number
+   * of pixels. The exact Euclidean distance is calculated in two
+   * separable passes, first along columns and then along rows, using
+   * the lower envelope of parabolas (Felzenszwalb and Huttenlocher).
+   * Both passes are run in parallel. The other distance types are
+   * calculated with a forward and a backward raster scan.
+   *
+   * @param image a binary image. Non-zero pixels are objects.
+   *
+   * @param type the distance measure
+   *
+   * @return distances to the closest background pixel
+   *
+   * ~~~(c++)
+   * PiiMatrix<unsigned char> matObjects = ...;
+   * // Find the cores of objects that are at least 10 pixels thick
+   * PiiMatrix<float> matDistances = PiiImage::distanceTransform(matObjects);
+   * PiiMatrix<int> matLabels = PiiImage::labelImage(matDistances >= 5);
+   * ~~~
+   */
+  template <class T> PiiMatrix<float> distanceTransform(const PiiMatrix<T>& image,
+                                                        DistanceType type = EuclideanDistance);
+}
+
+#include "PiiDistanceTransform-templates.h"
+
+#endif //_PIIDISTANCETRANSFORM_H
@@ -19,6 +19,10 @@
 
 #include <PiiAlgorithm.h>
 #include <PiiFunctional.h>
+#include <PiiParallel.h>
+#include <QVector>
+#include <QVarLengthArray>
+#include <cmath>
 
 namespace PiiImage
 {
@@ -29,12 +33,15 @@ namespace PiiImage
     PiiMatrix<T> result(1, int(levels));
     T* vector = result.row(0);
 
-    const int iRows = image.rows(), iCols = image.columns();
+    const int iRows = image.rows();
+    RoiSpans<Roi> spans(roi, 0, image.columns());
     for (int r=0; r<iRows; ++r)
       {
+        spans.selectRow(r);
         const U* row = image.row(r);
-        for (int c=0; c<iCols; ++c)
-          if (unsigned(row[c]) < levels && roi(r,c)) ++vector[unsigned(row[c])];
+        for (int i=0; i<spans.count(); ++i)
+          for (int c=spans.start(i), iEnd=spans.end(i); c<iEnd; ++c)
+            if (unsigned(row[c]) < levels) ++vector[unsigned(row[c])];
       }
     return result;
   }
@@ -44,12 +51,15 @@ namespace PiiImage
     PiiMatrix<T> result(1, quantizer.levels());
     T* vector = result.row(0);
 
-    const int iRows = image.rows(), iCols = image.columns();
+    const int iRows = image.rows();
+    RoiSpans<Roi> spans(roi, 0, image.columns());
     for (int r=0; r<iRows; ++r)
       {
+        spans.selectRow(r);
         const U* row = image.row(r);
-        for (int c=0; c<iCols; ++c)
-          if (roi(r,c)) ++vector[quantizer.quantize(row[c])];
+        for (int i=0; i<spans.count(); ++i)
+          for (int c=spans.start(i), iEnd=spans.end(i); c<iEnd; ++c)
+            ++vector[quantizer.quantize(row[c])];
       }
     return result;
   }
@@ -88,25 +98,169 @@ namespace PiiImage
     return end < cumulative.columns() ? end : -1;
   }
 
-  template <class T, class U> PiiMatrix<U> backProject(const PiiMatrix<T>& img, const PiiMatrix<U>& histogram)
+  /// @internal
+  namespace BackProjection
+  {
+    // Looks up histogram values for bands of rows. If *maxima* is
+    // non-zero, indices are clamped to the histogram, and the largest
+    // index of each band is stored. Indices are compared as unsigned
+    // integers so that negative values appear as large ones.
+    template <class T, class U> struct Lookup
+    {
+      Lookup(const PiiMatrix<T>& image, const U* histogram, int size,
+             PiiMatrix<U>& result, unsigned int* maxima) :
+        image(image), pHistogram(histogram), uiLast(unsigned(size - 1)),
+        result(result), pMaxima(maxima)
+      {}
+
+      void operator() (int block, int firstRow, int lastRow)
+      {
+        const int iColumns = image.columns();
+        if (pMaxima == 0)
+          {
+            for (int r=firstRow; r<lastRow; ++r)
+              {
+                const T* pSource = image[r];
+                U* pTarget = result[r];
+                int c = 0;
+                for (; c<iColumns-3; c+=4)
+                  {
+                    pTarget[c] = pHistogram[int(pSource[c])];
+                    pTarget[c+1] = pHistogram[int(pSource[c+1])];
+                    pTarget[c+2] = pHistogram[int(pSource[c+2])];
+                    pTarget[c+3] = pHistogram[int(pSource[c+3])];
+                  }
+                for (; c<iColumns; ++c)
+                  pTarget[c] = pHistogram[int(pSource[c])];
+              }
+          }
+        else
+          {
+            unsigned int uiMaximum = 0;
+            for (int r=firstRow; r<lastRow; ++r)
+              {
+                const T* pSource = image[r];
+                U* pTarget = result[r];
+                for (int c=0; c<iColumns; ++c)
+                  {
+                    const unsigned int uiIndex = unsigned(pSource[c]);
+                    uiMaximum = qMax(uiMaximum, uiIndex);
+                    pTarget[c] = pHistogram[qMin(uiIndex, uiLast)];
+                  }
+              }
+            pMaxima[block] = uiMaximum;
+          }
+      }
+
+      const PiiMatrix<T>& image;
+      const U* pHistogram;
+      unsigned int uiLast;
+      PiiMatrix<U>& result;
+      unsigned int* pMaxima;
+    };
+
+    // Two-dimensional version of Lookup. The first channel is mapped
+    // to histogram rows through a table of row pointers.
+    template <class T, class U> struct Lookup2D
+    {
+      Lookup2D(const PiiMatrix<T>& ch1, const PiiMatrix<T>& ch2, const U* const* rows,
+               int rowCount, int columnCount, PiiMatrix<U>& result,
+               unsigned int* maxima1, unsigned int* maxima2) :
+        ch1(ch1), ch2(ch2), pRows(rows),
+        uiLastRow(unsigned(rowCount - 1)), uiLastColumn(unsigned(columnCount - 1)),
+        result(result), pMaxima1(maxima1), pMaxima2(maxima2)
+      {}
+
+      void operator() (int block, int firstRow, int lastRow)
+      {
+        const int iColumns = ch1.columns();
+        if (pMaxima1 == 0)
+          {
+            for (int r=firstRow; r<lastRow; ++r)
+              {
+                const T* pSource1 = ch1[r];
+                const T* pSource2 = ch2[r];
+                U* pTarget = result[r];
+                for (int c=0; c<iColumns; ++c)
+                  pTarget[c] = pRows[int(pSource1[c])][int(pSource2[c])];
+              }
+          }
+        else
+          {
+            unsigned int uiMaximum1 = 0, uiMaximum2 = 0;
+            for (int r=firstRow; r<lastRow; ++r)
+              {
+                const T* pSource1 = ch1[r];
+                const T* pSource2 = ch2[r];
+                U* pTarget = result[r];
+                for (int c=0; c<iColumns; ++c)
+                  {
+                    const unsigned int uiRow = unsigned(pSource1[c]), uiColumn = unsigned(pSource2[c]);
+                    uiMaximum1 = qMax(uiMaximum1, uiRow);
+                    uiMaximum2 = qMax(uiMaximum2, uiColumn);
+                    pTarget[c] = pRows[qMin(uiRow, uiLastRow)][qMin(uiColumn, uiLastColumn)];
+                  }
+              }
+            pMaxima1[block] = uiMaximum1;
+            pMaxima2[block] = uiMaximum2;
+          }
+      }
+
+      const PiiMatrix<T>& ch1;
+      const PiiMatrix<T>& ch2;
+      const U* const* pRows;
+      unsigned int uiLastRow, uiLastColumn;
+      PiiMatrix<U>& result;
+      unsigned int *pMaxima1, *pMaxima2;
+    };
+  }
+
+  template <class T, class U> PiiMatrix<U> backProject(const PiiMatrix<T>& img, const PiiMatrix<U>& histogram,
+                                                       unsigned int* maximum)
   {
     PiiMatrix<U> result(PiiMatrix<U>::uninitialized(img.rows(), img.columns()));
-    Pii::transform(img.begin(), img.end(), result.begin(), Pii::arrayLookup(histogram[0]));
+    const int iBlocks = Pii::parallelBlockCount(img.rows(), 32);
+    QVarLengthArray<unsigned int,16> vecMaxima(iBlocks);
+    BackProjection::Lookup<T,U> lookup(img, histogram[0], histogram.columns(), result,
+                                       maximum != 0 ? vecMaxima.data() : 0);
+    Pii::parallelForBlocks(0, img.rows(), iBlocks, lookup);
+    if (maximum != 0)
+      {
+        *maximum = 0;
+        // Blocks are not run if there are no rows.
+        for (int b=0; b<iBlocks && !img.isEmpty(); ++b)
+          *maximum = qMax(*maximum, vecMaxima[b]);
+      }
     return result;
   }
 
   template <class T, class U> PiiMatrix<U> backProject(const PiiMatrix<T>& ch1, const PiiMatrix<T>& ch2,
-                                                       const PiiMatrix<U>& histogram)
+                                                       const PiiMatrix<U>& histogram,
+                                                       unsigned int* maximum1, unsigned int* maximum2)
   {
     PiiMatrix<U> result(PiiMatrix<U>::uninitialized(ch1.rows(), ch1.columns()));
-    const int iRows = ch1.rows(), iCols = ch1.columns();
-    for (int r=0; r<iRows; ++r)
+    QVarLengthArray<const U*,256> vecRows(histogram.rows());
+    for (int r=0; r<histogram.rows(); ++r)
+      vecRows[r] = histogram[r];
+
+    const int iBlocks = Pii::parallelBlockCount(ch1.rows(), 32);
+    QVarLengthArray<unsigned int,16> vecMaxima1(iBlocks), vecMaxima2(iBlocks);
+    const bool bCheck = maximum1 != 0 || maximum2 != 0;
+    BackProjection::Lookup2D<T,U> lookup(ch1, ch2, vecRows.constData(),
+                                         histogram.rows(), histogram.columns(), result,
+                                         bCheck ? vecMaxima1.data() : 0,
+                                         bCheck ? vecMaxima2.data() : 0);
+    Pii::parallelForBlocks(0, ch1.rows(), iBlocks, lookup);
+    if (bCheck)
       {
-        const T* ch1Row = ch1.row(r);
-        const T* ch2Row = ch2.row(r);
-        U* targetRow = result.row(r);
-        for (int c=0; c<iCols; ++c)
-          targetRow[c] = histogram((int)ch1Row[c], (int)ch2Row[c]);
+        unsigned int uiMaximum1 = 0, uiMaximum2 = 0;
+        for (int b=0; b<iBlocks && !ch1.isEmpty(); ++b)
+          {
+            uiMaximum1 = qMax(uiMaximum1, vecMaxima1[b]);
+            uiMaximum2 = qMax(uiMaximum2, vecMaxima2[b]);
+          }
+        if (maximum1 != 0) *maximum1 = uiMaximum1;
+        if (maximum2 != 0) *maximum2 = uiMaximum2;
       }
     return result;
   }
@@ -142,4 +296,212 @@ namespace PiiImage
       }
     return backProject(img, newDist);
   }
+
+  /// @internal
+  namespace AdaptiveEqualization
+  {
+    // Tiles are laid out evenly with a fractional size. The context
+    // window of a tile covers half of each neighboring tile.
+    inline int windowStart(int tile, double tileSize, int size)
+    {
+      return qBound(0, int(std::floor((tile - 0.5) * tileSize)), size);
+    }
+
+    inline int windowEnd(int tile, double tileSize, int size)
+    {
+      return qBound(0, int(std::ceil((tile + 1.5) * tileSize)), size);
+    }
+
+    // Clips a window histogram, redistributes the excess and stores
+    // the cumulative mapping to *mapping*.
+    template <class T> void buildMapping(const int* histogram, int* work, int levels,
+                                         int pixels, double clipLimit, T* mapping)
+    {
+      if (clipLimit > 0)
+        {
+          const int iClip = qMax(1, int(clipLimit * pixels / levels));
+          int iExcess = 0;
+          for (int i=0; i<levels; ++i)
+            {
+              if (histogram[i] > iClip)
+                {
+                  iExcess += histogram[i] - iClip;
+                  work[i] = iClip;
+                }
+              else
+                work[i] = histogram[i];
+            }
+          const int iAdd = iExcess / levels;
+          int iResidual = iExcess - iAdd * levels;
+          if (iAdd > 0)
+            for (int i=0; i<levels; ++i)
+              work[i] += iAdd;
+          if (iResidual > 0)
+            for (int i=0, iStep=qMax(levels / iResidual, 1); i<levels && iResidual > 0; i += iStep, --iResidual)
+              ++work[i];
+          histogram = work;
+        }
+
+      const double dScale = pixels > 0 ? double(levels - 1) / pixels : 0;
+      int iSum = 0;
+      for (int i=0; i<levels; ++i)
+        {
+          iSum += histogram[i];
+          mapping[i] = T(iSum * dScale + 0.5);
+        }
+    }
+
+    // Builds the mappings for a range of tile rows. The window
+    // histogram slides along the tile row so that each column enters
+    // and leaves it only once.
+    template <class T> struct MappingBuilder
+    {
+      MappingBuilder(const PiiMatrix<T>& image, PiiMatrix<T>& mappings,
+                     int gridRows, int gridColumns, double clipLimit) :
+        image(image), mappings(mappings),
+        iGridRows(gridRows), iGridColumns(gridColumns),
+        dTileHeight(double(image.rows()) / gridRows),
+        dTileWidth(double(image.columns()) / gridColumns),
+        dClipLimit(clipLimit)
+      {}
+
+      void operator() (int firstTileRow, int lastTileRow)
+      {
+        const int iLevels = mappings.columns();
+        const int iRows = image.rows(), iColumns = image.columns();
+        QVector<int> vecHistogram(iLevels), vecWork(iLevels);
+        int* pHistogram = vecHistogram.data();
+
+        for (int ty=firstTileRow; ty<lastTileRow; ++ty)
+          {
+            const int iTop = windowStart(ty, dTileHeight, iRows);
+            const int iBottom = windowEnd(ty, dTileHeight, iRows);
+            vecHistogram.fill(0);
+            int iLeft = 0, iRight = 0;
+            for (int tx=0; tx<iGridColumns; ++tx)
+              {
+                const int iNewLeft = windowStart(tx, dTileWidth, iColumns);
+                const int iNewRight = windowEnd(tx, dTileWidth, iColumns);
+                if (iNewLeft >= iRight)
+                  {
+                    // No overlap with the previous window.
+                    vecHistogram.fill(0);
+                    iLeft = iRight = iNewLeft;
+                  }
+                for (int r=iTop; r<iBottom; ++r)
+                  {
+                    const T* pRow = image[r];
+                    for (int c=iLeft; c<iNewLeft; ++c)
+                      --pHistogram[int(pRow[c])];
+                    for (int c=iRight; c<iNewRight; ++c)
+                      ++pHistogram[int(pRow[c])];
+                  }
+                iLeft = iNewLeft;
+                iRight = iNewRight;
+                buildMapping(pHistogram, vecWork.data(), iLevels,
+                             (iBottom - iTop) * (iRight - iLeft), dClipLimit,
+                             mappings[ty * iGridColumns + tx]);
+              }
+          }
+      }
+
+      const PiiMatrix<T>& image;
+      PiiMatrix<T>& mappings;
+      int iGridRows, iGridColumns;
+      double dTileHeight, dTileWidth, dClipLimit;
+    };
+
+    // The closest tile centers and the interpolation weight of the
+    // latter for a pixel coordinate.
+    struct Neighbors
+    {
+      int iFirst, iSecond;
+      float fWeight;
+    };
+
+    inline Neighbors neighbors(int position, double tileSize, int tiles)
+    {
+      const double dPosition = (position + 0.5) / tileSize - 0.5;
+      const int iFirst = int(std::floor(dPosition));
+      Neighbors result;
+      result.fWeight = float(dPosition - iFirst);
+      result.iFirst = qBound(0, iFirst, tiles-1);
+      result.iSecond = qBound(0, iFirst+1, tiles-1);
+      return result;
+    }
+
+    // Maps pixels through the four closest tile mappings and
+    // interpolates the results bilinearly.
+    template <class T> struct Interpolator
+    {
+      Interpolator(const PiiMatrix<T>& image, const PiiMatrix<T>& mappings,
+                   int gridRows, int gridColumns, PiiMatrix<T>& result) :
+        image(image), mappings(mappings),
+        iGridRows(gridRows), iGridColumns(gridColumns),
+        result(result)
+      {}
+
+      void operator() (int firstRow, int lastRow)
+      {
+        const int iColumns = image.columns();
+        const double dTileHeight = double(image.rows()) / iGridRows;
+        const double dTileWidth = double(iColumns) / iGridColumns;
+        QVarLengthArray<Neighbors,1024> vecColumns(iColumns);
+        for (int c=0; c<iColumns; ++c)
+          vecColumns[c] = neighbors(c, dTileWidth, iGridColumns);
+
+        for (int r=firstRow; r<lastRow; ++r)
+          {
+            const Neighbors rows = neighbors(r, dTileHeight, iGridRows);
+            const int iTop = rows.iFirst * iGridColumns, iBottom = rows.iSecond * iGridColumns;
+            const T* pSource = image[r];
+            T* pTarget = result[r];
+            for (int c=0; c<iColumns; ++c)
+              {
+                const Neighbors& columns = vecColumns[c];
+                const int iValue = int(pSource[c]);
+                const float fTop = mappings(iTop + columns.iFirst, iValue) +
+                  columns.fWeight * (float(mappings(iTop + columns.iSecond, iValue)) - mappings(iTop + columns.iFirst, iValue));
+                const float fBottom = mappings(iBottom + columns.iFirst, iValue) +
+                  columns.fWeight * (float(mappings(iBottom + columns.iSecond, iValue)) - mappings(iBottom + columns.iFirst, iValue));
+                pTarget[c] = T(fTop + rows.fWeight * (fBottom - fTop) + 0.5f);
+              }
+          }
+      }
+
+      const PiiMatrix<T>& image;
+      const PiiMatrix<T>& mappings;
+      int iGridRows, iGridColumns;
+      PiiMatrix<T>& result;
+    };
+  }
+
+  template <class T> PiiMatrix<T> adaptiveEqualize(const PiiMatrix<T>& img,
+                                                   int tileRows, int tileColumns,
+                                                   double clipLimit,
+                                                   unsigned int levels)
+  {
+    const int iRows = img.rows(), iColumns = img.columns();
+    if (iRows == 0 || iColumns == 0)
+      return img;
+
+    unsigned int maxValue = (unsigned int)Pii::max(img);
+    if (levels <= maxValue)
+      levels = maxValue + 1;
+    // The mappings store output levels as T.
+    if (double(levels) > double(Pii::Numeric<T>::maxValue()) + 1)
+      levels = (unsigned int)Pii::Numeric<T>::maxValue() + 1;
+
+    const int iGridRows = qMax(1, (iRows + qMax(tileRows,1)/2) / qMax(tileRows,1));
+    const int iGridColumns = qMax(1, (iColumns + qMax(tileColumns,1)/2) / qMax(tileColumns,1));
+
+    PiiMatrix<T> matMappings(PiiMatrix<T>::uninitialized(iGridRows * iGridColumns, int(levels)));
+    AdaptiveEqualization::MappingBuilder<T> builder(img, matMappings, iGridRows, iGridColumns, clipLimit);
+    Pii::parallelFor(0, iGridRows, builder, 1);
+
+    PiiMatrix<T> matResult(PiiMatrix<T>::uninitialized(iRows, iColumns));
+    AdaptiveEqualization::Interpolator<T> interpolator(img, matMappings, iGridRows, iGridColumns, matResult);
+    Pii::parallelFor(0, iRows, interpolator, 16);
+    return matResult;
+  }
 }
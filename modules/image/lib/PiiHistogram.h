@@ -165,7 +165,14 @@ namespace PiiImage
    *
    * @param histogram the histogram. A 1-by-N matrix.
    *
-   * The function makes no boundary checks for performance reasons. If
+   * @param maximum if non-zero, the largest value in `img`
+   * (converted to `unsigned int`) will be stored here. In this case,
+   * values that exceed the histogram are clamped to its last element,
+   * and the caller can check the result without a separate pass over
+   * the image. Negative values appear as large ones.
+   *
+   * Rows of `img` are processed in parallel. If `maximum` is zero,
+   * the function makes no boundary checks for performance reasons. If
    * you aren't sure about your data, you must check that
    * `histogram`.columns() is larger than the maximum value in `img`
    * and that there are no negative values in `img`.
@@ -186,7 +193,8 @@ namespace PiiImage
    * PiiMatrix<PiiColor<> > colorImg(PiiImage::backProject(indexedImg, colorMap);
    * ~~~
    */
-  template <class T, class U> PiiMatrix<U> backProject(const PiiMatrix<T>& img, const PiiMatrix<U>& histogram);
+  template <class T, class U> PiiMatrix<U> backProject(const PiiMatrix<T>& img, const PiiMatrix<U>& histogram,
+                                                       unsigned int* maximum = 0);
 
   /**
    * Two-dimensional histogram backprojection. This function is
@@ -203,6 +211,12 @@ namespace PiiImage
    *
    * @param histogram two-dimensional histogram (N-by-M)
    *
+   * @param maximum1 if non-zero, the largest value in `ch1` will be
+   * stored here. See the one-dimensional version for details.
+   *
+   * @param maximum2 if non-zero, the largest value in `ch2` will be
+   * stored here.
+   *
    * The sizes of `ch1` and `ch2` must be equal.
    *
    * ~~~(c++)
@@ -214,7 +228,9 @@ namespace PiiImage
    * ~~~
    */
   template <class T, class U> PiiMatrix<U> backProject(const PiiMatrix<T>& ch1, const PiiMatrix<T>& ch2,
-                                                       const PiiMatrix<U>& histogram);
+                                                       const PiiMatrix<U>& histogram,
+                                                       unsigned int* maximum1 = 0,
+                                                       unsigned int* maximum2 = 0);
 
   /**
    * Histogram equalization. Enhances the contrast of `img` by making
@@ -229,6 +245,50 @@ namespace PiiImage
    * @return an image with enhanced contrast
    */
   template <class T> PiiMatrix<T> equalize(const PiiMatrix<T>& img, unsigned int levels = 0);
+
+  /**
+   * Contrast-limited adaptive histogram equalization (CLAHE).
+   * Divides `img` into a grid of tiles and builds an equalizing
+   * mapping for each tile from the histogram of a window that extends
+   * half a tile over each neighboring tile. Each output pixel is a
+   * bilinear interpolation of the mappings of the four closest tile
+   * centers.
+   *
+   * The window histograms are not recalculated from scratch: when
+   * the window slides to the next tile on a tile row, only the
+   * columns that leave and enter the window are subtracted and
+   * added. Tile rows are processed in parallel.
+   *
+   * @param img the input image. Gray levels must not be negative.
+   *
+   * @param tileRows the nominal height of a tile in pixels. The tile
+   * grid will be adjusted so that the tiles cover the image evenly.
+   *
+   * @param tileColumns the nominal width of a tile in pixels.
+   *
+   * @param clipLimit the maximum frequency of a gray level in a
+   * window histogram, relative to the average frequency. The excess
+   * is distributed evenly to all levels, which limits the
+   * amplification of noise in uniform areas. Zero or a negative value
+   * disables clipping.
+   *
+   * @param levels the number of quantization levels. If this value
+   * is omitted or smaller than the maximum value in `img` plus one,
+   * the latter will be used. The number of levels is limited to the
+   * number of values representable by `T`.
+   *
+   * @return an image with locally enhanced contrast
+   *
+   * ~~~(c++)
+   * PiiMatrix<unsigned char> image = ...;
+   * // 64-by-64 tiles, clip at three times the average frequency
+   * PiiMatrix<unsigned char> enhanced = PiiImage::adaptiveEqualize(image, 64, 64, 3.0, 256);
+   * ~~~
+   */
+  template <class T> PiiMatrix<T> adaptiveEqualize(const PiiMatrix<T>& img,
+                                                   int tileRows, int tileColumns,
+                                                   double clipLimit = 3.0,
+                                                   unsigned int levels = 0);
 };
 
 #include "PiiHistogram-templates.h"
@@ -23,9 +23,73 @@
 
 #include <PiiMatrixUtil.h>
 #include <PiiMath.h>
+#include <PiiParallel.h>
+#include <algorithm>
 
 namespace PiiImage
 {
+  template <class U, class T, class Roi> U sum(const PiiMatrix<T>& image, const Roi& roi, int* pixelCount)
+  {
+    U total(0);
+    int iCount = 0;
+    RoiSpans<Roi> spans(roi, 0, image.columns());
+    for (int r=0; r<image.rows(); ++r)
+      {
+        spans.selectRow(r);
+        const T* pRow = image[r];
+        for (int i=0; i<spans.count(); ++i)
+          {
+            const int iEnd = spans.end(i);
+            for (int c=spans.start(i); c<iEnd; ++c)
+              total += U(pRow[c]);
+            iCount += iEnd - spans.start(i);
+          }
+      }
+    if (pixelCount != 0)
+      *pixelCount = iCount;
+    return total;
+  }
+
+  template <class U, class T, class Roi> U mean(const PiiMatrix<T>& image, const Roi& roi)
+  {
+    int iCount = 0;
+    U total = sum<U>(image, roi, &iCount);
+    return iCount > 0 ? total / iCount : U(0);
+  }
+
+  template <class U, class T, class Roi> U var(const PiiMatrix<T>& image, const Roi& roi, U* mean)
+  {
+    U total(0), squareSum(0);
+    int iCount = 0;
+    RoiSpans<Roi> spans(roi, 0, image.columns());
+    for (int r=0; r<image.rows(); ++r)
+      {
+        spans.selectRow(r);
+        const T* pRow = image[r];
+        for (int i=0; i<spans.count(); ++i)
+          {
+            const int iEnd = spans.end(i);
+            for (int c=spans.start(i); c<iEnd; ++c)
+              {
+                const U value(pRow[c]);
+                total += value;
+                squareSum += value * value;
+              }
+            iCount += iEnd - spans.start(i);
+          }
+      }
+    if (iCount == 0)
+      {
+        if (mean != 0)
+          *mean = U(0);
+        return U(0);
+      }
+    const U average = total / iCount;
+    if (mean != 0)
+      *mean = average;
+    return squareSum / iCount - average * average;
+  }
+
   template <class ColorType> PiiMatrix<typename ColorType::Type> colorChannel(const PiiMatrix<ColorType>& image,
                                                                               int channel)
   {
@@ -465,6 +529,182 @@ namespace PiiImage
     return matResult;
   }
 
+  // Applies a (pruned) sorting network to arrays of *length*
+  // elements. Each lane is a separate array, and the comparators
+  // operate on all elements at once.
+  template <class T> void applyRankNetwork(const RankNetwork::Network& network, T** lanes, int length)
+  {
+    for (int i = 0; i < network.size(); ++i)
+      {
+        T* pLow = lanes[network[i].iLow];
+        T* pHigh = lanes[network[i].iHigh];
+        switch (network[i].operation)
+          {
+          case RankNetwork::CompareExchange:
+            for (int c = 0; c < length; ++c)
+              {
+                T low = pLow[c], high = pHigh[c];
+                pLow[c] = low < high ? low : high;
+                pHigh[c] = low < high ? high : low;
+              }
+            break;
+          case RankNetwork::TakeMin:
+            for (int c = 0; c < length; ++c)
+              pLow[c] = pHigh[c] < pLow[c] ? pHigh[c] : pLow[c];
+            break;
+          case RankNetwork::TakeMax:
+            for (int c = 0; c < length; ++c)
+              pHigh[c] = pLow[c] < pHigh[c] ? pHigh[c] : pLow[c];
+            break;
+          }
+      }
+  }
+
+  // Filters a block of rows with sorting networks. Each thread has
+  // its own lane buffers.
+  template <class T> struct NetworkRankFilter
+  {
+    NetworkRankFilter(const PiiMatrix<T>& input, const RankNetwork& network, PiiMatrix<T>& output) :
+      input(input), network(network), output(output)
+    {}
+
+    void operator() (int firstRow, int lastRow)
+    {
+      const int iSize = network.iSize,
+        iInCols = input.columns(),
+        iOutCols = output.columns();
+      PiiMatrix<T> matColumns(PiiMatrix<T>::uninitialized(iSize, iInCols));
+      PiiMatrix<T> matRows(PiiMatrix<T>::uninitialized(iSize * iSize, iOutCols));
+      QVector<T*> vecColumnLanes(iSize), vecRowLanes(iSize * iSize),
+        vecCandidates(network.vecCandidates.size());
+      for (int i = 0; i < iSize; ++i)
+        vecColumnLanes[i] = matColumns.row(i);
+      for (int i = 0; i < iSize * iSize; ++i)
+        vecRowLanes[i] = matRows.row(i);
+      for (int i = 0; i < vecCandidates.size(); ++i)
+        vecCandidates[i] = vecRowLanes[network.vecCandidates[i].first * iSize +
+                                       network.vecCandidates[i].second];
+
+      for (int r = firstRow; r < lastRow; ++r)
+        {
+          // Sort the columns. Each sorted column is used by all
+          // windows that overlap it.
+          for (int i = 0; i < iSize; ++i)
+            Pii::copyN(input.row(r + i), iInCols, vecColumnLanes[i]);
+          applyRankNetwork(network.columnNetwork, vecColumnLanes.data(), iInCols);
+
+          // Sort the rows of each window as far as needed. Lane
+          // (i,j) holds the ith smallest value of the jth column in
+          // the window of each output pixel.
+          for (int i = 0; i < iSize; ++i)
+            {
+              T** ppLanes = vecRowLanes.data() + i * iSize;
+              for (int j = 0; j < iSize; ++j)
+                if (network.vecRowLanes[i][j])
+                  Pii::copyN(vecColumnLanes[i] + j, iOutCols, ppLanes[j]);
+              applyRankNetwork(network.vecRowNetworks[i], ppLanes, iOutCols);
+            }
+
+          applyRankNetwork(network.selectionNetwork, vecCandidates.data(), iOutCols);
+          Pii::copyN(vecCandidates[network.iResultIndex], iOutCols, output.row(r));
+        }
+    }
+
+    const PiiMatrix<T>& input;
+    const RankNetwork& network;
+    PiiMatrix<T>& output;
+  };
+
+  // Filters a block of rows by selecting the value of the requested
+  // rank separately in each window.
+  template <class T> struct GenericRankFilter
+  {
+    GenericRankFilter(const PiiMatrix<T>& input, int windowSize, int rank, PiiMatrix<T>& output) :
+      input(input), iWindowSize(windowSize), iRank(rank), output(output)
+    {}
+
+    void operator() (int firstRow, int lastRow)
+    {
+      const int iCount = iWindowSize * iWindowSize;
+      QVector<T> vecWindow(iCount);
+      T* pWindow = vecWindow.data();
+      for (int r = firstRow; r < lastRow; ++r)
+        {
+          T* pOutput = output.row(r);
+          for (int c = 0; c < output.columns(); ++c)
+            {
+              T* ptr = pWindow;
+              for (int i = 0; i < iWindowSize; ++i)
+                ptr = Pii::copyN(input.row(r + i) + c, iWindowSize, ptr);
+              std::nth_element(pWindow, pWindow + iRank, pWindow + iCount);
+              pOutput[c] = pWindow[iRank];
+            }
+        }
+    }
+
+    const PiiMatrix<T>& input;
+    int iWindowSize, iRank;
+    PiiMatrix<T>& output;
+  };
+
+  template <class T, bool numeric = Pii::IsNumeric<T>::boolValue> struct RankFilterImpl
+  {
+    static bool fastMedian(const PiiMatrix<T>&, int, Pii::ExtendMode, PiiMatrix<T>&) { return false; }
+  };
+
+  template <class T> struct RankFilterImpl<T, true>
+  {
+    static bool fastMedian(const PiiMatrix<T>& image, int windowSize, Pii::ExtendMode mode, PiiMatrix<T>& result)
+    {
+      if (windowSize != 3 && windowSize != 5 && windowSize != 7)
+        return false;
+      result = rankFilter(image, windowSize, windowSize * windowSize / 2, mode);
+      return true;
+    }
+
+    static bool networkFilter(const PiiMatrix<T>& input, int windowSize, int rank, PiiMatrix<T>& output)
+    {
+      if (windowSize > 7)
+        return false;
+      RankNetwork network(windowSize, rank);
+      NetworkRankFilter<T> filter(input, network, output);
+      Pii::parallelFor(0, output.rows(), filter, 16);
+      return true;
+    }
+  };
+
+  template <class T> PiiMatrix<T> rankFilter(const PiiMatrix<T>& image,
+                                             int windowSize, int rank,
+                                             Pii::ExtendMode mode)
+  {
+    windowSize = qMax(windowSize, 1) | 1;
+    rank = qBound(0, rank, windowSize * windowSize - 1);
+    const int iRadius = windowSize / 2;
+    PiiMatrix<T> matExtended(Pii::extend(image, iRadius, iRadius, iRadius, iRadius, mode));
+    const int iOutRows = matExtended.rows() - windowSize + 1,
+      iOutCols = matExtended.columns() - windowSize + 1;
+    if (iOutRows <= 0 || iOutCols <= 0)
+      return PiiMatrix<T>();
+
+    PiiMatrix<T> matResult(PiiMatrix<T>::uninitialized(iOutRows, iOutCols));
+    if (!RankFilterImpl<T>::networkFilter(matExtended, windowSize, rank, matResult))
+      {
+        GenericRankFilter<T> filter(matExtended, windowSize, rank, matResult);
+        Pii::parallelFor(0, iOutRows, filter, 16);
+      }
+    return matResult;
+  }
+
+  template <class T> PiiMatrix<T> percentileFilter(const PiiMatrix<T>& image,
+                                                   int windowSize, double percentile,
+                                                   Pii::ExtendMode mode)
+  {
+    windowSize = qMax(windowSize, 1) | 1;
+    return rankFilter(image, windowSize,
+                      Pii::round<int>(qBound(0.0, percentile, 1.0) * (windowSize * windowSize - 1)),
+                      mode);
+  }
+
   // PENDING use histogram-based filtering for large neighborhoods
   template <class T> PiiMatrix<T> medianFilter(const PiiMatrix<T>& image,
                                                int windowRows, int windowColumns,
@@ -472,6 +712,10 @@ namespace PiiImage
   {
     const int iRows = image.rows(), iCols = image.columns();
     if (windowColumns <= 0) windowColumns = windowRows;
+    PiiMatrix<T> matFast;
+    if (windowRows == windowColumns && windowRows <= iRows && windowColumns <= iCols &&
+        RankFilterImpl<T>::fastMedian(image, windowRows, mode, matFast))
+      return matFast;
     if (windowRows > iRows) windowRows = iRows;
     if (windowColumns > iCols) windowColumns = iCols;
     int rows = windowRows / 2, cols = windowColumns / 2;
@@ -1147,30 +1391,199 @@ namespace PiiImage
                                                 int smoothWidth,
                                                 T lowThreshold, T highThreshold)
   {
+    typedef typename Pii::Combine<T,int>::Type GradientType;
     // Filter the source image if necessary
-    PiiMatrix<T> matSource(smoothWidth != 0 ?
-                           filter<T>(image, GaussianFilter, Pii::ExtendReplicate, smoothWidth) :
-                           image);
+    if (smoothWidth != 0)
+      return cannyEdges(filter<T>(image, GaussianFilter, Pii::ExtendReplicate, smoothWidth),
+                        GradientType(lowThreshold), GradientType(highThreshold));
+    return cannyEdges(image, GradientType(lowThreshold), GradientType(highThreshold));
+  }
+
+  /// @internal
+  // Calculates Sobel gradients and their absolute sum one row at a
+  // time. The 3x3 Sobel masks are separated into a vertical and a
+  // horizontal pass so that the inner loops are plain arithmetic on
+  // contiguous arrays the compiler can vectorize.
+  template <class T, class G> class CannyGradient
+  {
+  public:
+    CannyGradient(const PiiMatrix<T>& image) :
+      _image(image),
+      _iRows(image.rows()),
+      _iColumns(image.columns()),
+      _vecZeros(image.columns(), T(0)),
+      _vecSum(image.columns() + 2, G(0)),
+      _vecDiff(image.columns() + 2, G(0))
+    {}
+
+    void operator() (int row, G* gradX, G* gradY, G* magnitude)
+    {
+      const T* pAbove = row > 0 ? _image[row-1] : _vecZeros.constData();
+      const T* pCenter = _image[row];
+      const T* pBelow = row < _iRows-1 ? _image[row+1] : _vecZeros.constData();
+      // The first and the last entry are zero padding.
+      G* pSum = _vecSum.data() + 1;
+      G* pDiff = _vecDiff.data() + 1;
+      for (int c=0; c<_iColumns; ++c)
+        {
+          pSum[c] = G(pAbove[c]) + 2 * G(pCenter[c]) + G(pBelow[c]);
+          pDiff[c] = G(pBelow[c]) - G(pAbove[c]);
+        }
+      for (int c=0; c<_iColumns; ++c)
+        {
+          gradX[c] = pSum[c+1] - pSum[c-1];
+          gradY[c] = pDiff[c-1] + 2 * pDiff[c] + pDiff[c+1];
+          magnitude[c] = Pii::abs(gradX[c]) + Pii::abs(gradY[c]);
+        }
+    }
 
-    PiiMatrix<T> matGradientX = filter<T>(matSource, SobelXFilter, Pii::ExtendZeros);
-    PiiMatrix<T> matGradientY = filter<T>(matSource, SobelYFilter, Pii::ExtendZeros);
-    PiiMatrix<T> matMagnitude = gradientMagnitude(matGradientX, matGradientY);
+  private:
+    const PiiMatrix<T>& _image;
+    const int _iRows, _iColumns;
+    QVector<T> _vecZeros;
+    QVector<G> _vecSum, _vecDiff;
+  };
 
-    // Automatic threshold if not explicitly given
+  template <class T>
+  PiiMatrix<int> cannyEdges(const PiiMatrix<T>& image,
+                            typename Pii::Combine<T,int>::Type lowThreshold,
+                            typename Pii::Combine<T,int>::Type highThreshold,
+                            PiiMatrix<typename Pii::Combine<T,int>::Type>* magnitude)
+  {
+    typedef typename Pii::Combine<T,int>::Type G;
+    const int iRows = image.rows(), iColumns = image.columns();
+    // 0 = not an edge, 1 = weak edge candidate, 2 = edge
+    PiiMatrix<int> matEdges(iRows, iColumns);
+    if (magnitude != 0)
+      *magnitude = PiiMatrix<G>(PiiMatrix<G>::uninitialized(iRows, iColumns));
+    if (iRows == 0 || iColumns == 0)
+      return matEdges;
+
+    CannyGradient<T,G> gradient(image);
+    // Each magnitude row is padded with one entry on both sides. The
+    // padding and the rows outside of the image are set to the
+    // maximum value so that a pixel on the border can never be a
+    // local maximum in a direction that points outside of the image.
+    const int iWidth = iColumns + 2;
+    const G maxMagnitude = Pii::Numeric<G>::maxValue();
+    QVector<G> vecMagnitude(3 * iWidth, maxMagnitude), vecBorder(iWidth, maxMagnitude);
+    QVector<G> vecGradX(3 * iColumns), vecGradY(3 * iColumns);
+
+    // Automatic threshold: the famous two-sigma rule (TM)
     if (highThreshold == 0)
       {
-        // Use the famous two-sigma rule (TM) as a threshold.
-        float fMean = 0;
-        float fStd = Pii::std<float>(matMagnitude, &fMean);
-        highThreshold = T(fMean + fStd * 2);
+        double dSum = 0, dSquareSum = 0;
+        G* pMagnitude = vecMagnitude.data() + 1;
+        for (int r=0; r<iRows; ++r)
+          {
+            gradient(r, vecGradX.data(), vecGradY.data(), pMagnitude);
+            for (int c=0; c<iColumns; ++c)
+              {
+                dSum += double(pMagnitude[c]);
+                dSquareSum += double(pMagnitude[c]) * double(pMagnitude[c]);
+              }
+          }
+        const double dCount = double(iRows) * iColumns;
+        const double dMean = dSum / dCount;
+        highThreshold = G(dMean + 2 * std::sqrt(qMax(dSquareSum / dCount - dMean * dMean, 0.0)));
       }
     if (lowThreshold == 0)
-      lowThreshold = T(0.4 * highThreshold);
+      lowThreshold = G(0.4 * highThreshold);
+
+    // Points to the strong edge pixels whose neighbors haven't been
+    // traced yet.
+    QVector<int*> vecStack;
+    vecStack.reserve(iColumns);
+    const float fTan22 = 0.41421356f; // tan(pi/8)
+
+    const G* pPrevious = vecBorder.constData() + 1;
+    gradient(0, vecGradX.data(), vecGradY.data(), vecMagnitude.data() + 1);
+    for (int r=0; r<iRows; ++r)
+      {
+        const int iSlot = r % 3;
+        const G* pCurrent = vecMagnitude.constData() + iSlot * iWidth + 1;
+        const G* pNext = vecBorder.constData() + 1;
+        if (r < iRows-1)
+          {
+            const int iNextSlot = (r+1) % 3;
+            G* pNextRow = vecMagnitude.data() + iNextSlot * iWidth + 1;
+            gradient(r+1,
+                     vecGradX.data() + iNextSlot * iColumns,
+                     vecGradY.data() + iNextSlot * iColumns,
+                     pNextRow);
+            pNext = pNextRow;
+          }
+        if (magnitude != 0)
+          std::copy(pCurrent, pCurrent + iColumns, (*magnitude)[r]);
+
+        const G* pGradX = vecGradX.constData() + iSlot * iColumns;
+        const G* pGradY = vecGradY.constData() + iSlot * iColumns;
+        int* pEdges = matEdges[r];
+        for (int c=0; c<iColumns; ++c)
+          {
+            const G currentMagnitude = pCurrent[c];
+            if (currentMagnitude < lowThreshold || currentMagnitude == 0)
+              continue;
+            // Quantize gradient direction to one of the eight points
+            // of the compass and pick the neighbors in the positive
+            // and negative gradient direction.
+            const float fAbsX = float(Pii::abs(pGradX[c])), fAbsY = float(Pii::abs(pGradY[c]));
+            const int iDx = fAbsX <= fTan22 * fAbsY ? 0 : (pGradX[c] > 0 ? 1 : -1);
+            const int iDy = fAbsY <= fTan22 * fAbsX ? 0 : (pGradY[c] > 0 ? 1 : -1);
+            const G* pPositiveRow = iDy > 0 ? pNext : iDy < 0 ? pPrevious : pCurrent;
+            const G* pNegativeRow = iDy > 0 ? pPrevious : iDy < 0 ? pNext : pCurrent;
+            // If the largest gradient area is wider than one pixel,
+            // the edge is taken at the positive gradient direction.
+            if (pPositiveRow[c + iDx] < currentMagnitude &&
+                pNegativeRow[c - iDx] <= currentMagnitude)
+              {
+                if (currentMagnitude >= highThreshold)
+                  {
+                    pEdges[c] = 2;
+                    vecStack.append(pEdges + c);
+                  }
+                else
+                  pEdges[c] = 1;
+              }
+          }
+        pPrevious = pCurrent;
+      }
+
+    // Trace weak edges connected to strong ones.
+    const int iStride = int(matEdges.stride() / sizeof(int));
+    int* const pFirst = matEdges[0];
+    while (!vecStack.isEmpty())
+      {
+        int* pEdge = vecStack.last();
+        vecStack.removeLast();
+        const int iIndex = int(pEdge - pFirst);
+        const int r = iIndex / iStride, c = iIndex % iStride;
+        for (int dr=-1; dr<=1; ++dr)
+          {
+            if (r + dr < 0 || r + dr >= iRows)
+              continue;
+            for (int dc=-1; dc<=1; ++dc)
+              {
+                if (c + dc < 0 || c + dc >= iColumns)
+                  continue;
+                int* pNeighbor = pEdge + dr * iStride + dc;
+                if (*pNeighbor == 1)
+                  {
+                    *pNeighbor = 2;
+                    vecStack.append(pNeighbor);
+                  }
+              }
+          }
+      }
 
-    return hysteresisThreshold(suppressNonMaxima(matMagnitude,
-                                                 gradientDirection(matGradientX, matGradientY),
-                                                 RadiansToPoints<float>()),
-                               lowThreshold, highThreshold);
+    // Convert to binary: 2 -> 1, 1 -> 0
+    for (int r=0; r<iRows; ++r)
+      {
+        int* pEdges = matEdges[r];
+        for (int c=0; c<iColumns; ++c)
+          pEdges[c] >>= 1;
+      }
+    return matEdges;
   }
 
   template <class T> PiiMatrix<int> detectFastCorners(const PiiMatrix<T>& image, T threshold)
@@ -15,6 +15,7 @@
 
 #include "PiiImage.h"
 #include <PiiMatrixUtil.h>
+#include <QHash>
 
 namespace PiiImage
 {
@@ -43,6 +44,95 @@ namespace PiiImage
                           0, 0, 0,
                           1, 1, 1);
 
+  RankNetwork::Network RankNetwork::sortingNetwork(int size)
+  {
+    // Batcher's odd-even merge sort for the next power of two.
+    // Comparators that touch the padding are no-ops if the padding is
+    // thought to be infinite, and can thus be left out.
+    int n = 1;
+    while (n < size)
+      n <<= 1;
+    Network network;
+    for (int p = 1; p < n; p <<= 1)
+      for (int k = p; k >= 1; k >>= 1)
+        for (int j = k % p; j + k < n; j += 2*k)
+          for (int i = 0; i < k && i + j + k < n; ++i)
+            if ((i + j) / (2*p) == (i + j + k) / (2*p) && i + j + k < size)
+              {
+                Comparator comparator = { i + j, i + j + k, CompareExchange };
+                network << comparator;
+              }
+    return network;
+  }
+
+  RankNetwork::Network RankNetwork::prune(const Network& network, int size, const QVector<bool>& needed)
+  {
+    // Walk backwards and keep only the comparators whose outputs are
+    // needed later. If just one output is needed, half of the
+    // compare-exchange suffices.
+    QVector<bool> vecNeeded(needed);
+    vecNeeded.resize(size);
+    Network result;
+    for (int i = network.size(); i--; )
+      {
+        Comparator comparator = network[i];
+        bool bLow = vecNeeded[comparator.iLow], bHigh = vecNeeded[comparator.iHigh];
+        if (!bLow && !bHigh)
+          continue;
+        comparator.operation = bLow && bHigh ? CompareExchange : bLow ? TakeMin : TakeMax;
+        vecNeeded[comparator.iLow] = vecNeeded[comparator.iHigh] = true;
+        result.prepend(comparator);
+      }
+    return result;
+  }
+
+  RankNetwork::RankNetwork(int size, int rank) :
+    iSize(size),
+    vecRowNetworks(size),
+    vecRowLanes(size, QVector<bool>(size, false)),
+    iResultIndex(0)
+  {
+    const int iCount = size * size;
+    rank = qBound(0, rank, iCount - 1);
+
+    /* Once both rows and columns are sorted, the value at (r,c) is
+       greater than or equal to at least (r+1)(c+1) values and less
+       than or equal to at least (size-r)(size-c) values. Positions
+       that cannot hold the value of the requested rank are left out.
+     */
+    int iBelow = 0;
+    QVector<bool> vecNeededRows(size, false);
+    for (int r = 0; r < size; ++r)
+      for (int c = 0; c < size; ++c)
+        {
+          if (iCount - (size - r) * (size - c) < rank)
+            ++iBelow;
+          else if ((r + 1) * (c + 1) - 1 <= rank)
+            {
+              vecCandidates << qMakePair(r, c);
+              vecRowLanes[r][c] = true;
+              vecNeededRows[r] = true;
+            }
+        }
+
+    Network sorter(sortingNetwork(size));
+    columnNetwork = prune(sorter, size, vecNeededRows);
+    for (int r = 0; r < size; ++r)
+      {
+        vecRowNetworks[r] = prune(sorter, size, vecRowLanes[r]);
+        // Inputs to the row network are needed too.
+        for (int i = 0; i < vecRowNetworks[r].size(); ++i)
+          vecRowLanes[r][vecRowNetworks[r][i].iLow] =
+            vecRowLanes[r][vecRowNetworks[r][i].iHigh] = true;
+      }
+
+    const int iCandidates = vecCandidates.size();
+    iResultIndex = rank - iBelow;
+    QVector<bool> vecResult(iCandidates, false);
+    vecResult[iResultIndex] = true;
+    selectionNetwork = prune(sortingNetwork(iCandidates), iCandidates, vecResult);
+  }
+
   PiiMatrix<double> makeGaussian(unsigned int size)
   {
     size |= 1; // make odd
@@ -222,7 +312,7 @@ namespace PiiImage
                                 const PiiMatrix<int>& rectangles)
   {
     PiiMatrix<bool> result(rows, columns);
-    for (int r=0; r<rows; ++r)
+    for (int r=0; r<rectangles.rows(); ++r)
       {
         const PiiRectangle<int>& rect = rectangles.rowAs<PiiRectangle<int> >(r);
         if (rect.x >=0 && rect.x < columns &&
@@ -251,6 +341,121 @@ namespace PiiImage
     return false;
   }
 
+  static inline bool isNeighbor(const QRect& r1, const QRect& r2)
+  {
+    // Either horizontally or vertically adjacent (or intersecting),
+    // but not diagonally.
+    return !((r2.right() < (r1.left()-1) ||
+              r2.left() > (r1.right()+1) ||
+              r2.bottom() < r1.top() ||
+              r2.top() > r1.bottom()) &&
+             (r2.right() < r1.left() ||
+              r2.left() > r1.right() ||
+              r2.bottom() < (r1.top()-1) ||
+              r2.top() > (r1.bottom())+1));
+  }
+
+  static int findRoot(QVector<int>& parents, int index)
+  {
+    while (parents[index] != index)
+      {
+        // Path halving keeps the trees flat.
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+      }
+    return index;
+  }
+
+  static inline int floorDiv(int value, int divisor)
+  {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+  }
+
+  QList<QList<int> > joinNeighbors(const QList<QRect>& rectangles,
+                                   const QList<int>& labels,
+                                   bool discardZero)
+  {
+    const int iRectangles = rectangles.size();
+    QList<QList<int> > lstResult;
+
+    // Size the grid cells according to the average rectangle. This
+    // keeps the number of cells per rectangle and rectangles per cell
+    // small.
+    qint64 iTotalWidth = 0, iTotalHeight = 0;
+    int iCount = 0;
+    for (int i=0; i<iRectangles; ++i)
+      if (!discardZero || labels[i] != 0)
+        {
+          iTotalWidth += rectangles[i].width();
+          iTotalHeight += rectangles[i].height();
+          ++iCount;
+        }
+    if (iCount < 2)
+      return lstResult;
+    const int iCellWidth = qMax(1, int(iTotalWidth / iCount)),
+      iCellHeight = qMax(1, int(iTotalHeight / iCount));
+
+    // Initially, each rectangle is a compound of its own.
+    QVector<int> vecParents(iRectangles);
+    for (int i=0; i<iRectangles; ++i)
+      vecParents[i] = i;
+
+    // Each rectangle is added to all cells its one-pixel neighborhood
+    // overlaps. Two rectangles can be neighbors only if they share a
+    // cell. Neighbors are merged with union-find.
+    QHash<qint64,QVector<int> > hashCells;
+    for (int i=0; i<iRectangles; ++i)
+      {
+        if (discardZero && labels[i] == 0)
+          continue;
+        const QRect& rect = rectangles[i];
+        const int iFirstX = floorDiv(rect.left() - 1, iCellWidth), iLastX = floorDiv(rect.right() + 1, iCellWidth);
+        const int iFirstY = floorDiv(rect.top() - 1, iCellHeight), iLastY = floorDiv(rect.bottom() + 1, iCellHeight);
+        for (int y=iFirstY; y<=iLastY; ++y)
+          for (int x=iFirstX; x<=iLastX; ++x)
+            {
+              QVector<int>& vecCell = hashCells[(qint64(y) << 32) | quint32(x)];
+              for (int j=0; j<vecCell.size(); ++j)
+                {
+                  const int iOther = vecCell[j];
+                  if (labels[i] == labels[iOther] && isNeighbor(rect, rectangles[iOther]))
+                    {
+                      const int iRoot1 = findRoot(vecParents, i), iRoot2 = findRoot(vecParents, iOther);
+                      if (iRoot1 != iRoot2)
+                        vecParents[qMax(iRoot1, iRoot2)] = qMin(iRoot1, iRoot2);
+                    }
+                }
+              vecCell.append(i);
+            }
+      }
+
+    // Link the rectangles of each compound into a list that starts at
+    // the root of the compound.
+    QVector<int> vecFirst(iRectangles, -1), vecNext(iRectangles, -1), vecSizes(iRectangles, 0);
+    for (int i=0; i<iRectangles; ++i)
+      {
+        const int iRoot = findRoot(vecParents, i);
+        vecNext[i] = vecFirst[iRoot];
+        vecFirst[iRoot] = i;
+        ++vecSizes[iRoot];
+      }
+
+    // Collect compounds in the order of their last rectangle.
+    for (int i=iRectangles; i--; )
+      {
+        const int iRoot = findRoot(vecParents, i);
+        if (vecSizes[iRoot] < 2 || vecFirst[iRoot] == -1)
+          continue;
+        QList<int> lstCompound;
+        // The list is in descending order, and i is its head.
+        for (int iIndex = vecFirst[iRoot]; iIndex != -1; iIndex = vecNext[iIndex])
+          lstCompound << iIndex;
+        lstResult << lstCompound;
+        vecFirst[iRoot] = -1;
+      }
+    return lstResult;
+  }
+
   PiiMatrix<bool> alphaToMask(const PiiMatrix<PiiColor4<> >& image)
   {
     const int iRows = image.rows(), iColumns = image.columns();
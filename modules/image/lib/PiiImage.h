@@ -17,12 +17,19 @@
 #define _PIIIMAGE_H
 
 #include "PiiImageGlobal.h"
+#include "PiiRunLengthRoi.h"
 #include <PiiMath.h>
 #include <PiiMatrixUtil.h>
 #include <PiiDsp.h>
 #include <PiiColor.h>
 #include <PiiPoint.h>
 
+#include <QVector>
+#include <QList>
+#include <QPair>
+#include <QRect>
+#include <QVarLengthArray>
+
 /**
  * Definitions and functions for image processing.
  *
@@ -74,6 +81,188 @@ namespace PiiImage
     const PiiMatrix<PiiColor4<T> > _image;
   };
 
+  /**
+   * Enumerates the horizontal spans of pixels that belong to a
+   * region of interest, one row at a time. Algorithms that iterate
+   * over the spans only touch the pixels within the ROI. The generic
+   * implementation tests each pixel with the ROI function object;
+   * the specializations for [DefaultRoi], [PiiRunLengthRoi] and mask
+   * matrices are faster.
+   *
+   * ~~~(c++)
+   * template <class T, class Roi> int countNonZero(const PiiMatrix<T>& image, const Roi& roi)
+   * {
+   *   int iCount = 0;
+   *   PiiImage::RoiSpans<Roi> spans(roi, 0, image.columns());
+   *   for (int r=0; r<image.rows(); ++r)
+   *     {
+   *       spans.selectRow(r);
+   *       const T* pRow = image[r];
+   *       for (int i=0; i<spans.count(); ++i)
+   *         for (int c=spans.start(i); c<spans.end(i); ++c)
+   *           if (pRow[c] != 0)
+   *             ++iCount;
+   *     }
+   *   return iCount;
+   * }
+   * ~~~
+   */
+  template <class Roi> class RoiSpans
+  {
+  public:
+    /**
+     * Creates a span enumerator that only reports pixels on columns
+     * [*left*, *right*).
+     */
+    RoiSpans(const Roi& roi, int left, int right) :
+      _roi(roi), _iLeft(left), _iRight(right)
+    {}
+
+    /**
+     * Finds the spans on *row*.
+     */
+    void selectRow(int row)
+    {
+      _lstSpans.clear();
+      for (int c=_iLeft; c<_iRight; )
+        {
+          while (c < _iRight && !_roi(row,c)) ++c;
+          if (c == _iRight)
+            break;
+          const int iStart = c;
+          while (c < _iRight && _roi(row,c)) ++c;
+          _lstSpans.append(PiiRunLengthRoi::Span(iStart, c));
+        }
+    }
+
+    /**
+     * Returns the number of spans on the selected row.
+     */
+    int count() const { return _lstSpans.size(); }
+    /**
+     * Returns the first column of the span at *index*.
+     */
+    int start(int index) const { return _lstSpans[index].start; }
+    /**
+     * Returns the column after the last one of the span at *index*.
+     */
+    int end(int index) const { return _lstSpans[index].end; }
+
+  private:
+    const Roi& _roi;
+    int _iLeft, _iRight;
+    QVarLengthArray<PiiRunLengthRoi::Span,16> _lstSpans;
+  };
+
+  template <> class RoiSpans<DefaultRoi>
+  {
+  public:
+    RoiSpans(const DefaultRoi&, int left, int right) :
+      _iLeft(left), _iRight(right)
+    {}
+
+    void selectRow(int) {}
+    int count() const { return _iLeft < _iRight ? 1 : 0; }
+    int start(int) const { return _iLeft; }
+    int end(int) const { return _iRight; }
+
+  private:
+    int _iLeft, _iRight;
+  };
+
+  template <> class RoiSpans<PiiRunLengthRoi>
+  {
+  public:
+    RoiSpans(const PiiRunLengthRoi& roi, int left, int right) :
+      _roi(roi), _iLeft(left), _iRight(right), _pSpans(0), _iCount(0)
+    {}
+
+    void selectRow(int row)
+    {
+      _pSpans = _roi.spans(row);
+      _iCount = _roi.spanCount(row);
+      // Skip spans outside of [left,right)
+      while (_iCount > 0 && _pSpans->end <= _iLeft)
+        {
+          ++_pSpans;
+          --_iCount;
+        }
+      while (_iCount > 0 && _pSpans[_iCount-1].start >= _iRight)
+        --_iCount;
+    }
+
+    int count() const { return _iCount; }
+    int start(int index) const { return qMax(_pSpans[index].start, _iLeft); }
+    int end(int index) const { return qMin(_pSpans[index].end, _iRight); }
+
+  private:
+    const PiiRunLengthRoi& _roi;
+    int _iLeft, _iRight;
+    const PiiRunLengthRoi::Span* _pSpans;
+    int _iCount;
+  };
+
+  template <class T> class RoiSpans<PiiMatrix<T> >
+  {
+  public:
+    RoiSpans(const PiiMatrix<T>& mask, int left, int right) :
+      _mask(mask), _iLeft(left), _iRight(right)
+    {}
+
+    void selectRow(int row)
+    {
+      _lstSpans.clear();
+      const T* pRow = _mask[row];
+      for (int c=_iLeft; c<_iRight; )
+        {
+          while (c < _iRight && pRow[c] == 0) ++c;
+          if (c == _iRight)
+            break;
+          const int iStart = c;
+          while (c < _iRight && pRow[c] != 0) ++c;
+          _lstSpans.append(PiiRunLengthRoi::Span(iStart, c));
+        }
+    }
+
+    int count() const { return _lstSpans.size(); }
+    int start(int index) const { return _lstSpans[index].start; }
+    int end(int index) const { return _lstSpans[index].end; }
+
+  private:
+    const PiiMatrix<T>& _mask;
+    int _iLeft, _iRight;
+    QVarLengthArray<PiiRunLengthRoi::Span,16> _lstSpans;
+  };
+
+  /**
+   * Calculates the sum of the pixels of *image* within *roi*. The
+   * return type is determined by the `U` template parameter.
+   *
+   * @param pixelCount if non-zero, the number of pixels in the ROI
+   * will be stored here.
+   *
+   * ~~~(c++)
+   * PiiRunLengthRoi roi(matMask);
+   * double dSum = PiiImage::sum<double>(image, roi);
+   * ~~~
+   */
+  template <class U, class T, class Roi> U sum(const PiiMatrix<T>& image, const Roi& roi, int* pixelCount = 0);
+
+  /**
+   * Calculates the mean of the pixels of *image* within *roi*.
+   * Returns zero if the ROI is empty.
+   */
+  template <class U, class T, class Roi> U mean(const PiiMatrix<T>& image, const Roi& roi);
+
+  /**
+   * Calculates the variance of the pixels of *image* within *roi*.
+   * Only the pixels within the ROI are accessed, and only once.
+   *
+   * @param mean if non-zero, the mean of the pixels will be stored
+   * here.
+   */
+  template <class U, class T, class Roi> U var(const PiiMatrix<T>& image, const Roi& roi, U* mean = 0);
+
   /**
    * Returns the alpha channel of `image` as a boolean mask. Non-zero
    * entries in the alpha channel will be `true` in the returned
@@ -105,6 +294,38 @@ namespace PiiImage
    */
   PII_IMAGE_EXPORT bool overlapping(const PiiMatrix<int>& rectangles);
 
+  /**
+   * Groups rectangles with equal labels into connected compounds. Two
+   * rectangles are neighbors if they intersect or are side by side.
+   * Rectangles that only touch diagonally are not neighbors.
+   * Neighbors of neighbors belong to the same compound.
+   *
+   * ~~~(c++)
+   * QList<QRect> lstRects;
+   * lstRects << QRect(0,0,10,10) << QRect(10,0,10,10) << QRect(20,10,10,10);
+   * QList<int> lstLabels;
+   * lstLabels << 1 << 1 << 1;
+   * // Returns ((1, 0)). The third rectangle touches the second one
+   * // only diagonally.
+   * QList<QList<int> > lstCompounds = PiiImage::joinNeighbors(lstRects, lstLabels);
+   * ~~~
+   *
+   * @param rectangles the rectangles to join
+   *
+   * @param labels a label for each rectangle
+   *
+   * @param discardZero if `true`, rectangles labeled with zero will
+   * not be joined.
+   *
+   * @return the indices of the rectangles in each compound.
+   * Rectangles with no neighbors are not included. The first index
+   * in each compound is the largest one, and the compounds are
+   * ordered by their first index in descending order.
+   */
+  PII_IMAGE_EXPORT QList<QList<int> > joinNeighbors(const QList<QRect>& rectangles,
+                                                    const QList<int>& labels,
+                                                    bool discardZero = false);
+
   typedef PiiMatrix<PiiPoint<int> > IntCoordinateMap;
   typedef PiiMatrix<PiiPoint<double> > DoubleCoordinateMap;
 
@@ -476,6 +697,50 @@ namespace PiiImage
                                                 int smoothWidth = 0,
                                                 T lowThreshold = 0, T highThreshold = 0);
 
+  /**
+   * Detects edges in a gray-level image with the Canny edge detector
+   * in a single streaming pass. Sobel gradients, non-maximum
+   * suppression and hysteresis thresholding are fused so that only
+   * three rows of gradients are kept in memory at a time, and the
+   * gradient direction is quantized on the fly instead of storing an
+   * angle for each pixel. Hysteresis is performed by tracing from
+   * strong edge pixels with an explicit stack. The result is
+   * equivalent to [suppressNonMaxima()] followed by
+   * [hysteresisThreshold()] with 8-connectivity, apart from the way
+   * ties between equal neighbors are resolved.
+   *
+   * Gradients are calculated with `int` for integer images and with
+   * the image type for floating-point images. The gradient magnitude
+   * is approximated with \(|x|+|y|\) (see [gradientMagnitude()]).
+   * Pixels outside of the image are assumed to be zeros.
+   *
+   * @param image a gray-level image
+   *
+   * @param lowThreshold the low threshold for hysteresis. If zero,
+   * 0.4 * *highThreshold* will be used.
+   *
+   * @param highThreshold the high threshold for hysteresis. If zero,
+   * the mean of the gradient magnitude plus two times its standard
+   * deviation will be used. This requires an extra pass over the
+   * image.
+   *
+   * @param magnitude an optional output-value parameter that receives
+   * the gradient magnitude of each pixel.
+   *
+   * @return a binary image in which detected edges are ones and other
+   * pixels zeros.
+   *
+   * ~~~(c++)
+   * PiiMatrix<unsigned char> image = ...;
+   * PiiMatrix<int> edges = PiiImage::cannyEdges(image, 40, 100);
+   * ~~~
+   */
+  template <class T>
+  PiiMatrix<int> cannyEdges(const PiiMatrix<T>& image,
+                            typename Pii::Combine<T,int>::Type lowThreshold = 0,
+                            typename Pii::Combine<T,int>::Type highThreshold = 0,
+                            PiiMatrix<typename Pii::Combine<T,int>::Type>* magnitude = 0);
+
   /**
    * Filter an image with the given filter. This is equivalent to
    * PiiDsp::filter(), except for the `mode` parameter.
@@ -796,6 +1061,10 @@ namespace PiiImage
   /**
    * Filters an image with a median filter.
    *
+   * Square 3x3, 5x5 and 7x7 windows on numeric pixel types are
+   * handled by [rankFilter()], which is much faster than the generic
+   * implementation used for other window sizes.
+   *
    * @param image the input image
    *
    * @param windowRows filter size in vertical direction
@@ -809,6 +1078,83 @@ namespace PiiImage
                                                int windowRows = 3, int windowColumns = 0,
                                                Pii::ExtendMode mode = Pii::ExtendZeros);
 
+  /**
+   * Filters an image with a rank filter. Each pixel is replaced by
+   * the *rank*th smallest value in the *windowSize* x *windowSize*
+   * neighborhood centered at it. Rank 0 produces a minimum filter,
+   * `windowSize*windowSize/2` a median filter and
+   * `windowSize*windowSize-1` a maximum filter.
+   *
+   * With 3x3, 5x5 and 7x7 windows on numeric pixel types, the filter
+   * is evaluated with sorting networks. The columns of the window
+   * are sorted first. Each sorted column is shared by all windows it
+   * belongs to. Only values that can still be the result are then
+   * passed to a selection network. The networks are applied to a row
+   * of pixels at a time using branchless min/max operations, which
+   * lets the compiler vectorize them. Other window sizes and pixel
+   * types use a generic selection algorithm.
+   *
+   * @param image the input image
+   *
+   * @param windowSize the width and height of the neighborhood.
+   * Even sizes will be rounded up to the next odd number.
+   *
+   * @param rank the zero-based rank of the output value within the
+   * neighborhood. Will be clamped to the valid range.
+   *
+   * @param mode the method of handling image borders
+   *
+   * ~~~(c++)
+   * // Remove salt-and-pepper noise
+   * PiiMatrix<unsigned char> matFiltered(PiiImage::rankFilter(matImage, 3, 4));
+   * ~~~
+   */
+  template <class T> PiiMatrix<T> rankFilter(const PiiMatrix<T>& image,
+                                             int windowSize, int rank,
+                                             Pii::ExtendMode mode = Pii::ExtendZeros);
+
+  /**
+   * Filters an image with a percentile filter. This is a convenience
+   * function that converts *percentile* (0-1) to a rank and calls
+   * [rankFilter()]. 0.5 produces a median filter.
+   */
+  template <class T> PiiMatrix<T> percentileFilter(const PiiMatrix<T>& image,
+                                                   int windowSize, double percentile,
+                                                   Pii::ExtendMode mode = Pii::ExtendZeros);
+
+  /// @internal
+  struct PII_IMAGE_EXPORT RankNetwork
+  {
+    enum Operation { CompareExchange, TakeMin, TakeMax };
+    struct Comparator
+    {
+      int iLow, iHigh;
+      Operation operation;
+    };
+    typedef QVector<Comparator> Network;
+
+    /* Builds the networks that find the value of the given rank in a
+       size x size window. */
+    RankNetwork(int size, int rank);
+
+    static Network sortingNetwork(int size);
+    static Network prune(const Network& network, int size, const QVector<bool>& needed);
+
+    int iSize;
+    // Sorts the columns of the window (size lanes).
+    Network columnNetwork;
+    // Partially sorts each row of the column-sorted window (size lanes).
+    QVector<Network> vecRowNetworks;
+    // Lanes whose values must be copied from sorted columns to row
+    // lanes. Indexed by row.
+    QVector<QVector<bool> > vecRowLanes;
+    // The (row, column) positions that may contain the result.
+    QVector<QPair<int,int> > vecCandidates;
+    // Selects the result among the candidates.
+    Network selectionNetwork;
+    int iResultIndex;
+  };
+
   template <class Input, class Output, class BinaryFunction>
   void medianFilter(const Input& image,
                     int windowRows,
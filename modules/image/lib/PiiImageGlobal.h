@@ -36,7 +36,7 @@ namespace PiiImage
 #ifdef Q_MOC_RUN
   Q_GADGET
 
-  Q_ENUMS(TransformedSize Connectivity MorphologyOperation MaskType RoiType PrebuiltFilterType);
+  Q_ENUMS(TransformedSize Connectivity MorphologyOperation MaskType RoiType PrebuiltFilterType DistanceType ContourType);
 public:
 #endif
 #ifndef PII_NO_QT
@@ -194,6 +194,37 @@ public:
       GaussianFilter,
       LoGFilter
     };
+
+  /**
+   * Distance measures for distance transforms.
+   *
+   * - `EuclideanDistance` - exact Euclidean distance.
+   *
+   * - `ChamferDistance` - an approximation of the Euclidean distance
+   * in which horizontal and vertical steps cost 1 and diagonal steps
+   * 4/3 (the 3-4 chamfer).
+   *
+   * - `CityBlockDistance` - the sum of horizontal and vertical
+   * distances (L1 norm).
+   *
+   * - `ChessboardDistance` - the maximum of horizontal and vertical
+   * distances (L-infinity norm).
+   */
+  enum DistanceType { EuclideanDistance, ChamferDistance, CityBlockDistance, ChessboardDistance };
+
+  /**
+   * Ways of representing object contours.
+   *
+   * - `CrackContour` - the contour runs along the cracks between
+   * object and background pixels. Only the corners are stored, and
+   * the polygon encloses exactly the object pixels.
+   *
+   * - `SubPixelContour` - one point is placed on each crack between
+   * an object and a background pixel, at the position where linear
+   * interpolation between the two pixel values crosses the threshold
+   * (marching squares).
+   */
+  enum ContourType { CrackContour, SubPixelContour };
 };
 
 #endif //_PIIIMAGEGLOBAL_H
@@ -409,69 +409,24 @@ namespace PiiImage
   PiiMatrix<typename Matrix::value_type> thin(const Matrix& image, int amount)
   {
     typedef typename Matrix::value_type T;
-    PiiMatrix<T> result(image);
-
-    if (amount >= 0)
-      {
-        while (amount--)
-          {
-            // Loop through all border detector masks
-            for (int m=8; m--;)
-              // Apply the binary subtraction function (take off edges in
-              // this direction)
-              result.map(BottomhatFunction<T>(), hitAndMiss(result, borderMasks[m][0], borderMasks[m][1]));
-          }
-      }
-    else
-      {
-        PiiMatrix<T> tmpResult(result);
-        // Apply the thinning operator as many times as necessary
-        while (true)
-          {
-            // Loop through all border detector masks
-            for (int m=8; m--;)
-              // Apply the binary subtraction function (take off edges in
-              // this direction)
-              tmpResult.map(BottomhatFunction<T>(), hitAndMiss(tmpResult, borderMasks[m][0], borderMasks[m][1]));
-            // compare matrices
-            if (Pii::equals(tmpResult,result))
-              break; // we converged
-            // No luck yet. Continue
-            result = tmpResult;
-          }
-      }
-
-    return result;
+    PiiBinaryImage result(thin(PiiBinaryImage(Pii::matrix(image)), amount));
+    return result.toMatrix<T>();
   }
 
   template <class Matrix>
   PiiMatrix<typename Matrix::value_type> border(const Matrix& image)
   {
     typedef typename Matrix::value_type T;
-    PiiMatrix<T> result(image.rows(), image.columns());
-
-    // Loop through all border detector masks
-    for (int m=8; m--;)
-      // Combine results into the resulting border matrix
-      result |= hitAndMiss(image, borderMasks[m][0], borderMasks[m][1]);
-
-    return result;
+    PiiBinaryImage result(border(PiiBinaryImage(Pii::matrix(image))));
+    return result.toMatrix<T>();
   }
 
   template <class Matrix>
   PiiMatrix<typename Matrix::value_type> shrink(const Matrix& image, int amount)
   {
     typedef typename Matrix::value_type T;
-    if (amount == 1)
-      // Subtract border from original image
-      return Pii::matrix(image.mapped(BottomhatFunction<T>(), border(image)));
-    else
-      {
-        PiiMatrix<T> result(image);
-        while (amount--)
-          result.map(BottomhatFunction<T>(), border(result));
-        return result;
-      }
+    PiiBinaryImage result(shrink(PiiBinaryImage(Pii::matrix(image)), amount));
+    return result.toMatrix<T>();
   }
 
   template <class T> void createMask(MaskType type, PiiMatrix<T>& mask)
@@ -16,6 +16,164 @@
 #include "PiiMorphology.h"
 #include <cmath>
 
+namespace
+{
+  typedef PiiBinaryImage::Word Word;
+
+  struct AndWord { Word operator() (Word a, Word b) const { return a & b; } };
+  struct AndNotWord { Word operator() (Word a, Word b) const { return a & ~b; } };
+  struct OrWord { Word operator() (Word a, Word b) const { return a | b; } };
+
+  // Returns the 64 bits that start at bit position *pos* on a row of
+  // *words* words. Bits outside of the row are zeros.
+  inline Word wordAt(const Word* row, int words, int pos)
+  {
+    const int iWord = pos >= 0 ? pos / 64 : -((-pos + 63) / 64);
+    const int iShift = pos - iWord * 64;
+    const Word lo = iWord >= 0 && iWord < words ? row[iWord] : 0;
+    if (iShift == 0)
+      return lo;
+    const Word hi = iWord + 1 >= 0 && iWord + 1 < words ? row[iWord+1] : 0;
+    return (lo >> iShift) | (hi << (64 - iShift));
+  }
+
+  // Combines *image* shifted by (dr, dc) into *result* so that
+  // result(r,c) = op(result(r,c), image(r+dr, c+dc)). Pixels outside
+  // of the image are zeros.
+  template <class Operation> void combineShifted(const PiiBinaryImage& image, int dr, int dc,
+                                                 PiiBinaryImage& result, Operation op)
+  {
+    const int iRows = image.rows(), iWords = image.wordsPerRow();
+    for (int r=0; r<iRows; ++r)
+      {
+        Word* pTarget = result.row(r);
+        const int iSourceRow = r + dr;
+        if (iSourceRow < 0 || iSourceRow >= iRows)
+          {
+            for (int w=0; w<iWords; ++w)
+              pTarget[w] = op(pTarget[w], Word(0));
+            continue;
+          }
+        const Word* pSource = image.row(iSourceRow);
+        for (int w=0; w<iWords; ++w)
+          pTarget[w] = op(pTarget[w], wordAt(pSource, iWords, w * 64 + dc));
+      }
+  }
+
+  // Index of the lowest set bit in a non-zero word (de Bruijn
+  // multiplication).
+  inline int lowestBit(Word word)
+  {
+    static const int aIndices[64] =
+      {
+        0,1,48,2,57,49,28,3,61,58,50,42,38,29,17,4,
+        62,55,59,36,53,51,43,22,45,39,33,30,24,18,12,5,
+        63,47,56,27,60,41,37,16,54,35,52,21,44,32,23,11,
+        46,26,40,15,34,20,31,10,25,14,19,9,13,8,7,6
+      };
+    return aIndices[((word & (~word + 1)) * Q_UINT64_C(0x03f79d71b4cb0a89)) >> 58];
+  }
+
+  // Returns the pixels at columns c-1, c and c+1 as a three-bit
+  // number. c must not be on the boundary.
+  inline int threeBits(const Word* row, int c)
+  {
+    const int iBit = c - 1, iWord = iBit >> 6, iShift = iBit & 63;
+    Word word = row[iWord] >> iShift;
+    if (iShift > 61)
+      word |= row[iWord+1] << (64 - iShift);
+    return int(word & 7);
+  }
+
+  // Codes the 3x3 neighborhood of (r,c) as a 9-bit number. Bit
+  // 3*i+j corresponds to mask entry (i,j).
+  inline int neighborhood(const PiiBinaryImage& image, int r, int c)
+  {
+    return threeBits(image.row(r-1), c) |
+      (threeBits(image.row(r), c) << 3) |
+      (threeBits(image.row(r+1), c) << 6);
+  }
+
+  // Marks in *lut* all 3x3 neighborhoods matched by a hit-and-miss
+  // mask. Old entries are retained.
+  void addToLut(const PiiMatrix<int>& mask, const PiiMatrix<int>& significance, bool* lut)
+  {
+    for (int iCode=0; iCode<512; ++iCode)
+      {
+        bool bMatch = true;
+        for (int i=0; i<9 && bMatch; ++i)
+          if (significance(i/3, i%3) != 0 && (mask(i/3, i%3) != 0) != ((iCode >> i) & 1))
+            bMatch = false;
+        lut[iCode] |= bMatch;
+      }
+  }
+
+  // Appends the indices (r*columns + c) of all set pixels that are
+  // not on the image boundary to *pixels*. Empty words are skipped
+  // 64 pixels at a time.
+  void collectInterior(const PiiBinaryImage& image, QVector<int>& pixels)
+  {
+    const int iRows = image.rows(), iColumns = image.columns(), iWords = image.wordsPerRow();
+    for (int r=1; r<iRows-1; ++r)
+      {
+        const Word* pRow = image.row(r);
+        for (int w=0; w<iWords; ++w)
+          for (Word word = pRow[w]; word != 0; word &= word - 1)
+            {
+              const int c = w * 64 + lowestBit(word);
+              if (c > 0 && c < iColumns - 1)
+                pixels.append(r * iColumns + c);
+            }
+      }
+  }
+
+  // Appends the set, non-boundary 8-neighbors of *changed* pixels
+  // (and the pixels themselves) to *pixels*. *queued* is used for
+  // removing duplicates and is left cleared.
+  void collectNeighbors(const PiiBinaryImage& image, const QVector<int>* changed, int lists,
+                        PiiBinaryImage& queued, QVector<int>& pixels)
+  {
+    const int iRows = image.rows(), iColumns = image.columns();
+    pixels.clear();
+    for (int l=0; l<lists; ++l)
+      for (int i=0; i<changed[l].size(); ++i)
+        {
+          const int r = changed[l][i] / iColumns, c = changed[l][i] % iColumns;
+          for (int nr = qMax(r-1, 1); nr <= qMin(r+1, iRows-2); ++nr)
+            for (int nc = qMax(c-1, 1); nc <= qMin(c+1, iColumns-2); ++nc)
+              if (image.testBit(nr, nc) && !queued.testBit(nr, nc))
+                {
+                  queued.setBit(nr, nc);
+                  pixels.append(nr * iColumns + nc);
+                }
+        }
+    for (int i=0; i<pixels.size(); ++i)
+      queued.setBit(pixels[i] / iColumns, pixels[i] % iColumns, false);
+  }
+
+  // Appends the candidates whose neighborhood matches *lut* to
+  // *matches*.
+  void findMatches(const PiiBinaryImage& image, const QVector<int>& candidates,
+                   const bool* lut, QVector<int>& matches)
+  {
+    const int iColumns = image.columns();
+    matches.clear();
+    for (int i=0; i<candidates.size(); ++i)
+      {
+        const int r = candidates[i] / iColumns, c = candidates[i] % iColumns;
+        if (image.testBit(r, c) && lut[neighborhood(image, r, c)])
+          matches.append(candidates[i]);
+      }
+  }
+
+  void clearPixels(PiiBinaryImage& image, const QVector<int>& pixels)
+  {
+    const int iColumns = image.columns();
+    for (int i=0; i<pixels.size(); ++i)
+      image.setBit(pixels[i] / iColumns, pixels[i] % iColumns, false);
+  }
+}
+
 namespace PiiImage
 {
   PiiMatrix<int> borderMasks[8][2] =
@@ -118,6 +276,137 @@ namespace PiiImage
       }
     };
 
+  PiiBinaryImage erode(const PiiBinaryImage& image, const PiiMatrix<int>& mask)
+  {
+    const int rOrig = mask.rows() / 2, cOrig = mask.columns() / 2;
+    PiiBinaryImage result(image.rows(), image.columns());
+    result.invert();
+    for (int mr=0; mr<mask.rows(); ++mr)
+      for (int mc=0; mc<mask.columns(); ++mc)
+        if (mask(mr,mc) != 0)
+          combineShifted(image, mr - rOrig, mc - cOrig, result, AndWord());
+    return result;
+  }
+
+  PiiBinaryImage dilate(const PiiBinaryImage& image, const PiiMatrix<int>& mask)
+  {
+    const int rOrig = mask.rows() / 2, cOrig = mask.columns() / 2;
+    PiiBinaryImage result(image.rows(), image.columns());
+    for (int mr=0; mr<mask.rows(); ++mr)
+      for (int mc=0; mc<mask.columns(); ++mc)
+        if (mask(mr,mc) != 0)
+          combineShifted(image, rOrig - mr, cOrig - mc, result, OrWord());
+    // Shifting to the left may have moved pixels to the padding area.
+    result.clearPadding();
+    return result;
+  }
+
+  PiiBinaryImage hitAndMiss(const PiiBinaryImage& image,
+                            const PiiMatrix<int>& mask,
+                            const PiiMatrix<int>& significance)
+  {
+    const int rOrig = mask.rows() / 2, cOrig = mask.columns() / 2;
+    PiiBinaryImage result(image.rows(), image.columns());
+    result.invert();
+    for (int mr=0; mr<mask.rows(); ++mr)
+      for (int mc=0; mc<mask.columns(); ++mc)
+        {
+          if (significance(mr,mc) == 0)
+            continue;
+          if (mask(mr,mc) != 0)
+            combineShifted(image, mr - rOrig, mc - cOrig, result, AndWord());
+          else
+            combineShifted(image, mr - rOrig, mc - cOrig, result, AndNotWord());
+        }
+    result.clearPadding();
+    return result;
+  }
+
+  PiiBinaryImage thin(const PiiBinaryImage& image, int amount)
+  {
+    PiiBinaryImage result(image);
+    const int iRows = image.rows(), iColumns = image.columns();
+    if (amount == 0 || iRows < 3 || iColumns < 3)
+      return result;
+
+    bool aLuts[8][512] = { { false } };
+    for (int m=0; m<8; ++m)
+      addToLut(borderMasks[m][0], borderMasks[m][1], aLuts[m]);
+
+    // Pixels removed during the previous pass in each direction.
+    QVector<int> aRemoved[8];
+    QVector<int> vecCandidates;
+    PiiBinaryImage queued(iRows, iColumns);
+    collectInterior(result, vecCandidates);
+
+    for (int iPass=0; ; ++iPass)
+      {
+        bool bChanged = false;
+        for (int m=8; m--; )
+          {
+            // A pixel that did not match in this direction on the
+            // previous pass cannot match now unless something
+            // changed in its neighborhood during the last eight
+            // sub-passes.
+            if (iPass > 0)
+              collectNeighbors(result, aRemoved, 8, queued, vecCandidates);
+            // Find all matches first to keep the result independent
+            // of processing order.
+            findMatches(result, vecCandidates, aLuts[m], aRemoved[m]);
+            clearPixels(result, aRemoved[m]);
+            bChanged |= aRemoved[m].size() != 0;
+          }
+        if (!bChanged || --amount == 0)
+          break;
+      }
+    return result;
+  }
+
+  PiiBinaryImage border(const PiiBinaryImage& image)
+  {
+    PiiBinaryImage result(image.rows(), image.columns());
+    if (image.rows() < 3 || image.columns() < 3)
+      return result;
+
+    bool aLut[512] = { false };
+    for (int m=0; m<8; ++m)
+      addToLut(borderMasks[m][0], borderMasks[m][1], aLut);
+
+    QVector<int> vecCandidates, vecBorder;
+    collectInterior(image, vecCandidates);
+    findMatches(image, vecCandidates, aLut, vecBorder);
+    for (int i=0; i<vecBorder.size(); ++i)
+      result.setBit(vecBorder[i] / image.columns(), vecBorder[i] % image.columns());
+    return result;
+  }
+
+  PiiBinaryImage shrink(const PiiBinaryImage& image, int amount)
+  {
+    PiiBinaryImage result(image);
+    const int iRows = image.rows(), iColumns = image.columns();
+    if (amount <= 0 || iRows < 3 || iColumns < 3)
+      return result;
+
+    bool aLut[512] = { false };
+    for (int m=0; m<8; ++m)
+      addToLut(borderMasks[m][0], borderMasks[m][1], aLut);
+
+    QVector<int> vecCandidates, vecRemoved;
+    PiiBinaryImage queued(iRows, iColumns);
+    collectInterior(result, vecCandidates);
+    while (true)
+      {
+        findMatches(result, vecCandidates, aLut, vecRemoved);
+        clearPixels(result, vecRemoved);
+        if (vecRemoved.isEmpty() || --amount == 0)
+          break;
+        // Only the neighbors of removed pixels may become border
+        // pixels on the next round.
+        collectNeighbors(result, &vecRemoved, 1, queued, vecCandidates);
+      }
+    return result;
+  }
+
   PiiMatrix<int> createMask(MaskType type, int rows, int columns)
   {
     return createMask<int>(type,rows,columns);
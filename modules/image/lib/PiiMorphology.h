@@ -19,6 +19,7 @@
 #include <PiiMatrix.h>
 #include <iostream>
 #include "PiiImageGlobal.h"
+#include "PiiBinaryImage.h"
 #include <PiiTemplateExport.h>
 
 namespace PiiImage
@@ -331,45 +332,91 @@ namespace PiiImage
                                                     const PiiMatrix<U>& mask,
                                                     const PiiMatrix<U>& significance);
 
+  /**
+   * Erodes a bit-packed binary image. Pixels outside of the image are
+   * assumed to be zeros. Each row is processed 64 pixels at a time,
+   * which makes this function much faster than the matrix version.
+   */
+  PII_IMAGE_EXPORT PiiBinaryImage erode(const PiiBinaryImage& image, const PiiMatrix<int>& mask);
+
+  /**
+   * Dilates a bit-packed binary image.
+   */
+  PII_IMAGE_EXPORT PiiBinaryImage dilate(const PiiBinaryImage& image, const PiiMatrix<int>& mask);
+
+  /**
+   * Hit-and-miss transform for bit-packed binary images. Unlike the
+   * matrix version, this function assumes zeros outside of the image
+   * and thus also detects matches on image borders.
+   */
+  PII_IMAGE_EXPORT PiiBinaryImage hitAndMiss(const PiiBinaryImage& image,
+                                             const PiiMatrix<int>& mask,
+                                             const PiiMatrix<int>& significance);
+
   /**
    * Thins binary objects towards a skeleton.
    *
-   * @param image input image
+   * @param image input image. Non-zero pixels are treated as
+   * foreground.
    *
    * @param amount the number of iterations. On each iteration, one
    * border pixel will be removed. If amount < 0, the operation loops
    * until the binary objects have converged to one-pixel wide
    * skeletons.
    *
-   * @return thinned image
+   * @return thinned image. Foreground pixels are set to one.
+   *
+   * The operation is performed on a [PiiBinaryImage]. Each
+   * iteration consists of eight sub-passes, one for each of the
+   * [borderMasks], in which the 3x3 neighborhood of a pixel is
+   * matched with a single table look-up. After the first iteration,
+   * only pixels whose neighborhood changed during the previous eight
+   * sub-passes are inspected. Pixels on the image boundary are never
+   * removed.
    */
   template <class Matrix>
   PiiMatrix<typename Matrix::value_type> thin(const Matrix& image, int amount = 1);
 
+  /**
+   * Thins a bit-packed binary image. See [thin()].
+   */
+  PII_IMAGE_EXPORT PiiBinaryImage thin(const PiiBinaryImage& image, int amount = 1);
+
   /**
    * Extracts the border of binary objects.
    *
    * @param image input image
    *
    * @return an image in which only the borders of binary objects are
-   * retained.
+   * retained. Border pixels are set to one.
    */
   template <class Matrix>
   PiiMatrix<typename Matrix::value_type> border(const Matrix& image);
 
+  /**
+   * Extracts the border of objects in a bit-packed binary image.
+   */
+  PII_IMAGE_EXPORT PiiBinaryImage border(const PiiBinaryImage& image);
+
   /**
    * Remove object borders. This operation is equivalent to
    * subtracting border() from the original image.
    *
    * @param image input image
    *
-   * @param amount the number of iterations.
+   * @param amount the number of iterations. After the first
+   * iteration, only the neighbors of removed pixels are inspected.
    *
    * @return an image in which the borders of binary objects have been
-   * removed.
+   * removed. Remaining pixels are set to one.
    */
   template <class Matrix>
   PiiMatrix<typename Matrix::value_type> shrink(const Matrix& image, int amount = 1);
+
+  /**
+   * Removes object borders from a bit-packed binary image.
+   */
+  PII_IMAGE_EXPORT PiiBinaryImage shrink(const PiiBinaryImage& image, int amount = 1);
 }
 
 #include <PiiMorphology-templates.h>
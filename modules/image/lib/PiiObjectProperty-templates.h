@@ -18,9 +18,104 @@
 #endif
 
 #include <PiiPrincipalComponents.h>
+#include <PiiParallel.h>
+#include <QVector>
+#include <climits>
 
 namespace PiiImage
 {
+  /// @internal
+  namespace ObjectProperty
+  {
+    // Per-object sums collected by calculateMoments().
+    struct Accumulator
+    {
+      Accumulator() :
+        dM00(0), dM10(0), dM01(0), dM20(0), dM11(0), dM02(0),
+        iLeft(INT_MAX), iTop(INT_MAX), iRight(-1), iBottom(-1), iPerimeter(0)
+      {}
+
+      void operator+= (const Accumulator& other)
+      {
+        dM00 += other.dM00; dM10 += other.dM10; dM01 += other.dM01;
+        dM20 += other.dM20; dM11 += other.dM11; dM02 += other.dM02;
+        iLeft = qMin(iLeft, other.iLeft);
+        iTop = qMin(iTop, other.iTop);
+        iRight = qMax(iRight, other.iRight);
+        iBottom = qMax(iBottom, other.iBottom);
+        iPerimeter += other.iPerimeter;
+      }
+
+      double dM00, dM10, dM01, dM20, dM11, dM02;
+      int iLeft, iTop, iRight, iBottom, iPerimeter;
+    };
+
+    // Sum of squares 0^2 + 1^2 + ... + n^2
+    inline double squareSum(double n) { return n * (n+1) * (2*n+1) / 6; }
+
+    // Scans a band of rows as runs of equal labels. Each block of rows
+    // has its own set of accumulators.
+    template <class T> struct MomentCollector
+    {
+      MomentCollector(const PiiMatrix<T>& image, int labels, int blocks, bool perimeters) :
+        image(image), iLabels(labels), bPerimeters(perimeters),
+        vecAccumulators(blocks, QVector<Accumulator>(labels))
+      {}
+
+      void operator() (int block, int firstRow, int lastRow)
+      {
+        Accumulator* pAccumulators = vecAccumulators[block].data();
+        const int iRows = image.rows(), iColumns = image.columns();
+        for (int r=firstRow; r<lastRow; ++r)
+          {
+            const T* pRow = image[r];
+            const T* pAbove = r > 0 ? image[r-1] : 0;
+            const T* pBelow = r < iRows-1 ? image[r+1] : 0;
+            for (int c=0; c<iColumns; )
+              {
+                const T label = pRow[c];
+                const int iStart = c;
+                while (++c < iColumns && pRow[c] == label) ;
+                if (label <= 0 || int(label) > iLabels)
+                  continue;
+
+                const int iEnd = c-1;
+                const double dLength = c - iStart;
+                const double dSumX = dLength * (iStart + iEnd) / 2;
+                Accumulator& acc = pAccumulators[int(label)-1];
+                acc.dM00 += dLength;
+                acc.dM10 += dSumX;
+                acc.dM01 += dLength * r;
+                acc.dM20 += squareSum(iEnd) - squareSum(iStart-1);
+                acc.dM11 += dSumX * r;
+                acc.dM02 += dLength * r * r;
+                acc.iLeft = qMin(acc.iLeft, iStart);
+                acc.iRight = qMax(acc.iRight, iEnd);
+                acc.iTop = qMin(acc.iTop, r);
+                acc.iBottom = qMax(acc.iBottom, r);
+
+                if (bPerimeters)
+                  {
+                    // The ends of a run always face another label.
+                    int iEdges = 2;
+                    for (int i=iStart; i<=iEnd; ++i)
+                      {
+                        if (pAbove == 0 || pAbove[i] != label) ++iEdges;
+                        if (pBelow == 0 || pBelow[i] != label) ++iEdges;
+                      }
+                    acc.iPerimeter += iEdges;
+                  }
+              }
+          }
+      }
+
+      const PiiMatrix<T>& image;
+      int iLabels;
+      bool bPerimeters;
+      QVector<QVector<Accumulator> > vecAccumulators;
+    };
+  }
+
   template <class T> void calculateProperties(const PiiMatrix<T>& mat, int labels, PiiMatrix<int>& areas,
                                               PiiMatrix<int>& centroids, PiiMatrix<int>& bbox)
   {
@@ -155,6 +250,56 @@ namespace PiiImage
     return matBase;
   }
 
+  template <class T> PiiMatrix<double> calculateMoments(const PiiMatrix<T>& mat,
+                                                        int labels,
+                                                        PiiMatrix<int>* bbox,
+                                                        PiiMatrix<int>* perimeters)
+  {
+    if (labels == 0 && !mat.isEmpty())
+      labels = qMax(0, int(Pii::max(mat)));
+
+    const int iBlocks = Pii::parallelBlockCount(mat.rows(), 32);
+    ObjectProperty::MomentCollector<T> collector(mat, labels, iBlocks, perimeters != 0);
+    Pii::parallelForBlocks(0, mat.rows(), iBlocks, collector);
+
+    // Merge the results of all blocks.
+    QVector<ObjectProperty::Accumulator>& vecTotal = collector.vecAccumulators[0];
+    for (int b=1; b<iBlocks; ++b)
+      for (int i=0; i<labels; ++i)
+        vecTotal[i] += collector.vecAccumulators[b][i];
+
+    PiiMatrix<double> matMoments(labels, 6);
+    if (bbox != 0)
+      *bbox = PiiMatrix<int>(labels, 4);
+    if (perimeters != 0)
+      *perimeters = PiiMatrix<int>(labels, 1);
+
+    for (int i=0; i<labels; ++i)
+      {
+        const ObjectProperty::Accumulator& acc = vecTotal[i];
+        double* pMoments = matMoments[i];
+        pMoments[0] = acc.dM00;
+        pMoments[1] = acc.dM10;
+        pMoments[2] = acc.dM01;
+        pMoments[3] = acc.dM20;
+        pMoments[4] = acc.dM11;
+        pMoments[5] = acc.dM02;
+        if (acc.dM00 == 0)
+          continue;
+        if (bbox != 0)
+          {
+            int* pBox = (*bbox)[i];
+            pBox[0] = acc.iLeft;
+            pBox[1] = acc.iTop;
+            pBox[2] = acc.iRight - acc.iLeft + 1;
+            pBox[3] = acc.iBottom - acc.iTop + 1;
+          }
+        if (perimeters != 0)
+          (*perimeters)(i,0) = acc.iPerimeter;
+      }
+    return matMoments;
+  }
+
   template <class ImageType, class SweepFunction>
   SweepFunction sweepLine(const PiiMatrix<ImageType>& image,
                           const PiiMatrix<double>& coordinates,
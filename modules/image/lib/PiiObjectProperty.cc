@@ -0,0 +1,51 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "PiiObjectProperty.h"
+#include <cmath>
+
+namespace PiiImage
+{
+  PiiMatrix<double> calculateAxes(const PiiMatrix<double>& moments)
+  {
+    PiiMatrix<double> matAxes(moments.rows(), 3);
+    for (int i=0; i<moments.rows(); ++i)
+      {
+        const double* pMoments = moments[i];
+        const double dArea = pMoments[0];
+        if (dArea < 2)
+          continue;
+
+        // Second-order central moments, i.e. the scatter matrix of
+        // pixel coordinates.
+        const double dCenterX = pMoments[1] / dArea, dCenterY = pMoments[2] / dArea;
+        const double dXX = pMoments[3] - dArea * dCenterX * dCenterX;
+        const double dXY = pMoments[4] - dArea * dCenterX * dCenterY;
+        const double dYY = pMoments[5] - dArea * dCenterY * dCenterY;
+
+        // Eigenvalues of the scatter matrix are the squared singular
+        // values of the centered coordinates.
+        const double dMean = (dXX + dYY) / 2;
+        const double dDiff = (dXX - dYY) / 2;
+        const double dRadius = std::sqrt(dDiff * dDiff + dXY * dXY);
+
+        double* pAxes = matAxes[i];
+        pAxes[0] = 0.5 * std::atan2(2 * dXY, dXX - dYY);
+        pAxes[1] = std::sqrt(qMax(0.0, dMean + dRadius)) + 1;
+        pAxes[2] = std::sqrt(qMax(0.0, dMean - dRadius)) + 1;
+      }
+    return matAxes;
+  }
+}
@@ -16,6 +16,7 @@
 #ifndef _PIIOBJECTPROPERTY_H
 #define _PIIOBJECTPROPERTY_H
 
+#include "PiiImageGlobal.h"
 #include <PiiMatrix.h>
 #include <PiiMath.h>
 
@@ -95,6 +96,65 @@ namespace PiiImage
                                        double* width = 0,
                                        int* pixels = 0);
 
+  /**
+   * Calculates raw image moments up to the second order, bounding
+   * boxes and perimeters for all labeled objects in a single pass
+   * over the image. The image is scanned as horizontal runs of equal
+   * labels, and the moments of each run are added in closed form.
+   * Bands of rows are processed in parallel.
+   *
+   * @param mat labeled image. Zero is background.
+   *
+   * @param labels the number of labeled objects. If zero, the
+   * maximum value in `mat` will be used. Pixels whose label is larger
+   * than `labels` are ignored.
+   *
+   * @param bbox an optional output parameter that will store the
+   * bounding boxes of the objects as a N-by-4 matrix (x, y, width,
+   * height). Rows for labels that do not appear in the image will be
+   * zero.
+   *
+   * @param perimeters an optional output parameter that will store
+   * the perimeter of each object as a N-by-1 matrix. The perimeter
+   * is the number of pixel edges between the object and other pixels
+   * or the image border.
+   *
+   * @return a N-by-6 matrix in which each row stores the raw moments
+   * m00, m10, m01, m20, m11 and m02 of an object, in this order.
+   * m<sub>pq</sub> is the sum of x<sup>p</sup>y<sup>q</sup> over the
+   * object's pixels, x being the column and y the row coordinate. m00
+   * is the area of the object.
+   *
+   * ~~~(c++)
+   * PiiMatrix<int> matLabels = PiiImage::labelImage(matBinary);
+   * PiiMatrix<int> matBoxes;
+   * PiiMatrix<double> matMoments = PiiImage::calculateMoments(matLabels, 0, &matBoxes);
+   * PiiMatrix<double> matAxes = PiiImage::calculateAxes(matMoments);
+   * ~~~
+   */
+  template <class T> PiiMatrix<double> calculateMoments(const PiiMatrix<T>& mat,
+                                                        int labels = 0,
+                                                        PiiMatrix<int>* bbox = 0,
+                                                        PiiMatrix<int>* perimeters = 0);
+
+  /**
+   * Calculates the orientations and axis lengths of objects from
+   * their raw moments. The result is the same as that of
+   * [calculateDirection()], but it is derived in closed form from
+   * the second-order central moments instead of decomposing the
+   * coordinates of all pixels.
+   *
+   * @param moments raw moments as returned by [calculateMoments()]
+   *
+   * @return a N-by-3 matrix. Each row stores the angle of the major
+   * axis in radians (-pi/2, pi/2], measured from the x axis towards
+   * the y axis (downwards in image coordinates), followed by the
+   * relative length and width of the object as defined by
+   * [calculateDirection()]. All values will be zero for objects with
+   * less than two pixels.
+   */
+  PII_IMAGE_EXPORT PiiMatrix<double> calculateAxes(const PiiMatrix<double>& moments);
+
   /**
    * A Default struct which is used in line sweeper. Which does
    * nothing. Provided for convience.
@@ -0,0 +1,127 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIRASTERFONT_H
+#define _PIIRASTERFONT_H
+
+#include "PiiImageGlobal.h"
+#include <PiiMatrix.h>
+#include <QHash>
+#include <QString>
+
+/**
+ * A set of pre-rendered glyphs for drawing text with [PiiRasterizer].
+ * Each glyph is a binary mask that is copied to the target image as
+ * such, which makes drawing text independent of any font engine.
+ *
+ * A small 5-by-7 pixel font that covers the printable ASCII
+ * characters is built in (see [defaultFont()]). Other fonts can be
+ * created by rendering glyphs with any font engine and adding them
+ * with [setGlyph()].
+ *
+ * ~~~(c++)
+ * PiiMatrix<unsigned char> image(100, 100);
+ * PiiRasterizer<unsigned char> rasterizer(image);
+ * rasterizer.setColor(255);
+ * rasterizer.drawText(10, 20, "OK", PiiRasterFont::defaultFont());
+ * ~~~
+ */
+class PII_IMAGE_EXPORT PiiRasterFont
+{
+public:
+  /**
+   * A pre-rendered character.
+   */
+  struct Glyph
+  {
+    Glyph() : left(0), top(0), advance(0) {}
+    /**
+     * The shape of the character. Non-zero entries will be painted.
+     */
+    PiiMatrix<unsigned char> mask;
+    /**
+     * The horizontal offset of the first column of [mask] relative
+     * to the pen position.
+     */
+    int left;
+    /**
+     * The vertical offset of the first row of [mask] relative to the
+     * baseline. Negative values are above the baseline.
+     */
+    int top;
+    /**
+     * The number of pixels the pen moves after drawing the
+     * character.
+     */
+    int advance;
+  };
+
+  /**
+   * Creates an empty font with the given *ascent* and *descent*.
+   */
+  PiiRasterFont(int ascent = 0, int descent = 0);
+
+  /**
+   * Returns the built-in 5-by-7 pixel font that contains the
+   * printable ASCII characters (32-126). The advance of each
+   * character is six pixels.
+   */
+  static const PiiRasterFont& defaultFont();
+
+  /**
+   * Adds *glyph* to the font as the representation of the
+   * character *code*. An old glyph for the same code will be
+   * replaced.
+   */
+  void setGlyph(uint code, const Glyph& glyph);
+
+  /**
+   * Returns the glyph for *code* or null if the font has no such
+   * glyph.
+   */
+  const Glyph* glyph(uint code) const;
+
+  /**
+   * Returns `true` if the font contains a glyph for *code*.
+   */
+  bool contains(uint code) const { return _hashGlyphs.contains(code); }
+
+  /**
+   * Returns the distance from the baseline to the top of the
+   * tallest glyph.
+   */
+  int ascent() const { return _iAscent; }
+  /**
+   * Returns the distance from the baseline to the bottom of the
+   * lowest glyph.
+   */
+  int descent() const { return _iDescent; }
+  /**
+   * Returns the height of a line of text.
+   */
+  int height() const { return _iAscent + _iDescent; }
+
+  /**
+   * Returns the width of *text* in pixels. Characters that have no
+   * glyph are ignored.
+   */
+  int textWidth(const QString& text) const;
+
+private:
+  QHash<uint,Glyph> _hashGlyphs;
+  int _iAscent, _iDescent;
+};
+
+#endif //_PIIRASTERFONT_H
@@ -0,0 +1,377 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIRASTERIZER_H
+# error "Never use <PiiRasterizer-templates.h> directly; include <PiiRasterizer.h> instead."
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+template <class T> PiiRasterizer<T>::PiiRasterizer(PiiMatrix<T>& image) :
+  _image(image),
+  _pFirstRow(0),
+  _iStride(image.stride()),
+  _color(T()),
+  _iLineWidth(1)
+{
+  // Detaches the data once so that pixels can be accessed without
+  // reference count checks.
+  if (image.rows() > 0)
+    _pFirstRow = reinterpret_cast<char*>(image.row(0));
+  setClipRect(PiiRectangle<int>(0, 0, image.columns(), image.rows()));
+}
+
+template <class T> void PiiRasterizer<T>::setClipRect(const PiiRectangle<int>& rect)
+{
+  _iLeft = qMax(rect.x, 0);
+  _iTop = qMax(rect.y, 0);
+  _iRight = qMin(rect.x + rect.width, _image.columns());
+  _iBottom = qMin(rect.y + rect.height, _image.rows());
+  // Empty clip rectangle
+  if (_iRight < _iLeft) _iRight = _iLeft;
+  if (_iBottom < _iTop) _iBottom = _iTop;
+}
+
+template <class T> PiiRectangle<int> PiiRasterizer<T>::clipRect() const
+{
+  return PiiRectangle<int>(_iLeft, _iTop, _iRight - _iLeft, _iBottom - _iTop);
+}
+
+template <class T> void PiiRasterizer<T>::fillSpan(int y, int x1, int x2)
+{
+  if (y < _iTop || y >= _iBottom)
+    return;
+  x1 = qMax(x1, _iLeft);
+  x2 = qMin(x2, _iRight - 1);
+  if (x1 > x2)
+    return;
+  T* pRow = pixelAt(0, y);
+  std::fill(pRow + x1, pRow + x2 + 1, _color);
+}
+
+template <class T> void PiiRasterizer<T>::plot(int x, int y)
+{
+  if (_iLineWidth == 1)
+    {
+      if (isInside(x, y))
+        *pixelAt(x, y) = _color;
+    }
+  else
+    {
+      // A square brush centered at (x,y)
+      const int iStart = -(_iLineWidth - 1) / 2, iEnd = iStart + _iLineWidth - 1;
+      for (int r=iStart; r<=iEnd; ++r)
+        fillSpan(y + r, x + iStart, x + iEnd);
+    }
+}
+
+template <class T> void PiiRasterizer<T>::drawPoint(int x, int y)
+{
+  plot(x, y);
+}
+
+template <class T>
+bool PiiRasterizer<T>::clipLine(double& x1, double& y1, double& x2, double& y2, double margin) const
+{
+  // Liang-Barsky
+  const double dx = x2 - x1, dy = y2 - y1;
+  const double aP[4] = { -dx, dx, -dy, dy };
+  const double aQ[4] = { x1 - (_iLeft - margin), (_iRight - 1 + margin) - x1,
+                         y1 - (_iTop - margin), (_iBottom - 1 + margin) - y1 };
+  double dStart = 0, dEnd = 1;
+  for (int i=0; i<4; ++i)
+    {
+      if (aP[i] == 0)
+        {
+          if (aQ[i] < 0)
+            return false;
+        }
+      else
+        {
+          const double dT = aQ[i] / aP[i];
+          if (aP[i] < 0)
+            dStart = qMax(dStart, dT);
+          else
+            dEnd = qMin(dEnd, dT);
+          if (dStart > dEnd)
+            return false;
+        }
+    }
+  x2 = x1 + dEnd * dx;
+  y2 = y1 + dEnd * dy;
+  x1 += dStart * dx;
+  y1 += dStart * dy;
+  return true;
+}
+
+template <class T> void PiiRasterizer<T>::drawLine(int x1, int y1, int x2, int y2)
+{
+  // Clip lines whose end points are outside. This avoids stepping
+  // through a huge number of invisible pixels. plot() still checks
+  // each pixel.
+  if (!isInside(x1, y1) || !isInside(x2, y2))
+    {
+      double dX1 = x1, dY1 = y1, dX2 = x2, dY2 = y2;
+      if (!clipLine(dX1, dY1, dX2, dY2, _iLineWidth / 2 + 1))
+        return;
+      x1 = coordinate(dX1);
+      y1 = coordinate(dY1);
+      x2 = coordinate(dX2);
+      y2 = coordinate(dY2);
+    }
+
+  // Horizontal lines are common in annotations.
+  if (y1 == y2 && _iLineWidth == 1)
+    {
+      fillSpan(y1, qMin(x1, x2), qMax(x1, x2));
+      return;
+    }
+
+  // Bresenham
+  const int iDx = qAbs(x2 - x1), iDy = -qAbs(y2 - y1);
+  const int iStepX = x1 < x2 ? 1 : -1, iStepY = y1 < y2 ? 1 : -1;
+  int iError = iDx + iDy;
+  for (;;)
+    {
+      plot(x1, y1);
+      if (x1 == x2 && y1 == y2)
+        break;
+      const int iError2 = 2 * iError;
+      if (iError2 >= iDy)
+        {
+          iError += iDy;
+          x1 += iStepX;
+        }
+      if (iError2 <= iDx)
+        {
+          iError += iDx;
+          y1 += iStepY;
+        }
+    }
+}
+
+template <class T> void PiiRasterizer<T>::drawRectangle(int x, int y, int width, int height)
+{
+  if (width < 0 || height < 0)
+    return;
+  if (_iLineWidth == 1)
+    {
+      fillSpan(y, x, x + width);
+      if (height > 0)
+        fillSpan(y + height, x, x + width);
+      for (int r=y+1; r<y+height; ++r)
+        {
+          fillSpan(r, x, x);
+          fillSpan(r, x + width, x + width);
+        }
+    }
+  else
+    {
+      drawLine(x, y, x + width, y);
+      drawLine(x + width, y, x + width, y + height);
+      drawLine(x + width, y + height, x, y + height);
+      drawLine(x, y + height, x, y);
+    }
+}
+
+template <class T> void PiiRasterizer<T>::fillRectangle(int x, int y, int width, int height)
+{
+  const int iTop = qMax(y, _iTop), iBottom = qMin(y + height, _iBottom);
+  for (int r=iTop; r<iBottom; ++r)
+    fillSpan(r, x, x + width - 1);
+}
+
+template <class T> void PiiRasterizer<T>::drawEllipse(int x, int y, int width, int height)
+{
+  if (width < 0 || height < 0)
+    return;
+  // Skip ellipses that are completely outside.
+  const int iMargin = _iLineWidth / 2 + 1;
+  if (x + width + iMargin < _iLeft || x - iMargin >= _iRight ||
+      y + height + iMargin < _iTop || y - iMargin >= _iBottom)
+    return;
+
+  const double dA = 0.5 * width, dB = 0.5 * height;
+  const double dCx = x + dA, dCy = y + dB;
+  // Approximate the outline with line segments about one pixel
+  // long. Consecutive segments that round to the same pixel are
+  // skipped.
+  const int iSegments = qMax(8, int(std::ceil(2 * M_PI * qMax(dA, dB))));
+  const double dStep = 2 * M_PI / iSegments;
+  int iPrevX = coordinate(dCx + dA), iPrevY = coordinate(dCy);
+  for (int i=1; i<=iSegments; ++i)
+    {
+      const double dAngle = i * dStep;
+      const int iX = coordinate(dCx + dA * std::cos(dAngle));
+      const int iY = coordinate(dCy + dB * std::sin(dAngle));
+      if (iX != iPrevX || iY != iPrevY)
+        {
+          drawLine(iPrevX, iPrevY, iX, iY);
+          iPrevX = iX;
+          iPrevY = iY;
+        }
+    }
+  if (width == 0 && height == 0)
+    plot(iPrevX, iPrevY);
+}
+
+template <class T> void PiiRasterizer<T>::fillEllipse(int x, int y, int width, int height)
+{
+  if (width < 0 || height < 0)
+    return;
+  const double dA = 0.5 * width, dB = 0.5 * height;
+  const double dCx = x + dA, dCy = y + dB;
+  if (dB == 0)
+    {
+      fillSpan(y, x, x + width);
+      return;
+    }
+  const int iTop = qMax(int(std::ceil(dCy - dB)), _iTop);
+  const int iBottom = qMin(int(std::floor(dCy + dB)), _iBottom - 1);
+  for (int r=iTop; r<=iBottom; ++r)
+    {
+      const double dY = (r - dCy) / dB;
+      const double dHalfWidth = dA * std::sqrt(qMax(1.0 - dY * dY, 0.0));
+      fillSpan(r, int(std::ceil(dCx - dHalfWidth)), int(std::floor(dCx + dHalfWidth)));
+    }
+}
+
+template <class T> void PiiRasterizer<T>::drawText(int x, int y, const QString& text, const PiiRasterFont& font)
+{
+  int iPenX = x;
+  for (int i=0; i<text.size(); ++i)
+    {
+      const uint uiCode = text[i].unicode();
+      if (uiCode == '\n')
+        {
+          iPenX = x;
+          y += font.height() + 1;
+          continue;
+        }
+      const PiiRasterFont::Glyph* pGlyph = font.glyph(uiCode);
+      if (pGlyph == 0)
+        continue;
+
+      const int iLeft = iPenX + pGlyph->left, iTop = y + pGlyph->top;
+      const int iRows = pGlyph->mask.rows(), iColumns = pGlyph->mask.columns();
+      // Clip the glyph once and copy the visible part.
+      const int iFirstRow = qMax(_iTop - iTop, 0), iLastRow = qMin(_iBottom - iTop, iRows);
+      const int iFirstColumn = qMax(_iLeft - iLeft, 0), iLastColumn = qMin(_iRight - iLeft, iColumns);
+      for (int r=iFirstRow; r<iLastRow; ++r)
+        {
+          const unsigned char* pMask = pGlyph->mask[r];
+          T* pTarget = pixelAt(iLeft, iTop + r);
+          for (int c=iFirstColumn; c<iLastColumn; ++c)
+            if (pMask[c])
+              pTarget[c] = _color;
+        }
+      iPenX += pGlyph->advance;
+    }
+}
+
+template <class T> template <class U>
+void PiiRasterizer<T>::drawPolyline(const PiiMatrix<U>& points, bool closed)
+{
+  const int iCount = points.rows();
+  if (iCount == 0 || points.columns() < 2)
+    return;
+  int iPrevX = coordinate(points(0,0)), iPrevY = coordinate(points(0,1));
+  if (iCount == 1)
+    plot(iPrevX, iPrevY);
+  for (int i=1; i<iCount; ++i)
+    {
+      const int iX = coordinate(points(i,0)), iY = coordinate(points(i,1));
+      drawLine(iPrevX, iPrevY, iX, iY);
+      iPrevX = iX;
+      iPrevY = iY;
+    }
+  if (closed && iCount > 2)
+    drawLine(iPrevX, iPrevY, coordinate(points(0,0)), coordinate(points(0,1)));
+}
+
+template <class T> template <class U>
+void PiiRasterizer<T>::drawPoints(const PiiMatrix<U>& points)
+{
+  if (points.columns() < 2)
+    return;
+  for (int i=0; i<points.rows(); ++i)
+    {
+      const U* pRow = points[i];
+      plot(coordinate(pRow[0]), coordinate(pRow[1]));
+    }
+}
+
+template <class T> template <class U>
+void PiiRasterizer<T>::drawLines(const PiiMatrix<U>& lines)
+{
+  if (lines.columns() < 4)
+    return;
+  for (int i=0; i<lines.rows(); ++i)
+    {
+      const U* pRow = lines[i];
+      drawLine(coordinate(pRow[0]), coordinate(pRow[1]), coordinate(pRow[2]), coordinate(pRow[3]));
+    }
+}
+
+template <class T> template <class U>
+void PiiRasterizer<T>::drawRectangles(const PiiMatrix<U>& rectangles, bool fill)
+{
+  if (rectangles.columns() < 4)
+    return;
+  for (int i=0; i<rectangles.rows(); ++i)
+    {
+      const U* pRow = rectangles[i];
+      const int iX = coordinate(pRow[0]), iY = coordinate(pRow[1]);
+      const int iWidth = coordinate(pRow[2]), iHeight = coordinate(pRow[3]);
+      if (fill)
+        fillRectangle(iX, iY, iWidth, iHeight);
+      else
+        drawRectangle(iX, iY, iWidth, iHeight);
+    }
+}
+
+template <class T> template <class U>
+void PiiRasterizer<T>::drawEllipses(const PiiMatrix<U>& rectangles, bool fill)
+{
+  if (rectangles.columns() < 4)
+    return;
+  for (int i=0; i<rectangles.rows(); ++i)
+    {
+      const U* pRow = rectangles[i];
+      const int iX = coordinate(pRow[0]), iY = coordinate(pRow[1]);
+      const int iWidth = coordinate(pRow[2]), iHeight = coordinate(pRow[3]);
+      if (fill)
+        fillEllipse(iX, iY, iWidth, iHeight);
+      else
+        drawEllipse(iX, iY, iWidth, iHeight);
+    }
+}
+
+template <class T> template <class U>
+void PiiRasterizer<T>::drawCircles(const PiiMatrix<U>& circles, bool fill)
+{
+  if (circles.columns() < 3)
+    return;
+  for (int i=0; i<circles.rows(); ++i)
+    {
+      const U* pRow = circles[i];
+      const int iX = coordinate(pRow[0]), iY = coordinate(pRow[1]), iRadius = coordinate(pRow[2]);
+      if (fill)
+        fillCircle(iX, iY, iRadius);
+      else
+        drawCircle(iX, iY, iRadius);
+    }
+}
@@ -0,0 +1,195 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIRASTERIZER_H
+#define _PIIRASTERIZER_H
+
+#include "PiiRasterFont.h"
+#include <PiiMatrix.h>
+#include <PiiRectangle.h>
+#include <PiiMath.h>
+
+/**
+ * A lightweight rasterizer that draws graphics primitives directly
+ * into a PiiMatrix of any pixel type. Unlike QPainter, the rasterizer
+ * needs no conversion of the image to a QImage, which makes it cheap
+ * to annotate gray-level or floating-point images with a large
+ * number of primitives.
+ *
+ * All primitives are drawn with a single, opaque color without
+ * anti-aliasing. Pixels outside of the [clip rectangle](setClipRect())
+ * are never touched. Text is drawn with pre-rendered glyphs (see
+ * [PiiRasterFont]).
+ *
+ * The batch functions ([drawPoints()], [drawLines()],
+ * [drawRectangles()], [drawEllipses()] and [drawCircles()]) accept
+ * the same N-by-2, N-by-3 and N-by-4 coordinate matrices the
+ * rest of the library uses for geometric objects. Coordinates of any
+ * numeric type are accepted and rounded to the closest pixel.
+ *
+ * ~~~(c++)
+ * PiiMatrix<unsigned char> image = ...;
+ * PiiMatrix<int> matBoxes = ...; // N-by-4 (x, y, width, height)
+ * PiiRasterizer<unsigned char> rasterizer(image);
+ * rasterizer.setColor(255);
+ * rasterizer.drawRectangles(matBoxes);
+ * rasterizer.drawText(2, 10, QString("%1 objects").arg(matBoxes.rows()));
+ * ~~~
+ *
+ * ! The rasterizer holds a reference to the image. The image must
+ * not be resized or reassigned while the rasterizer is in use.
+ */
+template <class T> class PiiRasterizer
+{
+public:
+  /**
+   * Creates a rasterizer that draws on *image*. The clip rectangle
+   * will be set to cover the whole image.
+   */
+  PiiRasterizer(PiiMatrix<T>& image);
+
+  /**
+   * Sets the color all primitives are drawn with.
+   */
+  void setColor(const T& color) { _color = color; }
+  /**
+   * Returns the drawing color.
+   */
+  T color() const { return _color; }
+
+  /**
+   * Sets the width of lines and outlines in pixels. The default is
+   * one. Text is not affected.
+   */
+  void setLineWidth(int lineWidth) { _iLineWidth = qMax(lineWidth, 1); }
+  /**
+   * Returns the width of lines.
+   */
+  int lineWidth() const { return _iLineWidth; }
+
+  /**
+   * Restricts drawing to *rect*. The clip rectangle will always be
+   * limited to the boundaries of the image.
+   */
+  void setClipRect(const PiiRectangle<int>& rect);
+  /**
+   * Returns the current clip rectangle.
+   */
+  PiiRectangle<int> clipRect() const;
+
+  /**
+   * Sets the pixel at (*x*, *y*).
+   */
+  void drawPoint(int x, int y);
+
+  /**
+   * Draws a line from (*x1*, *y1*) to (*x2*, *y2*). Both end points
+   * are included.
+   */
+  void drawLine(int x1, int y1, int x2, int y2);
+
+  /**
+   * Draws the outline of a rectangle whose upper left corner is at
+   * (*x*, *y*). As with QPainter, the outline covers *width* + 1
+   * columns and *height* + 1 rows.
+   */
+  void drawRectangle(int x, int y, int width, int height);
+  /**
+   * Fills the *width* -by- *height* rectangle whose upper left
+   * corner is at (*x*, *y*).
+   */
+  void fillRectangle(int x, int y, int width, int height);
+
+  /**
+   * Draws the outline of an ellipse framed by a rectangle.
+   */
+  void drawEllipse(int x, int y, int width, int height);
+  /**
+   * Fills an ellipse framed by a rectangle.
+   */
+  void fillEllipse(int x, int y, int width, int height);
+
+  /**
+   * Draws the outline of a circle centered at (*x*, *y*).
+   */
+  void drawCircle(int x, int y, int radius) { drawEllipse(x - radius, y - radius, 2 * radius, 2 * radius); }
+  /**
+   * Fills a circle centered at (*x*, *y*).
+   */
+  void fillCircle(int x, int y, int radius) { fillEllipse(x - radius, y - radius, 2 * radius, 2 * radius); }
+
+  /**
+   * Draws *text* so that the baseline of the first line starts at
+   * (*x*, *y*). Newline characters move the pen to the beginning of
+   * the next line. Characters not found in *font* are skipped.
+   */
+  void drawText(int x, int y, const QString& text,
+                const PiiRasterFont& font = PiiRasterFont::defaultFont());
+
+  /**
+   * Draws a line through a sequence of points. *points* is a N-by-2
+   * matrix in which each row stores the coordinates of a point
+   * (x, y). If *closed* is `true`, the last point will be connected
+   * to the first one.
+   */
+  template <class U> void drawPolyline(const PiiMatrix<U>& points, bool closed = false);
+
+  /**
+   * Draws a point for each row in a N-by-2 matrix (x, y).
+   */
+  template <class U> void drawPoints(const PiiMatrix<U>& points);
+  /**
+   * Draws a line for each row in a N-by-4 matrix (x1, y1, x2, y2).
+   */
+  template <class U> void drawLines(const PiiMatrix<U>& lines);
+  /**
+   * Draws a rectangle for each row in a N-by-4 matrix (x, y, width,
+   * height). If *fill* is `true`, the rectangles will be filled.
+   */
+  template <class U> void drawRectangles(const PiiMatrix<U>& rectangles, bool fill = false);
+  /**
+   * Draws an ellipse for each row in a N-by-4 matrix that stores
+   * the framing rectangles (x, y, width, height).
+   */
+  template <class U> void drawEllipses(const PiiMatrix<U>& rectangles, bool fill = false);
+  /**
+   * Draws a circle for each row in a N-by-3 matrix (x, y, radius).
+   */
+  template <class U> void drawCircles(const PiiMatrix<U>& circles, bool fill = false);
+
+private:
+  template <class U> static int coordinate(U value) { return Pii::round<int>(value); }
+
+  T* pixelAt(int x, int y) { return reinterpret_cast<T*>(_pFirstRow + y * _iStride) + x; }
+  bool isInside(int x, int y) const { return x >= _iLeft && x < _iRight && y >= _iTop && y < _iBottom; }
+  // Sets pixels x1...x2 (inclusive) on row y.
+  void fillSpan(int y, int x1, int x2);
+  // Plots a single point of a line using the current line width.
+  void plot(int x, int y);
+  // Clips the line to the clip rectangle expanded by *margin*.
+  // Returns false if nothing remains.
+  bool clipLine(double& x1, double& y1, double& x2, double& y2, double margin) const;
+
+  PiiMatrix<T>& _image;
+  char* _pFirstRow;
+  std::size_t _iStride;
+  T _color;
+  int _iLineWidth;
+  int _iLeft, _iTop, _iRight, _iBottom;
+};
+
+#include "PiiRasterizer-templates.h"
+
+#endif //_PIIRASTERIZER_H
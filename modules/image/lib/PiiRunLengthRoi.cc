@@ -0,0 +1,238 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "PiiRunLengthRoi.h"
+
+#include <QVarLengthArray>
+#include <algorithm>
+#include <climits>
+
+namespace
+{
+  struct SpanStartLess
+  {
+    bool operator() (const PiiRunLengthRoi::Span& s1, const PiiRunLengthRoi::Span& s2) const
+    {
+      return s1.start < s2.start;
+    }
+  };
+}
+
+PiiRunLengthRoi::PiiRunLengthRoi() :
+  _iRows(0), _iColumns(0),
+  _vecRowStarts(1, 0)
+{}
+
+PiiRunLengthRoi::PiiRunLengthRoi(int rows, int columns) :
+  _iRows(rows), _iColumns(columns),
+  _vecRowStarts(rows+1, 0)
+{}
+
+PiiRunLengthRoi::PiiRunLengthRoi(int rows, int columns, const PiiRectangle<int>& rect) :
+  _iRows(rows), _iColumns(columns),
+  _vecRowStarts(rows+1, 0)
+{
+  const int iTop = qMax(rect.y, 0), iBottom = qMin(rect.y + rect.height, rows);
+  const int iLeft = qMax(rect.x, 0), iRight = qMin(rect.x + rect.width, columns);
+  for (int r=0; r<rows; ++r)
+    {
+      if (r >= iTop && r < iBottom && iLeft < iRight)
+        appendSpan(iLeft, iRight);
+      endRow(r);
+    }
+}
+
+PiiRunLengthRoi PiiRunLengthRoi::fromRectangles(int rows, int columns, const PiiMatrix<int>& rectangles)
+{
+  QVector<PiiRectangle<int> > vecRectangles;
+  for (int i=0; i<rectangles.rows(); ++i)
+    {
+      const PiiRectangle<int>& rect = rectangles.rowAs<PiiRectangle<int> >(i);
+      if (rect.x >=0 && rect.x < columns &&
+          rect.y >=0 && rect.y < rows &&
+          rect.width > 0 &&
+          rect.height > 0 &&
+          rect.x + rect.width <= columns &&
+          rect.y + rect.height <= rows)
+        vecRectangles << rect;
+    }
+
+  PiiRunLengthRoi result(rows, columns);
+  QVarLengthArray<Span,16> lstRowSpans;
+  for (int r=0; r<rows; ++r)
+    {
+      lstRowSpans.clear();
+      for (int i=0; i<vecRectangles.size(); ++i)
+        if (r >= vecRectangles[i].y && r < vecRectangles[i].y + vecRectangles[i].height)
+          lstRowSpans.append(Span(vecRectangles[i].x, vecRectangles[i].x + vecRectangles[i].width));
+      std::sort(lstRowSpans.begin(), lstRowSpans.end(), SpanStartLess());
+      // Merge overlapping and touching spans
+      for (int i=0; i<lstRowSpans.size(); )
+        {
+          Span span = lstRowSpans[i];
+          for (++i; i<lstRowSpans.size() && lstRowSpans[i].start <= span.end; ++i)
+            span.end = qMax(span.end, lstRowSpans[i].end);
+          result.appendSpan(span.start, span.end);
+        }
+      result.endRow(r);
+    }
+  return result;
+}
+
+PiiMatrix<bool> PiiRunLengthRoi::toMask() const
+{
+  PiiMatrix<bool> matMask(_iRows, _iColumns);
+  for (int r=0; r<_iRows; ++r)
+    {
+      bool* pRow = matMask[r];
+      const Span* pSpans = spans(r);
+      for (int i=spanCount(r); i--; ++pSpans)
+        std::fill(pRow + pSpans->start, pRow + pSpans->end, true);
+    }
+  return matMask;
+}
+
+int PiiRunLengthRoi::pixelCount() const
+{
+  int iCount = 0;
+  for (int i=0; i<_vecSpans.size(); ++i)
+    iCount += _vecSpans[i].end - _vecSpans[i].start;
+  return iCount;
+}
+
+PiiRectangle<int> PiiRunLengthRoi::boundingRect() const
+{
+  int iTop = -1, iBottom = -1, iLeft = INT_MAX, iRight = 0;
+  for (int r=0; r<_iRows; ++r)
+    {
+      const int iCount = spanCount(r);
+      if (iCount == 0)
+        continue;
+      if (iTop == -1)
+        iTop = r;
+      iBottom = r;
+      iLeft = qMin(iLeft, spans(r)[0].start);
+      iRight = qMax(iRight, spans(r)[iCount-1].end);
+    }
+  if (iTop == -1)
+    return PiiRectangle<int>();
+  return PiiRectangle<int>(iLeft, iTop, iRight - iLeft, iBottom - iTop + 1);
+}
+
+bool PiiRunLengthRoi::contains(int r, int c) const
+{
+  if (r < 0 || r >= _iRows)
+    return false;
+  const Span* pBegin = spans(r), *pEnd = pBegin + spanCount(r);
+  // Find the first span that starts after c. The previous one is the
+  // only candidate.
+  const Span* pSpan = std::upper_bound(pBegin, pEnd, Span(c, c), SpanStartLess());
+  return pSpan != pBegin && c < (pSpan-1)->end;
+}
+
+PiiRunLengthRoi PiiRunLengthRoi::combined(const PiiRunLengthRoi& other, SetOperation operation) const
+{
+  PiiRunLengthRoi result(_iRows, _iColumns);
+  for (int r=0; r<_iRows; ++r)
+    {
+      const Span* pA = spans(r), *pAEnd = pA + spanCount(r);
+      const Span* pB = 0, *pBEnd = 0;
+      if (r < other._iRows)
+        {
+          pB = other.spans(r);
+          pBEnd = pB + other.spanCount(r);
+        }
+      // Sweep over span boundaries in both regions and emit a span
+      // whenever the result of the set operation changes.
+      bool bInA = false, bInB = false, bIn = false;
+      int iStart = 0;
+      while (pA != pAEnd || pB != pBEnd)
+        {
+          const int iNextA = pA != pAEnd ? (bInA ? pA->end : pA->start) : INT_MAX;
+          const int iNextB = pB != pBEnd ? (bInB ? pB->end : pB->start) : INT_MAX;
+          const int iPos = qMin(iNextA, iNextB);
+          if (iNextA == iPos)
+            {
+              if (bInA) ++pA;
+              bInA = !bInA;
+            }
+          if (iNextB == iPos)
+            {
+              if (bInB) ++pB;
+              bInB = !bInB;
+            }
+          bool bNowIn;
+          switch (operation)
+            {
+            case Union: bNowIn = bInA || bInB; break;
+            case Intersection: bNowIn = bInA && bInB; break;
+            default: bNowIn = bInA && !bInB; break;
+            }
+          if (bNowIn != bIn)
+            {
+              if (bNowIn)
+                iStart = iPos;
+              else
+                result.appendSpan(iStart, iPos);
+              bIn = bNowIn;
+            }
+        }
+      result.endRow(r);
+    }
+  return result;
+}
+
+PiiRunLengthRoi PiiRunLengthRoi::united(const PiiRunLengthRoi& other) const
+{
+  return combined(other, Union);
+}
+
+PiiRunLengthRoi PiiRunLengthRoi::intersected(const PiiRunLengthRoi& other) const
+{
+  return combined(other, Intersection);
+}
+
+PiiRunLengthRoi PiiRunLengthRoi::subtracted(const PiiRunLengthRoi& other) const
+{
+  return combined(other, Difference);
+}
+
+PiiRunLengthRoi PiiRunLengthRoi::inverted() const
+{
+  PiiRunLengthRoi result(_iRows, _iColumns);
+  for (int r=0; r<_iRows; ++r)
+    {
+      int iStart = 0;
+      const Span* pSpans = spans(r);
+      for (int i=spanCount(r); i--; ++pSpans)
+        {
+          if (pSpans->start > iStart)
+            result.appendSpan(iStart, pSpans->start);
+          iStart = pSpans->end;
+        }
+      if (iStart < _iColumns)
+        result.appendSpan(iStart, _iColumns);
+      result.endRow(r);
+    }
+  return result;
+}
+
+bool PiiRunLengthRoi::operator== (const PiiRunLengthRoi& other) const
+{
+  return _iRows == other._iRows &&
+    _iColumns == other._iColumns &&
+    _vecRowStarts == other._vecRowStarts &&
+    _vecSpans == other._vecSpans;
+}
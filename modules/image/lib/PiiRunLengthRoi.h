@@ -0,0 +1,213 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIRUNLENGTHROI_H
+#define _PIIRUNLENGTHROI_H
+
+#include "PiiImageGlobal.h"
+#include <PiiMatrix.h>
+#include <PiiRectangle.h>
+#include <QVector>
+
+/**
+ * A run-length encoded region of interest. The region is stored as a
+ * list of horizontal spans on each row. Compared to a binary mask,
+ * the representation is compact if the region consists of large
+ * uniform areas, and algorithms can skip pixels outside of the region
+ * without testing them one by one.
+ *
+ * PiiRunLengthRoi can be used as a ROI function object wherever a
+ * per-pixel ROI is accepted (see [PiiImage::DefaultRoi]). Algorithms
+ * that iterate over [PiiImage::RoiSpans] (such as
+ * [PiiImage::histogram()]) only visit the pixels within the spans.
+ *
+ * ~~~(c++)
+ * PiiMatrix<bool> matMask = ...;
+ * PiiRunLengthRoi roi(matMask);
+ * roi &= PiiRunLengthRoi(matMask.rows(), matMask.columns(),
+ *                        PiiRectangle<int>(10, 10, 100, 50));
+ * PiiMatrix<int> matHistogram = PiiImage::histogram(image, roi, 256);
+ * ~~~
+ */
+class PII_IMAGE_EXPORT PiiRunLengthRoi
+{
+public:
+  /**
+   * A horizontal run of pixels on a row. The span covers columns
+   * [start, end).
+   */
+  struct Span
+  {
+    Span(int s = 0, int e = 0) : start(s), end(e) {}
+    bool operator== (const Span& other) const { return start == other.start && end == other.end; }
+    int start;
+    int end;
+  };
+
+  /**
+   * Creates an empty region with zero size.
+   */
+  PiiRunLengthRoi();
+
+  /**
+   * Creates an empty region in a *rows* -by- *columns* frame.
+   */
+  PiiRunLengthRoi(int rows, int columns);
+
+  /**
+   * Creates a region that covers *rect*. The rectangle will be
+   * clipped to the frame.
+   */
+  PiiRunLengthRoi(int rows, int columns, const PiiRectangle<int>& rect);
+
+  /**
+   * Creates a region out of a mask. All non-zero entries in *mask*
+   * will be in the region.
+   */
+  template <class T> explicit PiiRunLengthRoi(const PiiMatrix<T>& mask);
+
+  /**
+   * Creates a region out of a set of rectangles. The rectangles are
+   * given as a N-by-4 matrix in which each row represents a rectangle
+   * (x, y, width, height). Rectangles that exceed the boundaries of
+   * the frame will be ignored, just like in
+   * [PiiImage::createRoiMask()].
+   */
+  static PiiRunLengthRoi fromRectangles(int rows, int columns, const PiiMatrix<int>& rectangles);
+
+  /**
+   * Converts the region to a binary mask.
+   */
+  PiiMatrix<bool> toMask() const;
+
+  /**
+   * Returns the number of rows in the frame.
+   */
+  int rows() const { return _iRows; }
+  /**
+   * Returns the number of columns in the frame.
+   */
+  int columns() const { return _iColumns; }
+
+  /**
+   * Returns `true` if the region contains no pixels.
+   */
+  bool isEmpty() const { return _vecSpans.isEmpty(); }
+
+  /**
+   * Returns the number of pixels in the region.
+   */
+  int pixelCount() const;
+
+  /**
+   * Returns the total number of spans in the region.
+   */
+  int spanCount() const { return _vecSpans.size(); }
+
+  /**
+   * Returns the number of spans on *row*.
+   */
+  int spanCount(int row) const { return _vecRowStarts[row+1] - _vecRowStarts[row]; }
+
+  /**
+   * Returns a pointer to the first span on *row*. The spans are
+   * sorted by their start column and never overlap or touch each
+   * other.
+   */
+  const Span* spans(int row) const { return _vecSpans.constData() + _vecRowStarts[row]; }
+
+  /**
+   * Returns the smallest rectangle that contains all pixels in the
+   * region.
+   */
+  PiiRectangle<int> boundingRect() const;
+
+  /**
+   * Returns `true` if the pixel at (*r*, *c*) is in the region.
+   */
+  bool contains(int r, int c) const;
+
+  /**
+   * Same as [contains()]. Makes it possible to use PiiRunLengthRoi
+   * as a ROI function object.
+   */
+  bool operator() (int r, int c) const { return contains(r, c); }
+
+  /**
+   * Returns the union of this region and *other*. Both regions must
+   * have the same frame size.
+   */
+  PiiRunLengthRoi united(const PiiRunLengthRoi& other) const;
+  /**
+   * Returns the intersection of this region and *other*.
+   */
+  PiiRunLengthRoi intersected(const PiiRunLengthRoi& other) const;
+  /**
+   * Returns the pixels in this region that are not in *other*.
+   */
+  PiiRunLengthRoi subtracted(const PiiRunLengthRoi& other) const;
+  /**
+   * Returns the pixels in the frame that are not in this region.
+   */
+  PiiRunLengthRoi inverted() const;
+
+  PiiRunLengthRoi operator| (const PiiRunLengthRoi& other) const { return united(other); }
+  PiiRunLengthRoi operator& (const PiiRunLengthRoi& other) const { return intersected(other); }
+  PiiRunLengthRoi operator- (const PiiRunLengthRoi& other) const { return subtracted(other); }
+  PiiRunLengthRoi operator~ () const { return inverted(); }
+  PiiRunLengthRoi& operator|= (const PiiRunLengthRoi& other) { return *this = united(other); }
+  PiiRunLengthRoi& operator&= (const PiiRunLengthRoi& other) { return *this = intersected(other); }
+  PiiRunLengthRoi& operator-= (const PiiRunLengthRoi& other) { return *this = subtracted(other); }
+
+  bool operator== (const PiiRunLengthRoi& other) const;
+  bool operator!= (const PiiRunLengthRoi& other) const { return !operator==(other); }
+
+private:
+  enum SetOperation { Union, Intersection, Difference };
+  PiiRunLengthRoi combined(const PiiRunLengthRoi& other, SetOperation operation) const;
+
+  void appendSpan(int start, int end) { _vecSpans.append(Span(start, end)); }
+  void endRow(int row) { _vecRowStarts[row+1] = _vecSpans.size(); }
+
+  int _iRows, _iColumns;
+  // Index of the first span on each row. The last entry is the total
+  // number of spans.
+  QVector<int> _vecRowStarts;
+  QVector<Span> _vecSpans;
+};
+
+Q_DECLARE_TYPEINFO(PiiRunLengthRoi::Span, Q_PRIMITIVE_TYPE);
+
+template <class T> PiiRunLengthRoi::PiiRunLengthRoi(const PiiMatrix<T>& mask) :
+  _iRows(mask.rows()), _iColumns(mask.columns()),
+  _vecRowStarts(mask.rows()+1, 0)
+{
+  for (int r=0; r<_iRows; ++r)
+    {
+      const T* pRow = mask[r];
+      for (int c=0; c<_iColumns; )
+        {
+          while (c < _iColumns && pRow[c] == 0) ++c;
+          if (c == _iColumns)
+            break;
+          const int iStart = c;
+          while (c < _iColumns && pRow[c] != 0) ++c;
+          appendSpan(iStart, c);
+        }
+      endRow(r);
+    }
+}
+
+#endif //_PIIRUNLENGTHROI_H
@@ -343,6 +343,48 @@ namespace PiiImage
     return threshold(image, ThresholdFunction<T>(), level);
   }
 
+  /**
+   * Thresholds the pixels of *image* that are within *roi*. Pixels
+   * outside of the ROI will be zero in the result. Only the pixels
+   * within the ROI are accessed, which makes the function fast with
+   * a small [PiiRunLengthRoi].
+   *
+   * @param image original image
+   *
+   * @param roi region-of-interest. See [RoiSpans].
+   *
+   * @param function the thresholding function, e.g.
+   * [ThresholdFunction].
+   *
+   * @param level the threshold. Must be of the same type as the
+   * image.
+   *
+   * ~~~(c++)
+   * PiiMatrix<bool> matBinary =
+   *   PiiImage::threshold(image, roi, PiiImage::ThresholdFunction<int,bool>(), 128);
+   * ~~~
+   */
+  template <class T, class Roi, class Function>
+  PiiMatrix<typename Function::result_type> threshold(const PiiMatrix<T>& image,
+                                                      const Roi& roi,
+                                                      Function function,
+                                                      T level)
+  {
+    typedef typename Function::result_type R;
+    PiiMatrix<R> matOutput(image.rows(), image.columns());
+    RoiSpans<Roi> spans(roi, 0, image.columns());
+    for (int r=0; r<image.rows(); ++r)
+      {
+        spans.selectRow(r);
+        const T* pSourceRow = image[r];
+        R* pTargetRow = matOutput[r];
+        for (int i=0; i<spans.count(); ++i)
+          for (int c=spans.start(i), iEnd=spans.end(i); c<iEnd; ++c)
+            pTargetRow[c] = function(pSourceRow[c], level);
+      }
+    return matOutput;
+  }
+
   /**
    * Thresholds and inverts an image.
    *
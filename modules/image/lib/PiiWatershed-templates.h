@@ -0,0 +1,229 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIWATERSHED_H
+# error "Never use <PiiWatershed-templates.h> directly; include <PiiWatershed.h> instead."
+#endif
+
+#include <PiiTypeTraits.h>
+#include <PiiMath.h>
+#include <QVector>
+#include <queue>
+#include <vector>
+
+namespace PiiImage
+{
+  /// @internal
+  namespace Watershed
+  {
+    // Temporary states of pixels in the label image.
+    enum { Unlabeled = 0, Blocked = -1, Queued = -2, Line = -3 };
+
+    // A priority queue that returns items with equal priorities in
+    // insertion order.
+    template <class T> class HeapQueue
+    {
+    public:
+      HeapQueue() : _iOrder(0) {}
+
+      void push(int index, T priority) { _heap.push(Item(priority, _iOrder++, index)); }
+      bool isEmpty() const { return _heap.empty(); }
+      int pop(T& priority)
+      {
+        const Item item = _heap.top();
+        _heap.pop();
+        priority = item.priority;
+        return item.index;
+      }
+
+    private:
+      struct Item
+      {
+        Item(T p, qint64 o, int i) : priority(p), order(o), index(i) {}
+        // std::priority_queue returns the largest item first.
+        bool operator< (const Item& other) const
+        {
+          return priority > other.priority || (priority == other.priority && order > other.order);
+        }
+        T priority;
+        qint64 order;
+        int index;
+      };
+      std::priority_queue<Item> _heap;
+      qint64 _iOrder;
+    };
+
+    // A queue with one FIFO bucket for each integer priority level.
+    // Priorities must never decrease below the level last popped.
+    template <class T> class BucketQueue
+    {
+    public:
+      BucketQueue(T minimum, int levels) :
+        _minimum(minimum), _vecBuckets(levels), _iLevel(0), _iPosition(0), _iCount(0)
+      {}
+
+      void push(int index, T priority)
+      {
+        _vecBuckets[int(priority - _minimum)].append(index);
+        ++_iCount;
+      }
+      bool isEmpty() const { return _iCount == 0; }
+      int pop(T& priority)
+      {
+        while (_iPosition >= _vecBuckets[_iLevel].size())
+          {
+            _vecBuckets[_iLevel].clear();
+            ++_iLevel;
+            _iPosition = 0;
+          }
+        --_iCount;
+        priority = T(_minimum + _iLevel);
+        return _vecBuckets[_iLevel][_iPosition++];
+      }
+
+    private:
+      T _minimum;
+      QVector<QVector<int> > _vecBuckets;
+      int _iLevel, _iPosition, _iCount;
+    };
+
+    template <class T, class Queue> void flood(const PiiMatrix<T>& image,
+                                               PiiMatrix<int>& labels,
+                                               Connectivity connectivity,
+                                               bool watershedLines,
+                                               Queue& queue)
+    {
+      static const int aRowOffsets[8] = { -1, 0, 0, 1, -1, -1, 1, 1 };
+      static const int aColumnOffsets[8] = { 0, -1, 1, 0, -1, 1, -1, 1 };
+      const int iNeighbors = connectivity == Connect4 ? 4 : 8;
+      const int iRows = image.rows(), iColumns = image.columns();
+
+      // Queue all unlabeled neighbors of the markers.
+      for (int r=0; r<iRows; ++r)
+        for (int c=0; c<iColumns; ++c)
+          {
+            const int iLabel = labels(r,c);
+            if (iLabel <= 0)
+              continue;
+            for (int n=0; n<iNeighbors; ++n)
+              {
+                const int nr = r + aRowOffsets[n], nc = c + aColumnOffsets[n];
+                if (nr >= 0 && nr < iRows && nc >= 0 && nc < iColumns &&
+                    labels(nr,nc) == Unlabeled)
+                  {
+                    labels(nr,nc) = Queued;
+                    queue.push(nr * iColumns + nc, image(nr,nc));
+                  }
+              }
+          }
+
+      T level;
+      while (!queue.isEmpty())
+        {
+          const int iIndex = queue.pop(level);
+          const int r = iIndex / iColumns, c = iIndex % iColumns;
+          // The label is decided only now, when all lower neighbors
+          // have been processed.
+          int iLabel = Queued;
+          for (int n=0; n<iNeighbors; ++n)
+            {
+              const int nr = r + aRowOffsets[n], nc = c + aColumnOffsets[n];
+              if (nr < 0 || nr >= iRows || nc < 0 || nc >= iColumns)
+                continue;
+              const int iNeighborLabel = labels(nr,nc);
+              if (iNeighborLabel <= 0)
+                continue;
+              if (iLabel == Queued)
+                {
+                  iLabel = iNeighborLabel;
+                  if (!watershedLines)
+                    break;
+                }
+              else if (iLabel != iNeighborLabel)
+                {
+                  iLabel = Line;
+                  break;
+                }
+            }
+          labels(r,c) = iLabel;
+          if (iLabel == Line)
+            continue;
+
+          for (int n=0; n<iNeighbors; ++n)
+            {
+              const int nr = r + aRowOffsets[n], nc = c + aColumnOffsets[n];
+              if (nr >= 0 && nr < iRows && nc >= 0 && nc < iColumns &&
+                  labels(nr,nc) == Unlabeled)
+                {
+                  labels(nr,nc) = Queued;
+                  // Pixels below the current level are flooded
+                  // immediately.
+                  queue.push(nr * iColumns + nc, qMax(image(nr,nc), level));
+                }
+            }
+        }
+    }
+  }
+
+  template <class T> PiiMatrix<int> watershed(const PiiMatrix<T>& image,
+                                              const PiiMatrix<int>& markers,
+                                              Connectivity connectivity,
+                                              bool watershedLines)
+  {
+    PiiMatrix<int> matLabels(markers);
+    const int iRows = image.rows(), iColumns = image.columns();
+    if (iRows == 0 || iColumns == 0)
+      return matLabels;
+
+    // Map all negative markers to one value.
+    for (int r=0; r<iRows; ++r)
+      {
+        int* pLabels = matLabels[r];
+        for (int c=0; c<iColumns; ++c)
+          if (pLabels[c] < 0)
+            pLabels[c] = Watershed::Blocked;
+      }
+
+    bool bBuckets = false;
+    T minimum(0), maximum(0);
+    if (Pii::IsInteger<T>::boolValue)
+      {
+        minimum = Pii::min(image);
+        maximum = Pii::max(image);
+        bBuckets = double(maximum) - double(minimum) < 65536;
+      }
+
+    if (bBuckets)
+      {
+        Watershed::BucketQueue<T> queue(minimum, int(maximum - minimum) + 1);
+        Watershed::flood(image, matLabels, connectivity, watershedLines, queue);
+      }
+    else
+      {
+        Watershed::HeapQueue<T> queue;
+        Watershed::flood(image, matLabels, connectivity, watershedLines, queue);
+      }
+
+    // Convert temporary states to background.
+    for (int r=0; r<iRows; ++r)
+      {
+        int* pLabels = matLabels[r];
+        for (int c=0; c<iColumns; ++c)
+          if (pLabels[c] < 0)
+            pLabels[c] = 0;
+      }
+    return matLabels;
+  }
+}
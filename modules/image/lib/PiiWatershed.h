@@ -0,0 +1,76 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIWATERSHED_H
+#define _PIIWATERSHED_H
+
+#include "PiiImageGlobal.h"
+#include <PiiMatrix.h>
+
+namespace PiiImage
+{
+  /**
+   * Marker-based watershed segmentation. Starting from the labeled
+   * markers, the labels are flooded over *image* in the order of
+   * increasing gray level so that each unlabeled pixel will be given
+   * the label of the marker it is first reached from. Pixels on
+   * plateaus are processed in the order they were reached.
+   *
+   * For integer images whose gray levels span at most 65536 values,
+   * the flooding uses a bucket queue and runs in time linear to the
+   * number of pixels. Other images use a binary heap.
+   *
+   * @param image the relief to be flooded, typically a gradient
+   * magnitude or a negated distance transform.
+   *
+   * @param markers initial labels, typically the output of
+   * [labelImage()]. Positive values are seeds, zeros will be flooded.
+   * Pixels with negative values are never flooded and will be zero
+   * in the result.
+   *
+   * @param connectivity the neighbors through which labels propagate
+   *
+   * @param watershedLines if `true`, pixels where two different
+   * labels meet are set to zero in the result, and labels do not
+   * propagate through them. If `false`, every reachable pixel will be
+   * labeled.
+   *
+   * @return a label image of the same size as *image*
+   *
+   * Separate touching round objects:
+   *
+   * ~~~(c++)
+   * PiiMatrix<unsigned char> matObjects = ...;
+   * PiiMatrix<float> matDistances = PiiImage::distanceTransform(matObjects);
+   * // One marker in the middle of each object
+   * PiiMatrix<int> matMarkers = PiiImage::labelImage(matDistances >= 10);
+   * // Do not flood the background
+   * for (int r=0; r<matObjects.rows(); ++r)
+   *   for (int c=0; c<matObjects.columns(); ++c)
+   *     if (matObjects(r,c) == 0)
+   *       matMarkers(r,c) = -1;
+   * PiiMatrix<int> matSeparated = PiiImage::watershed(PiiMatrix<float>(-matDistances),
+   *                                                   matMarkers, PiiImage::Connect8, true);
+   * ~~~
+   */
+  template <class T> PiiMatrix<int> watershed(const PiiMatrix<T>& image,
+                                              const PiiMatrix<int>& markers,
+                                              Connectivity connectivity = Connect8,
+                                              bool watershedLines = false);
+}
+
+#include "PiiWatershed-templates.h"
+
+#endif //_PIIWATERSHED_H
@@ -0,0 +1,75 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "PiiAdaptiveHistogramEqualizer.h"
+#include <PiiYdinTypes.h>
+#include "PiiHistogram.h"
+
+PiiAdaptiveHistogramEqualizer::Data::Data() :
+  tileSize(64,64),
+  dClipLimit(3),
+  iLevels(256)
+{
+}
+
+PiiAdaptiveHistogramEqualizer::PiiAdaptiveHistogramEqualizer() :
+  PiiDefaultOperation(new Data)
+{
+  addSocket(new PiiInputSocket("image"));
+  addSocket(new PiiOutputSocket("image"));
+}
+
+void PiiAdaptiveHistogramEqualizer::process()
+{
+  PiiVariant obj = readInput();
+
+  switch (obj.type())
+    {
+    case PiiYdin::UnsignedCharMatrixType:
+      equalize<unsigned char>(obj);
+      break;
+    case PiiYdin::UnsignedShortMatrixType:
+      equalize<unsigned short>(obj);
+      break;
+    default:
+      PII_THROW_UNKNOWN_TYPE(inputAt(0));
+    }
+}
+
+template <class T> void PiiAdaptiveHistogramEqualizer::equalize(const PiiVariant& obj)
+{
+  PII_D;
+  emitObject(PiiImage::adaptiveEqualize(obj.valueAs<PiiMatrix<T> >(),
+                                        d->tileSize.height(), d->tileSize.width(),
+                                        d->dClipLimit, unsigned(d->iLevels)));
+}
+
+void PiiAdaptiveHistogramEqualizer::setTileSize(const QSize& tileSize)
+{
+  if (tileSize.width() > 0 && tileSize.height() > 0)
+    _d()->tileSize = tileSize;
+}
+
+QSize PiiAdaptiveHistogramEqualizer::tileSize() const { return _d()->tileSize; }
+void PiiAdaptiveHistogramEqualizer::setClipLimit(double clipLimit) { _d()->dClipLimit = clipLimit; }
+double PiiAdaptiveHistogramEqualizer::clipLimit() const { return _d()->dClipLimit; }
+
+void PiiAdaptiveHistogramEqualizer::setLevels(int levels)
+{
+  if (levels >= 0 && levels <= 65536)
+    _d()->iLevels = levels;
+}
+
+int PiiAdaptiveHistogramEqualizer::levels() const { return _d()->iLevels; }
@@ -0,0 +1,100 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIADAPTIVEHISTOGRAMEQUALIZER_H
+#define _PIIADAPTIVEHISTOGRAMEQUALIZER_H
+
+#include <PiiDefaultOperation.h>
+#include <QSize>
+
+/**
+ * Contrast-limited adaptive histogram equalization. Enhances local
+ * contrast by equalizing the gray levels of each tile of the image
+ * separately and interpolating between the tiles. The operation is
+ * useful with unevenly lit surfaces, in which global equalization
+ * (PiiHistogramEqualizer) cannot bring out details in both dark and
+ * bright areas. See [PiiImage::adaptiveEqualize()] for details.
+ *
+ * Inputs
+ * ------
+ *
+ * @in image - the input image. An 8 or 16-bit gray-level image
+ * (unsigned char or unsigned short).
+ *
+ * Outputs
+ * -------
+ *
+ * @out image - equalized image. Type equals that of the input.
+ *
+ */
+class PiiAdaptiveHistogramEqualizer : public PiiDefaultOperation
+{
+  Q_OBJECT
+
+  /**
+   * The nominal size of a tile. The image will be divided into a
+   * grid of tiles that are approximately this large. The smaller the
+   * tiles, the more local the contrast enhancement. The default value
+   * is 64-by-64.
+   */
+  Q_PROPERTY(QSize tileSize READ tileSize WRITE setTileSize);
+
+  /**
+   * The maximum frequency of a gray level in a tile histogram,
+   * relative to the average frequency. Smaller values limit the
+   * amplification of noise in uniform areas. Zero disables clipping.
+   * The default value is 3.
+   */
+  Q_PROPERTY(double clipLimit READ clipLimit WRITE setClipLimit);
+
+  /**
+   * The number of discrete gray levels in the output image. The
+   * default value is 256. If the input image contains larger values,
+   * its maximum value plus one will be used. Setting this value to
+   * zero always uses the maximum of the input image.
+   */
+  Q_PROPERTY(int levels READ levels WRITE setLevels);
+
+  PII_OPERATION_SERIALIZATION_FUNCTION
+public:
+  PiiAdaptiveHistogramEqualizer();
+
+  void setTileSize(const QSize& tileSize);
+  QSize tileSize() const;
+  void setClipLimit(double clipLimit);
+  double clipLimit() const;
+  void setLevels(int levels);
+  int levels() const;
+
+protected:
+  void process();
+
+private:
+  template <class T> void equalize(const PiiVariant& obj);
+
+  /// @internal
+  class Data : public PiiDefaultOperation::Data
+  {
+  public:
+    Data();
+    QSize tileSize;
+    double dClipLimit;
+    int iLevels;
+  };
+  PII_D_FUNC;
+};
+
+
+#endif //_PIIADAPTIVEHISTOGRAMEQUALIZER_H
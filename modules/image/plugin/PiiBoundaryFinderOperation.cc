@@ -16,12 +16,15 @@
 #include "PiiBoundaryFinderOperation.h"
 
 #include "PiiBoundaryFinder.h"
+#include "PiiContours.h"
 #include <PiiYdinTypes.h>
 
 PiiBoundaryFinderOperation::Data::Data() :
   dThreshold(0),
   iMinLength(0),
-  iMaxLength(INT_MAX)
+  iMaxLength(INT_MAX),
+  boundaryType(TracedBoundary),
+  dPolygonTolerance(0)
 {
 }
 
@@ -34,6 +37,9 @@ PiiBoundaryFinderOperation::PiiBoundaryFinderOperation() : PiiDefaultOperation(n
   addSocket(d->pBoundariesOutput = new PiiOutputSocket("boundaries"));
   addSocket(d->pLimitsOutput = new PiiOutputSocket("limits"));
   addSocket(d->pMaskOutput = new PiiOutputSocket("mask"));
+  addSocket(d->pPerimetersOutput = new PiiOutputSocket("perimeters"));
+  addSocket(d->pAreasOutput = new PiiOutputSocket("areas"));
+  addSocket(d->pConvexitiesOutput = new PiiOutputSocket("convexities"));
 }
 
 void PiiBoundaryFinderOperation::process()
@@ -50,8 +56,16 @@ void PiiBoundaryFinderOperation::process()
 
 template <class T> void PiiBoundaryFinderOperation::findBoundaries(const PiiVariant& obj)
 {
-  PII_D;
   const PiiMatrix<T> image(obj.valueAs<PiiMatrix<T> >());
+  if (_d()->boundaryType == TracedBoundary)
+    traceBoundaries(image);
+  else
+    findContours(image);
+}
+
+template <class T> void PiiBoundaryFinderOperation::traceBoundaries(const PiiMatrix<T>& image)
+{
+  PII_D;
   PiiMatrix<unsigned char> matBoundaryMask;
   PiiBoundaryFinder finder(image.rows(), image.columns(), &matBoundaryMask);
   PiiMatrix<int> matPoints(0,2);
@@ -74,9 +88,100 @@ template <class T> void PiiBoundaryFinderOperation::findBoundaries(const PiiVari
         }
     }
 
+  d->pMaskOutput->emitObject(matBoundaryMask);
+  emitProperties(matPoints, matLimits);
+  emitBoundaries(matPoints, matLimits);
+}
+
+template <class T> void PiiBoundaryFinderOperation::findContours(const PiiMatrix<T>& image)
+{
+  PII_D;
+  PiiMatrix<int> matLimits;
+  PiiMatrix<double> matPoints(PiiImage::findContours(image, d->dThreshold,
+                                                     d->boundaryType == SubPixelBoundary ?
+                                                     PiiImage::SubPixelContour : PiiImage::CrackContour,
+                                                     PiiImage::Connect8,
+                                                     &matLimits));
+  PiiMatrix<double> matProperties(PiiImage::calculateContourProperties(matPoints, matLimits));
+
+  // Drop boundaries whose perimeter is out of range.
+  if (d->iMinLength > 0 || d->iMaxLength < INT_MAX)
+    {
+      PiiMatrix<double> matSelectedPoints(0,2), matSelectedProperties(0,3);
+      matSelectedPoints.reserve(matPoints.rows());
+      PiiMatrix<int> matSelectedLimits(1,32);
+      matSelectedLimits.resize(1,0);
+      for (int i=0, iStart=0; i<matLimits.columns(); iStart = matLimits(0,i++))
+        {
+          const double dPerimeter = matProperties(i,0);
+          if (dPerimeter < d->iMinLength || dPerimeter > d->iMaxLength)
+            continue;
+          for (int p=iStart; p<matLimits(0,i); ++p)
+            matSelectedPoints.appendRow(matPoints[p]);
+          matSelectedProperties.appendRow(matProperties[i]);
+          matSelectedLimits.appendColumn(matSelectedPoints.rows());
+        }
+      matPoints = matSelectedPoints;
+      matLimits = matSelectedLimits;
+      matProperties = matSelectedProperties;
+    }
+
+  if (d->pMaskOutput->isConnected())
+    {
+      // Mark object pixels that have a 4-connected background
+      // neighbor.
+      const int iRows = image.rows(), iColumns = image.columns();
+      PiiMatrix<unsigned char> matBoundaryMask(iRows, iColumns);
+      for (int r=0; r<iRows; ++r)
+        {
+          const T* pRow = image[r];
+          const T* pAbove = r > 0 ? image[r-1] : 0;
+          const T* pBelow = r < iRows-1 ? image[r+1] : 0;
+          unsigned char* pMask = matBoundaryMask[r];
+          for (int c=0; c<iColumns; ++c)
+            if (pRow[c] > d->dThreshold &&
+                (c == 0 || !(pRow[c-1] > d->dThreshold) ||
+                 c == iColumns-1 || !(pRow[c+1] > d->dThreshold) ||
+                 pAbove == 0 || !(pAbove[c] > d->dThreshold) ||
+                 pBelow == 0 || !(pBelow[c] > d->dThreshold)))
+              pMask[c] = 1;
+        }
+      d->pMaskOutput->emitObject(matBoundaryMask);
+    }
+  else
+    d->pMaskOutput->emitObject(PiiMatrix<unsigned char>());
+
+  d->pPerimetersOutput->emitObject(Pii::matrix(matProperties(0,0,-1,1)));
+  d->pAreasOutput->emitObject(Pii::matrix(matProperties(0,1,-1,1)));
+  d->pConvexitiesOutput->emitObject(Pii::matrix(matProperties(0,2,-1,1)));
+  emitBoundaries(matPoints, matLimits);
+}
+
+template <class T> void PiiBoundaryFinderOperation::emitProperties(const PiiMatrix<T>& points,
+                                                                   const PiiMatrix<int>& limits)
+{
+  PII_D;
+  if (!d->pPerimetersOutput->isConnected() &&
+      !d->pAreasOutput->isConnected() &&
+      !d->pConvexitiesOutput->isConnected())
+    return;
+  PiiMatrix<double> matProperties(PiiImage::calculateContourProperties(points, limits));
+  d->pPerimetersOutput->emitObject(Pii::matrix(matProperties(0,0,-1,1)));
+  d->pAreasOutput->emitObject(Pii::matrix(matProperties(0,1,-1,1)));
+  d->pConvexitiesOutput->emitObject(Pii::matrix(matProperties(0,2,-1,1)));
+}
+
+template <class T> void PiiBoundaryFinderOperation::emitBoundaries(const PiiMatrix<T>& points,
+                                                                   const PiiMatrix<int>& limits)
+{
+  PII_D;
+  PiiMatrix<T> matPoints(points);
+  PiiMatrix<int> matLimits(limits);
+  if (d->dPolygonTolerance > 0)
+    matPoints = PiiImage::approximatePolygons(points, limits, d->dPolygonTolerance, &matLimits);
+
   d->pBoundariesOutput->emitObject(matPoints);
   d->pLimitsOutput->emitObject(matLimits);
-  d->pMaskOutput->emitObject(matBoundaryMask);
 
   if (d->pBoundaryOutput->isConnected())
     {
@@ -99,3 +204,7 @@ void PiiBoundaryFinderOperation::setMinLength(int minLength) { _d()->iMinLength
 int PiiBoundaryFinderOperation::minLength() const { return _d()->iMinLength; }
 void PiiBoundaryFinderOperation::setMaxLength(int maxLength) { _d()->iMaxLength = maxLength; }
 int PiiBoundaryFinderOperation::maxLength() const { return _d()->iMaxLength; }
+void PiiBoundaryFinderOperation::setBoundaryType(BoundaryType boundaryType) { _d()->boundaryType = boundaryType; }
+PiiBoundaryFinderOperation::BoundaryType PiiBoundaryFinderOperation::boundaryType() const { return _d()->boundaryType; }
+void PiiBoundaryFinderOperation::setPolygonTolerance(double polygonTolerance) { _d()->dPolygonTolerance = polygonTolerance; }
+double PiiBoundaryFinderOperation::polygonTolerance() const { return _d()->dPolygonTolerance; }
@@ -50,7 +50,22 @@
  *
  * @out mask - boundary mask. A gray-level image in which the detected
  * edges are marked according to their type. See PiiBoundaryFinder for
- * an explanation.
+ * an explanation. With the `CrackBoundary` and `SubPixelBoundary`
+ * types, object pixels next to a background pixel are marked with
+ * ones. The mask is only built if this output is connected.
+ *
+ * @out perimeters - the length of each boundary polygon.
+ * PiiMatrix<double>(N,1).
+ *
+ * @out areas - the signed area of each boundary polygon. Outer
+ * boundaries have a positive and inner boundaries a negative area.
+ * PiiMatrix<double>(N,1).
+ *
+ * @out convexities - the ratio of the area of each boundary polygon
+ * to the area of its convex hull. PiiMatrix<double>(N,1).
+ *
+ * The polygon properties are calculated from the exact boundaries,
+ * before [polygonTolerance] is applied.
  *
  */
 class PiiBoundaryFinderOperation : public PiiDefaultOperation
@@ -81,9 +96,47 @@ class PiiBoundaryFinderOperation : public PiiDefaultOperation
    */
   Q_PROPERTY(int maxLength READ maxLength WRITE setMaxLength);
 
+  /**
+   * The type of the extracted boundaries. The default is
+   * `TracedBoundary`.
+   */
+  Q_PROPERTY(BoundaryType boundaryType READ boundaryType WRITE setBoundaryType);
+  Q_ENUMS(BoundaryType);
+
+  /**
+   * If this value is larger than zero, the boundaries will be
+   * approximated with polygons whose vertices deviate at most this
+   * many pixels from the original boundary (see
+   * [PiiImage::approximatePolygons()]). The default is zero.
+   */
+  Q_PROPERTY(double polygonTolerance READ polygonTolerance WRITE setPolygonTolerance);
+
   PII_OPERATION_SERIALIZATION_FUNCTION
 
 public:
+  /**
+   * Boundary types.
+   *
+   * - `TracedBoundary` - object boundaries are traversed pixel by
+   * pixel using PiiBoundaryFinder. Each boundary point is the
+   * coordinates of an object pixel (PiiMatrix<int>).
+   *
+   * - `CrackBoundary` - the corners of the cracks between object and
+   * background pixels, extracted in a single pass with
+   * [PiiImage::findContours()]. Pixel (x,y) covers the square from
+   * (x,y) to (x+1,y+1) (PiiMatrix<double>).
+   *
+   * - `SubPixelBoundary` - boundary points interpolated between
+   * object and background pixels at [threshold] (marching squares).
+   * Use a threshold of 0.5 with binary images to place the points in
+   * the middle of the cracks (PiiMatrix<double>).
+   *
+   * With `CrackBoundary` and `SubPixelBoundary`, diagonally touching
+   * pixels are connected, and [minLength] and [maxLength] are
+   * compared to the perimeter of a boundary.
+   */
+  enum BoundaryType { TracedBoundary, CrackBoundary, SubPixelBoundary };
+
   PiiBoundaryFinderOperation();
 
 protected:
@@ -95,6 +148,10 @@ protected:
   int minLength() const;
   void setMaxLength(int maxLength);
   int maxLength() const;
+  void setBoundaryType(BoundaryType boundaryType);
+  BoundaryType boundaryType() const;
+  void setPolygonTolerance(double polygonTolerance);
+  double polygonTolerance() const;
 
 private:
   /// @internal
@@ -104,12 +161,19 @@ private:
     Data();
     double dThreshold;
     PiiOutputSocket *pBoundaryOutput, *pBoundariesOutput, *pLimitsOutput, *pMaskOutput;
+    PiiOutputSocket *pPerimetersOutput, *pAreasOutput, *pConvexitiesOutput;
     int iMinLength;
     int iMaxLength;
+    BoundaryType boundaryType;
+    double dPolygonTolerance;
   };
   PII_D_FUNC;
 
   template <class T> void findBoundaries(const PiiVariant& obj);
+  template <class T> void traceBoundaries(const PiiMatrix<T>& image);
+  template <class T> void findContours(const PiiMatrix<T>& image);
+  template <class T> void emitBoundaries(const PiiMatrix<T>& points, const PiiMatrix<int>& limits);
+  template <class T> void emitProperties(const PiiMatrix<T>& points, const PiiMatrix<int>& limits);
 };
 
 #endif //_PIIBOUNDARYFINDEROPERATION_H
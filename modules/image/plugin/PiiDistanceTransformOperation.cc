@@ -0,0 +1,60 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+
+#include "PiiDistanceTransformOperation.h"
+#include "PiiDistanceTransform.h"
+#include <PiiYdinTypes.h>
+
+PiiDistanceTransformOperation::Data::Data() :
+  distanceType(PiiImage::EuclideanDistance)
+{
+}
+
+PiiDistanceTransformOperation::PiiDistanceTransformOperation() :
+  PiiDefaultOperation(new Data)
+{
+  setThreadCount(1);
+  PII_D;
+  d->pImageInput = new PiiInputSocket("image");
+  d->pDistanceOutput = new PiiOutputSocket("distance");
+
+  addSocket(d->pImageInput);
+  addSocket(d->pDistanceOutput);
+}
+
+void PiiDistanceTransformOperation::process()
+{
+  PII_D;
+
+  PiiVariant obj = d->pImageInput->firstObject();
+
+  switch (obj.type())
+    {
+      PII_GRAY_IMAGE_CASES(transform, obj);
+    default:
+      PII_THROW_UNKNOWN_TYPE(d->pImageInput);
+    }
+}
+
+template <class T> void PiiDistanceTransformOperation::transform(const PiiVariant& obj)
+{
+  PII_D;
+  d->pDistanceOutput->emitObject(PiiImage::distanceTransform(obj.valueAs<PiiMatrix<T> >(),
+                                                             d->distanceType));
+}
+
+void PiiDistanceTransformOperation::setDistanceType(PiiImage::DistanceType distanceType) { _d()->distanceType = distanceType; }
+PiiImage::DistanceType PiiDistanceTransformOperation::distanceType() const { return _d()->distanceType; }
@@ -0,0 +1,77 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+
+#ifndef _PIIDISTANCETRANSFORMOPERATION_H
+#define _PIIDISTANCETRANSFORMOPERATION_H
+
+#include <PiiDefaultOperation.h>
+#include <PiiMatrix.h>
+#include "PiiImageGlobal.h"
+
+/**
+ * Calculates the distance from each object pixel to the closest
+ * background pixel. See [PiiImage::distanceTransform()].
+ *
+ * Inputs
+ * ------
+ *
+ * @in image - the input image. Zero pixels are background, all
+ * others are objects. (Any gray-level image type.)
+ *
+ * Outputs
+ * -------
+ *
+ * @out distance - distances to the closest background pixel.
+ * (PiiMatrix<float>)
+ *
+ */
+class PiiDistanceTransformOperation : public PiiDefaultOperation
+{
+  Q_OBJECT
+
+  /**
+   * The distance measure. The default is `EuclideanDistance`.
+   */
+  Q_PROPERTY(PiiImage::DistanceType distanceType READ distanceType WRITE setDistanceType);
+
+  PII_OPERATION_SERIALIZATION_FUNCTION
+public:
+  PiiDistanceTransformOperation();
+
+  void setDistanceType(PiiImage::DistanceType distanceType);
+  PiiImage::DistanceType distanceType() const;
+
+protected:
+  void process();
+
+private:
+  template <class T> void transform(const PiiVariant& obj);
+
+  /// @internal
+  class Data : public PiiDefaultOperation::Data
+  {
+  public:
+    Data();
+    PiiImage::DistanceType distanceType;
+
+    PiiInputSocket* pImageInput;
+    PiiOutputSocket* pDistanceOutput;
+  };
+  PII_D_FUNC;
+};
+
+
+#endif //_PIIDISTANCETRANSFORMOPERATION_H
@@ -21,7 +21,7 @@
 PiiEdgeDetector::Data::Data() :
   detector(CannyDetector),
   dThreshold(0), dLowThreshold(0),
-  bDirectionConnected(false)
+  bMagnitudeConnected(false), bDirectionConnected(false)
 {
 }
 
@@ -57,6 +57,7 @@ void PiiEdgeDetector::check(bool reset)
       break;
     }
 
+  d->bMagnitudeConnected = outputAt(1)->isConnected();
   d->bDirectionConnected = outputAt(2)->isConnected();
 }
 
@@ -78,6 +79,11 @@ void PiiEdgeDetector::process()
 template <class T> void PiiEdgeDetector::detectIntEdges(const PiiVariant& obj)
 {
   PII_D;
+  if (d->detector == CannyDetector)
+    {
+      detectCannyEdges(obj.valueAs<PiiMatrix<T> >());
+      return;
+    }
   PiiMatrix<int> image(obj.valueAs<PiiMatrix<T> >());
   detectEdges(PiiImage::filter<int>(image, d->matFilterX),
               PiiImage::filter<int>(image, d->matFilterY));
@@ -87,10 +93,35 @@ template <class T> void PiiEdgeDetector::detectFloatEdges(const PiiVariant& obj)
 {
   PII_D;
   const PiiMatrix<T> image = obj.valueAs<PiiMatrix<T> >();
+  if (d->detector == CannyDetector)
+    {
+      detectCannyEdges(image);
+      return;
+    }
   detectEdges(PiiImage::filter<T>(image, PiiMatrix<T>(d->matFilterX)),
               PiiImage::filter<T>(image, PiiMatrix<T>(d->matFilterY)));
 }
 
+template <class T> void PiiEdgeDetector::detectCannyEdges(const PiiMatrix<T>& image)
+{
+  PII_D;
+  typedef typename Pii::Combine<T,int>::Type GradientType;
+  PiiMatrix<GradientType> matMagnitude;
+  PiiMatrix<int> matEdges = PiiImage::cannyEdges(image,
+                                                 GradientType(d->dLowThreshold),
+                                                 GradientType(d->dThreshold),
+                                                 d->bMagnitudeConnected ? &matMagnitude : 0);
+  if (d->bMagnitudeConnected)
+    outputAt(1)->emitObject(matMagnitude);
+
+  // Send detected edges
+  emitObject(PiiMatrix<GradientType>(matEdges));
+
+  if (d->bDirectionConnected)
+    outputAt(2)->emitObject(PiiImage::gradientDirection(PiiImage::filter<GradientType>(image, PiiMatrix<GradientType>(d->matFilterX), Pii::ExtendZeros),
+                                                        PiiImage::filter<GradientType>(image, PiiMatrix<GradientType>(d->matFilterY), Pii::ExtendZeros)));
+}
+
 template <class T> void PiiEdgeDetector::detectEdges(const PiiMatrix<T>& gradientX,
                                                      const PiiMatrix<T>& gradientY)
 {
@@ -106,10 +137,7 @@ template <class T> void PiiEdgeDetector::detectEdges(const PiiMatrix<T>& gradien
       threshold = T(fMean + fStd * 2);
     }
 
-  if (d->detector == CannyDetector)
-    cannyThreshold(gradientX, gradientY, matMagnitude, threshold);
-  else
-    matMagnitude.map(PiiImage::ThresholdFunction<T>(), threshold);
+  matMagnitude.map(PiiImage::ThresholdFunction<T>(), threshold);
 
   // Send detected edges
   emitObject(matMagnitude);
@@ -118,23 +146,6 @@ template <class T> void PiiEdgeDetector::detectEdges(const PiiMatrix<T>& gradien
     outputAt(2)->emitObject(PiiImage::gradientDirection(gradientX, gradientY));
 }
 
-template <class T> void PiiEdgeDetector::cannyThreshold(const PiiMatrix<T>& gradientX,
-                                                        const PiiMatrix<T>& gradientY,
-                                                        PiiMatrix<T>& magnitude,
-                                                        T highThreshold)
-{
-  PII_D;
-  T lowThreshold = T(d->dLowThreshold == 0 ? 0.4 * highThreshold : d->dLowThreshold);
-  /*magnitude = PiiImage::suppressNonMaxima(magnitude,
-                                          PiiImage::gradientDirection(gradientX, gradientY),
-                                          PiiImage::RadiansToPoints<float>());
-  */
-  magnitude = PiiImage::hysteresisThreshold(PiiImage::suppressNonMaxima(magnitude,
-                                                                        PiiImage::gradientDirection(gradientX, gradientY),
-                                                                        PiiImage::RadiansToPoints<float>()),
-                                            lowThreshold, highThreshold);
-}
-
 PiiEdgeDetector::Detector PiiEdgeDetector::detector() const { return _d()->detector; }
 void PiiEdgeDetector::setDetector(Detector detector) { _d()->detector = detector; }
 void PiiEdgeDetector::setThreshold(double threshold) { _d()->dThreshold = threshold; }
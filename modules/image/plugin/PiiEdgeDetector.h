@@ -92,7 +92,10 @@ public:
    * image is processed to contain only local maxima (
    * [PiiImage::suppressNonMaxima()]) 3) hysteresis thresholding is
    * performed ([PiiImage::hysteresisThreshold()]). This technique
-   * requires two thresholds ([lowThreshold] and [threshold]).
+   * requires two thresholds ([lowThreshold] and [threshold]). The
+   * steps are fused into a single pass over the image (see
+   * [PiiImage::cannyEdges()]). Gradient components are only
+   * calculated separately if the `direction` output is connected.
    *
    * ! The original edge detection technique by Canny actually
    * uses derivatives of 2D Gaussians to calculate the gradient. This
@@ -123,12 +126,9 @@ protected:
 private:
   template <class T> void detectIntEdges(const PiiVariant& obj);
   template <class T> void detectFloatEdges(const PiiVariant& obj);
+  template <class T> void detectCannyEdges(const PiiMatrix<T>& image);
   template <class T> void detectEdges(const PiiMatrix<T>& gradientX,
                                       const PiiMatrix<T>& gradientY);
-  template <class T> void cannyThreshold(const PiiMatrix<T>& gradientX,
-                                         const PiiMatrix<T>& gradientY,
-                                         PiiMatrix<T>& magnitude,
-                                         T highThreshold);
 
   /// @internal
   class Data : public PiiDefaultOperation::Data
@@ -139,7 +139,7 @@ private:
     double dThreshold;
     double dLowThreshold;
     PiiMatrix<int> matFilterX, matFilterY;
-    bool bDirectionConnected;
+    bool bMagnitudeConnected, bDirectionConnected;
   };
   PII_D_FUNC;
 };
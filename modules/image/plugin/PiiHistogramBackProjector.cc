@@ -19,10 +19,13 @@
 #include <PiiColor.h>
 #include <PiiMath.h>
 #include "PiiHistogram.h"
+#include <limits>
 
 PiiHistogramBackProjector::Data::Data() :
   bChannel2Connected(false),
-  bModelConnected(false)
+  bModelConnected(false),
+  dThreshold(NAN),
+  bThresholdedModelValid(false)
 {
 }
 
@@ -55,6 +58,7 @@ void PiiHistogramBackProjector::check(bool reset)
     PII_THROW(PiiExecutionException, tr("Model input is not connected and model has not been set."));
 
   d->varTmpModel = d->varModel;
+  d->bThresholdedModelValid = false;
 
   PiiDefaultOperation::check(reset);
 }
@@ -73,9 +77,10 @@ void PiiHistogramBackProjector::process()
   // First resolve the type of input
   switch (obj.type())
     {
-      // NOTE: if this is ever changed, change the limit check in
-      // backProject. It now assumes unsigned types.
       PII_INT_GRAY_IMAGE_CASES_M(backProject, (obj, obj2));
+    case PiiYdin::UnsignedShortMatrixType:
+      backProject<unsigned short>(obj, obj2);
+      break;
     default:
       PII_THROW_UNKNOWN_TYPE(inputAt(0));
     }
@@ -89,7 +94,14 @@ template <class T> void PiiHistogramBackProjector::backProject(const PiiVariant&
 
   // Read model histogram from input if it is connected
   if (d->bModelConnected)
-    d->varTmpModel = inputAt(2)->firstObject();
+    {
+      d->varTmpModel = inputAt(2)->firstObject();
+      d->bThresholdedModelValid = false;
+    }
+
+  const bool bThreshold = !Pii::isNan(d->dThreshold);
+  if (bThreshold && !d->bThresholdedModelValid)
+    updateThresholdedModel();
 
   // Two-dimensional back-projection
   if (obj2.isValid())
@@ -100,55 +112,135 @@ template <class T> void PiiHistogramBackProjector::backProject(const PiiVariant&
           ch1.rows() != ch2.rows())
         PII_THROW(PiiExecutionException, tr("The sizes of channel images must match in two-dimensional histogram back-projection."));
 
-      switch (d->varTmpModel.type())
+      if (bThreshold)
+        project(ch1, ch2, d->matThresholdedModel);
+      else
         {
-          PII_PRIMITIVE_MATRIX_CASES_M(backProject, (ch1, ch2));
-          PII_COLOR_IMAGE_CASES_M(backProject, (ch1, ch2));
-        default:
-          PII_THROW(PiiExecutionException, tr(errorMsg));
+          switch (d->varTmpModel.type())
+            {
+              PII_PRIMITIVE_MATRIX_CASES_M(backProject, (ch1, ch2));
+              PII_COLOR_IMAGE_CASES_M(backProject, (ch1, ch2));
+            default:
+              PII_THROW(PiiExecutionException, tr(errorMsg));
+            }
         }
     }
   // One-dimensional back-projection
   else
     {
       const PiiMatrix<T>& image = obj1.valueAs<PiiMatrix<T> >();
-      switch (d->varTmpModel.type())
+      if (bThreshold)
+        project(image, d->matThresholdedModel);
+      else
         {
-          PII_PRIMITIVE_MATRIX_CASES(backProject, image);
-          PII_COLOR_IMAGE_CASES(backProject, image);
-        default:
-          PII_THROW(PiiExecutionException, tr(errorMsg));
+          switch (d->varTmpModel.type())
+            {
+              PII_PRIMITIVE_MATRIX_CASES(backProject, image);
+              PII_COLOR_IMAGE_CASES(backProject, image);
+            default:
+              PII_THROW(PiiExecutionException, tr(errorMsg));
+            }
         }
     }
 }
 
+void PiiHistogramBackProjector::updateThresholdedModel()
+{
+  switch (_d()->varTmpModel.type())
+    {
+      PII_PRIMITIVE_MATRIX_CASES_M(thresholdModel, ());
+    default:
+      PII_THROW(PiiExecutionException, tr("Thresholding requires a numeric model histogram."));
+    }
+}
+
+template <class T> void PiiHistogramBackProjector::thresholdModel()
+{
+  PII_D;
+  const PiiMatrix<T> model = d->varTmpModel.valueAs<PiiMatrix<T> >();
+  const int iRows = model.rows(), iColumns = model.columns();
+  d->matThresholdedModel = PiiMatrix<unsigned char>::uninitialized(iRows, iColumns);
+  for (int r=0; r<iRows; ++r)
+    {
+      const T* pModel = model[r];
+      unsigned char* pThresholded = d->matThresholdedModel[r];
+      for (int c=0; c<iColumns; ++c)
+        pThresholded[c] = double(pModel[c]) >= d->dThreshold ? 1 : 0;
+    }
+  d->bThresholdedModelValid = true;
+}
+
+// True if a model dimension of the given size can be indexed with
+// any value of type U without range checks.
+template <class U> static inline bool coversAllValues(int size)
+{
+  return !std::numeric_limits<U>::is_signed &&
+    double(size) > double(std::numeric_limits<U>::max());
+}
+
 // Convert model to matrix and use already resolved input channel matrices
 template <class T, class U> void PiiHistogramBackProjector::backProject(const PiiMatrix<U>& ch1, const PiiMatrix<U>& ch2)
 {
-  static const char* errorMsg = QT_TR_NOOP("The values in channel %1 (%2-%3) exceed model dimensions (0-%4).");
-  const PiiMatrix<T> model = _d()->varTmpModel.valueAs<PiiMatrix<T> >();
-
-  // Check that the input matrices index a valid range of rows/columns
-  U maxVal =  Pii::max(ch1);
-  if (int(maxVal) >= model.rows()) // maxVal >= 0, because U is unsigned
-    PII_THROW(PiiExecutionException, tr(errorMsg).arg(0).arg(0).arg(maxVal).arg(model.rows()-1));
-  maxVal = Pii::max(ch2);
-  if (int(maxVal) >= model.columns())
-    PII_THROW(PiiExecutionException, tr(errorMsg).arg(1).arg(0).arg(maxVal).arg(model.columns()-1));
+  project(ch1, ch2, _d()->varTmpModel.valueAs<PiiMatrix<T> >());
+}
 
-  emitObject(PiiImage::backProject(ch1, ch2, model));
+template <class T, class U> void PiiHistogramBackProjector::project(const PiiMatrix<U>& ch1, const PiiMatrix<U>& ch2,
+                                                                    const PiiMatrix<T>& model)
+{
+  static const char* errorMsg = QT_TR_NOOP("The values in channel %1 (%2-%3) exceed model dimensions (0-%4).");
+  if (model.isEmpty())
+    PII_THROW(PiiExecutionException, tr("Model histogram is empty."));
+
+  // Check that the input matrices index a valid range of
+  // rows/columns. The maxima are collected during back-projection
+  // unless the model covers all possible values.
+  const bool bCheck = !coversAllValues<U>(model.rows()) || !coversAllValues<U>(model.columns());
+  unsigned int uiMaximum1 = 0, uiMaximum2 = 0;
+  PiiMatrix<T> matResult(PiiImage::backProject(ch1, ch2, model,
+                                               bCheck ? &uiMaximum1 : 0,
+                                               bCheck ? &uiMaximum2 : 0));
+  if (uiMaximum1 >= unsigned(model.rows()))
+    PII_THROW(PiiExecutionException, tr(errorMsg).arg(0).arg(0).arg(uiMaximum1).arg(model.rows()-1));
+  if (uiMaximum2 >= unsigned(model.columns()))
+    PII_THROW(PiiExecutionException, tr(errorMsg).arg(1).arg(0).arg(uiMaximum2).arg(model.columns()-1));
+
+  emitObject(matResult);
 }
 
 // Convert model to matrix and use already resolved input matrix
 template <class T, class U> void PiiHistogramBackProjector::backProject(const PiiMatrix<U>& image)
 {
-  const PiiMatrix<T>& model = _d()->varTmpModel.valueAs<PiiMatrix<T> >();
-  U maxVal = Pii::max(image);
-  if (int(maxVal) >= model.columns())
-    PII_THROW(PiiExecutionException, tr("Values in input image (%1-%2) exceed model size (0-%3).").arg(0).arg(maxVal).arg(model.columns()-1));
+  project(image, _d()->varTmpModel.valueAs<PiiMatrix<T> >());
+}
+
+template <class T, class U> void PiiHistogramBackProjector::project(const PiiMatrix<U>& image, const PiiMatrix<T>& model)
+{
+  if (model.isEmpty())
+    PII_THROW(PiiExecutionException, tr("Model histogram is empty."));
+
+  const bool bCheck = !coversAllValues<U>(model.columns());
+  unsigned int uiMaximum = 0;
+  PiiMatrix<T> matResult(PiiImage::backProject(image, model, bCheck ? &uiMaximum : 0));
+  if (uiMaximum >= unsigned(model.columns()))
+    PII_THROW(PiiExecutionException, tr("Values in input image (%1-%2) exceed model size (0-%3).").arg(0).arg(uiMaximum).arg(model.columns()-1));
 
-  emitObject(PiiImage::backProject(image, model));
+  emitObject(matResult);
+}
+
+void PiiHistogramBackProjector::setModel(const PiiVariant& model)
+{
+  PII_D;
+  d->varModel = model;
+  d->bThresholdedModelValid = false;
 }
 
-void PiiHistogramBackProjector::setModel(const PiiVariant& model) { _d()->varModel = model; }
 PiiVariant PiiHistogramBackProjector::model() const { return _d()->varModel; }
+
+void PiiHistogramBackProjector::setThreshold(double threshold)
+{
+  PII_D;
+  d->dThreshold = threshold;
+  d->bThresholdedModelValid = false;
+}
+
+double PiiHistogramBackProjector::threshold() const { return _d()->dThreshold; }
@@ -45,7 +45,13 @@
  * Outputs
  * -------
  *
- * @out image - backprojected image. Type depends on the model.
+ * @out image - backprojected image. Type depends on the model. If
+ * [threshold] is set, a binary image (PiiMatrix<unsigned char>).
+ *
+ * The model is looked up directly with pixel values. With 8-bit
+ * input images and models that cover all 256 values, no range checks
+ * are needed. Otherwise, the range of the input is checked during the
+ * back-projection itself. Rows are processed in parallel.
  *
  */
 class PiiHistogramBackProjector : public PiiDefaultOperation
@@ -59,6 +65,16 @@ class PiiHistogramBackProjector : public PiiDefaultOperation
    */
   Q_PROPERTY(PiiVariant model READ model WRITE setModel);
 
+  /**
+   * If this value is not NaN, the back-projection will be
+   * thresholded: pixels whose model value is greater than or equal
+   * to the threshold will be set to one and others to zero. The model
+   * is thresholded only when it changes, which makes the combined
+   * operation as fast as plain back-projection. Thresholding requires
+   * a numeric model. The default value is NaN.
+   */
+  Q_PROPERTY(double threshold READ threshold WRITE setThreshold);
+
   PII_OPERATION_SERIALIZATION_FUNCTION
 public:
   PiiHistogramBackProjector();
@@ -70,6 +86,8 @@ public:
 
   void setModel(const PiiVariant& model);
   PiiVariant model() const;
+  void setThreshold(double threshold);
+  double threshold() const;
 
 protected:
   void process();
@@ -79,6 +97,10 @@ private:
   template <class T> void backProject(const PiiVariant& obj1, const PiiVariant& obj2);
   template <class T, class U> void backProject(const PiiMatrix<U>& ch1, const PiiMatrix<U>& ch2);
   template <class T, class U> void backProject(const PiiMatrix<U>& image);
+  template <class T, class U> void project(const PiiMatrix<U>& ch1, const PiiMatrix<U>& ch2, const PiiMatrix<T>& model);
+  template <class T, class U> void project(const PiiMatrix<U>& image, const PiiMatrix<T>& model);
+  template <class T> void thresholdModel();
+  void updateThresholdedModel();
 
   /// @internal
   class Data : public PiiDefaultOperation::Data
@@ -87,6 +109,9 @@ private:
     Data();
     PiiVariant varModel, varTmpModel;
     bool bChannel2Connected, bModelConnected;
+    double dThreshold;
+    PiiMatrix<unsigned char> matThresholdedModel;
+    bool bThresholdedModelValid;
   };
   PII_D_FUNC;
 };
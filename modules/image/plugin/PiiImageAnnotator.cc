@@ -17,8 +17,11 @@
 
 #include <PiiYdinTypes.h>
 #include <PiiSmartPtr.h>
+#include <PiiRasterizer.h>
 
 #include <QPainter>
+#include <QFontMetrics>
+#include <QMutexLocker>
 
 using namespace Pii;
 using namespace PiiYdin;
@@ -29,7 +32,8 @@ PiiImageAnnotator::Data::Data() :
   pen(QColor(Qt::red)),
   bAnnotationConnected(false),
   bTypeConnected(false),
-  bEnabled(true)
+  bEnabled(true),
+  bNativeRendering(false)
 {
   pen.setCosmetic(true);
 }
@@ -73,6 +77,9 @@ QVariantList PiiImageAnnotator::annotations() const { return _d()->lstAnnotation
 void PiiImageAnnotator::setEnabled(bool enabled) { _d()->bEnabled = enabled; }
 bool PiiImageAnnotator::enabled() const { return _d()->bEnabled; }
 
+void PiiImageAnnotator::setNativeRendering(bool nativeRendering) { _d()->bNativeRendering = nativeRendering; }
+bool PiiImageAnnotator::nativeRendering() const { return _d()->bNativeRendering; }
+
 void PiiImageAnnotator::check(bool reset)
 {
   PII_D;
@@ -111,7 +118,9 @@ void PiiImageAnnotator::process()
 
 template <class T> void PiiImageAnnotator::Data::annotate(const PiiVariant& obj)
 {
-  if (bAnnotationConnected || lstAnnotations.size() != 0)
+  if (bNativeRendering && (bAnnotationConnected || lstAnnotations.size() != 0))
+    annotateNative<T>(obj);
+  else if (bAnnotationConnected || lstAnnotations.size() != 0)
     {
       const PiiMatrix<T> matrix = obj.valueAs<PiiMatrix<T> >();
       // Protect against exceptions
@@ -297,3 +306,267 @@ template <class T, class U> void PiiImageAnnotator::Data::drawAnnotation(QPainte
       break;
     }
 }
+
+// Converts a QColor to the pixel type of the annotated image.
+template <class T> struct RasterColor
+{
+  static T fromQColor(const QColor& clr) { return T(qGray(clr.rgb())); }
+};
+
+template <> struct RasterColor<float>
+{
+  static float fromQColor(const QColor& clr) { return float(qGray(clr.rgb())) / 255; }
+};
+
+template <> struct RasterColor<double>
+{
+  static double fromQColor(const QColor& clr) { return double(qGray(clr.rgb())) / 255; }
+};
+
+template <> struct RasterColor<PiiColor<unsigned char> >
+{
+  static PiiColor<unsigned char> fromQColor(const QColor& clr)
+  {
+    return PiiColor<unsigned char>(clr.red(), clr.green(), clr.blue());
+  }
+};
+
+template <> struct RasterColor<PiiColor4<unsigned char> >
+{
+  static PiiColor4<unsigned char> fromQColor(const QColor& clr)
+  {
+    return PiiColor4<unsigned char>(clr.red(), clr.green(), clr.blue(), clr.alpha());
+  }
+};
+
+template <class T> void PiiImageAnnotator::Data::annotateNative(const PiiVariant& obj)
+{
+  // The rasterizer detaches the copy before drawing.
+  PiiMatrix<T> matImage(obj.valueAs<PiiMatrix<T> >());
+  PiiRasterizer<T> rasterizer(matImage);
+
+  if (lstAnnotations.size() != 0)
+    rasterizeAnnotations(&rasterizer, lstAnnotations);
+  if (bAnnotationConnected)
+    {
+      PiiVariant pAnnotation = pAnnotationInput->firstObject();
+      AnnotationType type = bTypeConnected ?
+        static_cast<AnnotationType>(PiiYdin::primitiveAs<int>(pTypeInput)) :
+        annotationType;
+
+      if (type == Text)
+        {
+          QString strText = PiiYdin::convertToQString(pAnnotationInput);
+          rasterizer.setColor(RasterColor<T>::fromQColor(pen.color()));
+          rasterizer.drawText(textPosition.x(), textPosition.y(), strText, glyphs(strText));
+        }
+      else
+        {
+          switch (pAnnotation.type())
+            {
+              PII_NUMERIC_MATRIX_CASES_M(rasterize, (&rasterizer, pAnnotation, type));
+            default:
+              PII_THROW_UNKNOWN_TYPE(pAnnotationInput);
+              break;
+            }
+        }
+    }
+  pImageOutput->emitObject(matImage);
+}
+
+// Draws all shapes in a coordinate matrix. Points and lines cannot
+// be filled.
+template <class T, class U> static void rasterizeMatrix(PiiRasterizer<T>* rasterizer,
+                                                        const PiiMatrix<U>& matrix,
+                                                        PiiImageAnnotator::AnnotationType type,
+                                                        bool fill)
+{
+  const int iColumns = matrix.columns();
+  switch (type)
+    {
+    case PiiImageAnnotator::Point:
+      if (iColumns == 2 && !fill)
+        rasterizer->drawPoints(matrix);
+      break;
+    case PiiImageAnnotator::Line:
+      if (iColumns == 4 && !fill)
+        rasterizer->drawLines(matrix);
+      break;
+    case PiiImageAnnotator::Rectangle:
+      if (iColumns == 4)
+        rasterizer->drawRectangles(matrix, fill);
+      break;
+    case PiiImageAnnotator::Ellipse:
+      if (iColumns == 4)
+        rasterizer->drawEllipses(matrix, fill);
+      break;
+    case PiiImageAnnotator::Circle:
+      if (iColumns == 3)
+        rasterizer->drawCircles(matrix, fill);
+      break;
+    default:
+      break;
+    }
+}
+
+template <class U, class T> void PiiImageAnnotator::Data::rasterize(PiiRasterizer<T>* rasterizer,
+                                                                    const PiiVariant& annotation,
+                                                                    AnnotationType type)
+{
+  const PiiMatrix<U> matrix = annotation.valueAs<PiiMatrix<U> >();
+
+  // Determine property type automatically based on the number of
+  // columns in input.
+  if (type == Auto)
+    {
+      switch (matrix.columns())
+        {
+        case 2: type = Point; break;
+        case 3: type = Circle; break;
+        case 4: type = Rectangle; break;
+        }
+    }
+
+  // Fill first, then draw the outline on top of it.
+  if (brush.style() != Qt::NoBrush)
+    {
+      rasterizer->setColor(RasterColor<T>::fromQColor(brush.color()));
+      rasterizeMatrix(rasterizer, matrix, type, true);
+    }
+  if (pen.style() != Qt::NoPen)
+    {
+      rasterizer->setColor(RasterColor<T>::fromQColor(pen.color()));
+      rasterizer->setLineWidth(pen.width());
+      rasterizeMatrix(rasterizer, matrix, type, false);
+    }
+}
+
+template <class T> void PiiImageAnnotator::Data::rasterizeAnnotations(PiiRasterizer<T>* rasterizer,
+                                                                      const QVariantList& annotations)
+{
+  for (int i=0; i<annotations.size(); ++i)
+    {
+      QVariantMap map = annotations[i].toMap();
+
+      // All types must have x
+      if (!map.contains("x"))
+        continue;
+
+      QPen itemPen = map.contains("pen") ? map["pen"].value<QPen>() : QPen(Qt::red);
+      QBrush itemBrush = map.contains("brush") ? map["brush"].value<QBrush>() : QBrush(Qt::NoBrush);
+      AnnotationType type = static_cast<AnnotationType>(map["annotationType"].toInt());
+      const int iX = Pii::round<int>(map["x"].toDouble()), iY = Pii::round<int>(map["y"].toDouble());
+
+      if (itemBrush.style() != Qt::NoBrush)
+        {
+          rasterizer->setColor(RasterColor<T>::fromQColor(itemBrush.color()));
+          rasterizeShape(rasterizer, type, true, iX, iY, map);
+        }
+      if (itemPen.style() != Qt::NoPen)
+        {
+          rasterizer->setColor(RasterColor<T>::fromQColor(itemPen.color()));
+          rasterizer->setLineWidth(itemPen.width());
+          rasterizeShape(rasterizer, type, false, iX, iY, map);
+        }
+    }
+}
+
+template <class T> void PiiImageAnnotator::Data::rasterizeShape(PiiRasterizer<T>* rasterizer,
+                                                                AnnotationType type, bool fill,
+                                                                int x, int y, const QVariantMap& annotation)
+{
+  const int iWidth = Pii::round<int>(annotation["width"].toDouble());
+  const int iHeight = Pii::round<int>(annotation["height"].toDouble());
+  const int iRadius = Pii::round<int>(annotation["radius"].toDouble());
+
+  switch (type)
+    {
+    case Text:
+      if (!fill)
+        {
+          QString strText = annotation["text"].toString();
+          rasterizer->drawText(x, y, strText, glyphs(strText));
+        }
+      break;
+    case Line:
+      if (!fill)
+        rasterizer->drawLine(x, y,
+                             Pii::round<int>(annotation["x2"].toDouble()),
+                             Pii::round<int>(annotation["y2"].toDouble()));
+      break;
+    case Point:
+      if (!fill)
+        rasterizer->drawPoint(x, y);
+      break;
+    case Rectangle:
+      if (fill)
+        rasterizer->fillRectangle(x, y, iWidth, iHeight);
+      else
+        rasterizer->drawRectangle(x, y, iWidth, iHeight);
+      break;
+    case Ellipse:
+      if (fill)
+        rasterizer->fillEllipse(x, y, iWidth, iHeight);
+      else
+        rasterizer->drawEllipse(x, y, iWidth, iHeight);
+      break;
+    case Circle:
+      if (fill)
+        rasterizer->fillCircle(x, y, iRadius);
+      else
+        rasterizer->drawCircle(x, y, iRadius);
+      break;
+    case Auto:
+    default:
+      break;
+    }
+}
+
+PiiRasterFont PiiImageAnnotator::Data::glyphs(const QString& text)
+{
+  // The returned copy shares glyph data with the cache but is not
+  // affected by glyphs added later by other threads.
+  QMutexLocker lock(&glyphMutex);
+  if (rasterFont.height() == 0 || fntRaster != font)
+    {
+      QFontMetrics metrics(font);
+      rasterFont = PiiRasterFont(metrics.ascent(), metrics.descent());
+      fntRaster = font;
+    }
+
+  // Render missing characters once and store them as binary masks.
+  for (int i=0; i<text.size(); ++i)
+    {
+      const QChar chr = text[i];
+      if (chr == '\n' || rasterFont.contains(chr.unicode()))
+        continue;
+
+      QFontMetrics metrics(font);
+      const int iAdvance = metrics.width(chr);
+      // Leave room for glyphs that extend beyond the advance (italics)
+      const int iMargin = metrics.height() / 4 + 1;
+      QImage img(iAdvance + 2 * iMargin, metrics.height(), QImage::Format_RGB32);
+      img.fill(qRgb(0,0,0));
+      {
+        QPainter painter(&img);
+        painter.setFont(font);
+        painter.setPen(Qt::white);
+        painter.drawText(iMargin, metrics.ascent(), QString(chr));
+      }
+
+      PiiRasterFont::Glyph glyph;
+      glyph.mask.resize(img.height(), img.width());
+      for (int r=0; r<img.height(); ++r)
+        {
+          const QRgb* pSource = reinterpret_cast<const QRgb*>(img.scanLine(r));
+          unsigned char* pMask = glyph.mask[r];
+          for (int c=0; c<img.width(); ++c)
+            pMask[c] = qGray(pSource[c]) >= 128 ? 1 : 0;
+        }
+      glyph.left = -iMargin;
+      glyph.top = -metrics.ascent();
+      glyph.advance = iAdvance;
+      rasterFont.setGlyph(chr.unicode(), glyph);
+    }
+  return rasterFont;
+}
@@ -20,9 +20,11 @@
 #include <PiiMatrix.h>
 #include <PiiQImage.h>
 #include <PiiColor.h>
+#include <PiiRasterFont.h>
 #include <QPair>
 #include <QBrush>
 #include <QPen>
+#include <QMutex>
 
 
 /**
@@ -50,6 +52,8 @@
  * @out image - the annotated image output
  *
  */
+template <class T> class PiiRasterizer;
+
 class PiiImageAnnotator : public PiiDefaultOperation
 {
   Q_OBJECT
@@ -97,6 +101,21 @@ class PiiImageAnnotator : public PiiDefaultOperation
    */
   Q_PROPERTY(bool enabled READ enabled WRITE setEnabled);
 
+  /**
+   * Enables drawing directly into the input matrix. By default, each
+   * image is converted to a QImage, annotated with QPainter and
+   * converted back to a color matrix. If this flag is `true`,
+   * annotations are drawn with [PiiRasterizer] into a copy of the
+   * input, and the type of the output image will be the same as that
+   * of the input. Colors are converted to gray levels with gray-level
+   * images (in the range [0,1] with floating-point types). Native
+   * rendering uses no anti-aliasing, and only the color and the width
+   * of the pen and the color of the brush are used. Text is drawn with
+   * glyphs that are rendered once with [font] and cached. The default
+   * is `false`.
+   */
+  Q_PROPERTY(bool nativeRendering READ nativeRendering WRITE setNativeRendering);
+
   PII_OPERATION_SERIALIZATION_FUNCTION
 public:
 
@@ -154,6 +173,9 @@ public:
   void setEnabled(bool enabled);
   bool enabled() const;
 
+  void setNativeRendering(bool nativeRendering);
+  bool nativeRendering() const;
+
   void check(bool reset);
 
 protected:
@@ -173,6 +195,13 @@ private:
     void drawAnnotations(QImage*, const QVariantList& annotations);
     template <class T, class U> void drawAnnotation(QPainter* painter, const QVariantMap& annotation);
 
+    template <class T> void annotateNative(const PiiVariant& obj);
+    template <class U, class T> void rasterize(PiiRasterizer<T>* rasterizer, const PiiVariant& annotation, AnnotationType type);
+    template <class T> void rasterizeAnnotations(PiiRasterizer<T>* rasterizer, const QVariantList& annotations);
+    template <class T> void rasterizeShape(PiiRasterizer<T>* rasterizer, AnnotationType type, bool fill,
+                                           int x, int y, const QVariantMap& annotation);
+    PiiRasterFont glyphs(const QString& text);
+
     AnnotationType annotationType;
     QFont font;
     QBrush brush;
@@ -185,6 +214,12 @@ private:
 
     PiiOutputSocket* pImageOutput;
     bool bEnabled;
+    bool bNativeRendering;
+    // Glyphs rendered with fntRaster. Protected by glyphMutex because
+    // process() may run in many threads.
+    PiiRasterFont rasterFont;
+    QFont fntRaster;
+    QMutex glyphMutex;
   };
   PII_D_FUNC;
 
@@ -21,6 +21,7 @@
 
 PiiImageFilterOperation::Data::Data() :
   filterType(Prebuilt), iFilterSize(3),
+  dPercentile(0.5),
   borderHandling(Pii::ExtendZeros),
   matPrebuiltFilter(3, 3),
   bSeparableFilter(false)
@@ -54,6 +55,8 @@ void PiiImageFilterOperation::setFilterName(const QString& filterName)
     d->filterType = Custom;
   else if (n == "median")
     d->filterType = Median;
+  else if (n == "minimum" || n == "maximum" || n == "percentile")
+    d->filterType = Rank;
   else
     {
       int iFilterIndex = 0;
@@ -105,6 +108,20 @@ void PiiImageFilterOperation::setFilterSize(int filterSize)
     setFilterName(d->strFilterName);
 }
 
+template <class T> PiiMatrix<T> PiiImageFilterOperation::rankFilter(const PiiMatrix<T>& image)
+{
+  PII_D;
+  if (d->filterType == Median)
+    return PiiImage::medianFilter(image, d->iFilterSize, d->iFilterSize, d->borderHandling);
+
+  double dPercentile = d->dPercentile;
+  if (d->strFilterName == "minimum")
+    dPercentile = 0;
+  else if (d->strFilterName == "maximum")
+    dPercentile = 1;
+  return PiiImage::percentileFilter(image, d->iFilterSize, dPercentile, d->borderHandling);
+}
+
 void PiiImageFilterOperation::check(bool reset)
 {
   PII_D;
@@ -152,7 +169,8 @@ template <class T> void PiiImageFilterOperation::intGrayFilter(const PiiVariant&
         emitObject(PiiImage::intFilter(img, d->matActiveFilter, d->borderHandling));
       break;
     case Median:
-      emitObject(PiiImage::medianFilter(img, d->iFilterSize, d->iFilterSize, d->borderHandling));
+    case Rank:
+      emitObject(rankFilter(img));
       break;
     }
 }
@@ -171,7 +189,8 @@ template <class T> void PiiImageFilterOperation::floatGrayFilter(const PiiVarian
         emitObject(PiiImage::filter<T>(img, d->matActiveFilter, d->borderHandling));
       break;
     case Median:
-      emitObject(PiiImage::medianFilter(img, d->iFilterSize, d->iFilterSize, d->borderHandling));
+    case Rank:
+      emitObject(rankFilter(img));
       break;
     }
 }
@@ -204,15 +223,13 @@ template <class T> void PiiImageFilterOperation::intColorFilter(const PiiVariant
       }
       break;
     case Median:
+    case Rank:
       {
-        PiiMatrix<PrimitiveType> ch2 = PiiImage::medianFilter(PiiImage::colorChannel(img,2),
-                                                               d->iFilterSize, d->iFilterSize, d->borderHandling);
+        PiiMatrix<PrimitiveType> ch2 = rankFilter(PiiImage::colorChannel(img,2));
         PiiMatrix<T> matResult(ch2.rows(), ch2.columns());
         PiiImage::setColorChannel(matResult, 2, ch2);
-        PiiImage::setColorChannel(matResult, 1, PiiImage::medianFilter(PiiImage::colorChannel(img,1),
-                                                                     d->iFilterSize, d->iFilterSize, d->borderHandling));
-        PiiImage::setColorChannel(matResult, 0, PiiImage::medianFilter(PiiImage::colorChannel(img,0),
-                                                                     d->iFilterSize, d->iFilterSize, d->borderHandling));
+        PiiImage::setColorChannel(matResult, 1, rankFilter(PiiImage::colorChannel(img,1)));
+        PiiImage::setColorChannel(matResult, 0, rankFilter(PiiImage::colorChannel(img,0)));
         emitObject(matResult);
       }
       break;
@@ -239,11 +256,12 @@ template <class T> void PiiImageFilterOperation::floatColorFilter(const PiiVaria
                                        d->borderHandling));
       break;
     case Median:
-      PiiMatrix<PrimitiveType> ch2 = PiiImage::medianFilter(PiiImage::colorChannel(img,2), d->iFilterSize, d->iFilterSize, d->borderHandling);
+    case Rank:
+      PiiMatrix<PrimitiveType> ch2 = rankFilter(PiiImage::colorChannel(img,2));
       PiiMatrix<T> result(ch2.rows(), ch2.columns());
       PiiImage::setColorChannel(result, 2, ch2);
-      PiiImage::setColorChannel(result, 1, PiiImage::medianFilter(PiiImage::colorChannel(img,1), d->iFilterSize, d->iFilterSize, d->borderHandling));
-      PiiImage::setColorChannel(result, 0, PiiImage::medianFilter(PiiImage::colorChannel(img,0), d->iFilterSize, d->iFilterSize, d->borderHandling));
+      PiiImage::setColorChannel(result, 1, rankFilter(PiiImage::colorChannel(img,1)));
+      PiiImage::setColorChannel(result, 0, rankFilter(PiiImage::colorChannel(img,0)));
       emitObject(result);
       break;
     }
@@ -252,5 +270,7 @@ template <class T> void PiiImageFilterOperation::floatColorFilter(const PiiVaria
 QString PiiImageFilterOperation::filterName() const { return _d()->strFilterName; }
 PiiVariant PiiImageFilterOperation::filter() const { return _d()->pCustomFilter; }
 int PiiImageFilterOperation::filterSize() const { return _d()->iFilterSize; }
+void PiiImageFilterOperation::setPercentile(double percentile) { _d()->dPercentile = qBound(0.0, percentile, 1.0); }
+double PiiImageFilterOperation::percentile() const { return _d()->dPercentile; }
 void PiiImageFilterOperation::setBorderHandling(ExtendMode borderHandling) { _d()->borderHandling = static_cast<Pii::ExtendMode>(borderHandling); }
 PiiImageFilterOperation::ExtendMode PiiImageFilterOperation::borderHandling() const { return static_cast<ExtendMode>(_d()->borderHandling); }
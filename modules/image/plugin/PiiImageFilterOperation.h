@@ -45,11 +45,23 @@ class PiiImageFilterOperation : public PiiDefaultOperation
    * The name of the image filter. This is an easy way to set the
    * filter. For valid values see PiiImage::PrebuiltFilterType. Use
    * "sobelx" for `SobelXFilter`, "gaussian" for `GaussianFilter`
-   * etc. There are two special values not supported by makeFilter():
+   * etc. There are a few special values not supported by
+   * makeFilter():
    *
    * - `median` - a median filter. Median filter is non-linear and
    * cannot be implemented with ordinary correlation masks.
    *
+   * - `minimum` - a minimum (grayscale erosion) filter.
+   *
+   * - `maximum` - a maximum (grayscale dilation) filter.
+   *
+   * - `percentile` - a rank filter that outputs the value at the
+   * given [percentile] of each neighborhood.
+   *
+   * Non-linear filters use PiiImage::rankFilter(), which selects a
+   * sorting network implementation automatically for 3x3, 5x5 and
+   * 7x7 windows.
+   *
    * - `custom` - [filter] will be used as the filter mask.
    *
    * The default value is "uniform".
@@ -64,6 +76,13 @@ class PiiImageFilterOperation : public PiiDefaultOperation
    */
   Q_PROPERTY(int filterSize READ filterSize WRITE setFilterSize);
 
+  /**
+   * The percentile (0-1) of the neighborhood values the `percentile`
+   * filter outputs. 0 produces a minimum filter, 0.5 a median filter
+   * and 1 a maximum filter. The default value is 0.5.
+   */
+  Q_PROPERTY(double percentile READ percentile WRITE setPercentile);
+
   /**
    * The filter as a matrix. This value is used only if [filterName] is
    * set to "custom".
@@ -109,6 +128,8 @@ public:
   PiiVariant filter() const;
   void setFilterSize(int filterSize);
   int filterSize() const;
+  void setPercentile(double percentile);
+  double percentile() const;
   void setBorderHandling(ExtendMode borderHandling);
   ExtendMode borderHandling() const;
 
@@ -118,13 +139,14 @@ protected:
   void process();
 
 private:
-  enum FilterType { Prebuilt, Median, Custom };
+  enum FilterType { Prebuilt, Median, Rank, Custom };
 
   template <class T> void intGrayFilter(const PiiVariant& obj);
   template <class T> void floatGrayFilter(const PiiVariant& obj);
   template <class T> void intColorFilter(const PiiVariant& obj);
   template <class T> void floatColorFilter(const PiiVariant& obj);
   template <class T> void setCustomFilter(const PiiVariant& obj);
+  template <class T> PiiMatrix<T> rankFilter(const PiiMatrix<T>& image);
 
   /// @internal
   class Data : public PiiDefaultOperation::Data
@@ -134,6 +156,7 @@ private:
     FilterType filterType;
     QString strFilterName;
     int iFilterSize;
+    double dPercentile;
     Pii::ExtendMode borderHandling;
 
     PiiVariant pCustomFilter;
@@ -16,7 +16,9 @@
 #include "PiiImagePieceJoiner.h"
 #include <PiiYdinTypes.h>
 #include <PiiColor.h>
+#include <PiiImage.h>
 #include <complex>
+#include <algorithm>
 
 using namespace Pii;
 using namespace PiiYdin;
@@ -149,61 +151,24 @@ void PiiImagePieceJoiner::joinPieces()
   if (d->rectList.size() == 0)
     return;
 
-  QLinkedList<QPair<int,int> > pairs;
-
-  /*QRect r1(0,0,10,10), r2(10,0,10,10), r3(20,0,10,10),
-    r4(0,10,10,10), r5(10,10,10,10), r6(20,10,10,10),
-    r7(0,20,10,10), r8(10,20,10,10), r9(20,20,10,10);
-
-  qDebug("Neighbors:");
-  qDebug("r1,r5: %s", isNeighbor(r1,r5) ? "yes" : "no");
-  qDebug("r2,r5: %s", isNeighbor(r2,r5) ? "yes" : "no");
-  qDebug("r3,r5: %s", isNeighbor(r3,r5) ? "yes" : "no");
-  qDebug("r4,r5: %s", isNeighbor(r4,r5) ? "yes" : "no");
-  qDebug("r5,r5: %s", isNeighbor(r5,r5) ? "yes" : "no");
-  qDebug("r6,r5: %s", isNeighbor(r6,r5) ? "yes" : "no");
-  qDebug("r7,r5: %s", isNeighbor(r7,r5) ? "yes" : "no");
-  qDebug("r8,r5: %s", isNeighbor(r8,r5) ? "yes" : "no");
-  qDebug("r9,r5: %s", isNeighbor(r9,r5) ? "yes" : "no");*/
-
-  //qDebug("PiiImagePieceJoiner: Joining %d pieces", d->rectList.size());
-
-  // First find all pairs of neighboring pieces (a piece is a neighbor
-  // to itself)
-  for (int i=d->rectList.size(); i--; )
+  // Find connected groups of neighboring pieces. The compounds are
+  // emitted in the order of their last piece. Pieces that have no
+  // neighbors are not emitted.
+  QList<QList<int> > lstCompounds = PiiImage::joinNeighbors(d->rectList, d->labelList, d->bDiscardDefault);
+  for (int i=0; i<lstCompounds.size(); ++i)
     {
-      if (//d->labelList[i] >= 0 && // negative values are unknown and always discarded
-          (!d->bDiscardDefault || d->labelList[i] != 0)) // we need to consider also label 0
-        {
-          for (int j=i; j--; )
-            if (d->labelList[i] == d->labelList[j] && //if the pieces are in the same class
-                isNeighbor(d->rectList[i], d->rectList[j])) //... and they are neighbors
-              pairs << qMakePair(i,j);
-        }
-    }
-
-  // Then recursively join all neighbors
-  while (!pairs.isEmpty())
-    {
-      // Stores the indices (in d->rectList) of all neighbors
-      QList<int> indices;
-      indices << pairs.first().first;
-      // This removes all neighbors of the first item from <pairs>
-      joinNeighbors(pairs.first().first, pairs, indices);
-
-      //qDebug("PiiImagePieceJoiner: Joined %d neighbors. %d pairs left.", indices.size(), pairs.size());
+      const QList<int>& lstIndices = lstCompounds[i];
       // Build up a compound that encloses all the neighbors
+      QRect area = d->rectList[lstIndices[0]];
       if (d->bTransparent)
         {
           // If transparency is used, we need to collect all the
           // joined rectangles and copy each to a new image.
           QList<QRect*> subAreas;
-          QRect area = d->rectList[indices[0]];
-          subAreas << &d->rectList[indices[0]];
-          for (int i=1; i<indices.size(); i++)
+          for (int j=0; j<lstIndices.size(); ++j)
             {
-              area |= d->rectList[indices[i]];
-              subAreas << &d->rectList[indices[i]];
+              area |= d->rectList[lstIndices[j]];
+              subAreas << &d->rectList[lstIndices[j]];
             }
           emitCompound(area, subAreas);
         }
@@ -211,15 +176,13 @@ void PiiImagePieceJoiner::joinPieces()
         {
           // If transparency is not used, it suffices to frame the
           // rectangles and send that as a shared copy.
-          QRect area = d->rectList[indices[0]];
-          for (int i=1; i<indices.size(); i++)
-            area |= d->rectList[indices[i]];
+          for (int j=1; j<lstIndices.size(); ++j)
+            area |= d->rectList[lstIndices[j]];
           emitCompound(area);
         }
 
       // Send its label
-      d->pLabelOutput->emitObject(d->labelList[indices[0]]);
-      //qDebug("PiiImagePieceJoiner: finished this compound");
+      d->pLabelOutput->emitObject(d->labelList[lstIndices[0]]);
     }
 
   // Initialize the lists of rectangles and labels
@@ -266,9 +229,14 @@ template <class T> void PiiImagePieceJoiner::emitSubImage(QPair<QRect,QList<QRec
   for (int i=subAreas->size(); i--; )
     {
       QRect *subArea = subAreas->at(i);
-      // Copy this image piece
-      matPiece(subArea->y() - row, subArea->x() - column, subArea->height(), subArea->width()) <<
-        largeImage(subArea->y() - d->iTopY, subArea->x() - d->iLeftX, subArea->height(), subArea->width());
+      // Copy this image piece row by row
+      const int iSourceColumn = subArea->x() - d->iLeftX, iTargetColumn = subArea->x() - column;
+      const int iSourceRow = subArea->y() - d->iTopY, iTargetRow = subArea->y() - row;
+      for (int r=0; r<subArea->height(); ++r)
+        {
+          const T* pSource = largeImage[iSourceRow + r] + iSourceColumn;
+          std::copy(pSource, pSource + subArea->width(), matPiece[iTargetRow + r] + iTargetColumn);
+        }
     }
   d->pPieceOutput->emitObject(matPiece);
 }
@@ -297,55 +265,6 @@ template <class T> void PiiImagePieceJoiner::emitSubImage(QRect area)
   d->pPieceOutput->emitObject(d->largeImage.valueAs<PiiMatrix<T> >()(area.y() - d->iTopY, area.x() - d->iLeftX, area.height(), area.width()));
 }
 
-bool PiiImagePieceJoiner::isNeighbor(QRect r1, QRect r2)
-{
-  // We check for 4-neighbors (rectangles are neighbors if they
-  // intersect or they are side-by side, but not diagonally)
-  return !((r2.right() < (r1.left()-1) ||
-            r2.left() > (r1.right()+1) ||
-            r2.bottom() < r1.top() ||
-            r2.top() > r1.bottom()) &&
-           (r2.right() < r1.left() ||
-            r2.left() > r1.right() ||
-            r2.bottom() < (r1.top()-1) ||
-            r2.top() > (r1.bottom())+1));
-}
-
-void PiiImagePieceJoiner::joinNeighbors(int index, QLinkedList<QPair<int,int> >& pairs, QList<int>& indices)
-{
-  //qDebug("Finding neighbors for %d", index);
-  QList<int> newIndices;
-  QLinkedList<QPair<int,int> >::iterator i = pairs.begin();
-  while (i != pairs.end())
-    {
-      // If a match was found in the pair, add the other index in the
-      // pair to the index list. Then remove the found match from the
-      // list.
-      if (i->first == index)
-        {
-          //qDebug("  %d matches", i->second);
-          newIndices << i->second;
-          i = pairs.erase(i);
-        }
-      else if (i->second == index)
-        {
-          //qDebug("  %d matches", i->first);
-          newIndices << i->first;
-          i = pairs.erase(i);
-        }
-      else
-        i++;
-    }
-  // Now we have found all direct neighbors of <index>. Let's find
-  // (recursively) the neighbors of its neighbors.
-  for (int i=newIndices.size(); i--; )
-    if (newIndices[i] != index) //no need to check myself again...
-      joinNeighbors(newIndices[i], pairs, indices);
-
-  // Store all indices to a single list
-  indices << newIndices;
-}
-
 bool PiiImagePieceJoiner::isTransparent() const { return _d()->bTransparent; }
 void PiiImagePieceJoiner::setTransparent(bool transparent) { _d()->bTransparent = transparent; }
 QColor PiiImagePieceJoiner::backgroundColor() const { return _d()->clrBackground; }
@@ -18,7 +18,6 @@
 
 #include <PiiDefaultOperation.h>
 #include <QList>
-#include <QLinkedList>
 #include <QPair>
 #include <QColor>
 #include <QRect>
@@ -140,8 +139,6 @@ private:
   void joinPieces();
   void emitCompound(QRect area);
   void emitCompound(QRect area, QList<QRect*>& subAreas);
-  inline bool isNeighbor(QRect r1, QRect r2);
-  void joinNeighbors(int index, QLinkedList<QPair<int,int> >& pairs, QList<int>& indices);
   template <class T> void emitSubImage(QRect area);
   template <class T> void emitSubImage(QPair<QRect,QList<QRect*>* >& pair);
 
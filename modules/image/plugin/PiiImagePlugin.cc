@@ -35,6 +35,7 @@
 #include "PiiQuantizerOperation.h"
 #include "PiiHistogramBackProjector.h"
 #include "PiiHistogramEqualizer.h"
+#include "PiiAdaptiveHistogramEqualizer.h"
 
 //Binary
 #include "PiiThresholdingOperation.h"
@@ -44,6 +45,8 @@
 #include "PiiFeatureRangeLimiter.h"
 #include "PiiMaskGenerator.h"
 #include "PiiBoundaryFinderOperation.h"
+#include "PiiDistanceTransformOperation.h"
+#include "PiiWatershedOperation.h"
 
 // Other
 #include "PiiImageUnwarpOperation.h"
@@ -70,6 +73,7 @@ PII_REGISTER_OPERATION(PiiHistogramOperation);
 PII_REGISTER_OPERATION(PiiQuantizerOperation);
 PII_REGISTER_OPERATION(PiiHistogramBackProjector);
 PII_REGISTER_OPERATION(PiiHistogramEqualizer);
+PII_REGISTER_OPERATION(PiiAdaptiveHistogramEqualizer);
 
 //Binary
 PII_REGISTER_OPERATION(PiiThresholdingOperation);
@@ -79,6 +83,8 @@ PII_REGISTER_OPERATION(PiiObjectPropertyExtractor);
 PII_REGISTER_OPERATION(PiiFeatureRangeLimiter);
 PII_REGISTER_OPERATION(PiiMaskGenerator);
 PII_REGISTER_OPERATION(PiiBoundaryFinderOperation);
+PII_REGISTER_OPERATION(PiiDistanceTransformOperation);
+PII_REGISTER_OPERATION(PiiWatershedOperation);
 
 //Other
 PII_REGISTER_OPERATION(PiiImageUnwarpOperation);
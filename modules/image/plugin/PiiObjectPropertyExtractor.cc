@@ -36,6 +36,8 @@ PiiObjectPropertyExtractor::PiiObjectPropertyExtractor() :
   d->pAreasOutput = new PiiOutputSocket("areas");
   d->pCentroidsOutput = new PiiOutputSocket("centroids");
   d->pBoundingBoxOutput = new PiiOutputSocket("boundingboxes");
+  d->pPerimetersOutput = new PiiOutputSocket("perimeters");
+  d->pAxesOutput = new PiiOutputSocket("axes");
 
   addSocket(d->pLabeledImageInput);
   addSocket(d->pLabelsInput);
@@ -43,6 +45,8 @@ PiiObjectPropertyExtractor::PiiObjectPropertyExtractor() :
   addSocket(d->pAreasOutput);
   addSocket(d->pCentroidsOutput);
   addSocket(d->pBoundingBoxOutput);
+  addSocket(d->pPerimetersOutput);
+  addSocket(d->pAxesOutput);
 }
 
 void PiiObjectPropertyExtractor::process()
@@ -51,7 +55,7 @@ void PiiObjectPropertyExtractor::process()
   PiiVariant obj = d->pLabeledImageInput->firstObject();
 
   int objects = -1;
-  if (!d->pLabelsInput->isConnected() &&
+  if (d->pLabelsInput->isConnected() &&
       d->pLabelsInput->firstObject().type() == PiiVariant::IntType)
     objects = d->pLabelsInput->firstObject().valueAs<int>();
 
@@ -68,23 +72,35 @@ template <class T> void PiiObjectPropertyExtractor::operate(const PiiVariant& im
 {
   PII_D;
   const PiiMatrix<T>& image = img.valueAs<PiiMatrix<T> >();
-  if (labels == -1)
-    labels = Pii::max(image);
+  // calculateMoments() finds the maximum label if labels is zero.
+  PiiMatrix<int> matBoxes, matPerimeters;
+  PiiMatrix<double> matMoments(PiiImage::calculateMoments(image, qMax(labels, 0), &matBoxes,
+                                                          d->pPerimetersOutput->isConnected() ?
+                                                          &matPerimeters : 0));
+  labels = matMoments.rows();
 
-  PiiMatrix<int> areas, centroids, bbox;
-  if (labels > 0)
-    PiiImage::calculateProperties(image, labels, areas, centroids, bbox);
-  else
+  if (d->pAreasOutput->isConnected() || d->pCentroidsOutput->isConnected())
     {
-      areas = PiiMatrix<int>();
-      centroids = PiiMatrix<int>();
-      bbox = PiiMatrix<int>();
+      PiiMatrix<int> matAreas(labels, 1), matCentroids(labels, 2);
+      for (int i=0; i<labels; ++i)
+        {
+          const double* pMoments = matMoments[i];
+          matAreas(i,0) = int(pMoments[0]);
+          if (pMoments[0] > 0)
+            {
+              matCentroids(i,0) = int(pMoments[1] / pMoments[0] + 0.5);
+              matCentroids(i,1) = int(pMoments[2] / pMoments[0] + 0.5);
+            }
+        }
+      if (d->pAreasOutput->isConnected())
+        d->pAreasOutput->emitObject(matAreas);
+      if (d->pCentroidsOutput->isConnected())
+        d->pCentroidsOutput->emitObject(matCentroids);
     }
-
-  if (d->pAreasOutput->isConnected())
-    d->pAreasOutput->emitObject(areas);
-  if (d->pCentroidsOutput->isConnected())
-    d->pCentroidsOutput->emitObject(centroids);
   if (d->pBoundingBoxOutput->isConnected())
-    d->pBoundingBoxOutput->emitObject(bbox);
+    d->pBoundingBoxOutput->emitObject(matBoxes);
+  if (d->pPerimetersOutput->isConnected())
+    d->pPerimetersOutput->emitObject(matPerimeters);
+  if (d->pAxesOutput->isConnected())
+    d->pAxesOutput->emitObject(PiiImage::calculateAxes(matMoments));
 }
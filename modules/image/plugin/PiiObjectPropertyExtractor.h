@@ -45,6 +45,17 @@
  * @out boundingboxes - The bounding boxes of each object
  * (x,y,width,height). PiiMatrix<int>(N,4).
  *
+ * @out perimeters - the number of pixel edges on the boundary of
+ * each object. PiiMatrix<int>(N,1).
+ *
+ * @out axes - the orientation of the major axis (radians) and the
+ * relative length and width of each object. See
+ * [PiiImage::calculateAxes()]. PiiMatrix<double>(N,3).
+ *
+ * All properties are derived from raw moments that are collected
+ * for all objects in a single pass over the image. Pixels whose label
+ * exceeds the number of objects are ignored.
+ *
  */
 class PiiObjectPropertyExtractor : public PiiDefaultOperation
 {
@@ -71,6 +82,8 @@ private:
     PiiOutputSocket* pAreasOutput;
     PiiOutputSocket* pCentroidsOutput;
     PiiOutputSocket* pBoundingBoxOutput;
+    PiiOutputSocket* pPerimetersOutput;
+    PiiOutputSocket* pAxesOutput;
   };
   PII_D_FUNC;
 };
@@ -16,6 +16,7 @@
 #include "PiiQuantizerOperation.h"
 
 #include <PiiYdinTypes.h>
+#include <PiiRandom.h>
 
 PiiQuantizerOperation::Data::Data() :
   iLevels(16),
@@ -95,9 +96,7 @@ template <class T> void PiiQuantizerOperation::quantize(const PiiVariant& obj)
           const T* row = img.row(r);
           for (int c = img.columns(); c--; )
             {
-              // Random number between 0 and 1
-              double rnd = (double)std::rand() / RAND_MAX;
-              if (rnd < d->dSelectionProbability)
+              if (Pii::uniformRandom() < d->dSelectionProbability)
                 {
                   d->pCollectedData[d->iCollectionIndex++] = (double)row[c];
                   // All pixels collected ...
@@ -110,7 +110,7 @@ namespace PiiImage
               }
           }
         else
-          process(image, createRoiMask(iRows, iColumns, matRectangles));
+          process(image, PiiRunLengthRoi::fromRectangles(iRows, iColumns, matRectangles));
       }
     else // roiType = MaskRoi
       {
@@ -120,7 +120,9 @@ namespace PiiImage
                     QCoreApplication::translate("PiiRoi", roiMaskSizeError)
                     .arg(matMask.columns()).arg(matMask.rows())
                     .arg(image.columns()).arg(image.rows()));
-        process(image, matMask);
+        // Run-length encoding lets the processor skip pixels outside
+        // of the ROI.
+        process(image, PiiRunLengthRoi(matMask));
       }
   }
 }
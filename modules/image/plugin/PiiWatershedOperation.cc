@@ -0,0 +1,111 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+
+#include "PiiWatershedOperation.h"
+#include "PiiWatershed.h"
+#include <PiiYdinTypes.h>
+
+PiiWatershedOperation::Data::Data() :
+  connectivity(PiiImage::Connect8),
+  bWatershedLines(false),
+  bMaskConnected(false)
+{
+}
+
+PiiWatershedOperation::PiiWatershedOperation() :
+  PiiDefaultOperation(new Data)
+{
+  setThreadCount(1);
+  PII_D;
+  d->pImageInput = new PiiInputSocket("image");
+  d->pMarkersInput = new PiiInputSocket("markers");
+  d->pMaskInput = new PiiInputSocket("mask");
+  d->pMaskInput->setOptional(true);
+  d->pImageOutput = new PiiOutputSocket("image");
+
+  addSocket(d->pImageInput);
+  addSocket(d->pMarkersInput);
+  addSocket(d->pMaskInput);
+  addSocket(d->pImageOutput);
+}
+
+void PiiWatershedOperation::check(bool reset)
+{
+  PII_D;
+  d->bMaskConnected = d->pMaskInput->isConnected();
+  PiiDefaultOperation::check(reset);
+}
+
+void PiiWatershedOperation::process()
+{
+  PII_D;
+
+  PiiVariant obj = d->pImageInput->firstObject();
+  PiiVariant markersObj = d->pMarkersInput->firstObject();
+  if (markersObj.type() != PiiYdin::IntMatrixType)
+    PII_THROW_UNKNOWN_TYPE(d->pMarkersInput);
+  PiiMatrix<int> matMarkers = markersObj.valueAs<PiiMatrix<int> >();
+
+  if (d->bMaskConnected)
+    {
+      PiiVariant maskObj = d->pMaskInput->firstObject();
+      switch (maskObj.type())
+        {
+          PII_GRAY_IMAGE_CASES_M(applyMask, (maskObj, matMarkers));
+        default:
+          PII_THROW_UNKNOWN_TYPE(d->pMaskInput);
+        }
+    }
+
+  switch (obj.type())
+    {
+      PII_GRAY_IMAGE_CASES_M(flood, (obj, matMarkers));
+    default:
+      PII_THROW_UNKNOWN_TYPE(d->pImageInput);
+    }
+}
+
+template <class T> void PiiWatershedOperation::applyMask(const PiiVariant& obj, PiiMatrix<int>& markers)
+{
+  const PiiMatrix<T> matMask = obj.valueAs<PiiMatrix<T> >();
+  if (matMask.rows() != markers.rows() || matMask.columns() != markers.columns())
+    PII_THROW_WRONG_SIZE(_d()->pMaskInput, matMask, markers.rows(), markers.columns());
+
+  for (int r=0; r<markers.rows(); ++r)
+    {
+      const T* pMask = matMask[r];
+      int* pMarkers = markers[r];
+      for (int c=0; c<markers.columns(); ++c)
+        if (pMask[c] == 0)
+          pMarkers[c] = -1;
+    }
+}
+
+template <class T> void PiiWatershedOperation::flood(const PiiVariant& obj, const PiiMatrix<int>& markers)
+{
+  PII_D;
+  const PiiMatrix<T> image = obj.valueAs<PiiMatrix<T> >();
+  if (image.rows() != markers.rows() || image.columns() != markers.columns())
+    PII_THROW_WRONG_SIZE(d->pMarkersInput, markers, image.rows(), image.columns());
+
+  d->pImageOutput->emitObject(PiiImage::watershed(image, markers,
+                                                  d->connectivity, d->bWatershedLines));
+}
+
+void PiiWatershedOperation::setConnectivity(PiiImage::Connectivity connectivity) { _d()->connectivity = connectivity; }
+PiiImage::Connectivity PiiWatershedOperation::connectivity() const { return _d()->connectivity; }
+void PiiWatershedOperation::setWatershedLines(bool watershedLines) { _d()->bWatershedLines = watershedLines; }
+bool PiiWatershedOperation::watershedLines() const { return _d()->bWatershedLines; }
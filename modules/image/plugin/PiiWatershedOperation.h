@@ -0,0 +1,102 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+
+#ifndef _PIIWATERSHEDOPERATION_H
+#define _PIIWATERSHEDOPERATION_H
+
+#include <PiiDefaultOperation.h>
+#include <PiiMatrix.h>
+#include "PiiImageGlobal.h"
+
+/**
+ * Marker-based watershed segmentation. See [PiiImage::watershed()].
+ *
+ * Inputs
+ * ------
+ *
+ * @in image - the relief to be flooded, e.g. a gradient magnitude
+ * image. (Any gray-level image type.)
+ *
+ * @in markers - initial labels, typically from
+ * [PiiLabelingOperation]. Positive values are seeds, zeros will be
+ * flooded and negative values will never be flooded.
+ * (PiiMatrix<int>)
+ *
+ * @in mask - an optional mask. Pixels that are zero in the mask
+ * will not be flooded. (Any gray-level image type.)
+ *
+ * Outputs
+ * -------
+ *
+ * @out image - the segmented image. A PiiMatrix<int> in which each
+ * pixel is given the label of the marker it was flooded from.
+ * Unflooded pixels and watershed lines will be zero.
+ *
+ */
+class PiiWatershedOperation : public PiiDefaultOperation
+{
+  Q_OBJECT
+
+  /**
+   * The neighbors through which labels propagate. The default is
+   * `Connect8`.
+   */
+  Q_PROPERTY(PiiImage::Connectivity connectivity READ connectivity WRITE setConnectivity);
+
+  /**
+   * If `true`, pixels at which two different labels meet are set to
+   * zero, which separates the segments by one-pixel wide lines. The
+   * default is `false`.
+   */
+  Q_PROPERTY(bool watershedLines READ watershedLines WRITE setWatershedLines);
+
+  PII_OPERATION_SERIALIZATION_FUNCTION
+public:
+  PiiWatershedOperation();
+
+  void check(bool reset);
+
+  void setConnectivity(PiiImage::Connectivity connectivity);
+  PiiImage::Connectivity connectivity() const;
+  void setWatershedLines(bool watershedLines);
+  bool watershedLines() const;
+
+protected:
+  void process();
+
+private:
+  template <class T> void flood(const PiiVariant& obj, const PiiMatrix<int>& markers);
+  template <class T> void applyMask(const PiiVariant& obj, PiiMatrix<int>& markers);
+
+  /// @internal
+  class Data : public PiiDefaultOperation::Data
+  {
+  public:
+    Data();
+    PiiImage::Connectivity connectivity;
+    bool bWatershedLines;
+    bool bMaskConnected;
+
+    PiiInputSocket* pImageInput;
+    PiiInputSocket* pMarkersInput;
+    PiiInputSocket* pMaskInput;
+    PiiOutputSocket* pImageOutput;
+  };
+  PII_D_FUNC;
+};
+
+
+#endif //_PIIWATERSHEDOPERATION_H
@@ -38,7 +38,7 @@ bool PiiModbusIoChannel::currentState() const
 
   int res = 0;
   if (mode == Input)
-    res = driver()->readInputBits(d->iAddress, 1, &bits);
+    res = driver()->readInputBit(d->iAddress, &bits);
   else
     res = driver()->readBits(d->iAddress, 1, &bits);
 
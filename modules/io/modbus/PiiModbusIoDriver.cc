@@ -22,7 +22,9 @@ QMutex PiiModbusIoDriver::_instanceMutex;
 
 PiiModbusIoDriver::Data::Data() :
   pHandle(0),
-  strUnit("")
+  strUnit(""),
+  pCycleThread(0),
+  bInputsValid(false)
 {
 }
 
@@ -49,8 +51,13 @@ template <class T> PiiModbusIoDriver::InstanceList::iterator PiiModbusIoDriver::
 
 bool PiiModbusIoDriver::initialize()
 {
-  synchronized (_instanceMutex) return initialize(_d()->strUnit);
-  return false; // suppresses bogus compiler warning
+  bool bInitialized = false;
+  synchronized (_instanceMutex) bInitialized = initialize(_d()->strUnit);
+  // Must not be called with _instanceMutex locked because the I/O
+  // thread locks it from within a polling round.
+  if (bInitialized)
+    setIoCycleEnabled(true);
+  return bInitialized;
 }
 
 bool PiiModbusIoDriver::initialize(const QString& unit)
@@ -169,6 +176,7 @@ bool PiiModbusIoDriver::reset()
 bool PiiModbusIoDriver::close()
 {
   PII_D;
+  setIoCycleEnabled(false);
   QMutexLocker lock(&_instanceMutex);
   if (d->pHandle)
     {
@@ -203,16 +211,169 @@ int PiiModbusIoDriver::readInputBits(int addr, int nb, uint8_t *dest)
   return d->pHandle ? modbus_read_input_bits(d->pHandle, addr, nb, dest) : -1;
 }
 
+int PiiModbusIoDriver::readInputBit(int addr, uint8_t *dest)
+{
+  PII_D;
+  if (!isInCycle())
+    return readInputBits(addr, 1, dest);
+
+  if (!d->bInputsValid && !readInputRanges())
+    return -1;
+
+  for (int i=0; i<d->lstInputRanges.size(); ++i)
+    if (d->lstInputRanges[i].contains(addr))
+      {
+        *dest = d->lstInputRanges[i].vecBits[addr - d->lstInputRanges[i].iFirst];
+        return 1;
+      }
+  // The channel was switched to input mode during this round.
+  return readInputBits(addr, 1, dest);
+}
+
 int PiiModbusIoDriver::readBits(int addr, int nb, uint8_t *dest)
 {
-  QMutexLocker lock(&_instanceMutex);
   PII_D;
+  // An output that will be changed at the end of the round reads
+  // back its new state.
+  if (nb == 1 && isInCycle() && d->mapPendingWrites.contains(addr))
+    {
+      *dest = d->mapPendingWrites[addr];
+      return 1;
+    }
+  QMutexLocker lock(&_instanceMutex);
   return d->pHandle ? modbus_read_bits(d->pHandle, addr, nb, dest) : -1;
 }
 
 int PiiModbusIoDriver::writeBit(int addr, int status)
 {
-  QMutexLocker lock(&_instanceMutex);
   PII_D;
+  if (isInCycle())
+    {
+      const uint8_t value = status ? 1 : 0;
+      QMap<int,uint8_t>::iterator it = d->mapPendingWrites.find(addr);
+      // A pulse that starts and ends within the same round must not
+      // disappear. Send the first edge now.
+      if (it != d->mapPendingWrites.end() && it.value() != value && !flushWrites())
+        return -1;
+      d->mapPendingWrites[addr] = value;
+      return 1;
+    }
+  QMutexLocker lock(&_instanceMutex);
   return d->pHandle ? modbus_write_bit(d->pHandle, addr, status) : -1;
 }
+
+bool PiiModbusIoDriver::isInCycle() const
+{
+  return _d()->pCycleThread == QThread::currentThread();
+}
+
+void PiiModbusIoDriver::beginIoCycle()
+{
+  PII_D;
+  d->bInputsValid = false;
+  d->pCycleThread = QThread::currentThread();
+}
+
+void PiiModbusIoDriver::endIoCycle()
+{
+  PII_D;
+  d->pCycleThread = 0;
+  if (!flushWrites())
+    {
+      d->mapPendingWrites.clear();
+      handleCycleError(tr("Cannot set output states: %1").arg(modbus_strerror(errno)));
+    }
+}
+
+bool PiiModbusIoDriver::readInputRanges()
+{
+  PII_D;
+  // Two inputs are read with the same request if there are at most
+  // this many unused bits between them. Reading a few extra bits is
+  // much cheaper than a network round trip.
+  static const int iMaxGap = 16;
+
+  QVector<int> vecAddresses;
+  for (int i=0; i<d->lstChannels.size(); ++i)
+    {
+      PiiModbusIoChannel* pChannel = static_cast<PiiModbusIoChannel*>(d->lstChannels[i]);
+      if (pChannel != 0 &&
+          pChannel->channelMode() == PiiModbusIoChannel::Input &&
+          pChannel->address() >= 0)
+        vecAddresses << pChannel->address();
+    }
+  qSort(vecAddresses);
+
+  d->lstInputRanges.clear();
+  for (int i=0; i<vecAddresses.size(); )
+    {
+      const int iFirst = vecAddresses[i];
+      int iLast = iFirst;
+      while (++i < vecAddresses.size() &&
+             vecAddresses[i] - iLast <= iMaxGap + 1 &&
+             vecAddresses[i] - iFirst < MODBUS_MAX_READ_BITS)
+        iLast = vecAddresses[i];
+      d->lstInputRanges << BitRange(iFirst, iLast - iFirst + 1);
+    }
+
+  QMutexLocker lock(&_instanceMutex);
+  if (d->pHandle == 0)
+    return false;
+  for (int i=0; i<d->lstInputRanges.size(); ++i)
+    {
+      BitRange& range = d->lstInputRanges[i];
+      if (modbus_read_input_bits(d->pHandle, range.iFirst, range.vecBits.size(), range.vecBits.data()) == -1)
+        {
+          d->lstInputRanges.clear();
+          return false;
+        }
+    }
+  d->bInputsValid = true;
+  return true;
+}
+
+bool PiiModbusIoDriver::flushWrites()
+{
+  PII_D;
+  if (d->mapPendingWrites.isEmpty())
+    return true;
+
+  QMutexLocker lock(&_instanceMutex);
+  if (d->pHandle == 0)
+    return false;
+
+  // Addresses are in ascending order. Each run of consecutive
+  // addresses is written with one request.
+  QVector<uint8_t> vecValues;
+  QMap<int,uint8_t>::const_iterator it = d->mapPendingWrites.constBegin();
+  while (it != d->mapPendingWrites.constEnd())
+    {
+      const int iFirst = it.key();
+      vecValues.clear();
+      do
+        {
+          vecValues << it.value();
+          ++it;
+        }
+      while (it != d->mapPendingWrites.constEnd() &&
+             it.key() == iFirst + vecValues.size() &&
+             vecValues.size() < MODBUS_MAX_WRITE_BITS);
+
+      const int iResult = vecValues.size() == 1 ?
+        modbus_write_bit(d->pHandle, iFirst, vecValues[0]) :
+        modbus_write_bits(d->pHandle, iFirst, vecValues.size(), vecValues.constData());
+      if (iResult != vecValues.size())
+        return false;
+    }
+  d->mapPendingWrites.clear();
+  return true;
+}
+
+void PiiModbusIoDriver::handleCycleError(const QString& message)
+{
+  // Same as PiiDefaultIoDriver::reconnect(), which cannot be used
+  // here because no channel failed.
+  piiCritical(message);
+  if (!reset())
+    emit connectionLost();
+}
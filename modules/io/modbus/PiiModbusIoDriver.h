@@ -19,6 +19,8 @@
 #include "PiiDefaultIoDriver.h"
 #include "PiiModbusIoDriverGlobal.h"
 #include <PiiIoChannel.h>
+#include <QMap>
+#include <QVector>
 
 #include <modbus.h>
 
@@ -28,6 +30,14 @@ class PiiModbusIoChannel;
  * An implementation of the PiiIoChannel-interface for Modbus I/O
  * driver.
  *
+ * When used through the I/O thread, the driver batches its requests.
+ * On each polling round, the addresses of all input channels are
+ * sorted and merged into ranges, and each range is read with a single
+ * request on the first query. Output changes made during the round
+ * are buffered and written at the end of the round, using one
+ * multiple-coil request for each run of consecutive addresses.
+ * Channels accessed from other threads are read and written
+ * immediately.
  */
 class PII_MODBUSIODRIVER_EXPORT PiiModbusIoDriver : public PiiDefaultIoDriver
 {
@@ -72,6 +82,9 @@ public:
    */
   modbus_t* handle() const;
 
+  void beginIoCycle();
+  void endIoCycle();
+
 protected:
   /**
    * Create a new PiiIoChannel.
@@ -81,6 +94,16 @@ protected:
   PiiIoChannel* createChannel(int channel);
 
 private:
+  // A block of consecutive input bits read with one request.
+  struct BitRange
+  {
+    BitRange(int first = 0, int count = 0) : iFirst(first), vecBits(count) {}
+    bool contains(int addr) const { return addr >= iFirst && addr < iFirst + vecBits.size(); }
+
+    int iFirst;
+    QVector<uint8_t> vecBits;
+  };
+
   /// @internal
   class Data : public PiiDefaultIoDriver::Data
   {
@@ -89,6 +112,12 @@ private:
 
     modbus_t *pHandle;
     QString strUnit;
+
+    // The I/O thread while a polling round is in progress.
+    QThread* pCycleThread;
+    bool bInputsValid;
+    QList<BitRange> lstInputRanges;
+    QMap<int,uint8_t> mapPendingWrites;
   };
   PII_D_FUNC;
 
@@ -111,8 +140,13 @@ private:
   bool initialize(const QString& unit);
   friend class PiiModbusIoChannel;
   int readInputBits(int addr, int nb, uint8_t *dest);
+  int readInputBit(int addr, uint8_t *dest);
   int readBits(int addr, int nb, uint8_t *dest);
   int writeBit(int addr, int status);
+  bool isInCycle() const;
+  bool readInputRanges();
+  bool flushWrites();
+  void handleCycleError(const QString& message);
 
   typedef QList<Instance> InstanceList;
   template <class T> static InstanceList::iterator findInstance(const T& value);
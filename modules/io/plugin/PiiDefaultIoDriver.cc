@@ -63,6 +63,7 @@ PiiDefaultIoDriver::~PiiDefaultIoDriver()
     {
       // handle and remove output signals from the sending thread
       _pSendingThread->removeOutputList(d->lstChannels);
+      _pSendingThread->removeCycleDriver(this);
 
       //check if we must stop and delete thread
       _iInstanceCounter--;
@@ -82,6 +83,22 @@ PiiDefaultIoDriver::~PiiDefaultIoDriver()
   delete d;
 }
 
+void PiiDefaultIoDriver::beginIoCycle() {}
+void PiiDefaultIoDriver::endIoCycle() {}
+
+void PiiDefaultIoDriver::setIoCycleEnabled(bool enabled)
+{
+  synchronized (instanceLock())
+    {
+      if (_pSendingThread == 0)
+        return;
+      if (enabled)
+        _pSendingThread->addCycleDriver(this);
+      else
+        _pSendingThread->removeCycleDriver(this);
+    }
+}
+
 void PiiDefaultIoDriver::reconnect(PiiIoChannel* channel, const QString& message)
 {
   if (!d->lstChannels.contains(channel))
@@ -91,6 +108,15 @@ void PiiDefaultIoDriver::reconnect(PiiIoChannel* channel, const QString& message
     emit connectionLost();
 }
 
+void PiiDefaultIoDriver::setThreadAffinity(const QList<int>& cpus)
+{
+  synchronized (instanceLock())
+    {
+      if (_pSendingThread != 0)
+        _pSendingThread->setCpus(cpus);
+    }
+}
+
 void PiiDefaultIoDriver::sendSignal(PiiIoChannel *channel, bool value, qint64 time, int pulseWidth)
 {
   if (_pSendingThread != 0)
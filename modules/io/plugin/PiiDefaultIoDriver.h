@@ -46,6 +46,30 @@ public:
    */
   int channelCount() const;
 
+  /**
+   * Binds the sending thread to *cpus*. Note that the thread is
+   * shared between all instances of PiiDefaultIoDriver, and the
+   * affinity set last will be in effect.
+   */
+  void setThreadAffinity(const QList<int>& cpus);
+
+  /**
+   * Called by the I/O thread before it polls input channels and sends
+   * output signals on each round, if cycle notifications have been
+   * enabled with [setIoCycleEnabled()]. Drivers that can read many
+   * channels in one request can use this function to invalidate
+   * cached input states. The default implementation does nothing.
+   */
+  virtual void beginIoCycle();
+
+  /**
+   * Called by the I/O thread after each polling round, if cycle
+   * notifications have been enabled. Drivers that buffer output
+   * changes during the round should send them here. The default
+   * implementation does nothing.
+   */
+  virtual void endIoCycle();
+
 protected:
   /**
    * Create a PiiIoChannel depends on given channel-index.
@@ -64,6 +88,13 @@ protected:
   PiiDefaultIoDriver();
   PiiDefaultIoDriver(Data* data);
 
+  /**
+   * Enables or disables calls to [beginIoCycle()] and [endIoCycle()]
+   * from the I/O thread. Enable the calls only when the driver is
+   * fully constructed, and disable them before it is destroyed.
+   */
+  void setIoCycleEnabled(bool enabled);
+
 private slots:
   void reconnect(PiiIoChannel* channel, const QString& message);
 
@@ -21,6 +21,8 @@ PiiIoDriver::~PiiIoDriver()
 
 bool PiiIoDriver::close() { return true; }
 
+void PiiIoDriver::setThreadAffinity(const QList<int>& /*cpus*/) {}
+
 bool PiiIoDriver::reset()
 {
   return close() ? initialize() : false;
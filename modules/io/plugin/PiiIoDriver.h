@@ -18,6 +18,7 @@
 
 #include "PiiIoGlobal.h"
 #include <QObject>
+#include <QList>
 class PiiIoChannel;
 
 /**
@@ -78,6 +79,15 @@ public:
    */
   virtual PiiIoChannel* channel(int channel) = 0;
 
+  /**
+   * Restricts the threads the driver uses for polling inputs and
+   * sending delayed outputs to the given *cpus*. An empty list
+   * removes the restriction. Drivers that have no threads of their
+   * own can ignore this call. The default implementation does
+   * nothing.
+   */
+  virtual void setThreadAffinity(const QList<int>& cpus);
+
 signals:
   void connectionLost();
 };
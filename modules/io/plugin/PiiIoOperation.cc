@@ -78,6 +78,8 @@ void PiiIoOperation::check(bool reset)
 
               if (!d->pIoDriver->initialize())
                 PII_THROW(PiiExecutionException, tr("Cannot initialize I/O driver."));
+
+              d->pIoDriver->setThreadAffinity(boundCpus());
             }
         }
     }
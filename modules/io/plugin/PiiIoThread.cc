@@ -17,8 +17,10 @@
 #include <PiiDelay.h>
 #include <QDateTime>
 #include "PiiIoDriverException.h"
+#include "PiiDefaultIoDriver.h"
+#include <PiiThreadUtil.h>
 
-PiiIoThread::PiiIoThread(QObject *parent) : QThread(parent), _bRunning(true)
+PiiIoThread::PiiIoThread(QObject *parent) : QThread(parent), _bRunning(true), _bCpusChanged(false)
 {
 }
 
@@ -29,6 +31,15 @@ void PiiIoThread::run()
     {
       _mutex.lock();
 
+      if (_bCpusChanged)
+        {
+          Pii::bindThread(_lstCpus);
+          _bCpusChanged = false;
+        }
+
+      for (int i=0; i<_lstCycleDrivers.size(); ++i)
+        _lstCycleDrivers[i]->beginIoCycle();
+
       for (int i=_lstPollingInputs.size(); i--; )
         {
           try
@@ -66,6 +77,10 @@ void PiiIoThread::run()
         if (_lstWaitingOutputSignals[i].handled)
           _lstWaitingOutputSignals.removeAt(i);
 
+      // Send buffered outputs
+      for (int i=0; i<_lstCycleDrivers.size(); ++i)
+        _lstCycleDrivers[i]->endIoCycle();
+
       _mutex.unlock();
 
       PiiDelay::msleep(10);
@@ -128,6 +143,32 @@ void PiiIoThread::removePollingInput(PiiIoChannel *input)
   _mutex.unlock();
 }
 
+void PiiIoThread::addCycleDriver(PiiDefaultIoDriver *driver)
+{
+  _mutex.lock();
+  if (!_lstCycleDrivers.contains(driver))
+    _lstCycleDrivers << driver;
+  _mutex.unlock();
+}
+
+void PiiIoThread::removeCycleDriver(PiiDefaultIoDriver *driver)
+{
+  _mutex.lock();
+  _lstCycleDrivers.removeAll(driver);
+  _mutex.unlock();
+}
+
+void PiiIoThread::setCpus(const QList<int>& cpus)
+{
+  _mutex.lock();
+  if (cpus != _lstCpus)
+    {
+      _lstCpus = cpus;
+      _bCpusChanged = true;
+    }
+  _mutex.unlock();
+}
+
 
 void PiiIoThread::sendSignal(PiiIoChannel *channel, bool active, qint64 time, int width)
 {
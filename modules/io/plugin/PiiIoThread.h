@@ -21,6 +21,8 @@
 #include <QVector>
 #include "PiiIoChannel.h"
 
+class PiiDefaultIoDriver;
+
 class PiiIoThread : public QThread
 {
   Q_OBJECT
@@ -45,6 +47,20 @@ public:
   void addPollingInput(PiiIoChannel *input);
   void removePollingInput(PiiIoChannel *input);
 
+  /**
+   * Adds a driver whose [PiiDefaultIoDriver::beginIoCycle()] and
+   * [PiiDefaultIoDriver::endIoCycle()] functions will be called on
+   * each polling round.
+   */
+  void addCycleDriver(PiiDefaultIoDriver *driver);
+  void removeCycleDriver(PiiDefaultIoDriver *driver);
+
+  /**
+   * Binds the thread to the given *cpus*. The change will be applied
+   * by the thread itself during the next polling round.
+   */
+  void setCpus(const QList<int>& cpus);
+
   /**
    * Handle and remove all outputs from the _lstWaitingOutputSignals
    * depends on given parameter lstChannels.
@@ -55,10 +71,12 @@ private:
   bool needAppend(PiiIoChannel *channel, bool active, qint64 checkTime);
   void addNewStruct(PiiIoChannel *channel, bool active, qint64 time, int width);
 
-  bool _bRunning;
+  bool _bRunning, _bCpusChanged;
   QMutex _mutex;
+  QList<int> _lstCpus;
   QList<OutputSignal> _lstWaitingOutputSignals;
   QList<PiiIoChannel*> _lstPollingInputs;
+  QList<PiiDefaultIoDriver*> _lstCycleDrivers;
 };
 
 #endif //_PIIIOTHREAD_H
@@ -78,51 +78,82 @@ void PiiFeaturePointMatcher<T, SampleSet>::buildDatabase(const PiiMatrix<T>& poi
     }
   d->matModelPoints = points;
   d->vecModelIndices = modelIndices;
+  d->iModelCount = countModels(modelIndices);
 }
 
 template <class T, class SampleSet>
-template <class Matcher>
-PiiMatching::MatchList PiiFeaturePointMatcher<T,SampleSet>::findMatchingModels(const PiiMatrix<T>& points,
-                                                                               const SampleSet& features,
-                                                                               Matcher& matcher) const
+int PiiFeaturePointMatcher<T,SampleSet>::countModels(const QVector<int>& modelIndices)
 {
-  PiiMatching::MatchList lstMatchedModels;
+  if (modelIndices.isEmpty())
+    return 1;
+  return Pii::maxIn(modelIndices.constBegin(), modelIndices.constEnd()) + 1;
+}
 
-  if (d->matModelPoints.isEmpty())
-    return lstMatchedModels;
+// Finds the closest matches for a range of query points. Each query
+// point has its own result slot, which makes it possible to run
+// queries in parallel without locking.
+template <class T, class SampleSet>
+class PiiFeaturePointMatcher<T,SampleSet>::QueryFunction
+{
+public:
+  QueryFunction(const Data* data,
+                const SampleSet& features,
+                PiiClassification::MatchList* matches) :
+    d(data), _features(features), _pMatches(matches)
+  {}
+
+  void operator() (int firstPoint, int lastPoint)
+  {
+    using namespace PiiSampleSet;
+    for (int i=firstPoint; i<lastPoint; ++i)
+      {
+        if (d->pKdTree != 0)
+          {
+            if (d->iMaxEvaluations > 0)
+              _pMatches[i] = d->pKdTree->findClosestMatches(sampleAt(_features, i),
+                                                           d->iClosestMatchCount,
+                                                           d->iMaxEvaluations);
+            else
+              _pMatches[i] = d->pKdTree->findClosestMatches(sampleAt(_features, i),
+                                                           d->iClosestMatchCount);
+          }
+        else if (d->pDistanceMeasure != 0)
+          _pMatches[i] = PiiClassification::findClosestMatches(sampleAt(_features, i),
+                                                              d->modelFeatures,
+                                                              *d->pDistanceMeasure,
+                                                              d->iClosestMatchCount);
+        else
+          _pMatches[i] = PiiClassification::findClosestMatches(sampleAt(_features, i),
+                                                              d->modelFeatures,
+                                                              d->squaredGeometricDistance,
+                                                              d->iClosestMatchCount);
+      }
+  }
 
-  using namespace PiiSampleSet;
-  const int iPoints = qMin(points.rows(), sampleCount(features)),
-    iDimensions = points.columns();
+private:
+  const Data* d;
+  const SampleSet& _features;
+  PiiClassification::MatchList* _pMatches;
+};
 
-  typedef QHash<int, QList<QPair<int,int> > > MatchHash;
-  MatchHash hashMatchIndices;
+template <class T, class SampleSet>
+QList<int> PiiFeaturePointMatcher<T,SampleSet>::findCandidateModels(const PiiMatrix<T>& points,
+                                                                    const SampleSet& features,
+                                                                    QVector<PairList>& matchedPairs) const
+{
+  const int iPoints = qMin(points.rows(), PiiSampleSet::sampleCount(features));
 
   // Find N closest matches for each point
+  QVector<PiiClassification::MatchList> vecMatches(iPoints);
+  QueryFunction query(d, features, vecMatches.data());
+  Pii::parallelFor(0, iPoints, query, 16);
+
+  // Votes are collected in point order so that the order of point
+  // pairs within each model is independent of the number of threads.
+  matchedPairs.fill(PairList(), d->iModelCount);
   for (int i=0; i<iPoints; ++i)
     {
-      PiiClassification::MatchList lstMatches;
-      if (d->pKdTree != 0)
-        {
-          if (d->iMaxEvaluations > 0)
-            lstMatches = d->pKdTree->findClosestMatches(sampleAt(features, i),
-                                                        d->iClosestMatchCount,
-                                                        d->iMaxEvaluations);
-          else
-            lstMatches = d->pKdTree->findClosestMatches(sampleAt(features, i),
-                                                        d->iClosestMatchCount);
-        }
-      else if (d->pDistanceMeasure != 0)
-        lstMatches = PiiClassification::findClosestMatches(sampleAt(features, i),
-                                                           d->modelFeatures,
-                                                           *d->pDistanceMeasure,
-                                                           d->iClosestMatchCount);
-      else
-        lstMatches = PiiClassification::findClosestMatches(sampleAt(features, i),
-                                                           d->modelFeatures,
-                                                           d->squaredGeometricDistance,
-                                                           d->iClosestMatchCount);
-
+      const PiiClassification::MatchList& lstMatches = vecMatches[i];
       // All matches that are good enough compared to the best one
       // will be accepted as candidates.
       for (int j=0; j<lstMatches.size(); ++j)
@@ -133,87 +164,179 @@ PiiMatching::MatchList PiiFeaturePointMatcher<T,SampleSet>::findMatchingModels(c
                 int(d->vecModelIndices[lstMatches[j].second]) : 0;
               // Store the indices of matched points for each model
               // class separately.
-              hashMatchIndices[iModelIndex] << qMakePair(i, lstMatches[j].second);
+              matchedPairs[iModelIndex] << qMakePair(i, lstMatches[j].second);
             }
           else
             break;
         }
     }
 
-  QList<QPair<int,int> > lstCandidateModels;
-  int iMinMatches = 1;
-  int iMaxMatches = 1;
-
   // Collect models that have enough matches
-  for (MatchHash::iterator i = hashMatchIndices.begin();
-       i != hashMatchIndices.end(); ++i)
+  const int iMinMatches = 1;
+  QList<QPair<int,int> > lstCandidateModels;
+  for (int i=0; i<matchedPairs.size(); ++i)
     {
-      int iMatchCount = PII_ITERATOR_VALUE(i).size();
+      int iMatchCount = matchedPairs[i].size();
       if (iMatchCount >= iMinMatches)
-        lstCandidateModels << qMakePair(iMatchCount, PII_ITERATOR_KEY(i));
+        lstCandidateModels << qMakePair(iMatchCount, i);
     }
 
   // Sort according to match count (the candidate model with most
   // matches will be evaluated first)
   std::sort(lstCandidateModels.begin(), lstCandidateModels.end());
 
-  PiiMatrix<T> matQueryPoints(0,iDimensions), matModelPoints(0,iDimensions);
-
-  iMaxMatches = lstCandidateModels.last().first;
+  QList<int> lstResult;
+  lstResult.reserve(lstCandidateModels.size());
+  for (int i=lstCandidateModels.size(); i--; )
+    lstResult << lstCandidateModels[i].second;
+  return lstResult;
+}
 
-  matQueryPoints.reserve(iMaxMatches);
-  matModelPoints.reserve(iMaxMatches);
+template <class T, class SampleSet>
+template <class Matcher>
+bool PiiFeaturePointMatcher<T,SampleSet>::verifyModel(int modelIndex,
+                                                      PairList& matchedPairs,
+                                                      const PiiMatrix<T>& points,
+                                                      Matcher& matcher,
+                                                      PiiMatching::MatchList& matchedModels) const
+{
+  const int iDimensions = points.columns();
+  PiiMatrix<T> matQueryPoints(0,iDimensions), matModelPoints(0,iDimensions);
+  matQueryPoints.reserve(matchedPairs.size());
+  matModelPoints.reserve(matchedPairs.size());
 
-  while (!lstCandidateModels.isEmpty())
+  bool bMatched = false;
+  for (;;)
     {
-      // Collect point correspondences in the last candidate model.
-      int iCurrentCandidate = lstCandidateModels.last().second;
-      QList<QPair<int,int> >& lstMatchedPairs = hashMatchIndices[iCurrentCandidate];
-      collectPoints(lstMatchedPairs,
+      // Collect point correspondences in the candidate model.
+      collectPoints(matchedPairs,
                     points,
                     matQueryPoints,
                     matModelPoints);
 
-      /*qDebug("%d candidate models left, current candidate: %d, matched pairs: %d",
-             lstCandidateModels.size(), iCurrentCandidate,
-             lstMatchedPairs.size());
-      */
       // Try to match the points
-      if (matcher.findBestModel(matModelPoints, matQueryPoints))
-        {
-          QVector<int> vecInliers = matcher.inlyingPoints();
-          //qDebug("Model matched with %d inliers", vecInliers.size());
-          // removePoints requires a sorted index list
-          std::sort(vecInliers.begin(), vecInliers.end());
+      if (!matcher.findBestModel(matModelPoints, matQueryPoints))
+        return bMatched;
+
+      bMatched = true;
+      QVector<int> vecInliers = matcher.inlyingPoints();
+      // removePoints requires a sorted index list
+      std::sort(vecInliers.begin(), vecInliers.end());
+
+      matchedModels << PiiMatching::Match(modelIndex,
+                                          matcher.bestModel(),
+                                          matchIndices(vecInliers, matchedPairs));
+
+      // In MatchDifferentModels mode, matched points will not be
+      // removed from the query set. They will be reused to allow
+      // matches to the same points with different models. The
+      // current candidate is now matched and will not be matched
+      // again.
+      if (d->matchingMode != PiiMatching::MatchAllModels)
+        return true;
+
+      // If points were successfully matched, remove all inliers
+      // from the query set. The current candidate model will be
+      // tried again to allow multiple matches to the same model.
+      removePoints(vecInliers, matchedPairs);
+
+      matQueryPoints.resize(0, iDimensions);
+      matModelPoints.resize(0, iDimensions);
+    }
+}
+
+// Verifies every Nth candidate model with its own matcher. The
+// matches of each candidate are stored separately and concatenated
+// in candidate order afterwards.
+template <class T, class SampleSet>
+template <class Matcher>
+class PiiFeaturePointMatcher<T,SampleSet>::VerifyFunction
+{
+public:
+  VerifyFunction(const PiiFeaturePointMatcher* matcher,
+                 const PiiMatrix<T>& points,
+                 const QList<int>& candidateModels,
+                 PairList* matchedPairs,
+                 Matcher* const* matchers,
+                 int blockCount,
+                 PiiMatching::MatchList* matchedModels) :
+    _pMatcher(matcher),
+    _points(points),
+    _lstCandidateModels(candidateModels),
+    _pMatchedPairs(matchedPairs),
+    _pMatchers(matchers),
+    _iBlockCount(blockCount),
+    _pMatchedModels(matchedModels)
+  {}
+
+  void operator() (int block, int /*first*/, int /*last*/)
+  {
+    for (int i=block; i<_lstCandidateModels.size(); i += _iBlockCount)
+      {
+        int iModelIndex = _lstCandidateModels[i];
+        _pMatcher->verifyModel(iModelIndex,
+                               _pMatchedPairs[iModelIndex],
+                               _points,
+                               *_pMatchers[block],
+                               _pMatchedModels[i]);
+      }
+  }
+
+private:
+  const PiiFeaturePointMatcher* _pMatcher;
+  const PiiMatrix<T>& _points;
+  const QList<int>& _lstCandidateModels;
+  PairList* _pMatchedPairs;
+  Matcher* const* _pMatchers;
+  int _iBlockCount;
+  PiiMatching::MatchList* _pMatchedModels;
+};
+
+template <class T, class SampleSet>
+template <class Matcher>
+PiiMatching::MatchList PiiFeaturePointMatcher<T,SampleSet>::findMatchingModels(const PiiMatrix<T>& points,
+                                                                               const SampleSet& features,
+                                                                               Matcher& matcher) const
+{
+  Matcher* pMatcher = &matcher;
+  return findMatchingModels(points, features, &pMatcher, 1);
+}
 
-          lstMatchedModels << PiiMatching::Match(iCurrentCandidate,
-                                                 matcher.bestModel(),
-                                                 matchIndices(vecInliers, lstMatchedPairs));
+template <class T, class SampleSet>
+template <class Matcher>
+PiiMatching::MatchList PiiFeaturePointMatcher<T,SampleSet>::findMatchingModels(const PiiMatrix<T>& points,
+                                                                               const SampleSet& features,
+                                                                               Matcher* const* matchers,
+                                                                               int matcherCount) const
+{
+  PiiMatching::MatchList lstMatchedModels;
 
+  if (d->matModelPoints.isEmpty())
+    return lstMatchedModels;
 
+  QVector<PairList> vecMatchedPairs;
+  QList<int> lstCandidateModels = findCandidateModels(points, features, vecMatchedPairs);
+
+  if (d->matchingMode == PiiMatching::MatchOneModel || matcherCount < 2)
+    {
+      for (int i=0; i<lstCandidateModels.size(); ++i)
+        {
+          int iModelIndex = lstCandidateModels[i];
           // If only one match is requested, return now
-          if (d->matchingMode == PiiMatching::MatchOneModel)
+          if (verifyModel(iModelIndex, vecMatchedPairs[iModelIndex], points, *matchers[0], lstMatchedModels) &&
+              d->matchingMode == PiiMatching::MatchOneModel)
             return lstMatchedModels;
-
-          // If points were successfully matched, remove all inliers
-          // from the query set. The current candidate model will not
-          // be removed from the candidate to allow multiple matches
-          // to the same model.
-          if (d->matchingMode == PiiMatching::MatchAllModels)
-            removePoints(vecInliers, lstMatchedPairs);
-          // In MatchDifferentModels mode, matched points will not be
-          // removed from the query set. They will be reused to allow
-          // matches to the same points with different models. The
-          // current candidate is now matched and will not be matched
-          // again.
-          else // if (d->matchingMode == PiiMatching::MatchDifferentModels)
-            lstCandidateModels.removeLast();
         }
-      else
-        lstCandidateModels.removeLast();
-
-      matQueryPoints.resize(0, iDimensions);
-      matModelPoints.resize(0, iDimensions);
+    }
+  else
+    {
+      const int iBlocks = qMin(matcherCount, lstCandidateModels.size());
+      QVector<PiiMatching::MatchList> vecMatchedModels(lstCandidateModels.size());
+      VerifyFunction<Matcher> verify(this, points, lstCandidateModels, vecMatchedPairs.data(),
+                                    matchers, iBlocks, vecMatchedModels.data());
+      Pii::parallelForBlocks(0, iBlocks, iBlocks, verify);
+      for (int i=0; i<vecMatchedModels.size(); ++i)
+        lstMatchedModels << vecMatchedModels[i];
     }
 
   return lstMatchedModels;
@@ -255,19 +378,42 @@ namespace PiiMatching
 {
   template <class Merger> void removeDuplicates(MatchList& matchedModels, Merger& merge)
   {
+    // Only matches to the same model can be merged. Bucket the
+    // matches by model index so that each match is compared only to
+    // the preceding matches of the same model, in the same order as
+    // a full pairwise comparison would do.
+    QHash<int, QVector<int> > hashModelMatches;
+    for (int i=0; i<matchedModels.size(); ++i)
+      hashModelMatches[matchedModels[i].modelIndex()] << i;
+
+    QVector<bool> vecRemoved(matchedModels.size(), false);
+    int iRemovedCount = 0;
     for (int i=matchedModels.size()-1; i>0; --i)
       {
-        for (int j=i-1; j>=0; --j)
+        QVector<int>& vecPreceding = hashModelMatches[matchedModels[i].modelIndex()];
+        // Indices are processed in descending order -> i is always
+        // the last one in its bucket.
+        vecPreceding.pop_back();
+        for (int j=vecPreceding.size(); j--; )
           {
-            // If there are two matches to the same model and they can
-            // be merged, remove the other entry.
-            if (matchedModels[i].modelIndex() == matchedModels[j].modelIndex() &&
-                merge(matchedModels[i], matchedModels[j]))
+            // If the matches can be merged, remove the other entry.
+            if (merge(matchedModels[i], matchedModels[vecPreceding[j]]))
               {
-                matchedModels.removeAt(i);
+                vecRemoved[i] = true;
+                ++iRemovedCount;
                 break;
               }
           }
       }
+
+    if (iRemovedCount == 0)
+      return;
+
+    MatchList lstRemaining;
+    lstRemaining.reserve(matchedModels.size() - iRemovedCount);
+    for (int i=0; i<matchedModels.size(); ++i)
+      if (!vecRemoved[i])
+        lstRemaining << matchedModels[i];
+    matchedModels = lstRemaining;
   }
 }
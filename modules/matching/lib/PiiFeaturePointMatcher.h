@@ -22,6 +22,8 @@
 #include <PiiKdTree.h>
 #include <PiiClassification.h>
 #include <PiiSharedD.h>
+#include <PiiMath.h>
+#include <PiiParallel.h>
 
 #include <QList>
 #include <QVector>
@@ -188,6 +190,8 @@ template <class T, class SampleSet> class PiiFeaturePointMatcher
     archive & PII_NVP("mode", PII_ENUM(d->matchingMode));
     archive & PII_NVP("closestMatches", d->iClosestMatchCount);
     archive & PII_NVP("maxEvaluations", d->iMaxEvaluations);
+    if (Archive::InputArchive)
+      d->iModelCount = countModels(d->vecModelIndices);
   }
 public:
   typedef typename PiiSampleSet::Traits<SampleSet>::ConstFeatureIterator ConstFeatureIterator;
@@ -287,6 +291,10 @@ public:
    *
    * @param features the corresponding feature vectors (N x O)
    *
+   * The closest matches of the query points are searched in
+   * parallel. The order of the returned matches does not depend on
+   * the number of threads used.
+   *
    * @param matcher the matching algorithm. Must provide
    * findBestModel(const PiiMatrix<T>&, const PiiMatrix<T>&),
    * inlyingPoints(), and bestModel() functions with signatures equal
@@ -297,6 +305,31 @@ public:
                                             const SampleSet& features,
                                             Matcher& matcher) const;
 
+  /**
+   * Same as above, but verifies the candidate models concurrently
+   * using *matcherCount* independent matchers. Since each candidate
+   * model is verified only against the point pairs matched to it, the
+   * models can be verified independently of each other. The returned
+   * list is ordered as if the candidates had been verified in
+   * sequence. Thus, the result is equal to that of the
+   * single-threaded version provided that the matching algorithm is
+   * deterministic. Randomized algorithms such as RANSAC may find
+   * different (but equally valid) models because each matcher draws
+   * its own random samples.
+   *
+   * In `MatchOneModel` mode, only the first matcher is used.
+   *
+   * @param matchers an array of pointers to identically configured
+   * matchers. Each matcher is used by one thread at a time.
+   *
+   * @param matcherCount the number of matchers in *matchers*.
+   */
+  template <class Matcher>
+  PiiMatching::MatchList findMatchingModels(const PiiMatrix<T>& points,
+                                            const SampleSet& features,
+                                            Matcher* const* matchers,
+                                            int matcherCount) const;
+
   /**
    * Sets the matching mode. If the matching mode is set to
    * `MatchOneModel`, the search for matching models will be finished
@@ -377,7 +410,8 @@ private:
       pDistanceMeasure(0),
       matchingMode(PiiMatching::MatchAllModels),
       iClosestMatchCount(1),
-      iMaxEvaluations(0)
+      iMaxEvaluations(0),
+      iModelCount(0)
     {}
     Data(const Data& other) :
       matModelPoints(other.matModelPoints),
@@ -387,7 +421,8 @@ private:
       pDistanceMeasure(other.pDistanceMeasure ? other.pDistanceMeasure->clone() : 0),
       matchingMode(other.matchingMode),
       iClosestMatchCount(other.iClosestMatchCount),
-      iMaxEvaluations(other.iMaxEvaluations)
+      iMaxEvaluations(other.iMaxEvaluations),
+      iModelCount(other.iModelCount)
     {}
     ~Data()
     {
@@ -413,11 +448,29 @@ private:
     PiiMatching::ModelMatchingMode matchingMode;
     int iClosestMatchCount;
     int iMaxEvaluations;
+    int iModelCount;
     PiiSquaredGeometricDistance<ConstFeatureIterator> squaredGeometricDistance;
   } *d;
 
   void detach() { d = d->detach(); }
 
+  typedef QList<QPair<int,int> > PairList;
+  class QueryFunction;
+  template <class Matcher> class VerifyFunction;
+
+  static int countModels(const QVector<int>& modelIndices);
+
+  QList<int> findCandidateModels(const PiiMatrix<T>& points,
+                                 const SampleSet& features,
+                                 QVector<PairList>& matchedPairs) const;
+
+  template <class Matcher>
+  bool verifyModel(int modelIndex,
+                   PairList& matchedPairs,
+                   const PiiMatrix<T>& points,
+                   Matcher& matcher,
+                   PiiMatching::MatchList& matchedModels) const;
+
   void collectPoints(const QList<QPair<int,int> >& indices,
                      const PiiMatrix<T>& points,
                      PiiMatrix<T>& queryPoints,
@@ -15,7 +15,7 @@
 
 #include "PiiRandomLbp.h"
 
-#include <cstdlib>
+#include <PiiRandom.h>
 
 PiiRandomLbp::Data::Data() :
   iPatterns(50),
@@ -37,9 +37,14 @@ void PiiRandomLbp::setParameters(int patterns, int pairs, int rows, int columns)
   d->vecPointPairs.clear();
   d->vecPointPairs.reserve(patterns*pairs);
 
+  PiiRandomEngine& engine = Pii::randomEngine();
   for (int i=0; i<patterns*pairs; ++i)
-    d->vecPointPairs << qMakePair(PiiPoint<int>(rand() % rows, rand() % columns),
-                                  PiiPoint<int>(rand() % rows, rand() % columns));
+    {
+      // Evaluation order of function arguments is unspecified.
+      const int iR1 = int(engine.uniformInt(rows)), iC1 = int(engine.uniformInt(columns));
+      const int iR2 = int(engine.uniformInt(rows)), iC2 = int(engine.uniformInt(columns));
+      d->vecPointPairs << qMakePair(PiiPoint<int>(iR1, iC1), PiiPoint<int>(iR2, iC2));
+    }
   /* PENDING
    * The pairs could be reordered to optimize cache usage.
    */
@@ -21,6 +21,7 @@
 #include <PiiRigidPlaneRansac.h>
 
 #include <PiiMatrixUtil.h>
+#include <PiiRandom.h>
 
 PiiPointMatchingOperation::Data::Data(int pointDimensions) :
   PiiClassifierOperation::Data(PiiClassification::NonSupervisedLearner),
@@ -32,7 +33,8 @@ PiiPointMatchingOperation::Data::Data(int pointDimensions) :
   iPointDimensions(pointDimensions),
   matchingMode(PiiMatching::MatchAllModels),
   bMustSendPoints(false),
-  iClosestMatchCount(pMatcher->closestMatchCount())
+  iClosestMatchCount(pMatcher->closestMatchCount()),
+  iVerificationThreadCount(1)
 {
 }
 
@@ -286,7 +288,7 @@ void PiiPointMatchingOperation::collectSample(double label, double /*weight*/)
       switch (fullBufferBehavior())
         {
         case PiiClassification::OverwriteRandomSample:
-          iRemovedIndex = rand() % d->iModelCount;
+          iRemovedIndex = int(Pii::uniformRandomIndex(d->iModelCount));
           break;
         case PiiClassification::OverwriteOldestSample:
           break;
@@ -463,6 +465,7 @@ PiiPointMatchingOperation* PiiPointMatchingOperation::clone() const
   pNewData->iModelCount = d->iModelCount;
   pNewData->matchingMode = d->matchingMode;
   pNewData->iClosestMatchCount = d->iClosestMatchCount;
+  pNewData->iVerificationThreadCount = d->iVerificationThreadCount;
 
   return pNewOperation;
 }
@@ -480,3 +483,13 @@ int PiiPointMatchingOperation::closestMatchCount() const
 {
   return _d()->iClosestMatchCount;
 }
+
+void PiiPointMatchingOperation::setVerificationThreadCount(int verificationThreadCount)
+{
+  _d()->iVerificationThreadCount = qMax(1, verificationThreadCount);
+}
+
+int PiiPointMatchingOperation::verificationThreadCount() const
+{
+  return _d()->iVerificationThreadCount;
+}
@@ -152,6 +152,17 @@ class PII_MATCHING_EXPORT PiiPointMatchingOperation : public PiiClassifierOperat
    */
   Q_PROPERTY(int closestMatchCount READ closestMatchCount WRITE setClosestMatchCount);
 
+  /**
+   * The number of threads used for verifying candidate models. If
+   * this value is greater than one, candidate models will be verified
+   * concurrently, each thread using its own matching algorithm
+   * instance. Note that randomized matching algorithms may find
+   * slightly different models in concurrent mode. The default is 1.
+   * The closest matches of feature points are always searched in
+   * parallel.
+   */
+  Q_PROPERTY(int verificationThreadCount READ verificationThreadCount WRITE setVerificationThreadCount);
+
   friend struct PiiSerialization::Accessor;
   template <class Archive> void serialize(Archive& archive, const unsigned int)
   {
@@ -226,6 +237,7 @@ protected:
     PiiMatching::ModelMatchingMode matchingMode;
     bool bMustSendPoints;
     int iClosestMatchCount;
+    int iVerificationThreadCount;
   };
   PII_D_FUNC;
 
@@ -244,6 +256,8 @@ protected:
   PiiMatching::ModelMatchingMode matchingMode() const;
   void setClosestMatchCount(int closestMatchCount);
   int closestMatchCount() const;
+  void setVerificationThreadCount(int verificationThreadCount);
+  int verificationThreadCount() const;
 
   bool learnBatch();
   void replaceClassifier();
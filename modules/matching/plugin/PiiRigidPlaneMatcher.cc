@@ -37,7 +37,46 @@ PiiMatching::MatchList PiiRigidPlaneMatcher::match(Matcher& matcher,
                                                    const PiiMatrix<float>& points,
                                                    const PiiMatrix<float>& features)
 {
-  return matcher.findMatchingModels(points, features, ransac());
+  const int iThreads = verificationThreadCount();
+  if (iThreads < 2 || matchingMode() == PiiMatching::MatchOneModel)
+    return matcher.findMatchingModels(points, features, ransac());
+
+  // Each verification thread needs a RANSAC estimator of its own.
+  QVector<PiiRigidPlaneRansac<float>*> vecRansacs(iThreads);
+  vecRansacs[0] = &ransac();
+  for (int i=1; i<iThreads; ++i)
+    vecRansacs[i] = createRansac();
+
+  PiiMatching::MatchList lstMatches;
+  try
+    {
+      lstMatches = matcher.findMatchingModels(points, features, vecRansacs.constData(), iThreads);
+    }
+  catch (...)
+    {
+      for (int i=1; i<iThreads; ++i)
+        delete vecRansacs[i];
+      throw;
+    }
+  for (int i=1; i<iThreads; ++i)
+    delete vecRansacs[i];
+  return lstMatches;
+}
+
+PiiRigidPlaneRansac<float>* PiiRigidPlaneMatcher::createRansac() const
+{
+  const PiiRigidPlaneRansac<float>& source = ransac();
+  PiiRigidPlaneRansac<float>* pRansac = new PiiRigidPlaneRansac<float>;
+  pRansac->setMaxIterations(source.maxIterations());
+  pRansac->setMaxSamplings(source.maxSamplings());
+  pRansac->setMinInliers(source.minInliers());
+  pRansac->setFittingThreshold(source.fittingThreshold());
+  pRansac->setSelectionProbability(source.selectionProbability());
+  pRansac->setAutoRefine(source.autoRefine());
+  pRansac->setMinScale(source.minScale());
+  pRansac->setMaxScale(source.maxScale());
+  pRansac->setMaxRotationAngle(source.maxRotationAngle());
+  return pRansac;
 }
 
 PiiMatrix<double> PiiRigidPlaneMatcher::toTransformMatrix(const PiiMatrix<double>& transformParams)
@@ -126,6 +126,7 @@ private:
 
   inline PiiRigidPlaneRansac<float>& ransac();
   inline const PiiRigidPlaneRansac<float>& ransac() const;
+  PiiRigidPlaneRansac<float>* createRansac() const;
 };
 
 
@@ -17,6 +17,10 @@
 #include <PiiUtil.h>
 #include <PiiYdinTypes.h>
 #include <PiiMath.h>
+#include <PiiParallel.h>
+#include <QVarLengthArray>
+#include <QHash>
+#include <cstring>
 
 #define LENGTH_LIMIT (1<<24)
 
@@ -115,77 +119,171 @@ void PiiMultiVariableHistogram::setInputCount(int cnt)
   PiiBasicOperation::setNumberedInputs(cnt, 0, "matrix");
 }
 
-template <class T> PiiMatrix<int> PiiMultiVariableHistogram::scale(const PiiVariant& obj, double factor)
+// Collects a histogram for a band of rows. The first block counts
+// directly into the result. Other blocks use private histograms that
+// are merged at the end. If the histogram is long compared to the
+// number of pixels in a block, the private histograms are sparse.
+class PiiMultiVariableHistogram::Histogrammer
 {
-  return Pii::matrix(obj.valueAs<PiiMatrix<T> >().mapped(Pii::unaryCompose(Pii::Round<int>(),
-                                                                           std::bind2nd(std::multiplies<double>(),
-                                                                                        factor))));
+public:
+  Histogrammer(const QVector<Channel>& channels, bool joint, int columns,
+               int* result, int length, int blocks, bool sparse) :
+    _channels(channels), _bJoint(joint), _iColumns(columns),
+    _pResult(result), _iLength(length), _bSparse(sparse),
+    _vecHistograms(sparse ? 0 : blocks), _vecSparseHistograms(sparse ? blocks : 0)
+  {}
+
+  void operator() (int block, int firstRow, int lastRow)
+  {
+    int* pHistogram = _pResult;
+    if (block > 0 && !_bSparse)
+      {
+        _vecHistograms[block].fill(0, _iLength);
+        pHistogram = _vecHistograms[block].data();
+      }
+    QVarLengthArray<int,1024> vecBins(_iColumns);
+    int* pBins = vecBins.data();
+
+    for (int r=firstRow; r<lastRow; ++r)
+      {
+        if (_bJoint)
+          {
+            // Fold all dimensions into one bin index.
+            memset(pBins, 0, sizeof(int) * _iColumns);
+            for (int k=0; k<_channels.size(); ++k)
+              _channels[k].binRow(_channels[k], r, pBins);
+            count(block, pHistogram, pBins);
+          }
+        else
+          {
+            // Each dimension has its own range of bins.
+            for (int k=0; k<_channels.size(); ++k)
+              {
+                memset(pBins, 0, sizeof(int) * _iColumns);
+                _channels[k].binRow(_channels[k], r, pBins);
+                count(block, pHistogram, pBins);
+              }
+          }
+      }
+  }
+
+  void merge()
+  {
+    for (int b=1; b<_vecHistograms.size(); ++b)
+      {
+        const int* pHistogram = _vecHistograms[b].constData();
+        for (int i=0; i<_vecHistograms[b].size(); ++i)
+          _pResult[i] += pHistogram[i];
+      }
+    for (int b=1; b<_vecSparseHistograms.size(); ++b)
+      for (QHash<int,int>::const_iterator i = _vecSparseHistograms[b].constBegin();
+           i != _vecSparseHistograms[b].constEnd(); ++i)
+        _pResult[i.key()] += i.value();
+  }
+
+private:
+  inline void count(int block, int* histogram, const int* bins)
+  {
+    if (block > 0 && _bSparse)
+      {
+        QHash<int,int>& hashHistogram = _vecSparseHistograms[block];
+        for (int c=0; c<_iColumns; ++c)
+          ++hashHistogram[bins[c]];
+      }
+    else
+      for (int c=0; c<_iColumns; ++c)
+        ++histogram[bins[c]];
+  }
+
+  const QVector<Channel>& _channels;
+  bool _bJoint;
+  int _iColumns;
+  int* _pResult;
+  int _iLength;
+  bool _bSparse;
+  QVector<QVector<int> > _vecHistograms;
+  QVector<QHash<int,int> > _vecSparseHistograms;
+};
+
+template <class T> void PiiMultiVariableHistogram::binRow(const Channel& channel, int row, int* bins)
+{
+  const T* pRow = channel.object.valueAs<PiiMatrix<T> >()[row];
+  // All pixels need to be checked to prevent over/underflows.
+  if (channel.bScaled)
+    for (int c=0; c<channel.iColumns; ++c)
+      bins[c] += channel.iOffset + channel.iStep *
+        qBound(0, Pii::round<int>(double(pRow[c]) * channel.dScale), channel.iMaxValue);
+  else
+    for (int c=0; c<channel.iColumns; ++c)
+      bins[c] += channel.iOffset + channel.iStep * qBound(0, int(pRow[c]), channel.iMaxValue);
 }
 
-void PiiMultiVariableHistogram::process()
+template <class T> void PiiMultiVariableHistogram::readChannel(const PiiVariant& obj, int index, Channel& channel)
 {
   PII_D;
+  const PiiMatrix<T>& matrix = obj.valueAs<PiiMatrix<T> >();
+  if (index > 0 &&
+      (matrix.rows() != d->vecChannels[0].iRows || matrix.columns() != d->vecChannels[0].iColumns))
+    PII_THROW_WRONG_SIZE(inputAt(index), matrix, d->vecChannels[0].iRows, d->vecChannels[0].iColumns);
+
+  channel.object = obj;
+  channel.binRow = &binRow<T>;
+  channel.iRows = matrix.rows();
+  channel.iColumns = matrix.columns();
+  // If scaling factors have not been set or the current one equals
+  // one, no scaling is needed.
+  channel.bScaled = d->vecScales.size() > index && d->vecScales[index] != 1;
+  channel.dScale = channel.bScaled ? d->vecScales[index] : 1.0;
+  channel.iMaxValue = d->vecLevels[index] - 1;
+  if (d->distributionType == JointDistribution)
+    {
+      channel.iStep = index > 0 ? d->vecSteps[index-1] : 1;
+      channel.iOffset = 0;
+    }
+  else
+    {
+      channel.iStep = 1;
+      channel.iOffset = index > 0 ? d->vecSteps[index-1] : 0;
+    }
+}
 
-  // Input matrices are stored into a list (either as such or scaled).
-  QList<PiiMatrix<int> > lstMatrices;
+void PiiMultiVariableHistogram::process()
+{
+  PII_D;
 
-  int iRows = 0, iColumns = 0;
-  // Convert all input objects into int matrices
-  for (int i=0; i<inputCount(); ++i)
+  // The inputs are converted and scaled on the fly while building the
+  // histogram. No temporary matrices are needed.
+  const int iInputs = inputCount();
+  d->vecChannels.resize(iInputs);
+  for (int i=0; i<iInputs; ++i)
     {
-      // If scaling factors have not been set or the current one
-      // equals one, no scaling is needed.
-      bool bScaled = d->vecScales.size() > i && d->vecScales[i] != 1;
       PiiVariant obj = inputAt(i)->firstObject();
-      // If the input matrix is an int matrix, no conversion is needed
-      if (obj.type() == PiiYdin::IntMatrixType)
-        {
-          if (!bScaled)
-            lstMatrices << obj.valueAs<PiiMatrix<int> >();
-          else
-            lstMatrices << scale<int>(obj, d->vecScales[i]);
-        }
-      else
-        {
-          PiiMatrix<int> matrix;
-          // Convert type but do not scale
-          if (!bScaled)
-            {
-              switch (obj.type())
-                {
-                  PII_NUMERIC_MATRIX_CASES(matrix = (PiiMatrix<int>)PiiYdin::matrixAs, obj);
-                default:
-                  PII_THROW_UNKNOWN_TYPE(inputAt(i));
-                }
-            }
-          else
-            {
-              // Scale and convert to ints
-              switch (obj.type())
-                {
-                  PII_NUMERIC_MATRIX_CASES_M(matrix = scale, (obj, d->vecScales[i]));
-                default:
-                  PII_THROW_UNKNOWN_TYPE(inputAt(i));
-                }
-            }
-          if (i > 0 && (matrix.rows() != iRows || matrix.columns() != iColumns))
-            PII_THROW_WRONG_SIZE(inputAt(i), matrix, iRows, iColumns);
-          lstMatrices << matrix;
-        }
-
-      if (i == 0)
+      switch (obj.type())
         {
-          iRows = lstMatrices[0].rows();
-          iColumns = lstMatrices[0].columns();
+          PII_NUMERIC_MATRIX_CASES_M(readChannel, (obj, i, d->vecChannels[i]));
+        default:
+          PII_THROW_UNKNOWN_TYPE(inputAt(i));
         }
     }
 
   // Allocate size for the histogram
   PiiMatrix<int> matResult(1, d->vecSteps.last());
-  if (d->distributionType == JointDistribution)
-    jointHistogram(lstMatrices, iRows, iColumns, &matResult);
-  else
-    marginalHistograms(lstMatrices, iRows, iColumns, &matResult);
+  const int iRows = d->vecChannels[0].iRows, iColumns = d->vecChannels[0].iColumns;
+  if (iRows > 0 && iColumns > 0)
+    {
+      // Give each thread at least 64k pixels.
+      const int iBlocks = Pii::parallelBlockCount(iRows, qMax(1, 65536 / iColumns));
+      const int iLength = matResult.columns();
+      Histogrammer histogrammer(d->vecChannels, d->distributionType == JointDistribution,
+                                iColumns, matResult[0], iLength, iBlocks,
+                                qint64(iLength) * iBlocks > qint64(iRows) * iColumns);
+      Pii::parallelForBlocks(0, iRows, iBlocks, histogrammer);
+      histogrammer.merge();
+    }
+
+  // Release the input objects.
+  for (int i=0; i<iInputs; ++i)
+    d->vecChannels[i].object = PiiVariant();
 
   if (d->bNormalized)
     d->pHistogramOutput->emitObject(Pii::matrix(matResult.mapped(std::bind2nd(std::multiplies<double>(),
@@ -194,50 +292,5 @@ void PiiMultiVariableHistogram::process()
     d->pHistogramOutput->emitObject(matResult);
 }
 
-void PiiMultiVariableHistogram::jointHistogram(const QList<PiiMatrix<int> >& matrices,
-                                               int rows, int columns,
-                                               PiiMatrix<int>* result)
-{
-  PII_D;
-
-  const int iDimensions = matrices.size();
-  for (int r=0; r<rows; ++r)
-    {
-      for (int c=0; c<columns; ++c)
-        {
-          // Fold multi-dimensional values into one dimension. Index 0
-          // is treated separately to save an unnecessary
-          // multiplication by one. All pixels need to be checked to
-          // prevent over/underflows.
-          int index = qBound(0, const_cast<const PiiMatrix<int>&>(matrices[0])(r, c), d->vecLevels[0]-1);
-          for (int k=1; k<iDimensions; ++k)
-            index += d->vecSteps[k-1] * qBound(0, const_cast<const PiiMatrix<int>&>(matrices[k])(r, c), d->vecLevels[k]-1);
-
-          // Increase histogram at the folded index
-          ++(*result)(0, index);
-        }
-    }
-}
-
-void PiiMultiVariableHistogram::marginalHistograms(const QList<PiiMatrix<int> >& matrices,
-                                                   int rows, int columns,
-                                                   PiiMatrix<int>* result)
-{
-  PII_D;
-
-  int* pHistogram = result->row(0);
-  for (int k=0; k<matrices.size(); ++k)
-    {
-      int iMaxValue = d->vecLevels[k]-1;
-      for (int r=0; r<rows; ++r)
-        {
-          const int* pRow = const_cast<const PiiMatrix<int>&>(matrices[k])[r];
-          for (int c=0; c<columns; ++c)
-            ++pHistogram[qBound(0, pRow[c], iMaxValue)];
-        }
-      pHistogram += d->vecLevels[k];
-    }
-}
-
 void PiiMultiVariableHistogram::setNormalized(bool normalize) { _d()->bNormalized = normalize; }
 bool PiiMultiVariableHistogram::normalized() const { return _d()->bNormalized; }
@@ -18,6 +18,7 @@
 
 #include <PiiDefaultOperation.h>
 #include <PiiMatrix.h>
+#include <QVector>
 
 /**
  * An operation that builds histograms out of correlated variables.
@@ -40,7 +41,7 @@
  * in `JointDistribution` would be 4 * 4 * 4 = 64. The indices of the
  * three-dimensional colors in the resulting histogram would be (from
  * upper left corner) 0 + 4 * 1 + 4 * 4 * 3 = 52, 1 + 4 * 0 + 4 * 4 *
- * 2 = 32 etc. In `MarginalDistributions` mode the histograms are
+ * 2 = 33 etc. In `MarginalDistributions` mode the histograms are
  * calculated for each cannel separately, and concatenated together.
  * In the example above, the length of the histogram would be 4 + 4 +
  * 4 = 12.
@@ -50,8 +51,10 @@
  *
  * @in matrixX - input matrices. X is a zero-based index, and its
  * maximum value depends on the number of levels. Any real-valued
- * matrix will be accepted. For maximum performance, input integer
- * matrices.
+ * matrix will be accepted. The inputs are scaled and binned in their
+ * native type in a single pass; no converted copies are made. Large
+ * inputs are split into bands of rows that are processed in
+ * parallel.
  *
  * Outputs
  * -------
@@ -148,10 +151,26 @@ protected:
 
 private:
   inline void throwTooLong() { PII_THROW(PiiExecutionException, tr("The resulting histogram would be too long. Please reduce levels.")); }
-  template <class T> inline PiiMatrix<int> scale(const PiiVariant& obj, double factor);
   void setInputCount(int cnt);
-  void jointHistogram(const QList<PiiMatrix<int> >& matrices, int rows, int columns, PiiMatrix<int>* result);
-  void marginalHistograms(const QList<PiiMatrix<int> >& matrices, int rows, int columns, PiiMatrix<int>* result);
+
+  /// @internal
+  struct Channel;
+  /// @internal
+  typedef void (*BinFunction)(const Channel& channel, int row, int* bins);
+  /// @internal
+  struct Channel
+  {
+    PiiVariant object;
+    BinFunction binRow;
+    bool bScaled;
+    double dScale;
+    int iMaxValue, iStep, iOffset;
+    int iRows, iColumns;
+  };
+  class Histogrammer;
+
+  template <class T> void readChannel(const PiiVariant& obj, int index, Channel& channel);
+  template <class T> static void binRow(const Channel& channel, int row, int* bins);
 
   /// @internal
   class Data : public PiiDefaultOperation::Data
@@ -162,6 +181,7 @@ private:
     QVector<int> vecLevels;
     QVector<int> vecSteps;
     QVector<double> vecScales;
+    QVector<Channel> vecChannels;
     PiiOutputSocket* pHistogramOutput;
     DistributionType distributionType;
     bool bNormalized;
@@ -60,20 +60,24 @@ PiiMatrix<int> PiiLbp::genericLbp(const PiiMatrix<T>& image, Roi roi, UnaryFunct
       int bit, r, c;
       const T** neighborPtr = new const T*[iSamples];
       const T* centerPtr;
+      PiiImage::RoiSpans<Roi> spans(roi, iMargin, image.columns()-iMargin);
       for (r=iMargin; r<image.rows()-iMargin; ++r)
         {
           // Tell our matrix that we're about to handle a new row.
           result.changeRow(r);
+          spans.selectRow(r);
 
-          // Initialize pointers to center and neighbors at the start
-          // of each row sweep
-          for (bit=0; bit<iSamples; ++bit)
-            neighborPtr[bit] = image.row(r+d->pPoints[bit].nearestY) + (d->pPoints[bit].nearestX + iMargin);
-          centerPtr = image.row(r) + iMargin;
-
-          for (c=iMargin; c<image.columns()-iMargin; ++c)
+          // Only pixels within the ROI are visited.
+          for (int iSpan=0; iSpan<spans.count(); ++iSpan)
             {
-              if (roi(r,c))
+              const int iStart = spans.start(iSpan), iEnd = spans.end(iSpan);
+              // Initialize pointers to center and neighbors at the
+              // start of each span
+              for (bit=0; bit<iSamples; ++bit)
+                neighborPtr[bit] = image.row(r+d->pPoints[bit].nearestY) + (d->pPoints[bit].nearestX + iStart);
+              centerPtr = image.row(r) + iStart;
+
+              for (c=iStart; c<iEnd; ++c)
                 {
                   center = centerFunc(*centerPtr);
                   //the first bit doesn't need to be shifted
@@ -91,15 +95,9 @@ PiiMatrix<int> PiiLbp::genericLbp(const PiiMatrix<T>& image, Roi roi, UnaryFunct
                     result.modify(c, static_cast<unsigned int>(value >> iFinalShift));
                   else
                     result.modify(c, d->pLookup[value >> iFinalShift]);
-                }
-              else
-                {
-                  // Not in ROI -> just increment neighbor pointers
-                  for (bit=0; bit<iSamples; ++bit)
-                    ++neighborPtr[bit];
-                }
 
-              ++centerPtr;
+                  ++centerPtr;
+                }
             }
         }
       delete[] neighborPtr;
@@ -116,28 +114,32 @@ PiiMatrix<int> PiiLbp::genericLbp(const PiiMatrix<T>& image, Roi roi, UnaryFunct
       float neighbor;
       unsigned int value;
       int bit, r, c;
+      PiiImage::RoiSpans<Roi> spans(roi, iMargin, image.columns()-iMargin);
       for (r=iMargin; r<image.rows()-iMargin; ++r)
         {
           // Tell our matrix that we're about to handle a new row.
           result.changeRow(r);
+          spans.selectRow(r);
 
-          //Initialize pointers to center and neighbors at the start
-          //of each row sweep. Two pointers for each neighbor are
-          //needed because (in general) two rows of pixels are
-          //accessed at each sample.
-          for (bit=0; bit<iSamples; ++bit)
+          // Only pixels within the ROI are visited.
+          for (int iSpan=0; iSpan<spans.count(); ++iSpan)
             {
-              neighborPtr1[bit] = image.row(r+d->pPoints[bit].y) + (d->pPoints[bit].x + iMargin);
-              //Second row is used only if it fits in the image. (It
-              //won't if ceil(radius) = radius).
-              if (r+d->pPoints[bit].y+1 < image.rows())
-                neighborPtr2[bit] = image.row(r+d->pPoints[bit].y+1) + (d->pPoints[bit].x + iMargin);
-            }
-          centerPtr = image.row(r) + iMargin;
+              const int iStart = spans.start(iSpan), iEnd = spans.end(iSpan);
+              //Initialize pointers to center and neighbors at the
+              //start of each span. Two pointers for each neighbor are
+              //needed because (in general) two rows of pixels are
+              //accessed at each sample.
+              for (bit=0; bit<iSamples; ++bit)
+                {
+                  neighborPtr1[bit] = image.row(r+d->pPoints[bit].y) + (d->pPoints[bit].x + iStart);
+                  //Second row is used only if it fits in the image. (It
+                  //won't if ceil(radius) = radius).
+                  if (r+d->pPoints[bit].y+1 < image.rows())
+                    neighborPtr2[bit] = image.row(r+d->pPoints[bit].y+1) + (d->pPoints[bit].x + iStart);
+                }
+              centerPtr = image.row(r) + iStart;
 
-          for (c=iMargin; c<image.columns()-iMargin; ++c)
-            {
-              if (roi(r,c))
+              for (c=iStart; c<iEnd; ++c)
                 {
                   center = centerFunc(*centerPtr);
                   //the first bit doesn't need to be shifted
@@ -155,18 +157,9 @@ PiiMatrix<int> PiiLbp::genericLbp(const PiiMatrix<T>& image, Roi roi, UnaryFunct
                     result.modify(c, static_cast<unsigned int>(value >> iFinalShift));
                   else
                     result.modify(c, d->pLookup[value >> iFinalShift]);
-                }
-              else
-                {
-                  // Not in ROI -> just increment neighbor pointers
-                  for (bit=0; bit<iSamples; ++bit)
-                    {
-                      ++neighborPtr1[bit];
-                      ++neighborPtr2[bit];
-                    }
-                }
 
-              ++centerPtr;
+                  ++centerPtr;
+                }
             }
         }
       delete[] neighborPtr1;
@@ -198,18 +191,21 @@ template <class MatrixClass, class T, class Roi> PiiMatrix<int> PiiLbp::genericS
       unsigned int value;
       int bit, r, c, secondBit;
       const T** neighborPtr = new const T*[iSamples];
+      PiiImage::RoiSpans<Roi> spans(roi, iMargin, image.columns()-iMargin);
       for (r=iMargin; r<image.rows()-iMargin; ++r)
         {
           // Tell our matrix that we're about to handle a new row.
           result.changeRow(r);
+          spans.selectRow(r);
 
-          // Initialize pointers to neighbors at the start of each row
-          for (bit=0; bit<iSamples; ++bit)
-            neighborPtr[bit] = image.row(r+d->pPoints[bit].nearestY) + (d->pPoints[bit].nearestX + iMargin);
-
-          for (c=iMargin; c<image.columns()-iMargin; ++c)
+          for (int iSpan=0; iSpan<spans.count(); ++iSpan)
             {
-              if (roi(r,c))
+              const int iStart = spans.start(iSpan), iEnd = spans.end(iSpan);
+              // Initialize pointers to neighbors at the start of each span
+              for (bit=0; bit<iSamples; ++bit)
+                neighborPtr[bit] = image.row(r+d->pPoints[bit].nearestY) + (d->pPoints[bit].nearestX + iStart);
+
+              for (c=iStart; c<iEnd; ++c)
                 {
                   //the first bit doesn't need to be shifted
                   value = Pii::signBit(*neighborPtr[0], *neighborPtr[iHalfSamples]);
@@ -226,12 +222,6 @@ template <class MatrixClass, class T, class Roi> PiiMatrix<int> PiiLbp::genericS
                   // Update the result matrix.
                   result.modify(c, static_cast<unsigned int>(value >> iFinalShift));
                 }
-              else
-                {
-                  // Not in ROI -> just increment neighbor pointers
-                  for (bit=0; bit<iSamples; ++bit)
-                    ++neighborPtr[bit];
-                }
             }
         }
       delete[] neighborPtr;
@@ -247,27 +237,30 @@ template <class MatrixClass, class T, class Roi> PiiMatrix<int> PiiLbp::genericS
       float neighbor1, neighbor2;
       unsigned int value;
       int bit, r, c, secondBit;
+      PiiImage::RoiSpans<Roi> spans(roi, iMargin, image.columns()-iMargin);
       for (r=iMargin; r<image.rows()-iMargin; ++r)
         {
           // Tell our matrix that we're about to handle a new row.
           result.changeRow(r);
+          spans.selectRow(r);
 
-          //Initialize pointers to neighbors at the start
-          //of each row sweep. Two pointers for each neighbor are
-          //needed because (in general) two rows of pixels are
-          //accessed at each sample.
-          for (bit=0; bit<iSamples; ++bit)
+          for (int iSpan=0; iSpan<spans.count(); ++iSpan)
             {
-              neighborPtr1[bit] = image.row(r+d->pPoints[bit].y) + (d->pPoints[bit].x + iMargin);
-              //Second row is used only if it fits in the image. (It
-              //won't if ceil(radius) = radius).
-              if (r+d->pPoints[bit].y+1 < image.rows())
-                neighborPtr2[bit] = image.row(r+d->pPoints[bit].y+1) + (d->pPoints[bit].x + iMargin);
-            }
+              const int iStart = spans.start(iSpan), iEnd = spans.end(iSpan);
+              //Initialize pointers to neighbors at the start of each
+              //span. Two pointers for each neighbor are needed
+              //because (in general) two rows of pixels are accessed
+              //at each sample.
+              for (bit=0; bit<iSamples; ++bit)
+                {
+                  neighborPtr1[bit] = image.row(r+d->pPoints[bit].y) + (d->pPoints[bit].x + iStart);
+                  //Second row is used only if it fits in the image. (It
+                  //won't if ceil(radius) = radius).
+                  if (r+d->pPoints[bit].y+1 < image.rows())
+                    neighborPtr2[bit] = image.row(r+d->pPoints[bit].y+1) + (d->pPoints[bit].x + iStart);
+                }
 
-          for (c=iMargin; c<image.columns()-iMargin; ++c)
-            {
-              if (roi(r,c))
+              for (c=iStart; c<iEnd; ++c)
                 {
                   //the first bit doesn't need to be shifted
                   INTERPOLATE_NEIGHBOR(neighbor1, 0);
@@ -284,15 +277,6 @@ template <class MatrixClass, class T, class Roi> PiiMatrix<int> PiiLbp::genericS
                   // Update the result matrix.
                   result.modify(c, static_cast<unsigned int>(value >> iFinalShift));
                 }
-              else
-                {
-                  // Not in ROI -> just increment neighbor pointers
-                  for (bit=0; bit<iSamples; ++bit)
-                    {
-                      ++neighborPtr1[bit];
-                      ++neighborPtr2[bit];
-                    }
-                }
             }
         }
       delete[] neighborPtr1;
@@ -312,19 +296,22 @@ PiiMatrix<int> PiiLbp::basicLbp(const PiiMatrix<T>& image, Roi roi, UnaryFunctio
   C center;
   MatrixClass result(image.rows(), image.columns(), 1, 256);
 
+  PiiImage::RoiSpans<Roi> spans(roi, 1, image.columns()-1);
   for (r=1; r<image.rows()-1; ++r)
     {
       result.changeRow(r);
+      spans.selectRow(r);
 
-      //Initialize row pointers to the beginning of three successive
-      //rows.
-      r0 = image.row(r-1);
-      r1 = image.row(r);
-      r2 = image.row(r+1);
-
-      for (c=1; c<image.columns()-1; ++c)
+      for (int iSpan=0; iSpan<spans.count(); ++iSpan)
         {
-          if (roi(r,c))
+          const int iStart = spans.start(iSpan), iEnd = spans.end(iSpan);
+          //Initialize row pointers to the beginning of the span on
+          //three successive rows.
+          r0 = image.row(r-1) + (iStart-1);
+          r1 = image.row(r) + (iStart-1);
+          r2 = image.row(r+1) + (iStart-1);
+
+          for (c=iStart; c<iEnd; ++c)
             {
               //initialize center value
               center = centerFunc(r1[1]);
@@ -340,9 +327,9 @@ PiiMatrix<int> PiiLbp::basicLbp(const PiiMatrix<T>& image, Roi roi, UnaryFunctio
               value |= Pii::signBit(center, C(r2[2])) >> 24;
 
               result.modify(c, value);
-            }
 
-          ++r0; ++r1; ++r2;
+              ++r0; ++r1; ++r2;
+            }
         }
     }
   return result;
@@ -355,19 +342,22 @@ template <class MatrixClass, class T, class Roi> PiiMatrix<int> PiiLbp::basicSym
   int r, c;
   MatrixClass result(image.rows(), image.columns(), 1, 16);
 
+  PiiImage::RoiSpans<Roi> spans(roi, 1, image.columns()-1);
   for (r=1; r<image.rows()-1; ++r)
     {
       result.changeRow(r);
+      spans.selectRow(r);
 
-      // Initialize row pointers to the beginning of three successive
-      // rows.
-      r0 = image.row(r-1);
-      r1 = image.row(r);
-      r2 = image.row(r+1);
-
-      for (c=1; c<image.columns()-1; ++c)
+      for (int iSpan=0; iSpan<spans.count(); ++iSpan)
         {
-          if (roi(r,c))
+          const int iStart = spans.start(iSpan), iEnd = spans.end(iSpan);
+          // Initialize row pointers to the beginning of the span on
+          // three successive rows.
+          r0 = image.row(r-1) + (iStart-1);
+          r1 = image.row(r) + (iStart-1);
+          r2 = image.row(r+1) + (iStart-1);
+
+          for (c=iStart; c<iEnd; ++c)
             {
               // Set LBP bits by addressing the neighbors counter-clockwise
               value = Pii::signBit(*r1, r1[2]) >> 31;
@@ -376,8 +366,8 @@ template <class MatrixClass, class T, class Roi> PiiMatrix<int> PiiLbp::basicSym
               value |= Pii::signBit(r2[2], *r0) >> 28;
 
               result.modify(c, value);
+              ++r0; ++r1; ++r2;
             }
-          ++r0; ++r1; ++r2;
         }
     }
   return result;
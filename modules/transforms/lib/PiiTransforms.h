@@ -19,6 +19,7 @@
 #include <PiiMatrix.h>
 #include <PiiMath.h>
 #include <PiiMatrixValue.h>
+#include <PiiRandom.h>
 #include <PiiHeap.h>
 
 #include <QList>
@@ -86,17 +87,17 @@ namespace PiiTransforms
   {
     RandomSelector(double threshold, double selectionProbability) :
       ThresholdSelector(threshold),
-      _iLimit(Pii::round<int>(selectionProbability * RAND_MAX))
+      _dProbability(selectionProbability)
     {}
 
     template <class T> bool operator() (T magnitude) const
     {
       return ThresholdSelector::operator() (magnitude) &&
-        rand() < _iLimit;
+        Pii::uniformRandom() < _dProbability;
     }
 
   private:
-    int _iLimit;
+    double _dProbability;
   };
 
   enum GradientSign { PositiveGradient = 1, NegativeGradient = 2, IgnoreGradientSign = 3 };
@@ -0,0 +1,246 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "TestPiiDatabaseReader.h"
+
+#include <QtTest>
+#include <PiiDelay.h>
+#include <PiiMatrix.h>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+static const char* pFileName = "test.csv";
+static const char* pSqlFileName = "test.sqlite";
+static const int iSqlRows = 100;
+
+void TestPiiDatabaseReader::initTestCase()
+{
+  QVERIFY(createOperation("piidatabase", "PiiDatabaseReader"));
+  connect(this, SIGNAL(objectReceived(QString,PiiVariant)),
+          this, SLOT(collect(QString,PiiVariant)), Qt::DirectConnection);
+
+  QFile file(pFileName);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  // Quoted separators and line feeds, an empty field, CRLF and no
+  // line feed at the end.
+  file.write("1;2.5;\"a;b\"\n"
+             "2;;\"c\nd\"\r\n"
+             "\n"
+             "3;-1;e");
+  file.close();
+
+  operation()->setProperty("columnNames", QStringList() << "int" << "double" << "string");
+  QVariantMap values;
+  values["int"] = 0;
+  values["double"] = 1.0;
+  operation()->setProperty("defaultValues", values);
+  operation()->setProperty("databaseUri", "csv://");
+  operation()->setProperty("databaseName", pFileName);
+}
+
+void TestPiiDatabaseReader::cleanupTestCase()
+{
+  QFile::remove(pFileName);
+  QFile::remove(pSqlFileName);
+}
+
+void TestPiiDatabaseReader::collect(const QString& name, const PiiVariant& obj)
+{
+  QMutexLocker lock(&_mutex);
+  _mapObjects[name] << obj;
+}
+
+bool TestPiiDatabaseReader::readAll()
+{
+  _mapObjects.clear();
+  if (!start())
+    return false;
+  // The operation stops by itself at the end of data.
+  for (int i=0; i<200 && operation()->state() != PiiOperation::Stopped; ++i)
+    {
+      QCoreApplication::processEvents();
+      PiiDelay::msleep(10);
+    }
+  return operation()->state() == PiiOperation::Stopped;
+}
+
+void TestPiiDatabaseReader::readRows_data()
+{
+  QTest::addColumn<int>("prefetchSize");
+  QTest::addColumn<int>("fetchSize");
+  QTest::newRow("direct") << 0 << 128;
+  QTest::newRow("prefetch") << 1024 << 128;
+  QTest::newRow("small buffer") << 1 << 1;
+}
+
+void TestPiiDatabaseReader::readRows()
+{
+  QFETCH(int, prefetchSize);
+  QFETCH(int, fetchSize);
+  operation()->setProperty("blockSize", 0);
+  operation()->setProperty("prefetchSize", prefetchSize);
+  operation()->setProperty("fetchSize", fetchSize);
+
+  QVERIFY(readAll());
+
+  QList<PiiVariant> lstInts(_mapObjects["int"]), lstDoubles(_mapObjects["double"]), lstStrings(_mapObjects["string"]);
+  QCOMPARE(lstInts.size(), 3);
+  QCOMPARE(lstDoubles.size(), 3);
+  QCOMPARE(lstStrings.size(), 3);
+
+  QCOMPARE(lstInts[0].valueAs<int>(), 1);
+  QCOMPARE(lstInts[1].valueAs<int>(), 2);
+  QCOMPARE(lstInts[2].valueAs<int>(), 3);
+  QCOMPARE(lstDoubles[0].valueAs<double>(), 2.5);
+  QCOMPARE(lstDoubles[1].valueAs<double>(), 1.0);
+  QCOMPARE(lstDoubles[2].valueAs<double>(), -1.0);
+  QCOMPARE(lstStrings[0].valueAs<QString>(), QString("a;b"));
+  QCOMPARE(lstStrings[1].valueAs<QString>(), QString("c\nd"));
+  QCOMPARE(lstStrings[2].valueAs<QString>(), QString("e"));
+}
+
+void TestPiiDatabaseReader::readBlocks()
+{
+  operation()->setProperty("blockSize", 2);
+  QVERIFY(readAll());
+
+  QList<PiiVariant> lstInts(_mapObjects["int"]), lstDoubles(_mapObjects["double"]), lstStrings(_mapObjects["string"]);
+  QCOMPARE(lstInts.size(), 2);
+  QCOMPARE(lstDoubles.size(), 2);
+  QCOMPARE(lstStrings.size(), 2);
+
+  QCOMPARE(lstInts[0].type(), Pii::typeId<PiiMatrix<int> >());
+  QVERIFY(Pii::equals(lstInts[0].valueAs<PiiMatrix<int> >(), PiiMatrix<int>(2,1, 1,2)));
+  QVERIFY(Pii::equals(lstInts[1].valueAs<PiiMatrix<int> >(), PiiMatrix<int>(1,1, 3)));
+  QVERIFY(Pii::equals(lstDoubles[0].valueAs<PiiMatrix<double> >(), PiiMatrix<double>(2,1, 2.5, 1.0)));
+  QVERIFY(Pii::equals(lstDoubles[1].valueAs<PiiMatrix<double> >(), PiiMatrix<double>(1,1, -1.0)));
+  QCOMPARE(lstStrings[0].valueAs<QStringList>(), QStringList() << "a;b" << "c\nd");
+  QCOMPARE(lstStrings[1].valueAs<QStringList>(), QStringList() << "e");
+}
+
+bool TestPiiDatabaseReader::createSqlDatabase(int rows)
+{
+  QFile::remove(pSqlFileName);
+  bool bSuccess = true;
+  {
+    QSqlDatabase db(QSqlDatabase::addDatabase("QSQLITE", "setup"));
+    db.setDatabaseName(pSqlFileName);
+    if (db.open())
+      {
+        QSqlQuery query(db);
+        bSuccess = query.exec("CREATE TABLE test (i INTEGER, d REAL, s TEXT)") &&
+          db.transaction() &&
+          query.prepare("INSERT INTO test VALUES (?, ?, ?)");
+        for (int i=0; i<rows && bSuccess; ++i)
+          {
+            query.bindValue(0, i);
+            // Every tenth value is NULL.
+            query.bindValue(1, i % 10 == 3 ? QVariant(QVariant::Double) : QVariant(i * 0.5));
+            query.bindValue(2, QString("row %1").arg(i));
+            bSuccess = query.exec();
+          }
+        bSuccess = bSuccess && db.commit();
+        db.close();
+      }
+    else
+      bSuccess = false;
+  }
+  QSqlDatabase::removeDatabase("setup");
+  return bSuccess;
+}
+
+void TestPiiDatabaseReader::setSqlProperties(int prefetchSize, int fetchSize)
+{
+  operation()->setProperty("columnNames", QStringList() << "i" << "d" << "s");
+  QVariantMap values;
+  values["d"] = -1.0;
+  operation()->setProperty("defaultValues", values);
+  operation()->setProperty("databaseUri", "sqlite://");
+  operation()->setProperty("databaseName", pSqlFileName);
+  operation()->setProperty("blockSize", 0);
+  operation()->setProperty("prefetchSize", prefetchSize);
+  operation()->setProperty("fetchSize", fetchSize);
+}
+
+void TestPiiDatabaseReader::readSql_data()
+{
+  QTest::addColumn<int>("prefetchSize");
+  QTest::addColumn<int>("fetchSize");
+  QTest::newRow("direct") << 0 << 8;
+  QTest::newRow("prefetch") << 16 << 4;
+}
+
+void TestPiiDatabaseReader::readSql()
+{
+  if (!QSqlDatabase::isDriverAvailable("QSQLITE"))
+    QSKIP("SQLite driver is not available."
+#if QT_VERSION < 0x050000
+          , SkipAll
+#endif
+          );
+  QFETCH(int, prefetchSize);
+  QFETCH(int, fetchSize);
+  QVERIFY(createSqlDatabase(iSqlRows));
+  setSqlProperties(prefetchSize, fetchSize);
+
+  QVERIFY(readAll());
+
+  QList<PiiVariant> lstInts(_mapObjects["i"]), lstDoubles(_mapObjects["d"]), lstStrings(_mapObjects["s"]);
+  QCOMPARE(lstInts.size(), iSqlRows);
+  QCOMPARE(lstDoubles.size(), iSqlRows);
+  QCOMPARE(lstStrings.size(), iSqlRows);
+  for (int i=0; i<iSqlRows; ++i)
+    {
+      QCOMPARE(lstInts[i].valueAs<int>(), i);
+      QCOMPARE(lstDoubles[i].valueAs<double>(), i % 10 == 3 ? -1.0 : i * 0.5);
+      QCOMPARE(lstStrings[i].valueAs<QString>(), QString("row %1").arg(i));
+    }
+  // The connection was closed and removed.
+  QVERIFY(QSqlDatabase::connectionNames().isEmpty());
+}
+
+void TestPiiDatabaseReader::interruptSql()
+{
+  if (!QSqlDatabase::isDriverAvailable("QSQLITE"))
+    QSKIP("SQLite driver is not available."
+#if QT_VERSION < 0x050000
+          , SkipAll
+#endif
+          );
+  // Enough rows to make sure the operation is still running when
+  // interrupted.
+  QVERIFY(createSqlDatabase(100000));
+  // Rows are read in the processing thread, one at a time.
+  setSqlProperties(0, 1);
+
+  _mapObjects.clear();
+  QVERIFY(start());
+  for (int i=0; i<200 && operation()->state() != PiiOperation::Stopped; ++i)
+    {
+      _mutex.lock();
+      const int iCount = _mapObjects["i"].size();
+      _mutex.unlock();
+      if (iCount >= 10)
+        break;
+      PiiDelay::msleep(10);
+    }
+  // The connection opened by the processing thread must be closed
+  // even if the operation is stopped from this thread.
+  QVERIFY(stop());
+  QCOMPARE(operation()->state(), PiiOperation::Stopped);
+  QVERIFY(QSqlDatabase::connectionNames().isEmpty());
+}
+
+QTEST_MAIN(TestPiiDatabaseReader)
@@ -17,6 +17,8 @@
 #define _TESTOPERATION_H
 
 #include <PiiDefaultOperation.h>
+#include <PiiAtomicInt.h>
+#include <QSemaphore>
 
 class CounterOperation : public PiiDefaultOperation
 {
@@ -69,6 +71,32 @@ protected:
   void process();
 };
 
+// Blocks in process() until the test releases it.
+class BlockingOperation : public PiiDefaultOperation
+{
+  Q_OBJECT
+public:
+  BlockingOperation();
+
+  QSemaphore entered, released;
+  PiiAtomicInt iProcessedCount;
+
+protected:
+  void process();
+};
 
+// Records the scheduling policy of the thread that calls process().
+class SchedulingProbe : public PiiDefaultOperation
+{
+  Q_OBJECT
+public:
+  SchedulingProbe();
+
+  QSemaphore processed;
+  PiiAtomicInt iPolicy;
+
+protected:
+  void process();
+};
 
 #endif //_TESTOPERATION_H
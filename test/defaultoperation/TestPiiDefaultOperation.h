@@ -33,6 +33,14 @@ private slots:
   void metaProperties();
   void process();
   void process_data();
+  void growFullQueue();
+  void resizeQueues();
+  void tuner();
+  void stopTunerBeforeRun();
+  void shedTriggers();
+  void skipSinkRounds();
+  void schedulingClass();
+  void restoreNormalScheduling();
 
 private:
   enum { sequenceLength = 2048 };
@@ -18,6 +18,20 @@
 #include <QtTest>
 
 #include <PiiYdinUtil.h>
+#include <PiiEngineTuner.h>
+#include <PiiInputListener.h>
+#include <PiiDelay.h>
+#include <PiiThreadUtil.h>
+#include <PiiLog.h>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#  include <pthread.h>
+#  include <sched.h>
+#  ifndef SCHED_IDLE
+#    define SCHED_IDLE 5
+#  endif
+#endif
 
 CounterOperation::CounterOperation() :
   _iProp1(0),
@@ -51,6 +65,43 @@ void BufferOperation::process()
                        inputAt(1)->firstObject().valueAs<int>());
 }
 
+BlockingOperation::BlockingOperation()
+{
+  setObjectName("blocker");
+  addSocket(new PiiInputSocket("input"));
+}
+
+void BlockingOperation::process()
+{
+  entered.release();
+  released.acquire();
+  iProcessedCount.ref();
+}
+
+SchedulingProbe::SchedulingProbe() :
+  iPolicy(-1)
+{
+  setObjectName("probe");
+  addSocket(new PiiInputSocket("input"));
+}
+
+static int currentSchedulingPolicy()
+{
+#ifdef Q_OS_LINUX
+  int iPolicy;
+  sched_param param;
+  if (pthread_getschedparam(pthread_self(), &iPolicy, &param) == 0)
+    return iPolicy;
+#endif
+  return -1;
+}
+
+void SchedulingProbe::process()
+{
+  iPolicy.store(currentSchedulingPolicy());
+  processed.release();
+}
+
 void TestPiiDefaultOperation::initTestCase()
 {
   try
@@ -207,4 +258,394 @@ void TestPiiDefaultOperation::process_data()
     QTest::newRow(qPrintable(QString::number(i))) << i;
 }
 
+struct ReadyCounter : PiiInputListener
+{
+  ReadyCounter() : iCount(0) {}
+  void inputReady(PiiAbstractInputSocket*) { ++iCount; }
+  int iCount;
+};
+
+void TestPiiDefaultOperation::growFullQueue()
+{
+  PiiInputSocket input("input");
+  ReadyCounter counter;
+  input.setListener(&counter);
+  input.reserveQueueCapacity(4);
+  input.setQueueCapacity(2);
+  input.receive(PiiVariant(1));
+  input.receive(PiiVariant(2));
+  QVERIFY(!input.canReceive());
+
+  // The new capacity takes effect on the next shift(). A sender
+  // blocked at the old capacity must be woken up then, although the
+  // queue does not become non-full at the old capacity.
+  input.setQueueCapacity(4);
+  QCOMPARE(input.queueCapacity(), 4);
+  QVERIFY(!input.canReceive());
+  QCOMPARE(counter.iCount, 0);
+  input.shift();
+  QCOMPARE(counter.iCount, 1);
+  QVERIFY(input.canReceive());
+
+  // No wake-up if the queue wasn't full.
+  input.receive(PiiVariant(3));
+  input.shift();
+  QCOMPARE(counter.iCount, 1);
+
+  // Shrinking below the queue length blocks senders until the queue
+  // has drained below the new capacity.
+  input.receive(PiiVariant(4));
+  input.receive(PiiVariant(5));
+  QCOMPARE(input.queueLength(), 3);
+  input.setQueueCapacity(1);
+  input.shift();
+  QVERIFY(!input.canReceive());
+  input.shift();
+  QVERIFY(!input.canReceive());
+  QCOMPARE(counter.iCount, 1);
+  input.shift();
+  QVERIFY(input.canReceive());
+  QCOMPARE(counter.iCount, 2);
+  input.setListener(0);
+}
+
+void TestPiiDefaultOperation::resizeQueues()
+{
+  PiiInputSocket* pInputs[] = { _pCounter->input("input"),
+                                _pBuffer->input("input0"),
+                                _pBuffer->input("input1") };
+  for (int i=0; i<3; ++i)
+    pInputs[i]->reserveQueueCapacity(8);
+
+  _pBuffer->lstData.clear();
+  _pCounter->setProperty("threadCount", 2);
+  try
+    {
+      _engine.execute();
+    }
+  catch (PiiException& ex)
+    {
+      QFAIL(qPrintable(ex.message()));
+    }
+
+  // Change capacities while the queues are being filled and drained.
+  for (int iRound=0; !_engine.wait(PiiOperation::Stopped, 1); ++iRound)
+    {
+      QVERIFY2(iRound < 10000, "Engine did not stop while queue capacities were changed.");
+      for (int i=0; i<3; ++i)
+        pInputs[i]->setQueueCapacity(iRound % 2 ? 8 : 1);
+    }
+
+  QCOMPARE(_pBuffer->lstData.size(), int(sequenceLength));
+  for (int i=0; i<sequenceLength; ++i)
+    QCOMPARE(_pBuffer->lstData[i].first, i);
+
+  for (int i=0; i<3; ++i)
+    pInputs[i]->setQueueCapacity(2);
+}
+
+void TestPiiDefaultOperation::tuner()
+{
+  PiiEngineTuner tuner(&_engine);
+  tuner.setTuningInterval(10);
+  tuner.setHysteresis(1);
+  tuner.setMaxQueueCapacity(8);
+  // Also works through the meta-object system.
+  QVERIFY(QMetaObject::invokeMethod(&tuner, "start"));
+  QVERIFY(tuner.isRunning());
+
+  _pBuffer->lstData.clear();
+  _pCounter->setProperty("threadCount", 4);
+  try
+    {
+      _engine.execute();
+    }
+  catch (PiiException& ex)
+    {
+      QFAIL(qPrintable(ex.message()));
+    }
+  QVERIFY(_engine.wait(PiiOperation::Stopped, 5000));
+
+  tuner.stop();
+  QVERIFY(!tuner.isRunning());
+
+  QCOMPARE(_pBuffer->lstData.size(), int(sequenceLength));
+  for (int i=0; i<sequenceLength; ++i)
+    {
+      QCOMPARE(_pBuffer->lstData[i].first, i);
+      QCOMPARE(_pBuffer->lstData[i].second, i*2);
+    }
+
+  // Decisions must stay within the configured limits.
+  QVariantList lstDecisions(tuner.decisions());
+  for (int i=0; i<lstDecisions.size(); ++i)
+    {
+      QVariantMap mapDecision(lstDecisions[i].toMap());
+      if (mapDecision["parameter"].toString() == "queueCapacity")
+        QVERIFY(mapDecision["newValue"].toInt() <= 8);
+    }
+}
+
+void TestPiiDefaultOperation::stopTunerBeforeRun()
+{
+  // stop() immediately after start() must not hang.
+  for (int i=0; i<100; ++i)
+    {
+      PiiEngineTuner tuner(&_engine);
+      tuner.start();
+      tuner.stop();
+      QVERIFY(!tuner.isRunning());
+    }
+}
+
+static QVariantMap sheddingReport(const PiiEngine& engine, const QString& name)
+{
+  QVariantList lstReport(engine.loadSheddingReport());
+  for (int i=0; i<lstReport.size(); ++i)
+    if (lstReport[i].toMap()["name"].toString() == name)
+      return lstReport[i].toMap();
+  return QVariantMap();
+}
+
+void TestPiiDefaultOperation::shedTriggers()
+{
+  PiiEngine engine;
+  PiiBasicOperation* pTrigger = qobject_cast<PiiBasicOperation*>(engine.createOperation("PiiTriggerSource", "trigger"));
+  QVERIFY(pTrigger != 0);
+  pTrigger->setOverloadPolicy(PiiBasicOperation::DropWhenOverloaded);
+  pTrigger->setOverloadThreshold(0.5);
+  pTrigger->setOverloadDelay(200);
+
+  BlockingOperation* pBlocker = new BlockingOperation;
+  pBlocker->setProperty("threadCount", 1);
+  PiiInputSocket* pInput = pBlocker->input("input");
+  pInput->setQueueCapacity(8);
+  engine.addOperation(pBlocker);
+  QVERIFY(engine.connectOutput("trigger.trigger", "blocker.input"));
+
+  try
+    {
+      engine.execute();
+    }
+  catch (PiiException& ex)
+    {
+      QFAIL(qPrintable(ex.message()));
+    }
+
+  // The first trigger occupies the processing thread.
+  QMetaObject::invokeMethod(pTrigger, "trigger", Q_ARG(int, 0));
+  QVERIFY(pBlocker->entered.tryAcquire(1, 5000));
+  // Fill the queue up to the threshold.
+  for (int i=1; i<=4; ++i)
+    QMetaObject::invokeMethod(pTrigger, "trigger", Q_ARG(int, i));
+  QCOMPARE(pInput->queueLength(), 4);
+
+  // Saturation starts now, but nothing is dropped before
+  // overloadDelay has passed.
+  QMetaObject::invokeMethod(pTrigger, "trigger", Q_ARG(int, 5));
+  QCOMPARE(pInput->queueLength(), 5);
+  QVERIFY(!pTrigger->isOverloaded());
+  QCOMPARE(pTrigger->loadSheddingStatistics()["droppedCount"].toInt(), 0);
+
+  PiiDelay::msleep(250);
+  for (int i=6; i<9; ++i)
+    QMetaObject::invokeMethod(pTrigger, "trigger", Q_ARG(int, i));
+  QCOMPARE(pInput->queueLength(), 5);
+  QVERIFY(pTrigger->isOverloaded());
+
+  QVariantMap mapReport(sheddingReport(engine, "trigger"));
+  QCOMPARE(mapReport["droppedCount"].toInt(), 3);
+  QCOMPARE(mapReport["overloadPeriods"].toInt(), 1);
+  QVERIFY(mapReport["overloaded"].toBool());
+  // Blocking operations that dropped nothing are not reported.
+  QCOMPARE(engine.loadSheddingReport().size(), 1);
+
+  // Once the queue drains, triggers pass through again.
+  pBlocker->released.release(100);
+  QTime time;
+  time.start();
+  while (pBlocker->iProcessedCount.load() < 6)
+    {
+      QVERIFY2(time.elapsed() < 5000, "Queued triggers were not processed.");
+      PiiDelay::msleep(1);
+    }
+  QMetaObject::invokeMethod(pTrigger, "trigger", Q_ARG(int, 9));
+  QVERIFY(!pTrigger->isOverloaded());
+  mapReport = sheddingReport(engine, "trigger");
+  QCOMPARE(mapReport["droppedCount"].toInt(), 3);
+  QVERIFY(!mapReport["overloaded"].toBool());
+
+  engine.interrupt();
+  QVERIFY(engine.wait(PiiOperation::Stopped, 5000));
+}
+
+void TestPiiDefaultOperation::skipSinkRounds()
+{
+  PiiEngine engine;
+  PiiOperation* pTrigger = engine.createOperation("PiiTriggerSource", "trigger");
+  QVERIFY(pTrigger != 0);
+
+  // A sink may skip processing rounds.
+  BlockingOperation* pBlocker = new BlockingOperation;
+  pBlocker->setProperty("threadCount", 1);
+  pBlocker->setOverloadPolicy(PiiBasicOperation::DropWhenOverloaded);
+  pBlocker->setOverloadThreshold(0.5);
+  pBlocker->setOverloadDelay(0);
+  pBlocker->input("input")->setQueueCapacity(8);
+  engine.addOperation(pBlocker);
+  QVERIFY(engine.connectOutput("trigger.trigger", "blocker.input"));
+
+  try
+    {
+      engine.execute();
+    }
+  catch (PiiException& ex)
+    {
+      QFAIL(qPrintable(ex.message()));
+    }
+
+  QMetaObject::invokeMethod(pTrigger, "trigger", Q_ARG(int, 0));
+  QVERIFY(pBlocker->entered.tryAcquire(1, 5000));
+  for (int i=1; i<6; ++i)
+    QMetaObject::invokeMethod(pTrigger, "trigger", Q_ARG(int, i));
+  QCOMPARE(pBlocker->input("input")->queueLength(), 5);
+
+  // Rounds are skipped until the queue is below the threshold.
+  pBlocker->released.release(100);
+  QTime time;
+  time.start();
+  forever
+    {
+      const int iDropped = pBlocker->loadSheddingStatistics()["droppedCount"].toInt();
+      if (pBlocker->iProcessedCount.load() + iDropped == 6)
+        break;
+      QVERIFY2(time.elapsed() < 5000, "Queued objects were neither processed nor dropped.");
+      PiiDelay::msleep(1);
+    }
+  QVERIFY(pBlocker->loadSheddingStatistics()["droppedCount"].toInt() >= 1);
+  QVERIFY(pBlocker->iProcessedCount.load() >= 2);
+  QCOMPARE(sheddingReport(engine, "blocker")["overloadPeriods"].toInt(), 1);
+
+  engine.interrupt();
+  QVERIFY(engine.wait(PiiOperation::Stopped, 5000));
+}
+
+static PiiAtomicInt iWarningCount;
+
+static bool countWarnings(const char*, QtMsgType level)
+{
+  if (level == QtWarningMsg)
+    iWarningCount.ref();
+  return true;
+}
+
+void TestPiiDefaultOperation::schedulingClass()
+{
+  SchedulingProbe probe;
+  QCOMPARE(probe.schedulingClass(), PiiDefaultOperation::NormalClass);
+  QVERIFY(probe.setProperty("schedulingClass", "BackgroundClass"));
+  QCOMPARE(probe.schedulingClass(), PiiDefaultOperation::BackgroundClass);
+  QVERIFY(probe.setProperty("schedulingClass", int(PiiDefaultOperation::RealTimeClass)));
+  QCOMPARE(probe.property("schedulingClass").toInt(), int(PiiDefaultOperation::RealTimeClass));
+
+#ifdef Q_OS_LINUX
+  PiiEngine engine;
+  PiiOperation* pTrigger = engine.createOperation("PiiTriggerSource", "trigger");
+  QVERIFY(pTrigger != 0);
+  SchedulingProbe* pProbe = new SchedulingProbe;
+  pProbe->setProperty("threadCount", 1);
+  pProbe->setSchedulingClass(PiiDefaultOperation::RealTimeClass);
+  engine.addOperation(pProbe);
+  QVERIFY(engine.connectOutput("trigger.trigger", "probe.input"));
+
+  iWarningCount.store(0);
+  PiiLog::MessageFilter oldFilter = PiiLog::setMessageFilter(countWarnings);
+  try
+    {
+      engine.execute();
+    }
+  catch (PiiException& ex)
+    {
+      PiiLog::setMessageFilter(oldFilter);
+      QFAIL(qPrintable(ex.message()));
+    }
+  QMetaObject::invokeMethod(pTrigger, "trigger", Q_ARG(int, 0));
+  const bool bProcessed = pProbe->processed.tryAcquire(1, 5000);
+  PiiLog::setMessageFilter(oldFilter);
+  engine.interrupt();
+  QVERIFY(engine.wait(PiiOperation::Stopped, 5000));
+  QVERIFY(bProcessed);
+
+  // Without privileges, the thread falls back to normal scheduling
+  // with a warning.
+  if (pProbe->iPolicy.load() == SCHED_FIFO)
+    QCOMPARE(iWarningCount.load(), 0);
+  else
+    {
+      QCOMPARE(pProbe->iPolicy.load(), int(SCHED_OTHER));
+      QVERIFY(iWarningCount.load() >= 1);
+    }
+#endif
+}
+
+#ifdef Q_OS_LINUX
+// Leaves the thread with a background policy and then binds it to an
+// operation with normal scheduling.
+class BackgroundThread : public QThread
+{
+public:
+  BackgroundThread(PiiDefaultOperation* operation) :
+    bBackground(false), bBound(false), iPolicy(-1), _pOperation(operation)
+  {}
+
+  bool bBackground, bBound;
+  int iPolicy;
+
+protected:
+  void run()
+  {
+    bBackground = Pii::setThreadScheduling(Pii::BackgroundScheduling);
+    bBound = _pOperation->bindCurrentThread();
+    iPolicy = currentSchedulingPolicy();
+  }
+
+private:
+  PiiDefaultOperation* _pOperation;
+};
+#endif
+
+void TestPiiDefaultOperation::restoreNormalScheduling()
+{
+#ifdef Q_OS_LINUX
+  SchedulingProbe probe;
+  probe.check(true);
+  iWarningCount.store(0);
+  PiiLog::MessageFilter oldFilter = PiiLog::setMessageFilter(countWarnings);
+  BackgroundThread thread(&probe);
+  thread.start();
+  const bool bFinished = thread.wait(5000);
+  PiiLog::setMessageFilter(oldFilter);
+  QVERIFY(bFinished);
+  if (!thread.bBackground)
+    QSKIP("Background scheduling is not supported."
+#if QT_VERSION < 0x050000
+          , SkipAll
+#endif
+          );
+
+  // Returning from SCHED_IDLE may require privileges. If it fails, a
+  // warning must be emitted.
+  if (thread.bBound)
+    {
+      QCOMPARE(thread.iPolicy, int(SCHED_OTHER));
+      QCOMPARE(iWarningCount.load(), 0);
+    }
+  else
+    {
+      QCOMPARE(thread.iPolicy, int(SCHED_IDLE));
+      QVERIFY(iWarningCount.load() >= 1);
+    }
+#endif
+}
+
 QTEST_MAIN(TestPiiDefaultOperation)
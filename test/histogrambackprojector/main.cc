@@ -0,0 +1,130 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "TestPiiHistogramBackProjector.h"
+
+#include <QtTest>
+#include <PiiMatrix.h>
+#include <limits>
+
+void TestPiiHistogramBackProjector::initTestCase()
+{
+  QVERIFY(createOperation("piiimage", "PiiHistogramBackProjector"));
+  operation()->setProperty("threadCount", 0);
+}
+
+void TestPiiHistogramBackProjector::backProject()
+{
+  // Neither the model input nor the model property is set
+  QVERIFY(start(ExpectFail));
+
+  operation()->setProperty("model", QVariant::fromValue(PiiVariant(PiiMatrix<double>(1,4, 0.1, 0.5, 0.9, 0.3))));
+  QVERIFY(connectInput("image"));
+  QVERIFY(start());
+
+  QVERIFY(sendObject("image", PiiMatrix<unsigned char>(2,2, 0,1,2,3)));
+  QVERIFY(hasOutputValue("image"));
+  QCOMPARE(outputValue("image").type(), Pii::typeId<PiiMatrix<double> >());
+  QVERIFY(Pii::equals(outputValue("image", PiiMatrix<double>()),
+                      PiiMatrix<double>(2,2, 0.1, 0.5, 0.9, 0.3)));
+  QVERIFY(stop());
+}
+
+void TestPiiHistogramBackProjector::threshold()
+{
+  operation()->setProperty("threshold", 0.5);
+  QVERIFY(start());
+
+  // Pixels whose model value is at least 0.5 are set to one.
+  QVERIFY(sendObject("image", PiiMatrix<unsigned char>(2,3, 0,1,2, 3,2,1)));
+  QCOMPARE(outputValue("image").type(), Pii::typeId<PiiMatrix<unsigned char> >());
+  QVERIFY(Pii::equals(outputValue("image", PiiMatrix<unsigned char>()),
+                      PiiMatrix<unsigned char>(2,3, 0,1,1, 0,1,1)));
+
+  // 16-bit input
+  QVERIFY(sendObject("image", PiiMatrix<unsigned short>(1,4, 3,2,1,0)));
+  QVERIFY(Pii::equals(outputValue("image", PiiMatrix<unsigned char>()),
+                      PiiMatrix<unsigned char>(1,4, 0,1,1,0)));
+  QVERIFY(stop());
+
+  // Changing the threshold rebuilds the thresholded model.
+  operation()->setProperty("threshold", 0.3);
+  QVERIFY(start());
+  QVERIFY(sendObject("image", PiiMatrix<unsigned char>(1,4, 0,1,2,3)));
+  QVERIFY(Pii::equals(outputValue("image", PiiMatrix<unsigned char>()),
+                      PiiMatrix<unsigned char>(1,4, 0,1,1,1)));
+  QVERIFY(stop());
+
+  operation()->setProperty("threshold", std::numeric_limits<double>::quiet_NaN());
+}
+
+void TestPiiHistogramBackProjector::changeModel()
+{
+  QVERIFY(connectInput("model"));
+  operation()->setProperty("threshold", 4.0);
+  QVERIFY(start());
+
+  const PiiMatrix<unsigned char> matImage(1,4, 0,1,2,3);
+  QVERIFY(sendObject("model", PiiMatrix<int>(1,4, 1,5,9,3)));
+  QVERIFY(sendObject("image", matImage));
+  QVERIFY(Pii::equals(outputValue("image", PiiMatrix<unsigned char>()),
+                      PiiMatrix<unsigned char>(1,4, 0,1,1,0)));
+
+  // A new model in the middle of a run must not reuse the previously
+  // thresholded model.
+  QVERIFY(sendObject("model", PiiMatrix<int>(1,4, 9,3,1,5)));
+  QVERIFY(sendObject("image", matImage));
+  QVERIFY(Pii::equals(outputValue("image", PiiMatrix<unsigned char>()),
+                      PiiMatrix<unsigned char>(1,4, 1,0,0,1)));
+
+  // Without a threshold, the model is used as such.
+  QVERIFY(stop());
+  operation()->setProperty("threshold", std::numeric_limits<double>::quiet_NaN());
+  QVERIFY(start());
+  QVERIFY(sendObject("model", PiiMatrix<int>(1,4, 7,6,5,4)));
+  QVERIFY(sendObject("image", matImage));
+  QVERIFY(Pii::equals(outputValue("image", PiiMatrix<int>()),
+                      PiiMatrix<int>(1,4, 7,6,5,4)));
+  QVERIFY(stop());
+  disconnectInput("model");
+}
+
+void TestPiiHistogramBackProjector::outOfRange()
+{
+  operation()->setProperty("model", QVariant::fromValue(PiiVariant(PiiMatrix<double>(1,4, 0.1, 0.5, 0.9, 0.3))));
+
+  // An error stops the operation without emitting anything.
+  QVERIFY(start());
+  QVERIFY(sendObject("image", PiiMatrix<unsigned short>(1,3, 1,300,2)));
+  QVERIFY(!hasOutputValue("image"));
+  QCOMPARE(operation()->state(), PiiOperation::Stopped);
+
+  // Same with a thresholded model
+  operation()->setProperty("threshold", 0.5);
+  QVERIFY(start());
+  QVERIFY(sendObject("image", PiiMatrix<unsigned short>(1,2, 4,0)));
+  QVERIFY(!hasOutputValue("image"));
+  QCOMPARE(operation()->state(), PiiOperation::Stopped);
+
+  // In-range values still work after a restart.
+  QVERIFY(start());
+  QVERIFY(sendObject("image", PiiMatrix<unsigned short>(1,2, 3,2)));
+  QVERIFY(Pii::equals(outputValue("image", PiiMatrix<unsigned char>()),
+                      PiiMatrix<unsigned char>(1,2, 0,1)));
+  QVERIFY(stop());
+  operation()->setProperty("threshold", std::numeric_limits<double>::quiet_NaN());
+}
+
+QTEST_MAIN(TestPiiHistogramBackProjector)
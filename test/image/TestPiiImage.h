@@ -36,8 +36,11 @@ private slots:
   void colorChannel();
   void setColorChannel();
   void detectEdges();
+  void cannyEdges();
+  void rasterizer();
   void suppressNonMaxima();
   void medianFilter();
+  void rankFilter();
   void separateFilter();
   void filter();
   void intFilter();
@@ -66,22 +69,31 @@ private slots:
   void hitAndMiss();
   void border();
   void thin();
+  void binaryImage();
   void bottomHat();
   void labelImage();
   void labelLargerThan();
+  void distanceTransform();
+  void watershed();
 
   // Histogram
   void equalize();
+  void adaptiveEqualize();
   void histogram();
   void cumulative();
   void normalize();
   void percentile();
   void backProject();
 
+  // Regions of interest
+  void runLengthRoi();
+  void joinNeighbors();
+
   // Boundaries
   void findBoundary();
   void findNextBoundary();
   void findBoundaries();
+  void findContours();
 
   // Distortions
   void unwarpCylinder();
@@ -89,6 +101,7 @@ private slots:
   // Other
   void calculateDirection();
   void calculateProperties();
+  void calculateMoments();
   void sweepLine();
   void crop();
   void xorMatch();
@@ -22,16 +22,27 @@
 #include <PiiMatrixUtil.h>
 #include <PiiImage.h>
 #include <PiiMath.h>
+#include <PiiRandom.h>
 #include <PiiMorphology.h>
 #include <PiiBoundaryFinder.h>
+#include <PiiContours.h>
 #include <PiiLabeling.h>
 #include <PiiFunctional.h>
 #include <PiiObjectProperty.h>
 #include <PiiMaskGenerator.h>
 #include <PiiColor.h>
 #include <PiiImageDistortions.h>
+#include <PiiRunLengthRoi.h>
+#include <PiiThresholding.h>
+#include <PiiRasterizer.h>
+#include <PiiDistanceTransform.h>
+#include <PiiWatershed.h>
+
+#include <QLinkedList>
+#include <QSet>
 
 #include <functional>
+#include <cfloat>
 
 TestPiiImage::TestPiiImage() : _matThreshold(3,3,
                                              1,2,3,
@@ -340,6 +351,45 @@ void TestPiiImage::calculateProperties()
   }
 }
 
+void TestPiiImage::calculateMoments()
+{
+  PiiMatrix<int> source(6,8,
+                        0,0,0,0,0,0,0,0,
+                        1,1,1,1,1,1,0,2,
+                        0,0,0,0,0,0,0,2,
+                        0,3,3,0,0,0,0,2,
+                        0,3,3,0,0,0,0,2,
+                        0,0,0,0,0,0,0,2);
+  PiiMatrix<int> bbox, perimeters;
+  PiiMatrix<double> moments(PiiImage::calculateMoments(source, 0, &bbox, &perimeters));
+  QCOMPARE(moments.rows(), 3);
+  QVERIFY(Pii::equals(moments,
+                      PiiMatrix<double>(3,6,
+                                        6.0, 15.0, 6.0, 55.0, 15.0, 6.0,
+                                        5.0, 35.0, 15.0, 245.0, 105.0, 55.0,
+                                        4.0, 6.0, 14.0, 10.0, 21.0, 50.0)));
+  QVERIFY(Pii::equals(bbox,
+                      PiiMatrix<int>(3,4,
+                                     0,1,6,1,
+                                     7,1,1,5,
+                                     1,3,2,2)));
+  QVERIFY(Pii::equals(perimeters, PiiMatrix<int>(3,1, 14,12,8)));
+
+  // Closed-form axes agree with PCA.
+  PiiMatrix<double> axes(PiiImage::calculateAxes(moments));
+  for (int i=0; i<3; ++i)
+    {
+      double dLength = 0, dWidth = 0;
+      PiiMatrix<double> matDirection(PiiImage::calculateDirection(source, i+1, &dLength, &dWidth));
+      QVERIFY(Pii::almostEqualRel(axes(i,1), dLength));
+      QVERIFY(Pii::almostEqualRel(axes(i,2), dWidth));
+      if (axes(i,1) > axes(i,2))
+        QVERIFY(Pii::abs(Pii::abs(matDirection(0,0)) - Pii::abs(::cos(axes(i,0)))) < 1e-9);
+    }
+  QCOMPARE(axes(0,0), 0.0);
+  QCOMPARE(axes(1,0), M_PI/2);
+}
+
 void TestPiiImage::sweepLine()
 {
   {
@@ -962,6 +1012,76 @@ void TestPiiImage::detectEdges()
 
 }
 
+void TestPiiImage::cannyEdges()
+{
+  PiiMatrix<unsigned char> source(12,12);
+  source(3,3,6,6) = 100;
+  PiiMatrix<int> matMagnitude;
+  PiiMatrix<int> matEdges = PiiImage::cannyEdges(source, 100, 200, &matMagnitude);
+  QVERIFY(Pii::equals(matMagnitude,
+                      PiiImage::gradientMagnitude(PiiImage::filter<int>(source, PiiImage::sobelX, Pii::ExtendZeros),
+                                                  PiiImage::filter<int>(source, PiiImage::sobelY, Pii::ExtendZeros))));
+  // Ties are resolved towards the positive gradient direction, which
+  // puts the edge on the boundary of the square.
+  PiiMatrix<int> matExpected(12,12);
+  matExpected(3,3,6,6) = 1;
+  matExpected(4,4,4,4) = 0;
+  QVERIFY(Pii::equals(matEdges, matExpected));
+
+  // Automatic thresholds find the same edges.
+  QVERIFY(Pii::equals(PiiImage::cannyEdges(source), matExpected));
+
+  PiiMatrix<float> floatSource(12,12);
+  floatSource(3,3,6,6) = 1.0f;
+  QVERIFY(Pii::equals(PiiImage::cannyEdges(floatSource, 1.0f, 2.0f), matExpected));
+}
+
+void TestPiiImage::rasterizer()
+{
+  {
+    PiiMatrix<unsigned char> image(10,10);
+    PiiRasterizer<unsigned char> rasterizer(image);
+    rasterizer.setColor(1);
+    rasterizer.drawLine(0,0,9,9);
+    QCOMPARE(Pii::sum<int>(image), 10);
+    for (int i=0; i<10; ++i)
+      QCOMPARE(int(image(i,i)), 1);
+  }
+  {
+    // Drawing is limited to the clip rectangle.
+    PiiMatrix<int> image(10,10);
+    PiiRasterizer<int> rasterizer(image);
+    rasterizer.setColor(2);
+    rasterizer.setClipRect(PiiRectangle<int>(2,2,5,5));
+    rasterizer.fillRectangle(-5,-5,100,100);
+    PiiMatrix<int> matExpected(10,10);
+    matExpected(2,2,5,5) = 2;
+    QVERIFY(Pii::equals(image, matExpected));
+  }
+  {
+    // The outline covers width+1 columns and height+1 rows.
+    PiiMatrix<float> image(10,10);
+    PiiRasterizer<float> rasterizer(image);
+    rasterizer.setColor(0.5f);
+    rasterizer.drawRectangle(1,1,3,3);
+    PiiMatrix<float> matExpected(10,10);
+    matExpected(1,1,4,4) = 0.5f;
+    matExpected(2,2,2,2) = 0;
+    QVERIFY(Pii::equals(image, matExpected));
+  }
+  {
+    // The baseline of the built-in font is below the glyphs.
+    PiiMatrix<unsigned char> image(10,20);
+    PiiRasterizer<unsigned char> rasterizer(image);
+    rasterizer.setColor(1);
+    rasterizer.drawText(0,8,"|");
+    PiiMatrix<unsigned char> matExpected(10,20);
+    matExpected(1,2,7,1) = 1;
+    QVERIFY(Pii::equals(image, matExpected));
+    QCOMPARE(PiiRasterFont::defaultFont().textWidth("abc"), 18);
+  }
+}
+
 template <class TernaryFunction, class T>
 PiiMatrix<typename TernaryFunction::result_type> TestPiiImage::apply(const PiiMatrix<T>& mat,
                                                                      TernaryFunction func,
@@ -1178,6 +1298,65 @@ void TestPiiImage::medianFilter()
   QCOMPARE(matClrOut(1, 2), PiiColor<>(5, 6, 7));
 }
 
+// Selects the value of the given rank in each window by sorting.
+template <class T> static PiiMatrix<T> sortRankFilter(const PiiMatrix<T>& image, int windowSize, int rank)
+{
+  const int iRadius = windowSize/2;
+  PiiMatrix<T> matExtended(Pii::extend(image, iRadius, iRadius, iRadius, iRadius, Pii::ExtendZeros));
+  PiiMatrix<T> matResult(image.rows(), image.columns());
+  QVector<T> vecWindow;
+  for (int r=0; r<image.rows(); ++r)
+    for (int c=0; c<image.columns(); ++c)
+      {
+        vecWindow.clear();
+        for (int i=0; i<windowSize; ++i)
+          for (int j=0; j<windowSize; ++j)
+            vecWindow << matExtended(r+i, c+j);
+        qSort(vecWindow);
+        matResult(r,c) = vecWindow[rank];
+      }
+  return matResult;
+}
+
+void TestPiiImage::rankFilter()
+{
+  // Few distinct values to get many ties
+  PiiMatrix<int> matInt(PiiMatrix<int>(Pii::uniformRandomMatrix(23, 41, 0, 8)));
+  PiiMatrix<uchar> matUchar(PiiMatrix<uchar>(Pii::uniformRandomMatrix(37, 19, 0, 256)));
+  PiiMatrix<float> matFloat(PiiMatrix<float>(Pii::uniformRandomMatrix(17, 29, -1, 1)));
+
+  for (int iSize=3; iSize<=9; iSize+=2)
+    {
+      const int iCount = iSize*iSize;
+      const int aRanks[] = { 0, 1, iSize, iCount/2, iCount-2, iCount-1 };
+      for (unsigned i=0; i<sizeof(aRanks)/sizeof(aRanks[0]); ++i)
+        {
+          QVERIFY(Pii::equals(PiiImage::rankFilter(matInt, iSize, aRanks[i]),
+                              sortRankFilter(matInt, iSize, aRanks[i])));
+          QVERIFY(Pii::equals(PiiImage::rankFilter(matUchar, iSize, aRanks[i]),
+                              sortRankFilter(matUchar, iSize, aRanks[i])));
+          QVERIFY(Pii::equals(PiiImage::rankFilter(matFloat, iSize, aRanks[i]),
+                              sortRankFilter(matFloat, iSize, aRanks[i])));
+        }
+      QVERIFY(Pii::equals(PiiImage::percentileFilter(matInt, iSize, 0.5),
+                          sortRankFilter(matInt, iSize, iCount/2)));
+      QVERIFY(Pii::equals(PiiImage::medianFilter(matUchar, iSize, iSize),
+                          sortRankFilter(matUchar, iSize, iCount/2)));
+    }
+
+  PiiMatrix<int> mat(3,4,
+                     1, 2, 3, 4,
+                     5, 6, 7, 8,
+                     9, 10, 11, 12);
+  QVERIFY(Pii::equals(PiiImage::rankFilter(mat, 3, 8, Pii::ExtendReplicate),
+                      PiiMatrix<int>(3,4,
+                                     6, 7, 8, 8,
+                                     10, 11, 12, 12,
+                                     10, 11, 12, 12)));
+  QVERIFY(Pii::equals(PiiImage::rankFilter(mat, 3, 0, Pii::ExtendNot),
+                      PiiMatrix<int>(1,2, 1, 2)));
+}
+
 void TestPiiImage::backProject()
 {
   {
@@ -1193,6 +1372,14 @@ void TestPiiImage::backProject()
                                                                          8,4,2,1,
                                                                          2,1,8,4,
                                                                          8,2,4,1)));
+
+    // Out-of-range values are clamped and reported.
+    img(1,1) = 9;
+    unsigned int uiMaximum = 0;
+    PiiMatrix<int> result(PiiImage::backProject(img, model, &uiMaximum));
+    QCOMPARE(uiMaximum, 9u);
+    QCOMPARE(result(1,1), 8);
+    QCOMPARE(result(0,1), 2);
   }
   {
     PiiMatrix<unsigned char> ch1(4,4,
@@ -1212,6 +1399,11 @@ void TestPiiImage::backProject()
                                    13,14,15,16);
 
     QVERIFY(Pii::equals(PiiImage::backProject(ch1, ch2, model),model));
+
+    unsigned int uiMaximum1 = 0, uiMaximum2 = 0;
+    QVERIFY(Pii::equals(PiiImage::backProject(ch1, ch2, model, &uiMaximum1, &uiMaximum2),model));
+    QCOMPARE(uiMaximum1, 3u);
+    QCOMPARE(uiMaximum2, 3u);
   }
 }
 
@@ -1240,6 +1432,184 @@ void TestPiiImage::equalize()
                                                                 24,24,24,24,
                                                                 31,31,31,31)));
 }
+
+// Straightforward CLAHE: the histogram of each context window is
+// calculated from scratch and output pixels are interpolated in
+// double precision.
+template <class T> static PiiMatrix<T> referenceAdaptiveEqualize(const PiiMatrix<T>& img,
+                                                                 int tileRows, int tileColumns,
+                                                                 double clipLimit, int levels)
+{
+  const int iRows = img.rows(), iColumns = img.columns();
+  const int iGridRows = qMax(1, (iRows + tileRows/2) / tileRows);
+  const int iGridColumns = qMax(1, (iColumns + tileColumns/2) / tileColumns);
+  const double dTileHeight = double(iRows) / iGridRows, dTileWidth = double(iColumns) / iGridColumns;
+
+  QVector<QVector<int> > vecMappings;
+  for (int ty=0; ty<iGridRows; ++ty)
+    for (int tx=0; tx<iGridColumns; ++tx)
+      {
+        const int iTop = qBound(0, int(std::floor((ty - 0.5) * dTileHeight)), iRows);
+        const int iBottom = qBound(0, int(std::ceil((ty + 1.5) * dTileHeight)), iRows);
+        const int iLeft = qBound(0, int(std::floor((tx - 0.5) * dTileWidth)), iColumns);
+        const int iRight = qBound(0, int(std::ceil((tx + 1.5) * dTileWidth)), iColumns);
+        QVector<int> vecHistogram(levels);
+        for (int r=iTop; r<iBottom; ++r)
+          for (int c=iLeft; c<iRight; ++c)
+            ++vecHistogram[int(img(r,c))];
+        const int iPixels = (iBottom - iTop) * (iRight - iLeft);
+
+        if (clipLimit > 0)
+          {
+            const int iClip = qMax(1, int(clipLimit * iPixels / levels));
+            int iExcess = 0;
+            for (int i=0; i<levels; ++i)
+              if (vecHistogram[i] > iClip)
+                {
+                  iExcess += vecHistogram[i] - iClip;
+                  vecHistogram[i] = iClip;
+                }
+            for (int i=0; i<levels; ++i)
+              vecHistogram[i] += iExcess / levels;
+            int iResidual = iExcess % levels;
+            if (iResidual > 0)
+              for (int i=0, iStep=qMax(levels / iResidual, 1); i<levels && iResidual > 0; i += iStep, --iResidual)
+                ++vecHistogram[i];
+          }
+
+        QVector<int> vecMapping(levels);
+        const double dScale = double(levels - 1) / iPixels;
+        int iSum = 0;
+        for (int i=0; i<levels; ++i)
+          {
+            iSum += vecHistogram[i];
+            vecMapping[i] = int(iSum * dScale + 0.5);
+          }
+        vecMappings << vecMapping;
+      }
+
+  PiiMatrix<T> matResult(iRows, iColumns);
+  for (int r=0; r<iRows; ++r)
+    {
+      const double dY = (r + 0.5) / dTileHeight - 0.5;
+      const int iY = int(std::floor(dY));
+      const int iY0 = qBound(0, iY, iGridRows-1), iY1 = qBound(0, iY+1, iGridRows-1);
+      for (int c=0; c<iColumns; ++c)
+        {
+          const double dX = (c + 0.5) / dTileWidth - 0.5;
+          const int iX = int(std::floor(dX));
+          const int iX0 = qBound(0, iX, iGridColumns-1), iX1 = qBound(0, iX+1, iGridColumns-1);
+          const int iValue = int(img(r,c));
+          const double dTop = vecMappings[iY0*iGridColumns + iX0][iValue] * (1 - (dX - iX)) +
+            vecMappings[iY0*iGridColumns + iX1][iValue] * (dX - iX);
+          const double dBottom = vecMappings[iY1*iGridColumns + iX0][iValue] * (1 - (dX - iX)) +
+            vecMappings[iY1*iGridColumns + iX1][iValue] * (dX - iX);
+          matResult(r,c) = T(dTop * (1 - (dY - iY)) + dBottom * (dY - iY) + 0.5);
+        }
+    }
+  return matResult;
+}
+
+// Interpolation is done in single precision in the library.
+template <class T> static bool equalsWithinOne(const PiiMatrix<T>& a, const PiiMatrix<T>& b)
+{
+  if (a.rows() != b.rows() || a.columns() != b.columns())
+    return false;
+  for (int r=0; r<a.rows(); ++r)
+    for (int c=0; c<a.columns(); ++c)
+      if (qAbs(int(a(r,c)) - int(b(r,c))) > 1)
+        return false;
+  return true;
+}
+
+void TestPiiImage::adaptiveEqualize()
+{
+  {
+    // A single tile without clipping equals cumulative mapping.
+    PiiMatrix<int> img(4,4,
+                       0,0,0,0,
+                       1,1,1,1,
+                       2,2,2,2,
+                       3,3,3,3);
+    QVERIFY(Pii::equals(PiiImage::adaptiveEqualize(img, 8, 8, 0.0), PiiMatrix<int>(4,4,
+                                                                                  1,1,1,1,
+                                                                                  2,2,2,2,
+                                                                                  2,2,2,2,
+                                                                                  3,3,3,3)));
+  }
+  {
+    // Low-contrast texture on a dark and a bright half.
+    PiiMatrix<unsigned char> img(64,128);
+    for (int r=0; r<64; ++r)
+      for (int c=0; c<128; ++c)
+        img(r,c) = (c < 64 ? 10 : 200) + (r+c) % 11;
+    PiiMatrix<unsigned char> result(PiiImage::adaptiveEqualize(img, 64, 64, 0.0, 256));
+    QCOMPARE(result.rows(), 64);
+    QCOMPARE(result.columns(), 128);
+    PiiMatrix<unsigned char> matLeft(result(0,0,64,20)), matRight(result(0,108,64,20));
+    QVERIFY(Pii::max(matLeft) - Pii::min(matLeft) > 100);
+    QVERIFY(Pii::max(matRight) - Pii::min(matRight) > 100);
+    // More levels than unsigned char can hold are clamped.
+    QVERIFY(Pii::equals(PiiImage::adaptiveEqualize(img, 64, 64, 0.0, 1024), result));
+  }
+  {
+    // Multiple tiles of fractional size. Each mapping must equal one
+    // calculated from scratch over its window.
+    PiiMatrix<unsigned char> img(100,130);
+    for (int r=0; r<img.rows(); ++r)
+      for (int c=0; c<img.columns(); ++c)
+        img(r,c) = (unsigned char)((r * 3 + c * 2 + (r*c) % 17 + (c < 60 ? 0 : 120)) % 256);
+    QVERIFY(equalsWithinOne(PiiImage::adaptiveEqualize(img, 16, 20, 0.0, 256),
+                            referenceAdaptiveEqualize(img, 16, 20, 0.0, 256)));
+    QVERIFY(equalsWithinOne(PiiImage::adaptiveEqualize(img, 16, 20, 2.5, 256),
+                            referenceAdaptiveEqualize(img, 16, 20, 2.5, 256)));
+    QVERIFY(equalsWithinOne(PiiImage::adaptiveEqualize(img, 33, 17, 1.0, 256),
+                            referenceAdaptiveEqualize(img, 33, 17, 1.0, 256)));
+  }
+  {
+    // Clipping limits the slope of the mapping. A single tile with
+    // most pixels on four gray levels and a ramp that covers all
+    // levels.
+    PiiMatrix<unsigned char> img(64,64);
+    for (int r=0; r<64; ++r)
+      for (int c=0; c<64; ++c)
+        img(r,c) = (unsigned char)(r < 60 ? 100 + c % 4 : (r-60) * 64 + c);
+    PiiMatrix<unsigned char> matUnclipped(PiiImage::adaptiveEqualize(img, 64, 64, 0.0, 256));
+    // Output level for each input level
+    QVector<int> vecMapping(256), vecUnclipped(256);
+    const double dClipLimit = 2.0;
+    PiiMatrix<unsigned char> matClipped(PiiImage::adaptiveEqualize(img, 64, 64, dClipLimit, 256));
+    for (int r=0; r<64; ++r)
+      for (int c=0; c<64; ++c)
+        {
+          vecMapping[img(r,c)] = matClipped(r,c);
+          vecUnclipped[img(r,c)] = matUnclipped(r,c);
+        }
+    int iMaxStep = 0, iMaxUnclippedStep = 0;
+    for (int i=1; i<256; ++i)
+      {
+        QVERIFY(vecMapping[i] >= vecMapping[i-1]);
+        iMaxStep = qMax(iMaxStep, vecMapping[i] - vecMapping[i-1]);
+        iMaxUnclippedStep = qMax(iMaxUnclippedStep, vecUnclipped[i] - vecUnclipped[i-1]);
+      }
+    // The average slope is one. Clipped bins hold at most clipLimit
+    // times the average, and redistribution adds at most one average
+    // plus rounding.
+    QVERIFY(iMaxStep <= int(dClipLimit) + 2);
+    QVERIFY(iMaxUnclippedStep > 50);
+  }
+  {
+    // 16-bit input with clipping
+    PiiMatrix<unsigned short> img(50,70);
+    for (int r=0; r<50; ++r)
+      for (int c=0; c<70; ++c)
+        img(r,c) = (unsigned short)(r * 70 + c);
+    PiiMatrix<unsigned short> result(PiiImage::adaptiveEqualize(img, 16, 16, 2.0));
+    QVERIFY(equalsWithinOne(result, referenceAdaptiveEqualize(img, 16, 16, 2.0, 3500)));
+  }
+}
+
+
 void TestPiiImage::histogram()
 {
   //Testing basic functionality of PiiHistogram-class
@@ -1262,6 +1632,201 @@ void TestPiiImage::histogram()
 
 
 }
+
+void TestPiiImage::runLengthRoi()
+{
+  PiiMatrix<bool> matMask(Pii::uniformRandomMatrix(20, 30) > 0.6);
+  PiiRunLengthRoi roi(matMask);
+  QVERIFY(Pii::equals(roi.toMask(), matMask));
+  QCOMPARE(roi.pixelCount(), Pii::sum<int>(matMask));
+  for (int r=0; r<matMask.rows(); ++r)
+    for (int c=0; c<matMask.columns(); ++c)
+      QCOMPARE(roi(r,c), matMask(r,c));
+
+  // Set operations must match mask arithmetic
+  PiiRunLengthRoi rectRoi(20, 30, PiiRectangle<int>(5, 3, 12, 10));
+  PiiMatrix<bool> matRect(PiiImage::createRoiMask(20, 30, PiiMatrix<int>(1, 4, 5, 3, 12, 10)));
+  QVERIFY(Pii::equals(rectRoi.toMask(), matRect));
+  QVERIFY((roi | rectRoi) == PiiRunLengthRoi(PiiMatrix<bool>(matMask || matRect)));
+  QVERIFY((roi & rectRoi) == PiiRunLengthRoi(PiiMatrix<bool>(matMask && matRect)));
+  QVERIFY((roi - rectRoi) == PiiRunLengthRoi(PiiMatrix<bool>(matMask && !matRect)));
+  QVERIFY(~roi == PiiRunLengthRoi(PiiMatrix<bool>(!matMask)));
+  QVERIFY((roi & ~roi).isEmpty());
+
+  PiiRectangle<int> rect = rectRoi.boundingRect();
+  QCOMPARE(rect.x, 5);
+  QCOMPARE(rect.y, 3);
+  QCOMPARE(rect.width, 12);
+  QCOMPARE(rect.height, 10);
+
+  PiiMatrix<int> matRectangles(2, 4,
+                               0, 0, 4, 2,
+                               2, 1, 4, 2);
+  QVERIFY(Pii::equals(PiiRunLengthRoi::fromRectangles(20, 30, matRectangles).toMask(),
+                      PiiImage::createRoiMask(20, 30, matRectangles)));
+
+  // Algorithms must give the same result with masks and spans
+  PiiMatrix<int> matImage(Pii::uniformRandomMatrix(20, 30, 0, 15.99));
+  QVERIFY(Pii::equals(PiiImage::histogram(matImage, roi, 16),
+                      PiiImage::histogram(matImage, matMask, 16)));
+  QVERIFY(Pii::equals(PiiImage::histogram(matImage, PiiImage::DefaultRoi(), 16),
+                      PiiImage::histogram(matImage, 16)));
+  QVERIFY(Pii::equals(PiiImage::threshold(matImage, roi, PiiImage::ThresholdFunction<int>(), 8),
+                      PiiMatrix<int>(PiiImage::threshold(matImage, 8) && matMask)));
+
+  int iSum = 0, iCount = 0;
+  for (int r=0; r<matImage.rows(); ++r)
+    for (int c=0; c<matImage.columns(); ++c)
+      if (matMask(r,c))
+        iSum += matImage(r,c);
+  QCOMPARE(PiiImage::sum<int>(matImage, roi, &iCount), iSum);
+  QCOMPARE(iCount, roi.pixelCount());
+  double dMean = 0;
+  PiiImage::var<double>(matImage, rectRoi, &dMean);
+  QVERIFY(Pii::almostEqualRel(dMean, Pii::mean<double>(matImage(3, 5, 10, 12)), 1e-12));
+}
+
+// Pairwise clustering formerly used in PiiImagePieceJoiner. Returns
+// the same compounds as PiiImage::joinNeighbors(), but indices may be
+// repeated and in a different order.
+static bool isNeighborRect(QRect r1, QRect r2)
+{
+  return !((r2.right() < (r1.left()-1) ||
+            r2.left() > (r1.right()+1) ||
+            r2.bottom() < r1.top() ||
+            r2.top() > r1.bottom()) &&
+           (r2.right() < r1.left() ||
+            r2.left() > r1.right() ||
+            r2.bottom() < (r1.top()-1) ||
+            r2.top() > (r1.bottom())+1));
+}
+
+static void joinNeighborPairs(int index, QLinkedList<QPair<int,int> >& pairs, QList<int>& indices)
+{
+  QList<int> newIndices;
+  QLinkedList<QPair<int,int> >::iterator i = pairs.begin();
+  while (i != pairs.end())
+    {
+      if (i->first == index)
+        {
+          newIndices << i->second;
+          i = pairs.erase(i);
+        }
+      else if (i->second == index)
+        {
+          newIndices << i->first;
+          i = pairs.erase(i);
+        }
+      else
+        i++;
+    }
+  for (int i=newIndices.size(); i--; )
+    if (newIndices[i] != index)
+      joinNeighborPairs(newIndices[i], pairs, indices);
+  indices << newIndices;
+}
+
+static QList<QList<int> > joinNeighborsPairwise(const QList<QRect>& rects, const QList<int>& labels, bool discardZero)
+{
+  QLinkedList<QPair<int,int> > pairs;
+  for (int i=rects.size(); i--; )
+    if (!discardZero || labels[i] != 0)
+      for (int j=i; j--; )
+        if (labels[i] == labels[j] && isNeighborRect(rects[i], rects[j]))
+          pairs << qMakePair(i,j);
+
+  QList<QList<int> > lstResult;
+  while (!pairs.isEmpty())
+    {
+      QList<int> indices;
+      indices << pairs.first().first;
+      joinNeighborPairs(pairs.first().first, pairs, indices);
+      lstResult << indices;
+    }
+  return lstResult;
+}
+
+void TestPiiImage::joinNeighbors()
+{
+  {
+    // Side by side, diagonal and overlapping rectangles
+    QList<QRect> lstRects;
+    lstRects << QRect(0,0,10,10) << QRect(10,0,10,10) << QRect(20,10,10,10)
+             << QRect(25,15,10,10) << QRect(50,50,5,5) << QRect(0,10,10,10);
+    QList<int> lstLabels;
+    lstLabels << 1 << 1 << 1 << 1 << 1 << 2;
+    QList<QList<int> > lstCompounds(PiiImage::joinNeighbors(lstRects, lstLabels));
+    QCOMPARE(lstCompounds.size(), 2);
+    QCOMPARE(lstCompounds[0], QList<int>() << 3 << 2);
+    QCOMPARE(lstCompounds[1], QList<int>() << 1 << 0);
+
+    lstLabels[5] = 1;
+    lstCompounds = PiiImage::joinNeighbors(lstRects, lstLabels);
+    QCOMPARE(lstCompounds.size(), 2);
+    QCOMPARE(lstCompounds[0], QList<int>() << 5 << 1 << 0);
+
+    // Zero labels are discarded only on request
+    lstLabels.clear();
+    lstLabels << 0 << 0 << 0 << 0 << 0 << 0;
+    QCOMPARE(PiiImage::joinNeighbors(lstRects, lstLabels).size(), 2);
+    QCOMPARE(PiiImage::joinNeighbors(lstRects, lstLabels, true).size(), 0);
+  }
+
+  // Compare to the pairwise algorithm with grid-aligned and free-form
+  // rectangles.
+  PiiRandomEngine random(7);
+  for (int iRound=0; iRound<100; ++iRound)
+    {
+      const bool bGrid = iRound % 2 == 0, bDiscardZero = iRound % 4 < 2;
+      QList<QRect> lstRects;
+      QList<int> lstLabels;
+      if (bGrid)
+        {
+          // Like PiiImageSplitter, but some pieces are missing.
+          for (int y=0; y<12; ++y)
+            for (int x=0; x<12; ++x)
+              if (random.uniformInt(4) != 0)
+                {
+                  lstRects << QRect(x*10, y*10, 10, 10);
+                  lstLabels << int(random.uniformInt(3));
+                }
+        }
+      else
+        {
+          for (int i=int(random.uniformInt(150)); i--; )
+            {
+              lstRects << QRect(int(random.uniformInt(200)) - 50, int(random.uniformInt(200)) - 50,
+                                1 + int(random.uniformInt(30)), 1 + int(random.uniformInt(30)));
+              lstLabels << int(random.uniformInt(3));
+            }
+        }
+
+      QList<QList<int> > lstCompounds(PiiImage::joinNeighbors(lstRects, lstLabels, bDiscardZero));
+      QList<QList<int> > lstExpected(joinNeighborsPairwise(lstRects, lstLabels, bDiscardZero));
+      QCOMPARE(lstCompounds.size(), lstExpected.size());
+      for (int i=0; i<lstCompounds.size(); ++i)
+        {
+          // Compounds are in the same order, and the first index
+          // determines the label.
+          QCOMPARE(lstCompounds[i][0], lstExpected[i][0]);
+          QVERIFY(lstCompounds[i].size() > 1);
+          if (bDiscardZero)
+            QVERIFY(lstLabels[lstCompounds[i][0]] != 0);
+          // Transparent compounds are built of the joined pieces.
+          QSet<int> setIndices(lstCompounds[i].toSet());
+          QCOMPARE(setIndices.size(), lstCompounds[i].size());
+          QVERIFY(setIndices == lstExpected[i].toSet());
+          // Opaque compounds use the bounding box.
+          QRect area, expectedArea;
+          for (int j=0; j<lstCompounds[i].size(); ++j)
+            area |= lstRects[lstCompounds[i][j]];
+          for (int j=0; j<lstExpected[i].size(); ++j)
+            expectedArea |= lstRects[lstExpected[i][j]];
+          QCOMPARE(area, expectedArea);
+        }
+    }
+}
+
 void TestPiiImage::cumulative()
 {
   //Testing basic functionality of PiiHistogram-class
@@ -1595,6 +2160,69 @@ void TestPiiImage::labelLargerThan()
                                      1,1,0,0,0)));
 }
 
+void TestPiiImage::distanceTransform()
+{
+  PiiMatrix<int> source(5,5,
+                        1,1,1,1,1,
+                        1,1,1,1,1,
+                        1,1,0,1,1,
+                        1,1,1,1,1,
+                        1,1,1,1,1);
+  PiiMatrix<float> result(PiiImage::distanceTransform(source));
+  QCOMPARE(result(2,2), 0.0f);
+  QCOMPARE(result(2,4), 2.0f);
+  QCOMPARE(result(1,1), float(std::sqrt(2.0)));
+  QCOMPARE(result(0,0), float(std::sqrt(8.0)));
+  QCOMPARE(result(0,3), float(std::sqrt(5.0)));
+
+  result = PiiImage::distanceTransform(source, PiiImage::CityBlockDistance);
+  QCOMPARE(result(0,0), 4.0f);
+  QCOMPARE(result(1,3), 2.0f);
+  result = PiiImage::distanceTransform(source, PiiImage::ChessboardDistance);
+  QCOMPARE(result(0,0), 2.0f);
+  QCOMPARE(result(1,3), 1.0f);
+  result = PiiImage::distanceTransform(source, PiiImage::ChamferDistance);
+  QCOMPARE(result(2,0), 2.0f);
+  QCOMPARE(result(1,1), 4.0f/3);
+
+  // No background
+  result = PiiImage::distanceTransform(PiiMatrix<int>(2,3, 1,1,1, 1,1,1));
+  QCOMPARE(result(1,1), FLT_MAX);
+}
+
+void TestPiiImage::watershed()
+{
+  PiiMatrix<int> relief(3,9,
+                        1,2,3,4,9,4,3,2,1,
+                        1,2,3,4,9,4,3,2,1,
+                        1,2,3,4,9,4,3,2,1);
+  PiiMatrix<int> markers(3,9);
+  markers(1,0) = 1;
+  markers(1,8) = 2;
+
+  QVERIFY(Pii::equals(PiiImage::watershed(relief, markers, PiiImage::Connect4, true),
+                      PiiMatrix<int>(3,9,
+                                     1,1,1,1,0,2,2,2,2,
+                                     1,1,1,1,0,2,2,2,2,
+                                     1,1,1,1,0,2,2,2,2)));
+  // Without lines, the ridge goes to either side.
+  PiiMatrix<int> result(PiiImage::watershed(relief, markers, PiiImage::Connect4, false));
+  QVERIFY(Pii::equals(PiiMatrix<int>(result(0,0,3,4)),
+                      PiiMatrix<int>(3,4, 1,1,1,1, 1,1,1,1, 1,1,1,1)));
+  QVERIFY(Pii::equals(PiiMatrix<int>(result(0,5,3,4)),
+                      PiiMatrix<int>(3,4, 2,2,2,2, 2,2,2,2, 2,2,2,2)));
+  QVERIFY(result(1,4) != 0);
+
+  // Float images use a heap. Negative markers are never flooded.
+  markers(0,2,3,1) = -1;
+  result = PiiImage::watershed(PiiMatrix<float>(relief), markers, PiiImage::Connect8, false);
+  QVERIFY(Pii::equals(result,
+                      PiiMatrix<int>(3,9,
+                                     1,1,0,2,2,2,2,2,2,
+                                     1,1,0,2,2,2,2,2,2,
+                                     1,1,0,2,2,2,2,2,2)));
+}
+
 void TestPiiImage::thin()
 {
   PiiMatrix<int> source(6,6,
@@ -1623,6 +2251,84 @@ void TestPiiImage::thin()
                                             0,0,0,0,0,0)));
 }
 
+// The matrix-based thinning and border detection the bit-packed
+// versions replaced.
+static PiiMatrix<int> referenceThin(const PiiMatrix<int>& image, int amount)
+{
+  PiiMatrix<int> result(image);
+  if (amount >= 0)
+    {
+      while (amount--)
+        for (int m=8; m--; )
+          result.map(PiiImage::BottomhatFunction<int>(),
+                     PiiImage::hitAndMiss(result, PiiImage::borderMasks[m][0], PiiImage::borderMasks[m][1]));
+    }
+  else
+    {
+      PiiMatrix<int> tmpResult(result);
+      forever
+        {
+          for (int m=8; m--; )
+            tmpResult.map(PiiImage::BottomhatFunction<int>(),
+                          PiiImage::hitAndMiss(tmpResult, PiiImage::borderMasks[m][0], PiiImage::borderMasks[m][1]));
+          if (Pii::equals(tmpResult, result))
+            break;
+          result = tmpResult;
+        }
+    }
+  return result;
+}
+
+static PiiMatrix<int> referenceBorder(const PiiMatrix<int>& image)
+{
+  PiiMatrix<int> result(image.rows(), image.columns());
+  for (int m=8; m--; )
+    result |= PiiImage::hitAndMiss(image, PiiImage::borderMasks[m][0], PiiImage::borderMasks[m][1]);
+  return result;
+}
+
+void TestPiiImage::binaryImage()
+{
+  // The object spans two words on each row.
+  PiiMatrix<int> source(5,70);
+  source(1,1,3,68) = 1;
+  PiiBinaryImage image(source);
+  QCOMPARE(image.count(), 3*68);
+  QVERIFY(image.testBit(1,68));
+  QVERIFY(!image.testBit(1,69));
+  QVERIFY(Pii::equals(image.toMatrix<int>(), source));
+
+  PiiMatrix<int> matExpected(5,70);
+  matExpected(2,2,1,66) = 1;
+  QVERIFY(Pii::equals(PiiImage::erode(image, PiiImage::createMask(PiiImage::RectangularMask, 3)).toMatrix<int>(),
+                      matExpected));
+  matExpected = 1;
+  QVERIFY(Pii::equals(PiiImage::dilate(image, PiiImage::createMask(PiiImage::RectangularMask, 3)).toMatrix<int>(),
+                      matExpected));
+
+  // A shape with holes, diagonals and objects crossing word
+  // boundaries, compared against the original hit-and-miss loops.
+  source.resize(24,140);
+  source = 0;
+  source(2,3,12,40) = 1;
+  source(5,10,4,20) = 0;
+  for (int r=0; r<20; ++r)
+    source(r+2,50+r*4,3,6) = 1;
+  for (int r=2; r<22; ++r)
+    for (int c=100; c<138; ++c)
+      if ((r-12)*(r-12)*4 + (c-119)*(c-119) < 360 && (r+c) % 7 != 0)
+        source(r,c) = 1;
+  source(18,1,4,60) = 1;
+  image = PiiBinaryImage(source);
+
+  QVERIFY(Pii::equals(PiiImage::border(image).toMatrix<int>(), referenceBorder(source)));
+  QVERIFY(Pii::equals(PiiImage::border(source), referenceBorder(source)));
+  for (int iAmount=1; iAmount<=3; ++iAmount)
+    QVERIFY(Pii::equals(PiiImage::thin(image, iAmount).toMatrix<int>(), referenceThin(source, iAmount)));
+  QVERIFY(Pii::equals(PiiImage::thin(image, -1).toMatrix<int>(), referenceThin(source, -1)));
+  QVERIFY(Pii::equals(PiiImage::thin(source, -1), referenceThin(source, -1)));
+}
+
 void TestPiiImage::border()
 {
   PiiMatrix<int> source(6,6,
@@ -1990,6 +2696,64 @@ void TestPiiImage::findBoundaries()
                                                      0,0,0,0,0,0,0,0)));
 }
 
+void TestPiiImage::findContours()
+{
+  PiiMatrix<int> objects(5,5,
+                         0,0,0,0,0,
+                         0,1,1,1,0,
+                         0,1,0,1,0,
+                         0,1,1,1,0,
+                         0,0,0,0,0);
+  {
+    PiiMatrix<int> limits;
+    PiiMatrix<double> points(PiiImage::findContours(objects, 0.5, PiiImage::CrackContour,
+                                                    PiiImage::Connect8, &limits));
+    QVERIFY(Pii::equals(limits, PiiMatrix<int>(1,2, 5,10)));
+    // Outer boundary clockwise, hole counter-clockwise
+    QVERIFY(Pii::equals(points, PiiMatrix<double>(10,2,
+                                                  1.0,1.0,
+                                                  4.0,1.0,
+                                                  4.0,4.0,
+                                                  1.0,4.0,
+                                                  1.0,1.0,
+                                                  2.0,2.0,
+                                                  2.0,3.0,
+                                                  3.0,3.0,
+                                                  3.0,2.0,
+                                                  2.0,2.0)));
+
+    PiiMatrix<double> properties(PiiImage::calculateContourProperties(points, limits));
+    QCOMPARE(properties.rows(), 2);
+    QCOMPARE(properties(0,0), 12.0);
+    QCOMPARE(properties(0,1), 9.0);
+    QCOMPARE(properties(0,2), 1.0);
+    QCOMPARE(properties(1,0), 4.0);
+    QCOMPARE(properties(1,1), -1.0);
+  }
+  {
+    PiiMatrix<int> limits;
+    PiiMatrix<double> points(PiiImage::findContours(objects, 0.5, PiiImage::SubPixelContour,
+                                                    PiiImage::Connect8, &limits));
+    // One point per crack plus the closing point
+    QVERIFY(Pii::equals(limits, PiiMatrix<int>(1,2, 13,18)));
+    QCOMPARE(points(0,0), 1.5);
+    QCOMPARE(points(0,1), 1.0);
+    QCOMPARE(points(13,0), 2.0);
+    QCOMPARE(points(13,1), 2.5);
+
+    PiiMatrix<double> properties(PiiImage::calculateContourProperties(points, limits));
+    QCOMPARE(properties(0,1), 8.5);
+    QCOMPARE(properties(1,1), -0.5);
+    QVERIFY(Pii::almostEqualRel(properties(1,0), 2*M_SQRT2));
+
+    // Straight runs collapse to corners
+    PiiMatrix<int> polygonLimits;
+    PiiMatrix<double> polygons(PiiImage::approximatePolygons(points, limits, 0.1, &polygonLimits));
+    QVERIFY(Pii::equals(polygonLimits, PiiMatrix<int>(1,2, 9,14)));
+    QCOMPARE(polygons.rows(), 14);
+  }
+}
+
 void TestPiiImage::threshold()
 {
   QVERIFY(Pii::equals(PiiImage::threshold(_matThreshold, 5),
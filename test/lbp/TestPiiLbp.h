@@ -18,6 +18,7 @@
 
 #include <QObject>
 #include <PiiMatrix.h>
+#include <PiiLbp.h>
 
 class TestPiiLbp : public QObject
 {
@@ -27,12 +28,15 @@ private slots:
   void basicLbp();
   void genericLbp();
   void thresholdedLbp();
+  void roi();
 
 private:
   template <class T> PiiMatrix<T> createRandomImage();
   template <class T> void basicLbp();
   template <class T> void genericLbp();
   template <class T> void thresholdedLbp();
+  template <class T> void roi();
+  template <class T> void roi(PiiLbp& lbp, const PiiMatrix<T>& image, const PiiMatrix<bool>& mask);
 };
 
 
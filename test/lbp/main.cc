@@ -18,6 +18,7 @@
 #include <PiiLbp.h>
 #include <PiiMath.h>
 #include <PiiTypeTraits.h>
+#include <PiiRunLengthRoi.h>
 #include <QtTest>
 
 void TestPiiLbp::basicLbp()
@@ -47,6 +48,13 @@ void TestPiiLbp::thresholdedLbp()
   thresholdedLbp<double>();
 }
 
+void TestPiiLbp::roi()
+{
+  roi<unsigned char>();
+  roi<int>();
+  roi<float>();
+}
+
 template <class T> PiiMatrix<T> TestPiiLbp::createRandomImage()
 {
   PiiMatrix<T> image(256, 256);
@@ -172,4 +180,85 @@ template <class T> void TestPiiLbp::thresholdedLbp()
     }
 }
 
+// Tests the mask pixel by pixel, which makes RoiSpans use its
+// generic implementation.
+struct MaskFunction
+{
+  MaskFunction(const PiiMatrix<bool>& mask) : _mask(mask) {}
+  bool operator() (int r, int c) const { return _mask(r,c); }
+
+private:
+  PiiMatrix<bool> _mask;
+};
+
+template <class T> void TestPiiLbp::roi(PiiLbp& lbp, const PiiMatrix<T>& image, const PiiMatrix<bool>& mask)
+{
+  // Reference: the full feature image, histogrammed pixel by pixel
+  // wherever roi(r,c) is set. Pixels in the margin are never included.
+  PiiMatrix<int> matCodes(lbp.genericLbp<PiiLbp::Image>(image));
+  PiiMatrix<int> matFull(lbp.genericLbp<PiiLbp::Histogram>(image));
+  const int iMargin = (image.rows() - matCodes.rows()) / 2;
+  PiiMatrix<int> matExpected(1, matFull.columns());
+  for (int r=iMargin; r<image.rows()-iMargin; ++r)
+    for (int c=iMargin; c<image.columns()-iMargin; ++c)
+      if (mask(r,c))
+        ++matExpected(0, matCodes(r-iMargin, c-iMargin));
+
+  QVERIFY(Pii::equals(lbp.genericLbp<PiiLbp::Histogram>(image, mask), matExpected));
+  QVERIFY(Pii::equals(lbp.genericLbp<PiiLbp::Histogram>(image, PiiRunLengthRoi(mask)), matExpected));
+  QVERIFY(Pii::equals(lbp.genericLbp<PiiLbp::Histogram>(image, MaskFunction(mask)), matExpected));
+
+  // A full ROI equals no ROI.
+  PiiMatrix<bool> matAll(image.rows(), image.columns());
+  matAll = true;
+  QVERIFY(Pii::equals(lbp.genericLbp<PiiLbp::Histogram>(image, PiiRunLengthRoi(matAll)), matFull));
+  // An empty ROI gives an empty histogram.
+  QCOMPARE(Pii::sum<int>(lbp.genericLbp<PiiLbp::Histogram>(image, PiiRunLengthRoi(PiiMatrix<bool>(image.rows(), image.columns())))), 0);
+}
+
+template <class T> void TestPiiLbp::roi()
+{
+  // Few distinct gray levels make sure equal neighbors occur.
+  PiiMatrix<T> image(256, 256);
+  for (int r=0; r<image.rows(); ++r)
+    for (int c=0; c<image.columns(); ++c)
+      image(r,c) = T(rand() % 16);
+
+  // A random mask with regions that extend over the image borders.
+  // Spans that start or end in the margin must be clipped.
+  PiiMatrix<bool> matMask(image.rows(), image.columns());
+  for (int r=0; r<matMask.rows(); ++r)
+    for (int c=0; c<matMask.columns(); ++c)
+      matMask(r,c) = rand() % 3 == 0;
+  for (int r=0; r<matMask.rows(); ++r)
+    {
+      matMask(r,0) = matMask(r,1) = matMask(r,2) = true;
+      matMask(r,matMask.columns()-1) = matMask(r,matMask.columns()-2) = true;
+    }
+  for (int c=0; c<matMask.columns(); ++c)
+    matMask(0,c) = matMask(1,c) = true;
+  // Rows whose only pixels lie in the margin
+  for (int c=0; c<matMask.columns(); ++c)
+    matMask(100,c) = false;
+  matMask(100,0) = matMask(100,matMask.columns()-1) = true;
+  // A wide span in the middle
+  for (int c=40; c<200; ++c)
+    matMask(120,c) = true;
+
+  PiiLbp lbp1(8, 1, PiiLbp::Standard, Pii::NearestNeighborInterpolation);
+  roi(lbp1, image, matMask);
+  PiiLbp lbp2(8, 1, PiiLbp::Uniform, Pii::NearestNeighborInterpolation);
+  roi(lbp2, image, matMask);
+  PiiLbp lbp3(16, 2, PiiLbp::Standard, Pii::NearestNeighborInterpolation);
+  roi(lbp3, image, matMask);
+  PiiLbp lbp4(8, 1.5, PiiLbp::RotationInvariant, Pii::LinearInterpolation);
+  roi(lbp4, image, matMask);
+  PiiLbp lbp5(8, 1, PiiLbp::Symmetric, Pii::NearestNeighborInterpolation);
+  roi(lbp5, image, matMask);
+  PiiLbp lbp6(8, 2, PiiLbp::Symmetric, Pii::NearestNeighborInterpolation);
+  roi(lbp6, image, matMask);
+  PiiLbp lbp7(8, 2, PiiLbp::Symmetric, Pii::LinearInterpolation);
+  roi(lbp7, image, matMask);
+}
+
 QTEST_MAIN(TestPiiLbp)
@@ -16,6 +16,7 @@
 #include "TestPiiMatching.h"
 
 #include <PiiMatching.h>
+#include <PiiFeaturePointMatcher.h>
 #include <PiiMath.h>
 #include <PiiMatrixUtil.h>
 
@@ -85,4 +86,154 @@ void TestPiiMatching::shapeContextDescriptor()
   }
 }
 
+namespace
+{
+  struct TranslationMerger
+  {
+    bool operator() (const PiiMatching::Match& match1, PiiMatching::Match& match2) const
+    {
+      if (Pii::abs(match1.transformParams()(0,0) - match2.transformParams()(0,0)) > 1)
+        return false;
+      if (match2.matchedPointCount() < match1.matchedPointCount())
+        match2 = match1;
+      return true;
+    }
+  };
+
+  PiiMatching::Match createMatch(int model, double translation, int points)
+  {
+    QList<QPair<int,int> > lstPoints;
+    for (int i=0; i<points; ++i)
+      lstPoints << qMakePair(i,i);
+    return PiiMatching::Match(model, PiiMatrix<double>(1,1, translation), lstPoints);
+  }
+}
+
+void TestPiiMatching::removeDuplicates()
+{
+  PiiMatching::MatchList lstMatches;
+  lstMatches << createMatch(0, 0.0, 3)
+             << createMatch(1, 0.5, 2)
+             << createMatch(0, 0.5, 5)
+             << createMatch(0, 10.0, 1)
+             << createMatch(1, 20.0, 4)
+             << createMatch(1, 1.0, 6);
+
+  TranslationMerger merger;
+  PiiMatching::removeDuplicates(lstMatches, merger);
+
+  QCOMPARE(lstMatches.size(), 4);
+  QCOMPARE(lstMatches[0].modelIndex(), 0);
+  QCOMPARE(lstMatches[0].matchedPointCount(), 5);
+  QCOMPARE(lstMatches[1].modelIndex(), 1);
+  QCOMPARE(lstMatches[1].matchedPointCount(), 6);
+  QCOMPARE(lstMatches[2].modelIndex(), 0);
+  QCOMPARE(lstMatches[2].matchedPointCount(), 1);
+  QCOMPARE(lstMatches[3].modelIndex(), 1);
+  QCOMPARE(lstMatches[3].matchedPointCount(), 4);
+}
+
+namespace
+{
+  // Finds the translation supported by the largest number of point
+  // pairs. Deterministic, which makes the results of serial and
+  // parallel verification comparable.
+  struct TranslationMatcher
+  {
+    bool findBestModel(const PiiMatrix<int>& modelPoints, const PiiMatrix<int>& queryPoints)
+    {
+      vecInliers.clear();
+      for (int i=0; i<modelPoints.rows(); ++i)
+        {
+          const int iDx = queryPoints(i,0) - modelPoints(i,0),
+            iDy = queryPoints(i,1) - modelPoints(i,1);
+          QVector<int> vecSupport;
+          for (int j=0; j<modelPoints.rows(); ++j)
+            if (queryPoints(j,0) - modelPoints(j,0) == iDx &&
+                queryPoints(j,1) - modelPoints(j,1) == iDy)
+              vecSupport << j;
+          if (vecSupport.size() > vecInliers.size())
+            {
+              vecInliers = vecSupport;
+              matModel = PiiMatrix<double>(1,2, double(iDx), double(iDy));
+            }
+        }
+      return vecInliers.size() >= 3;
+    }
+
+    QVector<int> inlyingPoints() const { return vecInliers; }
+    PiiMatrix<double> bestModel() const { return matModel; }
+
+    QVector<int> vecInliers;
+    PiiMatrix<double> matModel;
+  };
+}
+
+void TestPiiMatching::parallelVerification()
+{
+  const int iModels = 6, iModelPoints = 5;
+  PiiMatrix<int> matModelPoints(0,2);
+  PiiMatrix<float> matModelFeatures(0,4);
+  QVector<int> vecModelIndices;
+  for (int m=0; m<iModels; ++m)
+    for (int k=0; k<iModelPoints; ++k)
+      {
+        const int i = m*iModelPoints + k;
+        matModelPoints.appendRow(k*7 + m, k*k + 3*m);
+        matModelFeatures.appendRow(float(i), float(2*i % 11), float(i % 3), 0.0f);
+        vecModelIndices << m;
+      }
+
+  PiiFeaturePointMatcher<int, PiiMatrix<float> > pointMatcher;
+  pointMatcher.buildDatabase(matModelPoints, matModelFeatures, vecModelIndices);
+  pointMatcher.setClosestMatchCount(1);
+
+  // Two instances of model 3, one of models 0 and 2. The points of
+  // different instances are interleaved.
+  const int aInstances[][3] = { { 3, 10, 10 }, { 0, 100, 50 }, { 2, -20, 30 }, { 3, 200, -40 } };
+  PiiMatrix<int> matQueryPoints(0,2);
+  PiiMatrix<float> matQueryFeatures(0,4);
+  for (int k=0; k<iModelPoints; ++k)
+    for (int i=0; i<4; ++i)
+      {
+        const int iRow = aInstances[i][0] * iModelPoints + k;
+        matQueryPoints.appendRow(matModelPoints(iRow,0) + aInstances[i][1],
+                                 matModelPoints(iRow,1) + aInstances[i][2]);
+        matQueryFeatures.appendRow(matModelFeatures[iRow]);
+      }
+  // Noise points that match no model consistently.
+  for (int k=0; k<4; ++k)
+    {
+      matQueryPoints.appendRow(500 + 13*k, 300 - 11*k);
+      matQueryFeatures.appendRow(float(1000 + k), 0.0f, 0.0f, 0.0f);
+    }
+
+  TranslationMatcher serialMatcher;
+  PiiMatching::MatchList lstSerial = pointMatcher.findMatchingModels(matQueryPoints,
+                                                                     matQueryFeatures,
+                                                                     serialMatcher);
+  QCOMPARE(lstSerial.size(), 4);
+  QCOMPARE(lstSerial[0].modelIndex(), 3);
+  QCOMPARE(lstSerial[1].modelIndex(), 3);
+  for (int i=0; i<lstSerial.size(); ++i)
+    QCOMPARE(lstSerial[i].matchedPointCount(), iModelPoints);
+
+  TranslationMatcher aMatchers[4];
+  TranslationMatcher* pMatchers[] = { &aMatchers[0], &aMatchers[1], &aMatchers[2], &aMatchers[3] };
+  for (int iThreads=2; iThreads<=4; ++iThreads)
+    {
+      PiiMatching::MatchList lstParallel = pointMatcher.findMatchingModels(matQueryPoints,
+                                                                           matQueryFeatures,
+                                                                           pMatchers,
+                                                                           iThreads);
+      QCOMPARE(lstParallel.size(), lstSerial.size());
+      for (int i=0; i<lstSerial.size(); ++i)
+        {
+          QCOMPARE(lstParallel[i].modelIndex(), lstSerial[i].modelIndex());
+          QVERIFY(Pii::equals(lstParallel[i].transformParams(), lstSerial[i].transformParams()));
+          QVERIFY(lstParallel[i].matchedPoints() == lstSerial[i].matchedPoints());
+        }
+    }
+}
+
 QTEST_MAIN(TestPiiMatching)
@@ -81,6 +81,7 @@ private slots:
   void forEachIf();
   void mapIf();
   void eigen();
+  void eigenDivideAndConquer();
   void hypotenuse();
   void realAndImag();
   void isSquare();
@@ -89,6 +90,7 @@ private slots:
   void svd();
   void pca();
   void plu();
+  void random();
   void numeric();
   void angleDiff();
 
@@ -26,10 +26,12 @@ using std::endl;
 #include "TestPiiMath.h"
 #include <PiiMatrixUtil.h>
 #include <PiiPseudoInverse.h>
+#include <PiiMathEigenSystem.h>
 #include <PiiMath.h>
 #include <QtTest>
 #include <algorithm>
 #include <PiiVector.h>
+#include <PiiRandom.h>
 #include <cstdlib>
 #include <ctime>
 
@@ -1630,6 +1632,110 @@ void TestPiiMath::eigen()
 #endif
 }
 
+// Reflects a symmetric matrix with a Householder matrix. The
+// eigenvalues are retained, but the matrix becomes dense.
+static PiiMatrix<double> reflectSymmetric(const PiiMatrix<double>& mat, int seed)
+{
+  const int n = mat.rows();
+  PiiMatrix<double> matV(n,1);
+  double dNorm = 0;
+  for (int i=0; i<n; ++i)
+    {
+      matV(i,0) = ::sin(seed * (i+1) * 0.7) + 0.1;
+      dNorm += matV(i,0) * matV(i,0);
+    }
+  PiiMatrix<double> matH(PiiMatrix<double>::identity(n) - matV * Pii::transpose(matV) * (2.0 / dNorm));
+  PiiMatrix<double> matResult(matH * mat * matH);
+  // Make the result exactly symmetric.
+  for (int r=0; r<n; ++r)
+    for (int c=0; c<r; ++c)
+      matResult(r,c) = matResult(c,r) = 0.5 * (matResult(r,c) + matResult(c,r));
+  return matResult;
+}
+
+// Checks |A*V - V*D| and |V'*V - I|.
+static bool checkSymmetricEigensystem(const PiiMatrix<double>& mat)
+{
+  const int n = mat.rows();
+  Pii::EigenSystem<double,double> eigensystem;
+  eigensystem.solve(mat);
+  const PiiMatrix<double>& matV = eigensystem.eigenvectors();
+  const PiiMatrix<double>& matD = eigensystem.eigenvaluesR();
+  if (matV.rows() != n || matV.columns() != n)
+    return false;
+
+  const PiiMatrix<double> matAV(mat * matV), matVV(Pii::transpose(matV) * matV);
+  double dMaxElement = 1.0;
+  for (int r=0; r<n; ++r)
+    for (int c=0; c<n; ++c)
+      dMaxElement = qMax(dMaxElement, Pii::abs(mat(r,c)));
+  const double dTolerance = 1e-10 * dMaxElement;
+  for (int r=0; r<n; ++r)
+    for (int c=0; c<n; ++c)
+      {
+        if (Pii::abs(matAV(r,c) - matV(r,c) * matD(0,c)) > dTolerance)
+          return false;
+        if (Pii::abs(matVV(r,c) - (r == c ? 1.0 : 0.0)) > 1e-10)
+          return false;
+      }
+  // Eigenvalues must be in ascending order.
+  for (int i=1; i<n; ++i)
+    if (matD(0,i) < matD(0,i-1) || eigensystem.eigenvaluesI()(0,i) != 0)
+      return false;
+  return true;
+}
+
+void TestPiiMath::eigenDivideAndConquer()
+{
+  // Symmetric matrices with n >= 64 are diagonalized with divide
+  // and conquer.
+  {
+    const int n = 100;
+    PiiMatrix<double> mat(n,n);
+    for (int r=0; r<n; ++r)
+      for (int c=0; c<=r; ++c)
+        mat(r,c) = mat(c,r) = ::cos(0.37*r*c + r + 0.5*c);
+    QVERIFY(checkSymmetricEigensystem(mat));
+  }
+  // Two identical blocks: every eigenvalue is repeated (deflation).
+  {
+    const int n = 96, h = n/2;
+    PiiMatrix<double> mat(n,n);
+    for (int r=0; r<h; ++r)
+      for (int c=0; c<=r; ++c)
+        {
+          const double dValue = ::sin(1.3*r + 0.7*c*c);
+          mat(r,c) = mat(c,r) = mat(r+h,c+h) = mat(c+h,r+h) = dValue;
+        }
+    QVERIFY(checkSymmetricEigensystem(reflectSymmetric(reflectSymmetric(mat, 1), 2)));
+  }
+  // Only four distinct eigenvalues.
+  {
+    const int n = 80;
+    PiiMatrix<double> mat(n,n);
+    for (int i=0; i<n; ++i)
+      mat(i,i) = i % 4;
+    QVERIFY(checkSymmetricEigensystem(reflectSymmetric(reflectSymmetric(mat, 3), 5)));
+  }
+  // Tridiagonal matrices with constant off-diagonal signs. The sign
+  // of the off-diagonal determines the sign of rho in every rank-one
+  // merge, so both positive and negative rho are covered.
+  for (int iSign=-1; iSign<=1; iSign+=2)
+    {
+      const int n = 80;
+      PiiMatrix<double> mat(n,n);
+      for (int i=0; i<n; ++i)
+        {
+          mat(i,i) = 2 + 0.01*i;
+          if (i > 0)
+            mat(i,i-1) = mat(i-1,i) = iSign;
+        }
+      QVERIFY(checkSymmetricEigensystem(mat));
+    }
+  // All eigenvalues equal.
+  QVERIFY(checkSymmetricEigensystem(PiiMatrix<double>::identity(64)));
+}
+
 void TestPiiMath::isSquare()
 {
   QVERIFY( Pii::isSquare(PiiMatrix<double>(1,2)) == false );
@@ -2047,6 +2153,52 @@ void TestPiiMath::plu()
   #endif
 }
 
+void TestPiiMath::random()
+{
+  {
+    // The same seed and stream produce the same sequence, different
+    // streams different sequences.
+    PiiRandomEngine engine1(123, 1), engine2(123, 1), engine3(123, 2);
+    for (int i=0; i<10; ++i)
+      {
+        quint64 iValue = engine1.next();
+        QCOMPARE(iValue, engine2.next());
+        QVERIFY(iValue != engine3.next());
+      }
+  }
+  {
+    Pii::seedRandom(7);
+    PiiMatrix<double> mat1(Pii::uniformRandomMatrix(300, 300, -1.0, 1.0));
+    Pii::seedRandom(7);
+    PiiMatrix<double> mat2(Pii::uniformRandomMatrix(300, 300, -1.0, 1.0));
+    QVERIFY(Pii::equals(mat1, mat2));
+    QVERIFY(Pii::min(mat1) >= -1.0);
+    QVERIFY(Pii::max(mat1) < 1.0);
+    QVERIFY(qAbs(Pii::mean<double>(mat1)) < 0.01);
+  }
+  {
+    PiiMatrix<double> mat(Pii::normalRandomMatrix(500, 400));
+    double dMean = 0;
+    double dVar = Pii::var<double>(mat, &dMean);
+    QVERIFY(qAbs(dMean) < 0.01);
+    QVERIFY(qAbs(dVar - 1.0) < 0.01);
+  }
+  {
+    PiiRandomEngine engine(5);
+    int aCounts[5] = { 0, 0, 0, 0, 0 };
+    for (int i=0; i<50000; ++i)
+      ++aCounts[engine.uniformInt(5)];
+    for (int i=0; i<5; ++i)
+      QVERIFY(qAbs(aCounts[i] - 10000) < 500);
+  }
+  {
+    QVector<int> vecIndices(Pii::selectRandomly(10, 100));
+    QCOMPARE(vecIndices.size(), 10);
+    for (int i=1; i<vecIndices.size(); ++i)
+      QVERIFY(vecIndices[i] > vecIndices[i-1]);
+  }
+}
+
 void TestPiiMath::numeric()
 {
 #define TEST_INTEGER_TYPE(type)                                         \
@@ -43,6 +43,7 @@ private slots:
   void reserve();
   void mapped();
   void map();
+  void traffic();
 
 private:
   template <class Matrix> void setTo(Matrix& matrix, typename Matrix::value_type value);
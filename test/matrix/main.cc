@@ -992,4 +992,38 @@ void TestPiiMatrix::map()
   QVERIFY(Pii::equals(mat, PiiMatrix<int>::constant(3,3, 1)));
 }
 
+void TestPiiMatrix::traffic()
+{
+  PiiMatrixTraffic traffic;
+  PiiMatrixTraffic* pPrevious = PiiMatrixData::setThreadTraffic(&traffic);
+  if (PiiMatrixData::threadTraffic() != &traffic)
+    QSKIP("Thread-local storage is not supported."
+#if QT_VERSION < 0x050000
+          , SkipAll
+#endif
+          );
+  {
+    PiiMatrix<int> mat(4, 4);
+    QCOMPARE(traffic.iAllocations, qint64(1));
+    QCOMPARE(traffic.iAllocatedBytes, qint64(4 * 4 * sizeof(int)));
+
+    // Shallow copy, no traffic
+    PiiMatrix<int> mat2(mat);
+    QCOMPARE(traffic.iAllocations, qint64(1));
+    QCOMPARE(traffic.iClones, qint64(0));
+
+    // Detaching clones the data
+    mat2(0,0) = 1;
+    QCOMPARE(traffic.iAllocations, qint64(2));
+    QCOMPARE(traffic.iClones, qint64(1));
+    QCOMPARE(traffic.iCopiedBytes, qint64(4 * 4 * sizeof(int)));
+  }
+  QCOMPARE(traffic.iReleases, qint64(2));
+  PiiMatrixData::setThreadTraffic(pPrevious);
+
+  // Uninstalled counters are not touched.
+  PiiMatrix<int> mat3(2, 2);
+  QCOMPARE(traffic.iAllocations, qint64(2));
+}
+
 QTEST_MAIN(TestPiiMatrix)
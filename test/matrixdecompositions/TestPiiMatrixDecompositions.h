@@ -26,6 +26,7 @@ private slots:
   void qrDecompose();
   void bdDecompose();
   void svDecompose();
+  void principalComponents();
 
 private:
   void unpackRowReflectors(const PiiMatrix<double>& mat, int diagonal);
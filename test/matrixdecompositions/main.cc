@@ -20,6 +20,7 @@
 #include <PiiQrDecomposition.h>
 #include <PiiBdDecomposition.h>
 #include <PiiSvDecomposition.h>
+#include <PiiPrincipalComponents.h>
 #include <QtTest>
 #include <PiiRandom.h>
 
@@ -301,6 +302,89 @@ void TestPiiMatrixDecompositions::svDecompose()
 
     QVERIFY(Pii::almostEqual(mat, U*matS*Pii::transpose(V), 1e-7));
   }
+
+  {
+    // One-sided Jacobi must agree with the default algorithm.
+    PiiMatrix<double> mat(Pii::uniformRandomMatrix(40, 25, -1.0, 1.0));
+    PiiMatrix<double> S = Pii::svDecompose(mat);
+
+    for (int iTranspose=0; iTranspose<2; ++iTranspose)
+      {
+        PiiMatrix<double> matA = iTranspose ? PiiMatrix<double>(Pii::transpose(mat)) : mat;
+        PiiMatrix<double> U, V, S2;
+        S2 = Pii::svDecompose(matA, &U, &V, Pii::SvdOneSidedJacobi);
+        QCOMPARE(U.columns(), 25);
+        QCOMPARE(V.columns(), 25);
+        QVERIFY(Pii::almostEqual(S, S2, 1e-12));
+
+        PiiMatrix<double> matS(25,25);
+        Pii::setDiagonal(matS, S2[0]);
+        QVERIFY(Pii::almostEqual(matA, U*matS*Pii::transpose(V), 1e-12));
+        QVERIFY(Pii::almostEqual(Pii::transpose(U)*U, PiiMatrix<double>::identity(25), 1e-12));
+        QVERIFY(Pii::almostEqual(Pii::transpose(V)*V, PiiMatrix<double>::identity(25), 1e-12));
+
+        S2 = Pii::svDecompose(matA, &U, &V, Pii::SvdOneSidedJacobi | Pii::SvdFullU | Pii::SvdFullV);
+        QCOMPARE(U.columns(), matA.rows());
+        QCOMPARE(V.columns(), matA.columns());
+        QVERIFY(Pii::almostEqual(Pii::transpose(U)*U, PiiMatrix<double>::identity(U.rows()), 1e-12));
+      }
+  }
+}
+
+void TestPiiMatrixDecompositions::principalComponents()
+{
+  // Random data with a known spectrum in a random orientation
+  const int iDims = 6;
+  const double aScales[iDims] = { 10, 5, 2, 1, 0.5, 0.1 };
+  PiiMatrix<double> matData(Pii::normalRandomMatrix(600, iDims));
+  for (int c=0; c<iDims; ++c)
+    for (int r=0; r<matData.rows(); ++r)
+      matData(r,c) *= aScales[c];
+  matData = matData * Pii::qrDecompose(Pii::normalRandomMatrix(iDims, iDims));
+  matData += 3.0;
+
+  PiiMatrix<double> matMean;
+  PiiMatrix<double> matCovariance(Pii::covariance(matData, &matMean));
+
+  // Feed the data in batches to two accumulators and merge them.
+  PiiIncrementalPca<double> pca, pca2;
+  for (int r=0; r<300; r+=100)
+    pca.addSamples(matData(r,0,100,-1));
+  for (int r=300; r<600; r+=50)
+    pca2.addSamples(matData(r,0,50,-1));
+  pca.merge(pca2);
+  QCOMPARE(pca.sampleCount(), 600);
+  QVERIFY(Pii::almostEqual(pca.mean(), matMean, 1e-10));
+  QVERIFY(Pii::almostEqual(pca.covariance(), matCovariance, 1e-9));
+
+  PiiMatrix<double> matOriginal(matData);
+  Pii::subtractMean(matData);
+  PiiMatrix<double> matS;
+  PiiMatrix<double> matFull(Pii::principalComponents(matData, &matS));
+
+  PiiMatrix<double> matVariances;
+  PiiMatrix<double> matBase(pca.components(3, &matVariances));
+  QCOMPARE(matBase.rows(), iDims);
+  QCOMPARE(matBase.columns(), 3);
+  QVERIFY(Pii::almostEqual(pca.project(matOriginal, matBase), matData * matBase, 1e-9));
+
+  PiiMatrix<double> matRandomS;
+  PiiMatrix<double> matRandomized(Pii::randomizedPrincipalComponents(matData, 3, &matRandomS));
+  QCOMPARE(matRandomized.columns(), 3);
+  for (int i=0; i<3; ++i)
+    {
+      double dDot = 0, dRandomDot = 0;
+      for (int r=0; r<iDims; ++r)
+        {
+          dDot += matBase(r,i) * matFull(r,i);
+          dRandomDot += matRandomized(r,i) * matFull(r,i);
+        }
+      // The sign of a component is arbitrary.
+      QVERIFY(Pii::almostEqualRel(Pii::abs(dDot), 1.0, 1e-6));
+      QVERIFY(Pii::almostEqualRel(Pii::abs(dRandomDot), 1.0, 1e-4));
+      QVERIFY(Pii::almostEqualRel(matVariances(0,i), matS(0,i)*matS(0,i) / 599, 1e-6));
+      QVERIFY(Pii::almostEqualRel(matRandomS(0,i), matS(0,i), 1e-6));
+    }
 }
 
 QTEST_MAIN(TestPiiMatrixDecompositions)
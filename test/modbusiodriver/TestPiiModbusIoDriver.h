@@ -0,0 +1,84 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _TESTPIIMODBUSIODRIVER_H
+#define _TESTPIIMODBUSIODRIVER_H
+
+#include <QObject>
+#include <QThread>
+#include <QAtomicInt>
+#include <QVector>
+#include <PiiModbusIoDriver.h>
+#include <modbus.h>
+
+// A local Modbus TCP server that counts requests by function code.
+class ModbusServer : public QThread
+{
+  Q_OBJECT
+
+public:
+  ModbusServer(int port);
+  ~ModbusServer();
+
+  bool listen();
+  int requestCount(int function) const;
+  void resetCounts();
+
+  modbus_mapping_t* mapping() const { return _pMapping; }
+
+protected:
+  void run();
+
+private:
+  modbus_t* _pContext;
+  modbus_mapping_t* _pMapping;
+  int _iSocket;
+  mutable QAtomicInt _aCounts[256];
+};
+
+// A driver that counts the polling rounds of the I/O thread and the
+// requests it sends to *server* with the given function codes during
+// each round.
+class CountingModbusDriver : public PiiModbusIoDriver
+{
+public:
+  CountingModbusDriver(ModbusServer* server, const QVector<int>& functions);
+
+  void beginIoCycle();
+  void endIoCycle();
+
+  int rounds() const;
+  int maxRequestsPerRound() const;
+  void resetCounts();
+
+private:
+  int requestCount() const;
+
+  ModbusServer* _pServer;
+  QVector<int> _vecFunctions;
+  int _iRequestsAtBegin;
+  mutable QAtomicInt _iRounds, _iMaxRequestsPerRound;
+};
+
+class TestPiiModbusIoDriver : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void readInputs();
+  void coalesceOutputs();
+};
+
+#endif //_TESTPIIMODBUSIODRIVER_H
@@ -0,0 +1 @@
+DEPENDENCIES = Io
@@ -0,0 +1,266 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "TestPiiModbusIoDriver.h"
+
+#include <QtTest>
+#include <PiiDelay.h>
+#include <PiiModbusIoChannel.h>
+#include <unistd.h>
+
+static const int iTestPort = 15502;
+
+ModbusServer::ModbusServer(int port) :
+  _pContext(modbus_new_tcp("127.0.0.1", port)),
+  _pMapping(modbus_mapping_new(256, 256, 0, 0)),
+  _iSocket(-1)
+{
+}
+
+ModbusServer::~ModbusServer()
+{
+  wait();
+  if (_iSocket != -1)
+    ::close(_iSocket);
+  modbus_mapping_free(_pMapping);
+  modbus_free(_pContext);
+}
+
+bool ModbusServer::listen()
+{
+  _iSocket = modbus_tcp_listen(_pContext, 1);
+  if (_iSocket == -1)
+    return false;
+  start();
+  return true;
+}
+
+void ModbusServer::run()
+{
+  if (modbus_tcp_accept(_pContext, &_iSocket) == -1)
+    return;
+
+  const int iHeaderLength = modbus_get_header_length(_pContext);
+  uint8_t aQuery[MODBUS_TCP_MAX_ADU_LENGTH];
+  forever
+    {
+      const int iLength = modbus_receive(_pContext, aQuery);
+      // The client closed the connection.
+      if (iLength == -1)
+        break;
+      if (iLength == 0)
+        continue;
+      _aCounts[aQuery[iHeaderLength]].ref();
+      modbus_reply(_pContext, aQuery, iLength, _pMapping);
+    }
+  modbus_close(_pContext);
+}
+
+int ModbusServer::requestCount(int function) const
+{
+  return _aCounts[function].fetchAndAddRelaxed(0);
+}
+
+void ModbusServer::resetCounts()
+{
+  for (int i=0; i<256; ++i)
+    _aCounts[i].fetchAndStoreRelaxed(0);
+}
+
+CountingModbusDriver::CountingModbusDriver(ModbusServer* server, const QVector<int>& functions) :
+  _pServer(server),
+  _vecFunctions(functions),
+  _iRequestsAtBegin(0)
+{
+}
+
+void CountingModbusDriver::beginIoCycle()
+{
+  _iRequestsAtBegin = requestCount();
+  PiiModbusIoDriver::beginIoCycle();
+}
+
+void CountingModbusDriver::endIoCycle()
+{
+  PiiModbusIoDriver::endIoCycle();
+  const int iRequests = requestCount() - _iRequestsAtBegin;
+  if (iRequests > maxRequestsPerRound())
+    _iMaxRequestsPerRound.fetchAndStoreRelaxed(iRequests);
+  _iRounds.ref();
+}
+
+int CountingModbusDriver::rounds() const
+{
+  return _iRounds.fetchAndAddRelaxed(0);
+}
+
+int CountingModbusDriver::maxRequestsPerRound() const
+{
+  return _iMaxRequestsPerRound.fetchAndAddRelaxed(0);
+}
+
+void CountingModbusDriver::resetCounts()
+{
+  _iRounds.fetchAndStoreRelaxed(0);
+  _iMaxRequestsPerRound.fetchAndStoreRelaxed(0);
+}
+
+int CountingModbusDriver::requestCount() const
+{
+  int iCount = 0;
+  for (int i=0; i<_vecFunctions.size(); ++i)
+    iCount += _pServer->requestCount(_vecFunctions[i]);
+  return iCount;
+}
+
+// Polls *condition* until it holds or *timeout* milliseconds have
+// passed.
+template <class Condition> static bool waitFor(Condition condition, int timeout = 5000)
+{
+  QTime time;
+  time.start();
+  while (!condition())
+    {
+      if (time.elapsed() > timeout)
+        return false;
+      PiiDelay::msleep(1);
+    }
+  return true;
+}
+
+struct RoundsDone
+{
+  RoundsDone(const CountingModbusDriver& driver, int rounds) : _driver(driver), _iRounds(rounds) {}
+  bool operator() () const { return _driver.rounds() >= _iRounds; }
+
+  const CountingModbusDriver& _driver;
+  int _iRounds;
+};
+
+struct SignalsReceived
+{
+  SignalsReceived(const QSignalSpy& spy, int count) : _spy(spy), _iCount(count) {}
+  bool operator() () const { return _spy.count() >= _iCount; }
+
+  const QSignalSpy& _spy;
+  int _iCount;
+};
+
+struct CoilsEqual
+{
+  CoilsEqual(const ModbusServer& server, int first, int count, int value) :
+    _server(server), _iFirst(first), _iCount(count), _iValue(value)
+  {}
+  bool operator() () const
+  {
+    for (int i=0; i<_iCount; ++i)
+      if (int(_server.mapping()->tab_bits[_iFirst + i]) != _iValue)
+        return false;
+    return true;
+  }
+
+  const ModbusServer& _server;
+  int _iFirst, _iCount, _iValue;
+};
+
+void TestPiiModbusIoDriver::readInputs()
+{
+  ModbusServer server(iTestPort);
+  QVERIFY(server.listen());
+
+  CountingModbusDriver driver(&server, QVector<int>() << MODBUS_FC_READ_DISCRETE_INPUTS);
+  QVERIFY(driver.selectUnit(QString("127.0.0.1:%1").arg(iTestPort)));
+  QVERIFY(driver.initialize());
+
+  // 32 inputs in two separate address ranges
+  QList<PiiModbusIoChannel*> lstChannels;
+  for (int i=0; i<32; ++i)
+    {
+      PiiModbusIoChannel* pChannel = static_cast<PiiModbusIoChannel*>(driver.channel(i));
+      pChannel->setChannelMode(PiiDefaultIoChannel::Input);
+      pChannel->setAddress(i < 16 ? i : 100 + i);
+      pChannel->initializeChannel();
+      lstChannels << pChannel;
+    }
+  QSignalSpy spy(lstChannels[20], SIGNAL(inputStateChanged(bool)));
+
+  server.resetCounts();
+  driver.resetCounts();
+  // Let the I/O thread see the initial state before changing it.
+  QVERIFY(waitFor(RoundsDone(driver, 2)));
+  server.mapping()->tab_input_bits[120] = 1;
+  QVERIFY(waitFor(SignalsReceived(spy, 1)));
+  const int iRounds = driver.rounds();
+  const int iReads = server.requestCount(MODBUS_FC_READ_DISCRETE_INPUTS);
+
+  // One request for each range on each round instead of one for
+  // each channel. The first round may have started before the counts
+  // were reset.
+  QVERIFY(iReads > 0);
+  QVERIFY2(iReads <= 2 * (iRounds + 1), qPrintable(QString("%1 reads in %2 rounds").arg(iReads).arg(iRounds)));
+  QVERIFY2(driver.maxRequestsPerRound() <= 2, qPrintable(QString("%1 reads in a round").arg(driver.maxRequestsPerRound())));
+  QCOMPARE(spy.count(), 1);
+
+  // Reads outside of the I/O thread go directly to the device.
+  server.resetCounts();
+  QVERIFY(lstChannels[20]->currentState());
+  QVERIFY(!lstChannels[0]->currentState());
+  QVERIFY(server.requestCount(MODBUS_FC_READ_DISCRETE_INPUTS) >= 2);
+
+  driver.close();
+}
+
+void TestPiiModbusIoDriver::coalesceOutputs()
+{
+  ModbusServer server(iTestPort + 1);
+  QVERIFY(server.listen());
+
+  CountingModbusDriver driver(&server, QVector<int>() << MODBUS_FC_WRITE_SINGLE_COIL << MODBUS_FC_WRITE_MULTIPLE_COILS);
+  QVERIFY(driver.selectUnit(QString("127.0.0.1:%1").arg(iTestPort + 1)));
+  QVERIFY(driver.initialize());
+
+  QList<PiiModbusIoChannel*> lstChannels;
+  for (int i=0; i<8; ++i)
+    {
+      PiiModbusIoChannel* pChannel = static_cast<PiiModbusIoChannel*>(driver.channel(i));
+      pChannel->setChannelMode(PiiDefaultIoChannel::Output);
+      pChannel->setAddress(10 + i);
+      pChannel->setPulseWidth(50);
+      pChannel->initializeChannel();
+      lstChannels << pChannel;
+    }
+
+  server.resetCounts();
+  driver.resetCounts();
+  for (int i=0; i<lstChannels.size(); ++i)
+    lstChannels[i]->activate();
+  QVERIFY(waitFor(CoilsEqual(server, 10, lstChannels.size(), 1)));
+  QVERIFY(waitFor(CoilsEqual(server, 10, lstChannels.size(), 0)));
+  // Let the round that cleared the coils finish.
+  QVERIFY(waitFor(RoundsDone(driver, driver.rounds() + 1)));
+
+  // The rising and falling edges are 50 ms apart and never in the
+  // same round. Each round sends all of its edges to the consecutive
+  // coils with a single request, however many edges there are.
+  const int iWrites = server.requestCount(MODBUS_FC_WRITE_SINGLE_COIL) +
+    server.requestCount(MODBUS_FC_WRITE_MULTIPLE_COILS);
+  QVERIFY(iWrites >= 2);
+  QVERIFY2(iWrites <= driver.rounds(), qPrintable(QString("%1 write requests in %2 rounds").arg(iWrites).arg(driver.rounds())));
+  QVERIFY2(driver.maxRequestsPerRound() == 1, qPrintable(QString("%1 write requests in a round").arg(driver.maxRequestsPerRound())));
+
+  driver.close();
+}
+
+QTEST_MAIN(TestPiiModbusIoDriver)
@@ -0,0 +1,3 @@
+include(../unit_test.pri)
+INCLUDEPATH += $$INTODIR/modules/io/modbus $$INTODIR/3rdparty/modbus/include
+LIBS += -lpiimodbusiodriver$$INTO_LIBV -L$$INTODIR/3rdparty/modbus/lib -lmodbus
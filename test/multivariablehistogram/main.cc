@@ -0,0 +1,215 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "TestPiiMultiVariableHistogram.h"
+
+#include <PiiMath.h>
+#include <PiiUtil.h>
+#include <QtTest>
+
+enum { JointDistribution, MarginalDistributions };
+
+// Builds a histogram pixel by pixel as documented in
+// PiiMultiVariableHistogram.
+static PiiMatrix<int> referenceHistogram(const QList<PiiMatrix<double> >& inputs,
+                                         const QVector<int>& levels,
+                                         const QVector<double>& scales,
+                                         bool joint)
+{
+  int iLength = joint ? 1 : 0;
+  for (int k=0; k<levels.size(); ++k)
+    iLength = joint ? iLength * levels[k] : iLength + levels[k];
+  PiiMatrix<int> matResult(1, iLength);
+
+  for (int r=0; r<inputs[0].rows(); ++r)
+    for (int c=0; c<inputs[0].columns(); ++c)
+      {
+        int iIndex = 0, iStep = 1, iOffset = 0;
+        for (int k=0; k<inputs.size(); ++k)
+          {
+            const double dValue = inputs[k](r,c);
+            int iBin = scales.size() > k && scales[k] != 1 ?
+              Pii::round<int>(dValue * scales[k]) : int(dValue);
+            iBin = qBound(0, iBin, levels[k]-1);
+            if (joint)
+              {
+                iIndex += iBin * iStep;
+                iStep *= levels[k];
+              }
+            else
+              {
+                ++matResult(0, iOffset + iBin);
+                iOffset += levels[k];
+              }
+          }
+        if (joint)
+          ++matResult(0, iIndex);
+      }
+  return matResult;
+}
+
+void TestPiiMultiVariableHistogram::initTestCase()
+{
+  QVERIFY(createOperation("piistatistics", "PiiMultiVariableHistogram"));
+  // Process in the sender's thread so that the output is available
+  // immediately.
+  operation()->setProperty("threadCount", 0);
+}
+
+void TestPiiMultiVariableHistogram::setLevels(const QVariantList& levels)
+{
+  disconnectAllInputs();
+  operation()->setProperty("levels", levels);
+  connectAllInputs();
+}
+
+void TestPiiMultiVariableHistogram::jointDistribution()
+{
+  setLevels(QVariantList() << 4 << 4 << 4);
+  operation()->setProperty("scales", QVariantList());
+  operation()->setProperty("distributionType", int(JointDistribution));
+  QVERIFY(start());
+
+  // The example in the class documentation
+  QVERIFY(sendObject("matrix0", PiiMatrix<int>(2,2, 0,1, 2,3)));
+  QVERIFY(sendObject("matrix1", PiiMatrix<int>(2,2, 1,0, 2,3)));
+  QVERIFY(sendObject("matrix2", PiiMatrix<int>(2,2, 3,2, 0,1)));
+
+  PiiMatrix<int> matExpected(1,64);
+  matExpected(0, 0 + 4*1 + 16*3) = 1;
+  matExpected(0, 1 + 4*0 + 16*2) = 1;
+  matExpected(0, 2 + 4*2 + 16*0) = 1;
+  matExpected(0, 3 + 4*3 + 16*1) = 1;
+  QVERIFY(Pii::equals(outputValue("histogram", PiiMatrix<int>()), matExpected));
+
+  // Different input types, values out of range.
+  QVERIFY(sendObject("matrix0", PiiMatrix<unsigned char>(1,3, 0,3,255)));
+  QVERIFY(sendObject("matrix1", PiiMatrix<short>(1,3, -5,1,4)));
+  QVERIFY(sendObject("matrix2", PiiMatrix<double>(1,3, 0.9,-0.5,7.0)));
+  matExpected = 0;
+  matExpected(0, 0 + 4*0 + 16*0) = 1;
+  matExpected(0, 3 + 4*1 + 16*0) = 1;
+  matExpected(0, 3 + 4*3 + 16*3) = 1;
+  QVERIFY(Pii::equals(outputValue("histogram", PiiMatrix<int>()), matExpected));
+
+  stop();
+}
+
+void TestPiiMultiVariableHistogram::marginalDistributions()
+{
+  setLevels(QVariantList() << 4 << 2 << 3);
+  operation()->setProperty("scales", QVariantList());
+  operation()->setProperty("distributionType", int(MarginalDistributions));
+  QVERIFY(start());
+
+  QVERIFY(sendObject("matrix0", PiiMatrix<int>(2,2, 0,1, 2,3)));
+  QVERIFY(sendObject("matrix1", PiiMatrix<float>(2,2, 1.0, 0.0, -1.0, 5.0)));
+  QVERIFY(sendObject("matrix2", PiiMatrix<unsigned char>(2,2, 2,2, 0,9)));
+
+  QVERIFY(Pii::equals(outputValue("histogram", PiiMatrix<int>()),
+                      PiiMatrix<int>(1,9,
+                                     1,1,1,1,
+                                     2,2,
+                                     1,0,3)));
+  stop();
+}
+
+void TestPiiMultiVariableHistogram::scaling()
+{
+  setLevels(QVariantList() << 4 << 4);
+  // Scale one equals no scaling (truncation instead of rounding).
+  operation()->setProperty("scales", QVariantList() << 1.0 << 0.5);
+  operation()->setProperty("distributionType", int(MarginalDistributions));
+  QVERIFY(start());
+
+  QVERIFY(sendObject("matrix0", PiiMatrix<double>(1,4, -3.0, 0.4, 2.6, 100.0)));
+  QVERIFY(sendObject("matrix1", PiiMatrix<double>(1,4, -3.0, 0.4, 2.6, 100.0)));
+  // Unscaled: 0 0 2 3. Scaled: 0 0 1 3.
+  QVERIFY(Pii::equals(outputValue("histogram", PiiMatrix<int>()),
+                      PiiMatrix<int>(1,8, 2,0,1,1, 2,1,0,1)));
+  stop();
+
+  operation()->setProperty("distributionType", int(JointDistribution));
+  QVERIFY(start());
+  QVERIFY(sendObject("matrix0", PiiMatrix<int>(1,3, 1, 2, 3)));
+  QVERIFY(sendObject("matrix1", PiiMatrix<int>(1,3, 1, 3, 8)));
+  // Bins (1,1), (2,2) and (3,3).
+  PiiMatrix<int> matExpected(1,16);
+  matExpected(0, 1 + 4*1) = 1;
+  matExpected(0, 2 + 4*2) = 1;
+  matExpected(0, 3 + 4*3) = 1;
+  QVERIFY(Pii::equals(outputValue("histogram", PiiMatrix<int>()), matExpected));
+  stop();
+}
+
+void TestPiiMultiVariableHistogram::largeImage_data()
+{
+  QTest::addColumn<int>("distributionType");
+  QTest::addColumn<QVariantList>("levels");
+
+  // 1M bins is more than the number of pixels in a block. Each
+  // block but the first collects a sparse histogram.
+  QTest::newRow("joint sparse") << int(JointDistribution) << (QVariantList() << 256 << 256 << 16);
+  QTest::newRow("joint dense") << int(JointDistribution) << (QVariantList() << 16 << 16 << 4);
+  QTest::newRow("marginal") << int(MarginalDistributions) << (QVariantList() << 256 << 200 << 16);
+}
+
+void TestPiiMultiVariableHistogram::largeImage()
+{
+  QFETCH(int, distributionType);
+  QFETCH(QVariantList, levels);
+
+  // Large enough to be split into several blocks of rows if there
+  // are many processors.
+  const int iRows = 512, iColumns = 512;
+  PiiMatrix<unsigned char> mat0(iRows, iColumns);
+  PiiMatrix<int> mat1(iRows, iColumns);
+  PiiMatrix<float> mat2(iRows, iColumns);
+  QList<PiiMatrix<double> > lstInputs;
+  for (int i=0; i<3; ++i)
+    lstInputs << PiiMatrix<double>(iRows, iColumns);
+  for (int r=0; r<iRows; ++r)
+    for (int c=0; c<iColumns; ++c)
+      {
+        lstInputs[0](r,c) = mat0(r,c) = (unsigned char)((3*c + 5*r) % 256);
+        // Also values out of range
+        lstInputs[1](r,c) = mat1(r,c) = (r*c) % 300 - 20;
+        lstInputs[2](r,c) = mat2(r,c) = float((r ^ c) % 37) * 1.3f;
+      }
+  QVector<double> vecScales;
+  vecScales << 1.0 << 1.0 << 0.5;
+
+  setLevels(levels);
+  operation()->setProperty("scales", QVariantList() << 1.0 << 1.0 << 0.5);
+  operation()->setProperty("distributionType", distributionType);
+  QVERIFY(start());
+
+  QVERIFY(sendObject("matrix0", mat0));
+  QVERIFY(sendObject("matrix1", mat1));
+  QVERIFY(sendObject("matrix2", mat2));
+
+  PiiMatrix<int> matHistogram(outputValue("histogram", PiiMatrix<int>()));
+  PiiMatrix<int> matExpected(referenceHistogram(lstInputs,
+                                                Pii::variantsToVector<int>(levels),
+                                                vecScales,
+                                                distributionType == JointDistribution));
+  QCOMPARE(matHistogram.columns(), matExpected.columns());
+  QVERIFY(Pii::equals(matHistogram, matExpected));
+  QCOMPARE(Pii::sum<int>(matHistogram),
+           iRows * iColumns * (distributionType == JointDistribution ? 1 : 3));
+  stop();
+}
+
+QTEST_MAIN(TestPiiMultiVariableHistogram)
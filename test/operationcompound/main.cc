@@ -314,6 +314,40 @@ void TestPiiOperationCompound::disabledOperations()
   QCOMPARE(e->activityMode(), PiiOperation::Disabled);
 }
 
+void TestPiiOperationCompound::effectiveCpuAffinity()
+{
+  PiiOperationCompound* pCompound1 = _compound.clone();
+  PiiOperationCompound* pCompound2 = _compound.clone();
+  TestOperation* pTest = new TestOperation;
+  pCompound1->addOperation(pCompound2);
+  pCompound2->addOperation(pTest);
+
+  QCOMPARE(pTest->effectiveCpuAffinity(), QString());
+
+  // Inherited from the closest ancestor that has it set
+  pCompound1->setCpuAffinity("0-3");
+  QCOMPARE(pCompound2->effectiveCpuAffinity(), QString("0-3"));
+  QCOMPARE(pTest->effectiveCpuAffinity(), QString("0-3"));
+  pCompound2->setCpuAffinity("2");
+  QCOMPARE(pTest->effectiveCpuAffinity(), QString("2"));
+
+  // The operation's own setting overrides
+  pTest->setCpuAffinity("1,5");
+  QCOMPARE(pTest->effectiveCpuAffinity(), QString("1,5"));
+  QCOMPARE(pCompound1->effectiveCpuAffinity(), QString("0-3"));
+
+  // Clearing reverts to inheritance
+  pTest->setCpuAffinity("");
+  pCompound2->setCpuAffinity("");
+  QCOMPARE(pTest->effectiveCpuAffinity(), QString("0-3"));
+
+  // A detached operation no longer inherits
+  pCompound2->removeOperation(pTest);
+  QCOMPARE(pTest->effectiveCpuAffinity(), QString());
+  delete pTest;
+  delete pCompound1;
+}
+
 void TestPiiOperationCompound::cleanupTestCase()
 {
   setOperation(0);
@@ -152,6 +152,7 @@ private slots:
   void exceptions();
   void singleThreaded();
   void propertyCache();
+  void asyncCalls();
 
 signals:
   void test1();
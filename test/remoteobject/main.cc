@@ -351,6 +351,58 @@ void TestPiiRemoteObject::propertyCache()
   QVERIFY(!_serverObject1.bNumberCalled);
 }
 
+void TestPiiRemoteObject::asyncCalls()
+{
+  QList<PiiRemoteFuture> lstResults;
+  for (int i=0; i<20; ++i)
+    lstResults << _pClient1->callAsync("functions/plus", i, 1);
+  PiiRemoteFuture exception = _pClient1->callAsync("functions/thrower", 0);
+  for (int i=0; i<lstResults.size(); ++i)
+    QCOMPARE(lstResults[i].value<int>(), i+1);
+
+  try
+    {
+      exception.result();
+      QFAIL("Call should have caused an exception.");
+    }
+  catch (PiiInvalidArgumentException& ex)
+    {
+      QCOMPARE(ex.message(), QString("InvalidArgument"));
+    }
+  catch (...)
+    {
+      QFAIL("Should have caught a PiiInvalidArgumentException.");
+    }
+
+  _serverObject1.setNumber(42);
+  QList<QPair<QString,QVariantList> > lstCalls;
+  lstCalls << qMakePair(QString("properties/number"), QVariantList())
+           << qMakePair(QString("functions/test2"), QVariantList() << QString("batch"))
+           << qMakePair(QString("functions/nonexistent"), QVariantList())
+           << qMakePair(QString("properties/number"), QVariantList() << 43);
+  lstResults = _pClient1->callBatch(lstCalls);
+  QCOMPARE(lstResults.size(), 4);
+  QVERIFY(lstResults[0].isFinished());
+  QCOMPARE(lstResults[0].value<int>(), 42);
+  QCOMPARE(lstResults[1].value<QString>(), QString("batch"));
+  try
+    {
+      lstResults[2].result();
+      QFAIL("Call should have caused an exception.");
+    }
+  catch (PiiNetworkException&) {}
+  QCOMPARE(lstResults[3].value<int>(), 43);
+  QCOMPARE(_serverObject1.iNumber, 43);
+
+  _pClient1->clearPropertyCache();
+  _serverObject1.bNumberCalled = false;
+  _pClient1->prefetchProperties(QStringList() << "number");
+  QVERIFY(_serverObject1.bNumberCalled);
+  _serverObject1.bNumberCalled = false;
+  QCOMPARE(_pClient1->property("number").toInt(), 43);
+  QVERIFY(!_serverObject1.bNumberCalled);
+}
+
 void ServerObject::thrower(int type)
 {
   switch (type)
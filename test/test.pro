@@ -10,6 +10,7 @@ SUBDIRS = algorithm \
           classification \
           color \
           colors \
+          databasereader \
           databasewriter \
           defaultoperation \
           dsp \
@@ -24,6 +25,7 @@ SUBDIRS = algorithm \
           genericfunction \
           geometry \
           heap \
+          histogrambackprojector \
           houghtransformoperation \
           httpserver \
           image \
@@ -40,6 +42,7 @@ SUBDIRS = algorithm \
           matrixdecompositions \
           matrixutil \
           multipartdecoder \
+          multivariablehistogram \
           operationcompound \
           optimization \
           perceptron \
@@ -57,6 +60,7 @@ SUBDIRS = algorithm \
           socket \
           stereotriangulator \
           stringformatter \
+          thumbnailloader \
           timer \
           threadsafetimer \
           tracking \
@@ -72,3 +76,5 @@ SUBDIRS = algorithm \
 
 include(../qt5.pri)
 qt5: SUBDIRS += qml
+# Requires libmodbus
+exists(../3rdparty/modbus/include/modbus.h): SUBDIRS += modbusiodriver
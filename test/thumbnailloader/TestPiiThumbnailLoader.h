@@ -0,0 +1,67 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _TESTPIITHUMBNAILLOADER_H
+#define _TESTPIITHUMBNAILLOADER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QImage>
+#include <QMutex>
+#include <QSemaphore>
+
+// Collects thumbnails emitted by the worker threads of the loader.
+class ThumbnailCollector : public QObject
+{
+  Q_OBJECT
+
+public:
+  ThumbnailCollector() : bBlock(false) {}
+
+  int count() const;
+  QStringList fileNames() const;
+  QImage image(const QString& fileName) const;
+
+  // If set, collect() blocks until released.
+  bool bBlock;
+  QSemaphore entered, released;
+
+public slots:
+  void collect(const QString& fileName, const QImage& image);
+
+private:
+  mutable QMutex _mutex;
+  QStringList _lstFileNames;
+  QList<QImage> _lstImages;
+};
+
+class TestPiiThumbnailLoader : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void parallelLoading();
+  void cacheHitsAndMisses();
+  void cacheLimit();
+  void prioritize();
+  void cleanupTestCase();
+
+private:
+  QString _strImageDirectory, _strCacheDirectory;
+  QStringList _lstImageFiles;
+};
+
+#endif //_TESTPIITHUMBNAILLOADER_H
@@ -0,0 +1,267 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "TestPiiThumbnailLoader.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QFileInfo>
+#include <PiiThumbnailLoader.h>
+
+static const int iImageCount = 12;
+
+int ThumbnailCollector::count() const
+{
+  QMutexLocker lock(&_mutex);
+  return _lstFileNames.size();
+}
+
+QStringList ThumbnailCollector::fileNames() const
+{
+  QMutexLocker lock(&_mutex);
+  return _lstFileNames;
+}
+
+QImage ThumbnailCollector::image(const QString& fileName) const
+{
+  QMutexLocker lock(&_mutex);
+  int iIndex = _lstFileNames.indexOf(fileName);
+  return iIndex >= 0 ? _lstImages[iIndex] : QImage();
+}
+
+void ThumbnailCollector::collect(const QString& fileName, const QImage& image)
+{
+  if (bBlock)
+    {
+      entered.release();
+      released.acquire();
+    }
+  QMutexLocker lock(&_mutex);
+  _lstFileNames << fileName;
+  _lstImages << image;
+}
+
+static bool waitForThumbnails(const ThumbnailCollector& collector, int count)
+{
+  QTime time;
+  time.start();
+  while (collector.count() < count)
+    {
+      if (time.elapsed() > 10000)
+        return false;
+      QTest::qWait(10);
+    }
+  return true;
+}
+
+static void removeFiles(const QString& directory)
+{
+  QDir dir(directory);
+  QStringList lstFiles(dir.entryList(QDir::Files));
+  for (int i=0; i<lstFiles.size(); ++i)
+    dir.remove(lstFiles[i]);
+}
+
+static qint64 totalSize(const QString& directory)
+{
+  QFileInfoList lstFiles(QDir(directory).entryInfoList(QStringList() << "*.png", QDir::Files));
+  qint64 iSize = 0;
+  for (int i=0; i<lstFiles.size(); ++i)
+    iSize += lstFiles[i].size();
+  return iSize;
+}
+
+static int fileCount(const QString& directory)
+{
+  return QDir(directory).entryList(QStringList() << "*.png", QDir::Files).size();
+}
+
+void TestPiiThumbnailLoader::initTestCase()
+{
+  QString strBase = QDir::tempPath() + "/piithumbnailloadertest";
+  _strImageDirectory = strBase + "/images";
+  _strCacheDirectory = strBase + "/cache";
+  QVERIFY(QDir().mkpath(_strImageDirectory));
+  QVERIFY(QDir().mkpath(_strCacheDirectory));
+  removeFiles(_strImageDirectory);
+  removeFiles(_strCacheDirectory);
+
+  for (int i=0; i<iImageCount; ++i)
+    {
+      QImage image(100 + 20*i, 60 + 10*i, QImage::Format_RGB32);
+      image.fill(qRgb(20*i, 255 - 20*i, 128));
+      QString strFileName = QString("%1/image%2.png").arg(_strImageDirectory).arg(i);
+      QVERIFY(image.save(strFileName, "PNG"));
+      _lstImageFiles << strFileName;
+    }
+}
+
+void TestPiiThumbnailLoader::parallelLoading()
+{
+  PiiThumbnailLoader loader;
+  loader.setCacheDirectory(_strCacheDirectory);
+  loader.clearCache();
+  loader.setWorkerCount(4);
+  ThumbnailCollector collector;
+  connect(&loader, SIGNAL(thumbnailReady(QString,QImage)),
+          &collector, SLOT(collect(QString,QImage)), Qt::DirectConnection);
+
+  loader.setFileNames(_lstImageFiles);
+  QVERIFY(waitForThumbnails(collector, iImageCount));
+  QVERIFY(loader.fileNames().isEmpty());
+
+  // Each file is loaded exactly once.
+  QStringList lstLoaded(collector.fileNames()), lstExpected(_lstImageFiles);
+  qSort(lstLoaded);
+  qSort(lstExpected);
+  QCOMPARE(lstLoaded, lstExpected);
+
+  for (int i=0; i<iImageCount; ++i)
+    {
+      QImage thumbnail(collector.image(_lstImageFiles[i]));
+      QSize originalSize(100 + 20*i, 60 + 10*i);
+      QCOMPARE(thumbnail.size(), originalSize.scaled(loader.thumbnailSize(), Qt::KeepAspectRatio));
+      QCOMPARE(thumbnail.pixel(thumbnail.width()/2, thumbnail.height()/2), qRgb(20*i, 255 - 20*i, 128));
+    }
+  QCOMPARE(fileCount(_strCacheDirectory), iImageCount);
+}
+
+void TestPiiThumbnailLoader::cacheHitsAndMisses()
+{
+  PiiThumbnailLoader loader;
+  loader.setCacheDirectory(_strCacheDirectory);
+  loader.clearCache();
+  QCOMPARE(fileCount(_strCacheDirectory), 0);
+
+  QString strFileName = _strImageDirectory + "/modified.png";
+  QImage image(200, 100, QImage::Format_RGB32);
+  image.fill(qRgb(0, 0, 255));
+  QVERIFY(image.save(strFileName, "PNG"));
+
+  // A miss creates the thumbnail and stores it.
+  QImage thumbnail(loader.loadThumbnail(strFileName));
+  QCOMPARE(thumbnail.size(), QSize(70, 35));
+  QCOMPARE(fileCount(_strCacheDirectory), 1);
+
+  // A hit reads the stored file. Replace it to tell the difference.
+  QString strCacheFile = QDir(_strCacheDirectory).entryInfoList(QStringList() << "*.png").first().absoluteFilePath();
+  QImage marker(5, 5, QImage::Format_RGB32);
+  marker.fill(qRgb(255, 0, 0));
+  QVERIFY(marker.save(strCacheFile, "PNG"));
+  QCOMPARE(loader.loadThumbnail(strFileName).size(), QSize(5, 5));
+
+  // A different thumbnail size is a miss.
+  loader.setThumbnailSize(QSize(40, 40));
+  QCOMPARE(loader.loadThumbnail(strFileName).size(), QSize(40, 20));
+  QCOMPARE(fileCount(_strCacheDirectory), 2);
+
+  // Changing the file makes the old thumbnail stale.
+  // A gradient makes sure the file size changes even if the
+  // modification time stays within the same second.
+  image = QImage(100, 100, QImage::Format_RGB32);
+  for (int r=0; r<image.height(); ++r)
+    for (int c=0; c<image.width(); ++c)
+      image.setPixel(c, r, qRgb(r*2, c*2, (r+c) & 0xff));
+  QVERIFY(image.save(strFileName, "PNG"));
+  QCOMPARE(loader.loadThumbnail(strFileName).size(), QSize(40, 40));
+  QCOMPARE(fileCount(_strCacheDirectory), 3);
+
+  // Nothing is stored if the cache is disabled.
+  loader.clearCache();
+  loader.setCacheEnabled(false);
+  QVERIFY(!loader.loadThumbnail(strFileName).isNull());
+  QCOMPARE(fileCount(_strCacheDirectory), 0);
+
+  QFile::remove(strFileName);
+}
+
+void TestPiiThumbnailLoader::cacheLimit()
+{
+  PiiThumbnailLoader loader;
+  loader.setCacheDirectory(_strCacheDirectory);
+  loader.clearCache();
+  for (int i=0; i<iImageCount; ++i)
+    QVERIFY(!loader.loadThumbnail(_lstImageFiles[i]).isNull());
+  QCOMPARE(fileCount(_strCacheDirectory), iImageCount);
+  const qint64 iFullSize = totalSize(_strCacheDirectory);
+
+  // No limit
+  loader.setMaxCacheSize(0);
+  loader.pruneCache();
+  QCOMPARE(fileCount(_strCacheDirectory), iImageCount);
+
+  loader.setMaxCacheSize(iFullSize / 2);
+  loader.pruneCache();
+  QVERIFY(totalSize(_strCacheDirectory) <= iFullSize / 2);
+  QVERIFY(fileCount(_strCacheDirectory) > 0);
+  QVERIFY(fileCount(_strCacheDirectory) < iImageCount);
+
+  // The loader prunes the cache once it runs out of work.
+  loader.clearCache();
+  loader.setMaxCacheSize(1);
+  ThumbnailCollector collector;
+  connect(&loader, SIGNAL(thumbnailReady(QString,QImage)),
+          &collector, SLOT(collect(QString,QImage)), Qt::DirectConnection);
+  loader.setFileNames(_lstImageFiles);
+  QVERIFY(waitForThumbnails(collector, iImageCount));
+  QTime time;
+  time.start();
+  while (fileCount(_strCacheDirectory) > 0 && time.elapsed() < 10000)
+    QTest::qWait(10);
+  QCOMPARE(fileCount(_strCacheDirectory), 0);
+}
+
+void TestPiiThumbnailLoader::prioritize()
+{
+  PiiThumbnailLoader loader;
+  loader.setCacheDirectory(_strCacheDirectory);
+  loader.setWorkerCount(1);
+  ThumbnailCollector collector;
+  collector.bBlock = true;
+  connect(&loader, SIGNAL(thumbnailReady(QString,QImage)),
+          &collector, SLOT(collect(QString,QImage)), Qt::DirectConnection);
+
+  // The only worker blocks after taking the first file.
+  loader.setFileNames(_lstImageFiles);
+  QVERIFY(collector.entered.tryAcquire(1, 10000));
+  QCOMPARE(loader.fileNames(), _lstImageFiles.mid(1));
+
+  // Unknown and already loaded files are ignored.
+  loader.prioritize(QStringList() << _lstImageFiles[7] << _lstImageFiles[3]
+                    << "nonexistent.png" << _lstImageFiles[0]);
+  QStringList lstExpected(_lstImageFiles.mid(1));
+  lstExpected.removeAll(_lstImageFiles[7]);
+  lstExpected.removeAll(_lstImageFiles[3]);
+  lstExpected.prepend(_lstImageFiles[3]);
+  lstExpected.prepend(_lstImageFiles[7]);
+  QCOMPARE(loader.fileNames(), lstExpected);
+
+  collector.released.release(iImageCount);
+  QVERIFY(waitForThumbnails(collector, iImageCount));
+  lstExpected.prepend(_lstImageFiles[0]);
+  QCOMPARE(collector.fileNames(), lstExpected);
+}
+
+void TestPiiThumbnailLoader::cleanupTestCase()
+{
+  removeFiles(_strImageDirectory);
+  removeFiles(_strCacheDirectory);
+  QDir dir(QDir::tempPath() + "/piithumbnailloadertest");
+  dir.rmdir("images");
+  dir.rmdir("cache");
+  QDir::temp().rmdir("piithumbnailloadertest");
+}
+
+QTEST_MAIN(TestPiiThumbnailLoader)
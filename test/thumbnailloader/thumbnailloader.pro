@@ -0,0 +1,3 @@
+include(../unit_test.pri)
+INCLUDEPATH += $$INTODIR/gui
+LIBS += -L$$INTODIR/gui/$$MODE -lpiigui$$INTO_LIBV
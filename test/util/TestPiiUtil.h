@@ -28,6 +28,8 @@ private slots:
   void findNeighbors();
   void findDependencies();
   void splitQuoted();
+  void parseCpuList();
+  void cpuListToString();
 };
 
 
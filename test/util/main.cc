@@ -16,6 +16,7 @@
 #include "TestPiiUtil.h"
 
 #include <PiiUtil.h>
+#include <PiiThreadUtil.h>
 #include <string>
 #include <QtTest>
 
@@ -151,4 +152,38 @@ void TestPiiUtil::splitQuoted()
   QCOMPARE(Pii::splitQuoted("/test/string;1", ';'), QStringList() << "/test/string" << "1");
 }
 
+void TestPiiUtil::parseCpuList()
+{
+  typedef QList<int> L;
+  QCOMPARE(Pii::parseCpuList(""), L());
+  QCOMPARE(Pii::parseCpuList("3"), L() << 3);
+  QCOMPARE(Pii::parseCpuList("0-3,8,10-11"), L() << 0 << 1 << 2 << 3 << 8 << 10 << 11);
+  // Whitespace around entries and range limits
+  QCOMPARE(Pii::parseCpuList(" 1 , 4 - 5 ,7"), L() << 1 << 4 << 5 << 7);
+  // Unordered input with overlapping ranges
+  QCOMPARE(Pii::parseCpuList("6,2-4,3,0,4-6"), L() << 0 << 2 << 3 << 4 << 5 << 6);
+  QCOMPARE(Pii::parseCpuList("2-2"), L() << 2);
+  // Invalid entries are ignored, the rest is retained.
+  QCOMPARE(Pii::parseCpuList("a,1,,2-,-3,5-4,1-2-3,x-y,7"), L() << 1 << 7);
+  QCOMPARE(Pii::parseCpuList("-1"), L());
+  QCOMPARE(Pii::parseCpuList(",,"), L());
+}
+
+void TestPiiUtil::cpuListToString()
+{
+  typedef QList<int> L;
+  QCOMPARE(Pii::cpuListToString(L()), QString());
+  QCOMPARE(Pii::cpuListToString(L() << 5), QString("5"));
+  QCOMPARE(Pii::cpuListToString(L() << 0 << 1 << 2 << 3 << 8 << 10 << 11), QString("0-3,8,10-11"));
+  QCOMPARE(Pii::cpuListToString(L() << 11 << 3 << 10 << 1 << 2 << 0 << 8), QString("0-3,8,10-11"));
+  QCOMPARE(Pii::cpuListToString(L() << 1 << 1 << 2 << 2 << 4), QString("1-2,4"));
+
+  // Round trip
+  const char* aLists[] = { "0", "0-1", "0,2,4", "1-3,5,7-9", "0-63" };
+  for (unsigned i=0; i<sizeof(aLists)/sizeof(aLists[0]); ++i)
+    QCOMPARE(Pii::cpuListToString(Pii::parseCpuList(aLists[i])), QString(aLists[i]));
+  L lstCpus = L() << 0 << 2 << 3 << 4 << 9 << 12 << 13;
+  QCOMPARE(Pii::parseCpuList(Pii::cpuListToString(lstCpus)), lstCpus);
+}
+
 QTEST_MAIN(TestPiiUtil)
@@ -18,7 +18,12 @@
 #include "PiiNullInputController.h"
 
 PiiBasicOperation::Data::Data() :
-  state(PiiOperation::Stopped)
+  state(PiiOperation::Stopped),
+  overloadPolicy(BlockWhenOverloaded),
+  dOverloadThreshold(1.0),
+  iOverloadDelay(50),
+  bSaturated(false), bOverloaded(false),
+  iDroppedCount(0), iOverloadPeriods(0), iPeriodStartDropCount(0)
 {}
 
 PiiBasicOperation::Data::~Data()
@@ -63,6 +68,97 @@ void PiiBasicOperation::check(bool reset)
 
   for (int i=d->lstOutputs.size(); i--; )
     d->lstOutputs[i]->reset();
+
+  QMutexLocker lock(&d->sheddingMutex);
+  d->bSaturated = d->bOverloaded = false;
+  if (reset)
+    d->iDroppedCount = d->iOverloadPeriods = d->iPeriodStartDropCount = 0;
+}
+
+double PiiBasicOperation::queueOccupancy() const
+{
+  const PII_D;
+  double dOccupancy = 0;
+  if (hasConnectedInputs())
+    {
+      for (int i=0; i<d->lstInputs.size(); ++i)
+        dOccupancy = qMax(dOccupancy, d->lstInputs[i]->queueOccupancy());
+    }
+  else
+    {
+      for (int i=0; i<d->lstOutputs.size(); ++i)
+        dOccupancy = qMax(dOccupancy, d->lstOutputs[i]->queueOccupancy());
+    }
+  return dOccupancy;
+}
+
+bool PiiBasicOperation::shedLoad()
+{
+  PII_D;
+  if (d->overloadPolicy == BlockWhenOverloaded)
+    return false;
+
+  double dOccupancy = queueOccupancy();
+
+  QMutexLocker lock(&d->sheddingMutex);
+  if (dOccupancy < d->dOverloadThreshold)
+    {
+      if (d->bOverloaded)
+        {
+          d->bOverloaded = false;
+          piiWarning(tr("%1 recovered from overload after dropping %2 objects.")
+                     .arg(fullName()).arg(d->iDroppedCount - d->iPeriodStartDropCount));
+        }
+      d->bSaturated = false;
+      return false;
+    }
+
+  if (!d->bSaturated)
+    {
+      d->bSaturated = true;
+      d->saturationTimer.restart();
+    }
+  if (!d->bOverloaded)
+    {
+      if (d->saturationTimer.milliseconds() < d->iOverloadDelay)
+        return false;
+      d->bOverloaded = true;
+      ++d->iOverloadPeriods;
+      d->iPeriodStartDropCount = d->iDroppedCount;
+      piiWarning(tr("%1 is overloaded (queue occupancy %2). Dropping objects.")
+                 .arg(fullName()).arg(dOccupancy));
+    }
+  ++d->iDroppedCount;
+  return true;
+}
+
+void PiiBasicOperation::setOverloadPolicy(OverloadPolicy overloadPolicy) { _d()->overloadPolicy = overloadPolicy; }
+PiiBasicOperation::OverloadPolicy PiiBasicOperation::overloadPolicy() const { return _d()->overloadPolicy; }
+void PiiBasicOperation::setOverloadThreshold(double overloadThreshold)
+{
+  if (overloadThreshold > 0 && overloadThreshold <= 1)
+    _d()->dOverloadThreshold = overloadThreshold;
+}
+double PiiBasicOperation::overloadThreshold() const { return _d()->dOverloadThreshold; }
+void PiiBasicOperation::setOverloadDelay(int overloadDelay) { _d()->iOverloadDelay = qMax(overloadDelay, 0); }
+int PiiBasicOperation::overloadDelay() const { return _d()->iOverloadDelay; }
+
+bool PiiBasicOperation::isOverloaded() const
+{
+  const PII_D;
+  QMutexLocker lock(&d->sheddingMutex);
+  return d->bOverloaded;
+}
+
+QVariantMap PiiBasicOperation::loadSheddingStatistics() const
+{
+  const PII_D;
+  QMutexLocker lock(&d->sheddingMutex);
+  QVariantMap mapResult;
+  mapResult["droppedCount"] = d->iDroppedCount;
+  mapResult["overloadPeriods"] = d->iOverloadPeriods;
+  mapResult["overloaded"] = d->bOverloaded;
+  return mapResult;
 }
 
 void PiiBasicOperation::updateActivityMode(ActivityMode mode)
@@ -17,6 +17,7 @@
 #define _PIIBASICOPERATION_H
 
 #include "PiiOperation.h"
+#include <PiiTimer.h>
 
 /**
  * A bare bones implementation of the PiiOperation interface. This
@@ -30,7 +31,68 @@ class PII_YDIN_EXPORT PiiBasicOperation : public PiiOperation
 {
   Q_OBJECT
 
+  /**
+   * The way the operation reacts to sustained overload. The default
+   * value is `BlockWhenOverloaded`, which makes producers wait until
+   * the receivers have room for new objects.
+   *
+   * With `DropWhenOverloaded`, the operation sheds load once its
+   * queues have been saturated for [overloadDelay] milliseconds:
+   *
+   * - An operation with connected inputs skips [process()]
+   *   (PiiDefaultOperation::process()) for the objects it receives
+   *   while overloaded. This consumes the objects immediately and
+   *   keeps the producer from blocking. Since no output is produced
+   *   for the skipped objects, receivers that synchronize the
+   *   outputs with other branches would lose track of the object
+   *   flow. Therefore, rounds are only skipped by operations whose
+   *   outputs are not connected, such as optional analysis or
+   *   display sinks. With connected outputs, the policy is ignored
+   *   and a warning is logged in [check()].
+   *
+   * - A source operation (one with no connected inputs) drops whole
+   *   frames before sending them. Because nothing is emitted to any
+   *   output, all synchronized branches stay coherent. Sources that
+   *   support shedding (such as cameras and trigger sources) call
+   *   [shedLoad()] for each frame.
+   *
+   * Shedding decisions are logged when an overload period starts and
+   * ends. See [loadSheddingStatistics()].
+   */
+  Q_PROPERTY(OverloadPolicy overloadPolicy READ overloadPolicy WRITE setOverloadPolicy);
+  Q_ENUMS(OverloadPolicy);
+
+  /**
+   * The queue occupancy at which the operation is considered
+   * saturated, in the range (0, 1]. Occupancy is the ratio of queued
+   * objects to [queue capacity](PiiInputSocket::queueCapacity). An
+   * operation with connected inputs measures its own input queues. A
+   * source operation measures the fullest input queue its outputs
+   * are connected to. The default value is 1.0, which means that
+   * saturation is reached when a queue is full and the producer would
+   * block.
+   */
+  Q_PROPERTY(double overloadThreshold READ overloadThreshold WRITE setOverloadThreshold);
+
+  /**
+   * The time (in milliseconds) occupancy must stay at or above
+   * [overloadThreshold] before load is shed. Short bursts that the
+   * queues can absorb are not considered overload. The default value
+   * is 50.
+   */
+  Q_PROPERTY(int overloadDelay READ overloadDelay WRITE setOverloadDelay);
+
 public:
+  /**
+   * Overload policies.
+   *
+   * - `BlockWhenOverloaded` - producers wait for the receivers.
+   *
+   * - `DropWhenOverloaded` - objects are dropped once the operation
+   * has been saturated for long enough.
+   */
+  enum OverloadPolicy { BlockWhenOverloaded, DropWhenOverloaded };
+
   ~PiiBasicOperation();
 
   /**
@@ -92,6 +154,34 @@ public:
    */
   PiiOutputSocket* outputAt(int index = 0) const;
 
+  void setOverloadPolicy(OverloadPolicy overloadPolicy);
+  OverloadPolicy overloadPolicy() const;
+  void setOverloadThreshold(double overloadThreshold);
+  double overloadThreshold() const;
+  void setOverloadDelay(int overloadDelay);
+  int overloadDelay() const;
+
+  /**
+   * Returns `true` if the operation is currently shedding load.
+   * Operations can use this to reduce work while overloaded, for
+   * example by processing images at a lower resolution.
+   */
+  Q_INVOKABLE bool isOverloaded() const;
+
+  /**
+   * Returns load shedding statistics collected since the last
+   * [check()] with reset. The map contains the following keys:
+   *
+   * - `droppedCount` - the number of dropped frames or skipped
+   * processing rounds (int)
+   *
+   * - `overloadPeriods` - the number of times the operation entered
+   * an overload period (int)
+   *
+   * - `overloaded` - the current overload status (bool)
+   */
+  Q_INVOKABLE QVariantMap loadSheddingStatistics() const;
+
 protected:
   /// @internal
   class PII_YDIN_EXPORT Data : public PiiOperation::Data
@@ -114,6 +204,14 @@ protected:
      * Pointers to output sockets.
      */
     QList<PiiOutputSocket*> lstOutputs;
+
+    OverloadPolicy overloadPolicy;
+    double dOverloadThreshold;
+    int iOverloadDelay;
+    mutable QMutex sheddingMutex;
+    PiiTimer saturationTimer;
+    bool bSaturated, bOverloaded;
+    int iDroppedCount, iOverloadPeriods, iPeriodStartDropCount;
   };
   PII_D_FUNC;
 
@@ -364,7 +462,30 @@ protected:
    */
   void updateActivityMode(ActivityMode mode);
 
+  /**
+   * Decides whether the current frame or processing round should be
+   * dropped according to [overloadPolicy]. Returns `false` if the
+   * policy is `BlockWhenOverloaded`, or if the operation has not been
+   * saturated for at least [overloadDelay] milliseconds. Otherwise,
+   * counts a dropped object and returns `true`.
+   *
+   * Source operations that can drop frames should call this function
+   * before emitting anything for a new frame:
+   *
+   * ~~~(c++)
+   * void MySource::frameReady(const PiiMatrix<int>& frame)
+   * {
+   *   if (shedLoad())
+   *     return;
+   *   emitObject(frame);
+   * }
+   * ~~~
+   */
+  bool shedLoad();
+
 private:
+  double queueOccupancy() const;
+
   template <class T> void setNumberedSockets(QList<T*>& sockets,
                                              int count,
                                              int staticSockets,
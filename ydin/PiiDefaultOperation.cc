@@ -23,12 +23,23 @@
 #include "PiiOneGroupFlowController.h"
 #include "PiiNullInputController.h"
 
+#include <PiiThreadUtil.h>
+#include <PiiTimer.h>
+
 PiiDefaultOperation::Data::Data() :
   pFlowController(0), pProcessor(0),
   bChecked(false),
   processLock(PiiReadWriteLock::Recursive),
   iThreadCount(0),
-  threadingCapabilities(NonThreaded | SingleThreaded)
+  threadingCapabilities(NonThreaded | SingleThreaded),
+  schedulingClass(NormalClass),
+  iDeadline(0), iRuntimeBudget(0),
+  iProcessedCount(0), iDeadlineMisses(0),
+  iMaxLatency(0), iTotalLatency(0), iBlockedTime(0),
+  bCollectStatistics(false),
+  iActiveThreadLimit(0),
+  bTrackMemory(false),
+  bSkipWhenOverloaded(false)
 {
 }
 
@@ -53,6 +64,7 @@ PiiDefaultOperation::PiiDefaultOperation(Data* data) :
 void PiiDefaultOperation::init()
 {
   setProtectionLevel("threadCount", WriteWhenStoppedOrPaused);
+  setProtectionLevel("schedulingClass", WriteWhenStoppedOrPaused);
   createProcessor();
 }
 
@@ -115,6 +127,112 @@ void PiiDefaultOperation::setPriority(int priority)
 
 int PiiDefaultOperation::priority() const { return _d()->pProcessor->processingPriority(); }
 
+void PiiDefaultOperation::setSchedulingClass(SchedulingClass schedulingClass) { _d()->schedulingClass = schedulingClass; }
+PiiDefaultOperation::SchedulingClass PiiDefaultOperation::schedulingClass() const { return _d()->schedulingClass; }
+void PiiDefaultOperation::setDeadline(int deadline) { _d()->iDeadline = qMax(deadline, 0); }
+int PiiDefaultOperation::deadline() const { return _d()->iDeadline; }
+void PiiDefaultOperation::setRuntimeBudget(int runtimeBudget) { _d()->iRuntimeBudget = qMax(runtimeBudget, 0); }
+int PiiDefaultOperation::runtimeBudget() const { return _d()->iRuntimeBudget; }
+
+namespace
+{
+  // Installs matrix traffic counters for the calling thread and
+  // restores the previous ones when going out of scope, even if
+  // process() throws.
+  class TrafficScope
+  {
+  public:
+    TrafficScope(PiiMatrixTraffic* traffic) :
+      _pTraffic(traffic),
+      _pPrevious(traffic != 0 ? PiiMatrixData::setThreadTraffic(traffic) : 0)
+    {}
+    ~TrafficScope()
+    {
+      if (_pTraffic != 0)
+        PiiMatrixData::setThreadTraffic(_pPrevious);
+    }
+
+  private:
+    PiiMatrixTraffic* _pTraffic;
+    PiiMatrixTraffic* _pPrevious;
+  };
+}
+
+void PiiDefaultOperation::processMeasured()
+{
+  PII_D;
+  PiiMatrixTraffic traffic;
+  PiiTimer timer;
+  {
+    TrafficScope scope(d->bTrackMemory ? &traffic : 0);
+    process();
+  }
+  qint64 iLatency = timer.microseconds();
+
+  QMutexLocker lock(&d->statisticsMutex);
+  d->memoryTraffic += traffic;
+  if (d->iDeadline > 0 || d->bCollectStatistics)
+    {
+      ++d->iProcessedCount;
+      if (d->iDeadline > 0 && iLatency > d->iDeadline)
+        ++d->iDeadlineMisses;
+      if (iLatency > d->iMaxLatency)
+        d->iMaxLatency = iLatency;
+      d->iTotalLatency += iLatency;
+    }
+}
+
+QVariantMap PiiDefaultOperation::schedulingStatistics() const
+{
+  const PII_D;
+  QMutexLocker lock(&d->statisticsMutex);
+  QVariantMap mapResult;
+  mapResult["processedCount"] = d->iProcessedCount;
+  mapResult["deadlineMisses"] = d->iDeadlineMisses;
+  mapResult["maxLatency"] = d->iMaxLatency;
+  mapResult["totalLatency"] = d->iTotalLatency;
+  qint64 iBlockedTime = d->iBlockedTime;
+  for (int i=0; i<d->lstOutputs.size(); ++i)
+    iBlockedTime += d->lstOutputs[i]->blockedTime();
+  mapResult["blockedTime"] = iBlockedTime;
+  return mapResult;
+}
+
+QVariantMap PiiDefaultOperation::memoryStatistics() const
+{
+  const PII_D;
+  QMutexLocker lock(&d->statisticsMutex);
+  QVariantMap mapResult;
+  mapResult["allocations"] = d->memoryTraffic.iAllocations;
+  mapResult["allocatedBytes"] = d->memoryTraffic.iAllocatedBytes;
+  mapResult["clones"] = d->memoryTraffic.iClones;
+  mapResult["copiedBytes"] = d->memoryTraffic.iCopiedBytes;
+  mapResult["reallocations"] = d->memoryTraffic.iReallocations;
+  mapResult["releases"] = d->memoryTraffic.iReleases;
+  return mapResult;
+}
+
+void PiiDefaultOperation::addBlockedTime(qint64 time)
+{
+  PII_D;
+  QMutexLocker lock(&d->statisticsMutex);
+  d->iBlockedTime += time;
+}
+
+void PiiDefaultOperation::setCollectingStatistics(bool collect) { _d()->bCollectStatistics = collect; }
+bool PiiDefaultOperation::isCollectingStatistics() const { return _d()->bCollectStatistics; }
+void PiiDefaultOperation::setTrackingMemory(bool track) { _d()->bTrackMemory = track; }
+bool PiiDefaultOperation::isTrackingMemory() const { return _d()->bTrackMemory; }
+
+void PiiDefaultOperation::setActiveThreadLimit(int limit) { _d()->iActiveThreadLimit = qMax(limit, 0); }
+
+int PiiDefaultOperation::activeThreadLimit() const
+{
+  const PII_D;
+  int iLimit = d->iActiveThreadLimit;
+  return iLimit > 0 && iLimit < d->iThreadCount ? iLimit : d->iThreadCount;
+}
+
 void PiiDefaultOperation::syncEvent(SyncEvent* /*event*/) {}
 
 void PiiDefaultOperation::interrupt()
@@ -150,12 +268,93 @@ void PiiDefaultOperation::check(bool reset)
   if (reset)
     PiiFlowController::SyncListener::reset();
 
+  d->lstCpus = Pii::parseCpuList(effectiveCpuAffinity());
+
+  // A skipped round emits nothing. Receivers that synchronize our
+  // outputs with other branches would fall out of step. Therefore,
+  // only operations with no connected outputs skip rounds.
+  d->bSkipWhenOverloaded = d->overloadPolicy == DropWhenOverloaded && hasConnectedInputs();
+  for (int i=0; i<d->lstOutputs.size() && d->bSkipWhenOverloaded; ++i)
+    if (d->lstOutputs[i]->isConnected())
+      {
+        d->bSkipWhenOverloaded = false;
+        piiWarning(tr("%1 has connected outputs and cannot skip processing rounds. "
+                      "Overload policy will be ignored.").arg(fullName()));
+      }
+
+  if (reset)
+    {
+      QMutexLocker lock(&d->statisticsMutex);
+      d->iProcessedCount = d->iDeadlineMisses = 0;
+      d->iMaxLatency = d->iTotalLatency = d->iBlockedTime = 0;
+      d->memoryTraffic = PiiMatrixTraffic();
+    }
+
   // Store flow controller to the processor
   d->pProcessor->setFlowController(d->pFlowController);
   d->pProcessor->check(reset);
   d->bChecked = true;
 }
 
+bool PiiDefaultOperation::bindCurrentThread()
+{
+  PII_D;
+  bool bSuccess = true;
+  if (!d->lstCpus.isEmpty() && !Pii::bindThread(d->lstCpus))
+    {
+      piiWarning(tr("Could not bind a thread of %1 to CPUs %2.")
+                 .arg(fullName()).arg(Pii::cpuListToString(d->lstCpus)));
+      bSuccess = false;
+    }
+  return applySchedulingClass() && bSuccess;
+}
+
+bool PiiDefaultOperation::applySchedulingClass()
+{
+  PII_D;
+  switch (d->schedulingClass)
+    {
+    case RealTimeClass:
+      {
+        // Deadline scheduling requires that the thread may run on all
+        // CPUs.
+        if (d->iDeadline > 0 && d->iRuntimeBudget > 0 && d->lstCpus.isEmpty() &&
+            Pii::setThreadDeadline(qMin(d->iRuntimeBudget, d->iDeadline), d->iDeadline, d->iDeadline))
+          return true;
+        // Map QThread::Priority (IdlePriority-TimeCriticalPriority) to
+        // real-time priorities 10-70.
+        int iPriority = priority();
+        if (iPriority < QThread::IdlePriority || iPriority > QThread::TimeCriticalPriority)
+          iPriority = QThread::NormalPriority;
+        if (Pii::setThreadScheduling(Pii::FifoScheduling, 10 + iPriority * 10))
+          return true;
+        piiWarning(tr("Real-time scheduling is not permitted for %1. Using normal scheduling.")
+                   .arg(fullName()));
+        return false;
+      }
+    case BackgroundClass:
+      if (Pii::setThreadScheduling(Pii::BackgroundScheduling))
+        return true;
+      piiWarning(tr("Background scheduling is not supported for %1.").arg(fullName()));
+      return false;
+    default:
+#ifdef Q_OS_LINUX
+      // The thread may have been left with a real-time or background
+      // policy by a previous user. QThread maps IdlePriority to
+      // SCHED_IDLE, which must be retained.
+      if (priority() != QThread::IdlePriority &&
+          !Pii::setThreadScheduling(Pii::NormalScheduling))
+        {
+          piiWarning(tr("Could not restore normal scheduling for %1.").arg(fullName()));
+          return false;
+        }
+#endif
+      return true;
+    }
+}
+
+QList<int> PiiDefaultOperation::boundCpus() const { return _d()->lstCpus; }
+
 PiiFlowController* PiiDefaultOperation::createFlowController()
 {
   PII_D;
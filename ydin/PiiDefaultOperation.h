@@ -18,7 +18,9 @@
 
 #include <QList>
 #include <QStringList>
+#include <QMutex>
 #include <PiiReadWriteLock.h>
+#include <PiiMatrixData.h>
 #include "PiiBasicOperation.h"
 #include "PiiFlowController.h"
 
@@ -104,10 +106,63 @@ class PII_YDIN_EXPORT PiiDefaultOperation :
    * synchronous operations if a configuration contains multiple
    * independent processing pipelines or branching pipelines.
    *
-   * ! Thread priority cannot be changed on Linux.
+   * ! Thread priority cannot be changed on Linux. Use
+   * [schedulingClass] to give latency-critical operations precedence
+   * over other threads.
    */
   Q_PROPERTY(int priority READ priority WRITE setPriority);
 
+  /**
+   * The scheduling class of the threads of this operation. The
+   * default value is `NormalClass`.
+   *
+   * Real-time threads preempt all normal threads. If both [deadline]
+   * and [runtimeBudget] are set, real-time threads will be scheduled
+   * with `SCHED_DEADLINE` where the operating system permits it.
+   * Otherwise, or if the deadline reservation is rejected,
+   * `SCHED_FIFO` will be used with a real-time priority derived
+   * from [priority]. If real-time scheduling is not permitted (the
+   * process lacks the required privileges), a warning will be
+   * emitted and the thread will run with normal scheduling.
+   *
+   * Background threads run only when there is nothing else to do.
+   * Use this class for batch work such as learning or database
+   * writes that must not delay trigger handling.
+   *
+   * The scheduling class also applies to external threads bound
+   * with [bindCurrentThread()], such as camera capture threads. It
+   * has no effect on non-threaded operations. Thread budgets for
+   * each class can be set in PiiEngine.
+   *
+   * This property can only be changed when the operation is stopped
+   * or paused.
+   */
+  Q_PROPERTY(SchedulingClass schedulingClass READ schedulingClass WRITE setSchedulingClass);
+  Q_ENUMS(SchedulingClass);
+
+  /**
+   * The maximum time (in microseconds) a single call to [process()]
+   * should take. If this value is greater than zero, the duration of
+   * each processing round will be measured, and rounds that take
+   * longer will be counted as deadline misses. See
+   * [schedulingStatistics()]. The default value is zero, which
+   * disables measurement.
+   */
+  Q_PROPERTY(int deadline READ deadline WRITE setDeadline);
+
+  /**
+   * The amount of CPU time (in microseconds) a real-time thread
+   * needs within each [deadline]. If set (together with [deadline]),
+   * real-time threads will request `SCHED_DEADLINE` scheduling with
+   * this runtime and a period equal to [deadline]. The default value
+   * is zero.
+   *
+   * ! Deadline-scheduled threads cannot be bound to a subset of CPUs
+   * on Linux. If [cpuAffinity] is set, `SCHED_FIFO` will be used
+   * instead.
+   */
+  Q_PROPERTY(int runtimeBudget READ runtimeBudget WRITE setRuntimeBudget);
+
   /**
    * This property lists the threading modes the operation is allowed
    * to run in. The default value is `NonThreaded |
@@ -137,6 +192,20 @@ public:
   enum ThreadingCapability { NonThreaded = 1, SingleThreaded = 2, MultiThreaded = 4 };
   Q_DECLARE_FLAGS(ThreadingCapabilities, ThreadingCapability);
 
+  /**
+   * Scheduling classes.
+   *
+   * - `NormalClass` - threads are scheduled normally by the operating
+   *   system.
+   *
+   * - `RealTimeClass` - threads are scheduled with a real-time policy
+   *   (`SCHED_DEADLINE` or `SCHED_FIFO`) for latency-critical work.
+   *
+   * - `BackgroundClass` - threads only run when processors would
+   *   otherwise be idle.
+   */
+  enum SchedulingClass { NormalClass, RealTimeClass, BackgroundClass };
+
   PiiDefaultOperation();
   ~PiiDefaultOperation();
 
@@ -152,6 +221,92 @@ public:
    */
   QVariant property(const char* name) const;
 
+  /**
+   * Returns processing time statistics collected since the last
+   * [check()] with reset. The statistics are collected only if
+   * [deadline] is greater than zero or statistics collection has
+   * been enabled with [setCollectingStatistics()]. The returned map
+   * contains the following keys:
+   *
+   * - `processedCount` - the number of measured processing rounds
+   * (int)
+   *
+   * - `deadlineMisses` - the number of rounds that took longer than
+   * [deadline] (int)
+   *
+   * - `maxLatency` - the longest processing time in microseconds
+   * (qint64)
+   *
+   * - `totalLatency` - the sum of processing times in microseconds
+   * (qint64)
+   *
+   * - `blockedTime` - the total time threads have been blocked
+   * waiting for the receivers of the outputs, in microseconds
+   * (qint64). This value is always collected.
+   */
+  Q_INVOKABLE QVariantMap schedulingStatistics() const;
+
+  /**
+   * Enables or disables the collection of processing time
+   * statistics even if [deadline] is not set. Monitoring tools such
+   * as PiiEngineTuner enable this to measure utilization.
+   */
+  void setCollectingStatistics(bool collect);
+  bool isCollectingStatistics() const;
+
+  /**
+   * Returns matrix memory traffic caused by [process()] since the
+   * last [check()] with reset. The traffic is recorded only if
+   * enabled with [setTrackingMemory()]. Allocations made by
+   * non-threaded operations that are invoked synchronously from
+   * within [process()] are attributed to them, not to this
+   * operation. The returned map contains the following keys:
+   *
+   * - `allocations` - the number of matrix data buffers allocated
+   * (qint64)
+   *
+   * - `allocatedBytes` - the total size of the allocated buffers in
+   * bytes (qint64)
+   *
+   * - `clones` - the number of times shared matrix data has been
+   * deep-copied (qint64)
+   *
+   * - `copiedBytes` - the number of bytes copied while cloning
+   * (qint64)
+   *
+   * - `reallocations` - the number of times a buffer has been
+   * resized in place (qint64)
+   *
+   * - `releases` - the number of matrix data buffers released
+   * (qint64)
+   *
+   * @see PiiMatrixTraffic
+   */
+  Q_INVOKABLE QVariantMap memoryStatistics() const;
+
+  /**
+   * Enables or disables the recording of matrix memory traffic. The
+   * cost of recording is a few thread-local increments per
+   * allocation. See [memoryStatistics()].
+   */
+  void setTrackingMemory(bool track);
+  bool isTrackingMemory() const;
+
+  /**
+   * Limits the number of threads that may execute [process()]
+   * concurrently in multi-threaded mode. The limit can be changed
+   * while the operation is running, and it takes effect when the
+   * next object is assigned to a thread. The limit cannot exceed
+   * [threadCount]. Zero (the default) means that all [threadCount]
+   * threads may be used.
+   */
+  void setActiveThreadLimit(int limit);
+  /**
+   * Returns the current concurrency limit, which is between one and
+   * [threadCount] for threaded operations.
+   */
+  int activeThreadLimit() const;
+
   /**
    * Checks the operation for execution. This function creates a
    * suitable flow controller by calling [createFlowController()]. It
@@ -241,6 +396,19 @@ protected:
     mutable PiiReadWriteLock processLock;
     int iThreadCount;
     ThreadingCapabilities threadingCapabilities;
+    // CPUs resolved from effectiveCpuAffinity() in check().
+    QList<int> lstCpus;
+    SchedulingClass schedulingClass;
+    int iDeadline, iRuntimeBudget;
+    mutable QMutex statisticsMutex;
+    int iProcessedCount, iDeadlineMisses;
+    qint64 iMaxLatency, iTotalLatency, iBlockedTime;
+    bool bCollectStatistics;
+    int iActiveThreadLimit;
+    bool bTrackMemory;
+    PiiMatrixTraffic memoryTraffic;
+    // Processing rounds may be skipped under overload.
+    bool bSkipWhenOverloaded;
   };
   PII_D_FUNC;
 
@@ -253,6 +421,13 @@ protected:
   void setPriority(int priority);
   int priority() const;
 
+  void setSchedulingClass(SchedulingClass schedulingClass);
+  SchedulingClass schedulingClass() const;
+  void setDeadline(int deadline);
+  int deadline() const;
+  void setRuntimeBudget(int runtimeBudget);
+  int runtimeBudget() const;
+
   void setThreadingCapabilities(ThreadingCapabilities threadingCapabilities);
   ThreadingCapabilities threadingCapabilities() const;
 
@@ -379,6 +554,31 @@ protected:
    */
   PiiReadWriteLock* processLock();
 
+  /**
+   * Binds the calling thread to the CPUs determined by the
+   * [effectiveCpuAffinity()] of the operation at the time [check()]
+   * was last called and applies the [schedulingClass]. The
+   * processing threads of PiiDefaultOperation call this function
+   * automatically when they start. Subclasses that receive data from
+   * threads they don't own (e.g. a capture thread of a camera driver)
+   * may call this function to place those threads as well. With
+   * `NormalClass`, the thread is returned to the normal time-sharing
+   * policy (`SCHED_OTHER` on Linux) in case it was left with another
+   * policy.
+   *
+   * @return `true` if the thread was bound or there was nothing to
+   * do, `false` if the affinity or the scheduling policy could not be
+   * changed.
+   */
+  bool bindCurrentThread();
+
+  /**
+   * Returns the CPUs the threads of this operation will be bound to.
+   * The list is resolved in [check()]. An empty list means that no
+   * affinity has been set.
+   */
+  QList<int> boundCpus() const;
+
 private:
   void init();
   void createProcessor();
@@ -390,9 +590,19 @@ private:
   inline void processLocked()
   {
     PiiReadLocker lock(&_d()->processLock);
-    process();
+    // Skip processing rounds if the inputs are overloaded.
+    if (_d()->bSkipWhenOverloaded && shedLoad())
+      return;
+    if (_d()->iDeadline > 0 || _d()->bCollectStatistics || _d()->bTrackMemory)
+      processMeasured();
+    else
+      process();
   }
 
+  void processMeasured();
+  void addBlockedTime(qint64 time);
+  bool applySchedulingClass();
+
   inline void sendSyncEvents(PiiFlowController* controller)
   {
     PiiReadLocker lock(&_d()->processLock);
@@ -18,6 +18,8 @@
 #include <PiiSerializableExport.h>
 #include <PiiUtil.h>
 #include <PiiFileUtil.h>
+#include <PiiThreadUtil.h>
+#include "PiiDefaultOperation.h"
 #include "PiiPlugin.h"
 #include <PiiGenericTextOutputArchive.h>
 #include <PiiGenericBinaryOutputArchive.h>
@@ -27,6 +29,7 @@
 #include <QLibrary>
 #include <QFile>
 #include <QFileInfo>
+#include <algorithm>
 
 PII_DEFINE_VIRTUAL_METAOBJECT_FUNCTION(PiiEngine)
 PII_SERIALIZABLE_EXPORT(PiiEngine);
@@ -51,7 +54,17 @@ public:
 } *d;
 
 
-PiiEngine::PiiEngine()
+PiiEngine::Data::Data() :
+  bLockMemory(false),
+  bMemoryLocked(false),
+  bTrackMemory(false)
+{
+  for (int i=0; i<3; ++i)
+    aThreadBudgets[i] = 0;
+}
+
+PiiEngine::PiiEngine() :
+  PiiOperationCompound(new Data)
 {
   Q_UNUSED(iEngineMetaType); // suppresses compiler warning
   Q_UNUSED(iPluginMetaType);
@@ -70,7 +83,148 @@ PiiEngine::PiiEngine(Data* data) : PiiOperationCompound(data)
 {}
 
 PiiEngine::~PiiEngine()
-{}
+{
+  PII_D;
+  if (d->bMemoryLocked)
+    Pii::lockProcessMemory(false);
+}
+
+// Names of the scheduling classes in the order of
+// PiiDefaultOperation::SchedulingClass.
+static const char* schedulingClassName(int schedulingClass)
+{
+  static const char* const aNames[] = { "normal", "realTime", "background" };
+  return aNames[schedulingClass];
+}
+
+void PiiEngine::check(bool reset)
+{
+  PII_D;
+  int aThreadCounts[3] = { 0, 0, 0 };
+  QList<PiiDefaultOperation*> lstOperations(findChildren<PiiDefaultOperation*>());
+  for (int i=0; i<lstOperations.size(); ++i)
+    {
+      aThreadCounts[lstOperations[i]->schedulingClass()] += lstOperations[i]->threadCount();
+      lstOperations[i]->setTrackingMemory(d->bTrackMemory);
+    }
+  for (int i=0; i<3; ++i)
+    if (d->aThreadBudgets[i] > 0 && aThreadCounts[i] > d->aThreadBudgets[i])
+      PII_THROW(PiiExecutionException,
+                tr("Operations in the %1 scheduling class use %2 threads, but the budget is %3.")
+                .arg(schedulingClassName(i)).arg(aThreadCounts[i]).arg(d->aThreadBudgets[i]));
+
+  if (d->bLockMemory != d->bMemoryLocked)
+    {
+      if (Pii::lockProcessMemory(d->bLockMemory))
+        d->bMemoryLocked = d->bLockMemory;
+      else if (d->bLockMemory)
+        piiWarning(tr("Could not lock process memory."));
+    }
+
+  PiiOperationCompound::check(reset);
+}
+
+QVariantMap PiiEngine::schedulingStatistics() const
+{
+  QVariantMap aStats[3];
+  for (int i=0; i<3; ++i)
+    {
+      aStats[i]["operations"] = 0;
+      aStats[i]["threads"] = 0;
+      aStats[i]["processedCount"] = 0;
+      aStats[i]["deadlineMisses"] = 0;
+      aStats[i]["maxLatency"] = qint64(0);
+      aStats[i]["totalLatency"] = qint64(0);
+    }
+
+  QList<PiiDefaultOperation*> lstOperations(findChildren<PiiDefaultOperation*>());
+  for (int i=0; i<lstOperations.size(); ++i)
+    {
+      QVariantMap& mapClass = aStats[lstOperations[i]->schedulingClass()];
+      QVariantMap mapOperation = lstOperations[i]->schedulingStatistics();
+      mapClass["operations"] = mapClass["operations"].toInt() + 1;
+      mapClass["threads"] = mapClass["threads"].toInt() + lstOperations[i]->threadCount();
+      mapClass["processedCount"] = mapClass["processedCount"].toInt() + mapOperation["processedCount"].toInt();
+      mapClass["deadlineMisses"] = mapClass["deadlineMisses"].toInt() + mapOperation["deadlineMisses"].toInt();
+      mapClass["maxLatency"] = qMax(mapClass["maxLatency"].toLongLong(), mapOperation["maxLatency"].toLongLong());
+      mapClass["totalLatency"] = mapClass["totalLatency"].toLongLong() + mapOperation["totalLatency"].toLongLong();
+    }
+
+  QVariantMap mapResult;
+  for (int i=0; i<3; ++i)
+    mapResult[schedulingClassName(i)] = aStats[i];
+  return mapResult;
+}
+
+QVariantList PiiEngine::loadSheddingReport() const
+{
+  QVariantList lstResult;
+  QList<PiiBasicOperation*> lstOperations(findChildren<PiiBasicOperation*>());
+  for (int i=0; i<lstOperations.size(); ++i)
+    {
+      QVariantMap mapStats = lstOperations[i]->loadSheddingStatistics();
+      if (lstOperations[i]->overloadPolicy() == PiiBasicOperation::BlockWhenOverloaded &&
+          mapStats["droppedCount"].toInt() == 0)
+        continue;
+      mapStats["name"] = lstOperations[i]->fullName();
+      lstResult << mapStats;
+    }
+  return lstResult;
+}
+
+// Sorts memory traffic maps in descending order of copied bytes.
+static bool copiedMoreThan(const QVariant& stats1, const QVariant& stats2)
+{
+  return stats1.toMap()["copiedBytes"].toLongLong() > stats2.toMap()["copiedBytes"].toLongLong();
+}
+
+QVariantList PiiEngine::memoryTrafficReport() const
+{
+  QVariantList lstResult;
+  QList<PiiDefaultOperation*> lstOperations(findChildren<PiiDefaultOperation*>());
+  for (int i=0; i<lstOperations.size(); ++i)
+    {
+      QVariantMap mapStats = lstOperations[i]->memoryStatistics();
+      if (mapStats["allocations"].toLongLong() == 0 &&
+          mapStats["clones"].toLongLong() == 0 &&
+          mapStats["reallocations"].toLongLong() == 0)
+        continue;
+      mapStats["name"] = lstOperations[i]->fullName();
+      lstResult << mapStats;
+    }
+  std::stable_sort(lstResult.begin(), lstResult.end(), copiedMoreThan);
+  return lstResult;
+}
+
+void PiiEngine::setRealTimeThreadBudget(int realTimeThreadBudget)
+{
+  _d()->aThreadBudgets[PiiDefaultOperation::RealTimeClass] = qMax(realTimeThreadBudget, 0);
+}
+int PiiEngine::realTimeThreadBudget() const { return _d()->aThreadBudgets[PiiDefaultOperation::RealTimeClass]; }
+void PiiEngine::setNormalThreadBudget(int normalThreadBudget)
+{
+  _d()->aThreadBudgets[PiiDefaultOperation::NormalClass] = qMax(normalThreadBudget, 0);
+}
+int PiiEngine::normalThreadBudget() const { return _d()->aThreadBudgets[PiiDefaultOperation::NormalClass]; }
+void PiiEngine::setBackgroundThreadBudget(int backgroundThreadBudget)
+{
+  _d()->aThreadBudgets[PiiDefaultOperation::BackgroundClass] = qMax(backgroundThreadBudget, 0);
+}
+int PiiEngine::backgroundThreadBudget() const { return _d()->aThreadBudgets[PiiDefaultOperation::BackgroundClass]; }
+
+void PiiEngine::setLockMemory(bool lockMemory)
+{
+  PII_D;
+  d->bLockMemory = lockMemory;
+  if (!lockMemory && d->bMemoryLocked)
+    {
+      Pii::lockProcessMemory(false);
+      d->bMemoryLocked = false;
+    }
+}
+bool PiiEngine::lockMemory() const { return _d()->bLockMemory; }
+void PiiEngine::setTrackMemory(bool trackMemory) { _d()->bTrackMemory = trackMemory; }
+bool PiiEngine::trackMemory() const { return _d()->bTrackMemory; }
 
 void PiiEngine::execute(ErrorHandling errorHandling)
 {
@@ -312,6 +466,34 @@ PiiEngine* PiiEngine::clone() const
   return pResult;
 }
 
+QVariantList PiiEngine::threadPlacement() const
+{
+  QVariantList lstResult;
+  QList<PiiOperation*> lstOperations(findChildren<PiiOperation*>());
+  for (int i=0; i<lstOperations.size(); ++i)
+    {
+      PiiOperation* pOperation = lstOperations[i];
+      if (pOperation->isCompound())
+        continue;
+      QList<int> lstCpus = Pii::parseCpuList(pOperation->effectiveCpuAffinity());
+      QVariant varThreadCount = pOperation->property("threadCount");
+      QStringList lstNodes;
+      if (!lstCpus.isEmpty())
+        {
+          QList<int> lstNodeIndices = Pii::numaNodesOf(lstCpus);
+          for (int j=0; j<lstNodeIndices.size(); ++j)
+            lstNodes << QString::number(lstNodeIndices[j]);
+        }
+      QVariantMap mapPlacement;
+      mapPlacement["name"] = pOperation->fullName();
+      mapPlacement["threadCount"] = varThreadCount.isValid() ? varThreadCount.toInt() : -1;
+      mapPlacement["cpus"] = Pii::cpuListToString(lstCpus);
+      mapPlacement["numaNodes"] = lstNodes.join(",");
+      lstResult << mapPlacement;
+    }
+  return lstResult;
+}
+
 void PiiEngine::save(const QString& fileName,
                      const QVariantMap& config,
                      FileFormat format) const
@@ -75,6 +75,51 @@ class PII_YDIN_EXPORT PiiEngine : public PiiOperationCompound
 
   Q_ENUMS(FileFormat ErrorHandling)
 
+  /**
+   * The maximum number of threads operations in the real-time
+   * [scheduling class](PiiDefaultOperation::schedulingClass) may
+   * use in total. The sum of the `threadCount` properties of all
+   * real-time operations must not exceed this value, or [check()]
+   * will fail. Zero means no limit. The default value is zero.
+   *
+   * A real-time thread that never blocks can starve everything else
+   * on its CPU. Keeping the number of real-time threads below the
+   * number of available cores ensures normal threads still make
+   * progress.
+   */
+  Q_PROPERTY(int realTimeThreadBudget READ realTimeThreadBudget WRITE setRealTimeThreadBudget);
+  /**
+   * The maximum number of threads of operations in the normal
+   * scheduling class. Zero means no limit. The default value is zero.
+   */
+  Q_PROPERTY(int normalThreadBudget READ normalThreadBudget WRITE setNormalThreadBudget);
+  /**
+   * The maximum number of threads of operations in the background
+   * scheduling class. Zero means no limit. The default value is zero.
+   */
+  Q_PROPERTY(int backgroundThreadBudget READ backgroundThreadBudget WRITE setBackgroundThreadBudget);
+
+  /**
+   * If this flag is `true`, all memory of the process will be locked
+   * into physical memory in [check()] to prevent page faults on
+   * real-time processing paths. The memory will be unlocked when
+   * the flag is turned off or the engine is destroyed. The default
+   * value is `false`.
+   *
+   * ! Locking requires privileges or a sufficient `RLIMIT_MEMLOCK`.
+   * If locking fails, a warning is emitted, and the engine runs
+   * without locked memory.
+   */
+  Q_PROPERTY(bool lockMemory READ lockMemory WRITE setLockMemory);
+
+  /**
+   * If this flag is `true`, all operations record the matrix memory
+   * traffic (allocations and deep copies) caused by their processing
+   * rounds. The flag is applied to the operations in [check()]. See
+   * [memoryTrafficReport()]. The default value is `false`.
+   */
+  Q_PROPERTY(bool trackMemory READ trackMemory WRITE setTrackMemory);
+
   friend struct PiiSerialization::Accessor;
   PII_SEPARATE_SAVE_LOAD_MEMBERS
   PII_DECLARE_SAVE_LOAD_MEMBERS
@@ -282,6 +327,109 @@ public:
    */
   PiiEngine* clone() const;
 
+  /**
+   * Returns a report of where the threads of the operations in this
+   * engine are placed. The returned list contains a QVariantMap for
+   * each non-compound operation with the following keys:
+   *
+   * - `name` - the [full name](PiiOperation::fullName()) of the
+   * operation.
+   *
+   * - `threadCount` - the value of the `threadCount` property, or -1
+   * if the operation has no such property.
+   *
+   * - `cpus` - the [effective CPU affinity]
+   * (PiiOperation::effectiveCpuAffinity()) of the operation in a
+   * normalized form. An empty string means the threads are not
+   * bound.
+   *
+   * - `numaNodes` - the NUMA nodes the CPUs belong to, as a
+   * comma-separated list.
+   *
+   * ~~~(c++)
+   * engine.setCpuAffinity("0-7");
+   * engine.childOperation("camera")->setCpuAffinity("8");
+   * QVariantList lstPlacement = engine.threadPlacement();
+   * ~~~
+   */
+  Q_INVOKABLE QVariantList threadPlacement() const;
+
+  /**
+   * Returns processing statistics aggregated by
+   * [scheduling class](PiiDefaultOperation::schedulingClass). The
+   * returned map contains a QVariantMap for each of the keys
+   * `realTime`, `normal` and `background`. Each of them contains the
+   * following keys:
+   *
+   * - `operations` - the number of operations in the class (int)
+   *
+   * - `threads` - the total thread count of the operations (int)
+   *
+   * - `processedCount`, `deadlineMisses`, `maxLatency` and
+   * `totalLatency` - see
+   * [PiiDefaultOperation::schedulingStatistics()].
+   *
+   * ~~~(c++)
+   * QVariantMap mapStats = engine.schedulingStatistics()["realTime"].toMap();
+   * int iMisses = mapStats["deadlineMisses"].toInt();
+   * ~~~
+   */
+  Q_INVOKABLE QVariantMap schedulingStatistics() const;
+
+  /**
+   * Returns a report of load shedding decisions. The returned list
+   * contains a QVariantMap for each operation whose
+   * [overload policy](PiiBasicOperation::overloadPolicy) is not
+   * `BlockWhenOverloaded` or that has dropped objects. In addition
+   * to the keys returned by
+   * [PiiBasicOperation::loadSheddingStatistics()], each map contains
+   * the [full name](PiiOperation::fullName()) of the operation in
+   * `name`.
+   */
+  Q_INVOKABLE QVariantList loadSheddingReport() const;
+
+  /**
+   * Returns a report of matrix memory traffic. The returned list
+   * contains a QVariantMap for each operation that has allocated or
+   * copied matrix data while [trackMemory] was enabled. In addition
+   * to the keys returned by
+   * [PiiDefaultOperation::memoryStatistics()], each map contains the
+   * [full name](PiiOperation::fullName()) of the operation in `name`.
+   * The list is sorted so that the operation that copied the most
+   * bytes comes first.
+   *
+   * ~~~(c++)
+   * engine.setTrackMemory(true);
+   * engine.execute();
+   * // ...
+   * QVariantMap mapWorst = engine.memoryTrafficReport().value(0).toMap();
+   * piiDebug("%s copied %lld bytes", piiPrintable(mapWorst["name"].toString()),
+   *          mapWorst["copiedBytes"].toLongLong());
+   * ~~~
+   */
+  Q_INVOKABLE QVariantList memoryTrafficReport() const;
+
+  /**
+   * Checks that the thread budgets of all scheduling classes are
+   * respected and locks memory if [lockMemory] is `true`. Then checks
+   * all child operations.
+   *
+   * @exception PiiExecutionException& if a thread budget is exceeded
+   * or any child operation fails.
+   */
+  void check(bool reset);
+
+  void setRealTimeThreadBudget(int realTimeThreadBudget);
+  int realTimeThreadBudget() const;
+  void setNormalThreadBudget(int normalThreadBudget);
+  int normalThreadBudget() const;
+  void setBackgroundThreadBudget(int backgroundThreadBudget);
+  int backgroundThreadBudget() const;
+  void setLockMemory(bool lockMemory);
+  bool lockMemory() const;
+  void setTrackMemory(bool trackMemory);
+  bool trackMemory() const;
+
   /**
    * Saves the engine to *fileName*. The *format* argument specifies
    * the file format. The *config* map is used to add configuration
@@ -350,6 +498,17 @@ public:
                          QVariantMap* config = 0);
 
 protected:
+  /// @internal
+  class Data : public PiiOperationCompound::Data
+  {
+  public:
+    Data();
+    int aThreadBudgets[3];
+    bool bLockMemory, bMemoryLocked;
+    bool bTrackMemory;
+  };
+  PII_UNSAFE_D_FUNC;
+
   /// @internal
   PiiEngine(Data* data);
 
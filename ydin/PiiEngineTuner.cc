@@ -0,0 +1,354 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#include "PiiEngineTuner.h"
+#include "PiiEngine.h"
+#include "PiiDefaultOperation.h"
+#include "PiiInputSocket.h"
+
+#include <PiiTimer.h>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDateTime>
+#include <QMap>
+
+static const int iSamplesPerRound = 10;
+static const int iMaxDecisions = 100;
+
+// Thresholds for thread tuning. Utilization and blocked time are
+// fractions of the wall-clock time available to the active threads.
+static const double dHighUtilization = 0.85;
+static const double dLowUtilization = 0.4;
+static const double dHighBlocking = 0.3;
+static const double dLowBlocking = 0.1;
+static const double dBacklogged = 0.5;
+// Thresholds for queue tuning (average occupancy).
+static const double dBursty = 0.75;
+static const double dIdleQueue = 0.25;
+
+class PiiEngineTuner::Thread : public QThread
+{
+public:
+  Thread(PiiEngineTuner* tuner) : _pTuner(tuner) {}
+
+protected:
+  void run() { _pTuner->run(); }
+
+private:
+  PiiEngineTuner* _pTuner;
+};
+
+class PiiEngineTuner::Data
+{
+public:
+  struct OperationState
+  {
+    OperationState() :
+      iThreadVotes(0), iQueueVotes(0),
+      iLastBusyTime(-1), iLastBlockedTime(0),
+      dOccupancySum(0), dOccupancyMax(0)
+    {}
+
+    int iThreadVotes, iQueueVotes;
+    qint64 iLastBusyTime, iLastBlockedTime;
+    double dOccupancySum, dOccupancyMax;
+  };
+
+  Data(PiiEngineTuner* tuner, PiiEngine* engine) :
+    thread(tuner),
+    pEngine(engine),
+    iCoreBudget(0),
+    iTuningInterval(1000),
+    iHysteresis(3),
+    iMaxQueueCapacity(16),
+    bRunning(false)
+  {}
+
+  Thread thread;
+  PiiEngine* pEngine;
+  int iCoreBudget, iTuningInterval, iHysteresis, iMaxQueueCapacity;
+  volatile bool bRunning;
+  QMutex waitMutex;
+  QWaitCondition stopCondition;
+  mutable QMutex decisionMutex;
+  QVariantList lstDecisions;
+  QMap<PiiDefaultOperation*, OperationState> mapStates;
+  QMap<PiiInputSocket*, int> mapOriginalCapacities;
+};
+
+PiiEngineTuner::PiiEngineTuner(PiiEngine* engine, QObject* parent) :
+  QObject(parent),
+  d(new Data(this, engine))
+{
+}
+
+PiiEngineTuner::~PiiEngineTuner()
+{
+  stop();
+  delete d;
+}
+
+void PiiEngineTuner::start()
+{
+  if (d->thread.isRunning())
+    return;
+
+  d->mapOriginalCapacities.clear();
+  QList<PiiDefaultOperation*> lstOperations(d->pEngine->findChildren<PiiDefaultOperation*>());
+  for (int i=0; i<lstOperations.size(); ++i)
+    {
+      QList<PiiInputSocket*> lstInputs(lstOperations[i]->inputSockets());
+      for (int j=0; j<lstInputs.size(); ++j)
+        {
+          d->mapOriginalCapacities[lstInputs[j]] = lstInputs[j]->queueCapacity();
+          // Queue storage can be safely reallocated only now. This is
+          // done in the calling thread so that the engine cannot be
+          // started in between.
+          if (d->pEngine->state() == PiiOperation::Stopped)
+            lstInputs[j]->reserveQueueCapacity(d->iMaxQueueCapacity);
+        }
+    }
+
+  // The flag must be set before the thread starts. Otherwise a stop()
+  // issued before run() gets scheduled would be overwritten.
+  synchronized (d->waitMutex)
+    d->bRunning = true;
+  d->thread.start();
+}
+
+void PiiEngineTuner::stop()
+{
+  synchronized (d->waitMutex)
+    {
+      d->bRunning = false;
+      d->stopCondition.wakeAll();
+    }
+  d->thread.wait();
+}
+
+bool PiiEngineTuner::isRunning() const
+{
+  return d->thread.isRunning();
+}
+
+bool PiiEngineTuner::waitFor(int ms)
+{
+  QMutexLocker lock(&d->waitMutex);
+  if (d->bRunning)
+    d->stopCondition.wait(&d->waitMutex, ms);
+  return d->bRunning;
+}
+
+void PiiEngineTuner::run()
+{
+  if (!d->bRunning)
+    return;
+  d->mapStates.clear();
+
+  QList<PiiDefaultOperation*> lstOperations;
+  PiiTimer timer;
+  while (d->bRunning)
+    {
+      lstOperations = d->pEngine->findChildren<PiiDefaultOperation*>();
+      for (int i=0; i<lstOperations.size(); ++i)
+        lstOperations[i]->setCollectingStatistics(true);
+
+      // Sample queue occupancies during the round.
+      for (int iSample=0; iSample<iSamplesPerRound && d->bRunning; ++iSample)
+        {
+          if (!waitFor(qMax(d->iTuningInterval / iSamplesPerRound, 1)))
+            break;
+          for (int i=0; i<lstOperations.size(); ++i)
+            {
+              double dOccupancy = 0;
+              QList<PiiInputSocket*> lstInputs(lstOperations[i]->inputSockets());
+              for (int j=0; j<lstInputs.size(); ++j)
+                if (lstInputs[j]->isConnected())
+                  dOccupancy = qMax(dOccupancy, qMin(lstInputs[j]->queueOccupancy(), 1.0));
+              Data::OperationState& state = d->mapStates[lstOperations[i]];
+              state.dOccupancySum += dOccupancy;
+              state.dOccupancyMax = qMax(state.dOccupancyMax, dOccupancy);
+            }
+        }
+
+      if (!d->bRunning)
+        break;
+
+      double dInterval = double(timer.restart());
+      if (d->pEngine->state() == PiiOperation::Running)
+        tune(dInterval);
+      else
+        d->mapStates.clear();
+    }
+
+  lstOperations = d->pEngine->findChildren<PiiDefaultOperation*>();
+  for (int i=0; i<lstOperations.size(); ++i)
+    lstOperations[i]->setCollectingStatistics(false);
+}
+
+void PiiEngineTuner::tune(double interval)
+{
+  QList<PiiDefaultOperation*> lstOperations(d->pEngine->findChildren<PiiDefaultOperation*>());
+
+  int iCoreBudget = d->iCoreBudget > 0 ? d->iCoreBudget : QThread::idealThreadCount();
+  int iCoresUsed = 0;
+  for (int i=0; i<lstOperations.size(); ++i)
+    iCoresUsed += lstOperations[i]->activeThreadLimit();
+
+  for (int i=0; i<lstOperations.size(); ++i)
+    {
+      PiiDefaultOperation* pOperation = lstOperations[i];
+      Data::OperationState& state = d->mapStates[pOperation];
+      double dAverageOccupancy = state.dOccupancySum / iSamplesPerRound;
+      double dMaxOccupancy = state.dOccupancyMax;
+      state.dOccupancySum = state.dOccupancyMax = 0;
+
+      if (!pOperation->hasConnectedInputs())
+        continue;
+
+      QVariantMap mapStats = pOperation->schedulingStatistics();
+      qint64 iBusyTime = mapStats["totalLatency"].toLongLong();
+      qint64 iBlockedTime = mapStats["blockedTime"].toLongLong();
+
+      // Statistics may have been reset by check(). The first round
+      // only initializes the counters.
+      if (state.iLastBusyTime >= 0 &&
+          iBusyTime >= state.iLastBusyTime && iBlockedTime >= state.iLastBlockedTime &&
+          pOperation->threadCount() > 1)
+        {
+          int iLimit = pOperation->activeThreadLimit();
+          double dUtilization = (iBusyTime - state.iLastBusyTime) / (interval * iLimit);
+          double dBlocked = (iBlockedTime - state.iLastBlockedTime) / (interval * iLimit);
+
+          int iVote = 0;
+          if (dUtilization > dHighUtilization && dAverageOccupancy > dBacklogged &&
+              dBlocked < dLowBlocking && iLimit < pOperation->threadCount())
+            iVote = 1;
+          else if (iLimit > 1 && (dUtilization < dLowUtilization || dBlocked > dHighBlocking))
+            iVote = -1;
+
+          // A vote in the opposite direction restarts counting.
+          if (iVote == 0 || (iVote > 0) != (state.iThreadVotes > 0))
+            state.iThreadVotes = iVote;
+          else
+            state.iThreadVotes += iVote;
+
+          if (qAbs(state.iThreadVotes) >= d->iHysteresis)
+            {
+              QString strReason = tr("utilization %1, blocked %2, queue occupancy %3")
+                .arg(dUtilization, 0, 'f', 2)
+                .arg(dBlocked, 0, 'f', 2)
+                .arg(dAverageOccupancy, 0, 'f', 2);
+              if (state.iThreadVotes > 0)
+                {
+                  if (iCoresUsed < iCoreBudget)
+                    {
+                      pOperation->setActiveThreadLimit(iLimit + 1);
+                      ++iCoresUsed;
+                      addDecision(pOperation->fullName(), "activeThreadLimit", iLimit, iLimit + 1, strReason);
+                    }
+                  else
+                    addDecision(pOperation->fullName(), "denied", iLimit, iLimit,
+                                tr("core budget (%1) exhausted; %2").arg(iCoreBudget).arg(strReason));
+                }
+              else
+                {
+                  pOperation->setActiveThreadLimit(iLimit - 1);
+                  --iCoresUsed;
+                  addDecision(pOperation->fullName(), "activeThreadLimit", iLimit, iLimit - 1, strReason);
+                }
+              state.iThreadVotes = 0;
+            }
+        }
+      state.iLastBusyTime = iBusyTime;
+      state.iLastBlockedTime = iBlockedTime;
+
+      // Queue tuning. Bursty load fills the queue now and then;
+      // steady overload keeps it full, and a larger queue would only
+      // add latency.
+      int iVote = 0;
+      if (dMaxOccupancy >= 1.0 && dAverageOccupancy < dBursty)
+        iVote = 1;
+      else if (dAverageOccupancy < dIdleQueue)
+        iVote = -1;
+      if (iVote == 0 || (iVote > 0) != (state.iQueueVotes > 0))
+        state.iQueueVotes = iVote;
+      else
+        state.iQueueVotes += iVote;
+
+      if (qAbs(state.iQueueVotes) < d->iHysteresis)
+        continue;
+
+      QString strReason = tr("average queue occupancy %1, peak %2")
+        .arg(dAverageOccupancy, 0, 'f', 2)
+        .arg(dMaxOccupancy, 0, 'f', 2);
+      QList<PiiInputSocket*> lstInputs(pOperation->inputSockets());
+      for (int j=0; j<lstInputs.size(); ++j)
+        {
+          PiiInputSocket* pInput = lstInputs[j];
+          if (!pInput->isConnected())
+            continue;
+          int iCapacity = pInput->queueCapacity(), iNewCapacity;
+          if (state.iQueueVotes > 0)
+            iNewCapacity = qMin(iCapacity * 2, qMin(pInput->reservedQueueCapacity(), d->iMaxQueueCapacity));
+          else
+            iNewCapacity = qMax(iCapacity / 2, d->mapOriginalCapacities.value(pInput, 1));
+          if (iNewCapacity != iCapacity)
+            {
+              pInput->setQueueCapacity(iNewCapacity);
+              addDecision(pOperation->fullName() + "." + pInput->objectName(),
+                          "queueCapacity", iCapacity, iNewCapacity, strReason);
+            }
+        }
+      state.iQueueVotes = 0;
+    }
+}
+
+void PiiEngineTuner::addDecision(const QString& operation, const QString& parameter,
+                                 int oldValue, int newValue, const QString& reason)
+{
+  piiDebug("Tuner: %s %s %d -> %d (%s)",
+           piiPrintable(operation), piiPrintable(parameter),
+           oldValue, newValue, piiPrintable(reason));
+  QVariantMap mapDecision;
+  mapDecision["time"] = QDateTime::currentDateTime();
+  mapDecision["operation"] = operation;
+  mapDecision["parameter"] = parameter;
+  mapDecision["oldValue"] = oldValue;
+  mapDecision["newValue"] = newValue;
+  mapDecision["reason"] = reason;
+  synchronized (d->decisionMutex)
+    {
+      d->lstDecisions << mapDecision;
+      while (d->lstDecisions.size() > iMaxDecisions)
+        d->lstDecisions.removeFirst();
+    }
+}
+
+QVariantList PiiEngineTuner::decisions() const
+{
+  QMutexLocker lock(&d->decisionMutex);
+  return d->lstDecisions;
+}
+
+void PiiEngineTuner::setCoreBudget(int coreBudget) { d->iCoreBudget = qMax(coreBudget, 0); }
+int PiiEngineTuner::coreBudget() const { return d->iCoreBudget; }
+void PiiEngineTuner::setTuningInterval(int tuningInterval) { d->iTuningInterval = qMax(tuningInterval, 10); }
+int PiiEngineTuner::tuningInterval() const { return d->iTuningInterval; }
+void PiiEngineTuner::setHysteresis(int hysteresis) { d->iHysteresis = qMax(hysteresis, 1); }
+int PiiEngineTuner::hysteresis() const { return d->iHysteresis; }
+void PiiEngineTuner::setMaxQueueCapacity(int maxQueueCapacity) { d->iMaxQueueCapacity = qMax(maxQueueCapacity, 1); }
+int PiiEngineTuner::maxQueueCapacity() const { return d->iMaxQueueCapacity; }
@@ -0,0 +1,161 @@
+/* This file is part of Into.
+ * Copyright (C) Intopii 2013.
+ * All rights reserved.
+ *
+ * Licensees holding a commercial Into license may use this file in
+ * accordance with the commercial license agreement. Please see
+ * LICENSE.commercial for commercial licensing terms.
+ *
+ * Alternatively, this file may be used under the terms of the GNU
+ * Affero General Public License version 3 as published by the Free
+ * Software Foundation. In addition, Intopii gives you special rights
+ * to use Into as a part of open source software projects. Please
+ * refer to LICENSE.AGPL3 for details.
+ */
+
+#ifndef _PIIENGINETUNER_H
+#define _PIIENGINETUNER_H
+
+#include <QObject>
+#include <QVariantList>
+#include "PiiYdin.h"
+
+class PiiEngine;
+
+/**
+ * A controller that adjusts the concurrency and queue capacities of
+ * the operations in an engine at run time. The tuner runs in a
+ * separate thread that periodically samples the utilization of each
+ * [PiiDefaultOperation], the time its threads spend blocked waiting
+ * for receivers, and the occupancy of its input queues.
+ *
+ * - The number of concurrently active threads (see
+ * [PiiDefaultOperation::setActiveThreadLimit()]) of multi-threaded
+ * operations is increased if the threads are busy, the input queues
+ * are backlogged, and the threads are not blocked by downstream
+ * operations. The total number of active threads in the engine is
+ * kept within [coreBudget]. The limit is decreased if the threads
+ * are mostly idle or blocked. [PiiDefaultOperation::threadCount]
+ * remains the upper limit for the number of active threads.
+ *
+ * - Input queue capacities are increased if the queues occasionally
+ * fill up but are mostly not full (bursty input), and decreased back
+ * towards their original values if they are mostly empty.
+ *
+ * A change is only made if the same decision has been reached on
+ * [hysteresis] consecutive rounds, which prevents oscillation. All
+ * decisions are logged with `piiDebug()` and can be retrieved with
+ * [decisions()].
+ *
+ * ~~~(c++)
+ * PiiEngine engine;
+ * // ... create and connect operations ...
+ * PiiEngineTuner tuner(&engine);
+ * tuner.setCoreBudget(8);
+ * tuner.start();
+ * engine.execute();
+ * ~~~
+ *
+ * If the tuner is started while the engine is stopped, it reserves
+ * storage for [maxQueueCapacity] objects in all input queues so that
+ * their capacities can later be changed without reallocation.
+ * Otherwise, queue capacities can only be increased up to the
+ * storage already reserved. The tuner does not change anything
+ * while the engine is not running.
+ */
+class PII_YDIN_EXPORT PiiEngineTuner : public QObject
+{
+  Q_OBJECT
+
+  /**
+   * The maximum total number of threads that may be actively
+   * processing objects at the same time. Single-threaded operations
+   * count as one thread each. Zero (the default) means the number of
+   * processor cores in the system.
+   */
+  Q_PROPERTY(int coreBudget READ coreBudget WRITE setCoreBudget);
+
+  /**
+   * The time between successive tuning rounds in milliseconds. The
+   * default is 1000.
+   */
+  Q_PROPERTY(int tuningInterval READ tuningInterval WRITE setTuningInterval);
+
+  /**
+   * The number of consecutive rounds a decision must be repeated
+   * before it is applied. The default is 3.
+   */
+  Q_PROPERTY(int hysteresis READ hysteresis WRITE setHysteresis);
+
+  /**
+   * The maximum capacity the tuner will give to an input queue. The
+   * default is 16.
+   */
+  Q_PROPERTY(int maxQueueCapacity READ maxQueueCapacity WRITE setMaxQueueCapacity);
+
+public:
+  /**
+   * Creates a new tuner that controls the operations in *engine*.
+   * The engine must remain valid as long as the tuner is running.
+   */
+  PiiEngineTuner(PiiEngine* engine, QObject* parent = 0);
+  /**
+   * Stops the tuner and waits for its thread to exit.
+   */
+  ~PiiEngineTuner();
+
+  /**
+   * Starts the tuner thread. Does nothing if the tuner is already
+   * running.
+   */
+  Q_INVOKABLE void start();
+
+  /**
+   * Signals the tuner to stop and waits until it has finished.
+   * Statistics collection will be turned off in all operations.
+   */
+  Q_INVOKABLE void stop();
+
+  /**
+   * Returns `true` if the tuner thread is running.
+   */
+  Q_INVOKABLE bool isRunning() const;
+
+  /**
+   * Returns the most recent tuning decisions, oldest first. Each
+   * entry is a QVariantMap with the following keys:
+   *
+   * - `time` - the time of the decision (QDateTime)
+   * - `operation` - the full name of the operation (QString)
+   * - `parameter` - either "activeThreadLimit", "queueCapacity" or
+   * "denied" if an increase was prevented by [coreBudget] (QString)
+   * - `oldValue` - the value before the change (int)
+   * - `newValue` - the value after the change (int)
+   * - `reason` - a human-readable explanation (QString)
+   */
+  Q_INVOKABLE QVariantList decisions() const;
+
+  void setCoreBudget(int coreBudget);
+  int coreBudget() const;
+  void setTuningInterval(int tuningInterval);
+  int tuningInterval() const;
+  void setHysteresis(int hysteresis);
+  int hysteresis() const;
+  void setMaxQueueCapacity(int maxQueueCapacity);
+  int maxQueueCapacity() const;
+
+private:
+  class Thread;
+  friend class Thread;
+  class Data;
+  Data* d;
+
+  void run();
+
+  bool waitFor(int ms);
+  void tune(double interval);
+  void addDecision(const QString& operation, const QString& parameter,
+                   int oldValue, int newValue, const QString& reason);
+};
+
+#endif //_PIIENGINETUNER_H
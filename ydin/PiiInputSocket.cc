@@ -30,7 +30,8 @@ PiiInputSocket::Data::Data() :
   bOptional(false),
   pController(PiiNullInputController::instance()),
   iQueueStart(0),
-  iQueueLength(0)
+  iQueueLength(0),
+  iQueueCapacity(0)
 {}
 
 bool PiiInputSocket::Data::setInputConnected(bool connected)
@@ -65,8 +66,25 @@ void PiiInputSocket::setQueueCapacity(int queueCapacity)
 {
   PII_D;
   if (queueCapacity < 1) return;
-  d->lstQueue.resize(queueCapacity);
-  reset();
+  d->iRequestedCapacity.store(queueCapacity);
+  // Reallocation is only allowed while the operation is stopped.
+  // Otherwise, the thread that receives and shifts objects under the
+  // processor's lock will pick up the new capacity in shift().
+  if (queueCapacity > d->lstQueue.size())
+    {
+      d->lstQueue.resize(queueCapacity);
+      reset();
+    }
+}
+
+void PiiInputSocket::reserveQueueCapacity(int capacity)
+{
+  PII_D;
+  if (capacity > d->lstQueue.size())
+    {
+      d->lstQueue.resize(capacity);
+      reset();
+    }
 }
 
 void PiiInputSocket::receive(const PiiVariant& obj)
@@ -87,10 +105,12 @@ void PiiInputSocket::shift()
   d->lstQueue[d->iQueueStart] = PiiVariant();
   // Rotate the queue
   d->iQueueStart = (d->iQueueStart+1) % d->lstQueue.size();
+  const bool bWasFull = d->iQueueLength >= d->iQueueCapacity;
   --d->iQueueLength;
+  d->iQueueCapacity = d->iRequestedCapacity.load();
   // Signal the sender if the queue was full (there may be a thread
   // waiting).
-  if (d->iQueueLength == d->lstQueue.size()-1 && d->pListener != 0)
+  if (bWasFull && d->iQueueLength < d->iQueueCapacity && d->pListener != 0)
     d->pListener->inputReady(this);
 }
 
@@ -154,6 +174,7 @@ void PiiInputSocket::reset()
   d->lstProcessableObjects.clear();
   d->iQueueLength = 0;
   d->iQueueStart = 0;
+  d->iQueueCapacity = d->iRequestedCapacity.load();
 }
 
 void PiiInputSocket::setController(PiiInputController* controller)
@@ -188,8 +209,10 @@ PiiInputController* PiiInputSocket::controller() const { return _d()->pControlle
 PiiVariant PiiInputSocket::queuedObject(int index) const { return _d()->lstQueue[queueIndex(index)]; }
 unsigned int PiiInputSocket::queuedType(int index) const { return _d()->lstQueue[queueIndex(index)].type(); }
 int PiiInputSocket::queueLength() const { return _d()->iQueueLength; }
-int PiiInputSocket::queueCapacity() const { return _d()->lstQueue.size(); }
-bool PiiInputSocket::canReceive() const { return _d()->lstQueue.size() > _d()->iQueueLength; }
+int PiiInputSocket::queueCapacity() const { return _d()->iRequestedCapacity.load(); }
+int PiiInputSocket::reservedQueueCapacity() const { return _d()->lstQueue.size(); }
+double PiiInputSocket::queueOccupancy() const { return double(_d()->iQueueLength) / _d()->iQueueCapacity; }
+bool PiiInputSocket::canReceive() const { return _d()->iQueueCapacity > _d()->iQueueLength; }
 void PiiInputSocket::setOptional(bool optional) { _d()->bOptional = optional; }
 bool PiiInputSocket::isOptional() const { return _d()->bOptional; }
 
@@ -20,6 +20,7 @@
 #include "PiiAbstractInputSocket.h"
 #include "PiiInputController.h"
 
+#include <PiiAtomicInt.h>
 #include <QVarLengthArray>
 #include <QPair>
 
@@ -77,10 +78,17 @@ class PII_YDIN_EXPORT PiiInputSocket : public PiiAbstractInputSocket
 
   /**
    * The capacity of the input queue. The default value is 2. The
-   * minimum value for queue capacity is 1. Note that queue capacity
-   * can safely be changed only if the parent operation is stopped.
-   * Changing the capacity will destroy all objects currently in the
-   * queue.
+   * minimum value for queue capacity is 1. Increasing the capacity
+   * beyond the storage reserved for the queue (see
+   * [reserveQueueCapacity()]) reallocates the queue and destroys all
+   * objects currently in it. This can safely be done only if the
+   * parent operation is stopped. Within the reserved storage, the
+   * capacity can be changed at any time from any thread. The new
+   * capacity takes effect when the processing thread next
+   * [shifts](shift()) the queue, or when the socket is
+   * [reset()]. If the capacity is decreased below the number of
+   * queued objects, no new objects will be accepted until the queue
+   * has drained.
    */
   Q_PROPERTY(int queueCapacity READ queueCapacity WRITE setQueueCapacity);
 
@@ -193,15 +201,38 @@ public:
    */
   void setQueueCapacity(int queueCapacity);
   /**
-   * Returns the capacity of the input queue.
+   * Returns the capacity of the input queue. If the capacity has been
+   * changed but the change has not taken effect yet, the new
+   * capacity will be returned.
    */
   int queueCapacity() const;
 
+  /**
+   * Reserves storage for *capacity* objects in the input queue. Once
+   * the storage has been reserved, [queueCapacity] can be changed up
+   * to *capacity* while the operation is running. If the storage
+   * needs to be enlarged, all queued objects will be destroyed.
+   * Therefore, this function must only be called when the parent
+   * operation is stopped.
+   */
+  void reserveQueueCapacity(int capacity);
+  /**
+   * Returns the number of objects storage has been reserved for.
+   * This is always greater than or equal to [queueCapacity].
+   */
+  int reservedQueueCapacity() const;
+
   /**
    * Returns the number of objects currently in the input queue.
    */
   int queueLength() const;
 
+  /**
+   * Returns the ratio of [queueLength()] to [queueCapacity()]. One
+   * means that the queue is full.
+   */
+  double queueOccupancy() const;
+
   /**
    * Returns the object at `index` in the input queue. If there is no
    * such object, an invalid variant will be returned.
@@ -256,6 +287,13 @@ protected:
     PiiVariant varProcessableObject;
     QVarLengthArray<QPair<Qt::HANDLE, PiiVariant> > lstProcessableObjects;
     int iQueueStart, iQueueLength;
+    // The logical capacity may be smaller than lstQueue.size(). Only
+    // changed by the thread that owns the queue, in shift() and
+    // reset().
+    int iQueueCapacity;
+    // The capacity set with setQueueCapacity(), applied on the next
+    // shift() or reset().
+    PiiAtomicInt iRequestedCapacity;
     mutable QMutex firstObjectMutex;
   };
   PII_D_FUNC;
@@ -61,6 +61,7 @@ protected:
         _threadId = QThread::currentThreadId();
         _threadStartedCondition.wakeOne();
       }
+    _pProcessor->bindThread();
     QMutex* pThreadMutex = &_pProcessor->_threadMutex;
     try
       {
@@ -163,7 +164,9 @@ void PiiMultiThreadedProcessor::endEmit(Qt::HANDLE threadId)
   // Retry emission to the outputs that haven't finished yet.
   while (!bAllCompleted && _bReset)
     {
+      PiiTimer timer;
       _freeInputCondition.wait();
+      _pParentOp->addBlockedTime(timer.microseconds());
       bAllCompleted = true;
 
       for (int i=0; i<iCnt; ++i)
@@ -250,8 +253,11 @@ PiiMultiProcessorThread* PiiMultiThreadedProcessor::reserveThread()
   if (!_bReset)
     return 0;
 
+  // Free-running threads are not limited.
+  int iLimit = _pFlowController != 0 ? _pParentOp->activeThreadLimit() : _pParentOp->threadCount();
   // Add new threads until the pool is full
-  if (_lstAllThreads.size() < _pParentOp->threadCount())
+  if (_lstAllThreads.size() < _pParentOp->threadCount() &&
+      busyThreadCount() < iLimit)
     {
       PiiMultiProcessorThread* pThread = new PiiMultiProcessorThread(this);
       pThread->setObjectName(_pParentOp->objectName());
@@ -260,14 +266,19 @@ PiiMultiProcessorThread* PiiMultiThreadedProcessor::reserveThread()
       pThread->start(_priority, _pFlowController == 0);
       return pThread;
     }
-  else if (!_lstFreeThreads.isEmpty())
-    return _lstFreeThreads.takeFirst();
 
-  _freeThreadCondition.wait(&_threadMutex);
-  // This may happen if a thread fails
-  if (_lstFreeThreads.size() == 0)
-    return 0;
-  return _lstFreeThreads.takeFirst();
+  forever
+    {
+      if (!_lstFreeThreads.isEmpty() && busyThreadCount() < iLimit)
+        return _lstFreeThreads.takeFirst();
+
+      _freeThreadCondition.wait(&_threadMutex);
+      // This may happen if a thread fails
+      if (_lstFreeThreads.size() == 0)
+        return 0;
+      // The limit may have been changed while waiting.
+      iLimit = _pParentOp->activeThreadLimit();
+    }
 }
 
 // _threadMutex must be held when calling this function
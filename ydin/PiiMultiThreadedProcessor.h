@@ -69,6 +69,8 @@ private:
   void waitAllThreadsToStop();
 
   inline void process() { _pParentOp->processLocked(); }
+  inline void bindThread() { _pParentOp->bindCurrentThread(); }
+  inline int busyThreadCount() const { return _lstAllThreads.size() - _lstFreeThreads.size(); }
 
   volatile bool _bReset;
   bool _bBlocked;
@@ -589,6 +589,25 @@ void PiiOperation::setActivityMode(ActivityMode activityMode)
 }
 
 PiiOperation::ActivityMode PiiOperation::activityMode() const { return d->activityMode; }
+
+void PiiOperation::setCpuAffinity(const QString& cpuAffinity)
+{
+  synchronized (&d->stateMutex)
+    {
+      if (state() member_of (Stopped, Paused))
+        d->strCpuAffinity = cpuAffinity;
+    }
+}
+
+QString PiiOperation::cpuAffinity() const { return d->strCpuAffinity; }
+
+QString PiiOperation::effectiveCpuAffinity() const
+{
+  if (!d->strCpuAffinity.isEmpty())
+    return d->strCpuAffinity;
+  PiiOperationCompound* pParent = parentOperation();
+  return pParent != 0 ? pParent->effectiveCpuAffinity() : QString();
+}
 void PiiOperation::updateActivityMode(ActivityMode) {}
 
 void PiiOperation::setErrorString(const QString& errorString) { d->strErrorString = errorString; }
@@ -113,6 +113,33 @@ class PII_YDIN_EXPORT PiiOperation : public QObject, public PiiConfigurable
    */
   Q_PROPERTY(ActivityMode activityMode READ activityMode WRITE setActivityMode NOTIFY activityModeChanged);
 
+  /**
+   * The processor cores the threads of this operation are allowed to
+   * run on. The value is a comma-separated list of CPU indices and
+   * index ranges, for example "0-3,8". If all of the listed CPUs
+   * belong to the same NUMA node, memory allocated by the threads
+   * (including [PiiMatrix] data produced by the operation) will be
+   * preferably placed on that node.
+   *
+   * If this property is empty (the default), the affinity of the
+   * [parent compound](parentOperation()) will be used. Setting the
+   * affinity of a compound (including [PiiEngine]) thus
+   * restricts all operations within it, unless they have an affinity
+   * of their own. If no affinity is set at any level, the operating
+   * system is free to place the threads.
+   *
+   * Operations that have no threads of their own (`threadCount` = 0)
+   * are executed in the threads of the operations that send them
+   * objects, and this property has no effect on them. Operations
+   * that receive data from external threads, such as camera drivers
+   * or I/O polling threads, apply the affinity to those threads.
+   *
+   * This property can only be changed if the operation is currently
+   * stopped or paused. The changes take effect when the operation is
+   * restarted. See [PiiEngine::threadPlacement()].
+   */
+  Q_PROPERTY(QString cpuAffinity READ cpuAffinity WRITE setCpuAffinity);
+
   Q_ENUMS(State ProtectionLevel ActivityMode);
 
   PII_DECLARE_VIRTUAL_METAOBJECT_FUNCTION;
@@ -581,6 +608,17 @@ public:
   void setActivityMode(ActivityMode activityMode);
   ActivityMode activityMode() const;
 
+  void setCpuAffinity(const QString& cpuAffinity);
+  QString cpuAffinity() const;
+
+  /**
+   * Returns the CPU affinity that is in effect for this operation.
+   * If [cpuAffinity] is set, returns it. Otherwise, returns the
+   * effective CPU affinity of the parent operation, or an empty
+   * string if there is no parent.
+   */
+  Q_INVOKABLE QString effectiveCpuAffinity() const;
+
   /**
    * Stores the cause of the last error. The error string will be
    * cleared by [PiiOperationCompound::check()] when the configuration
@@ -637,6 +675,7 @@ protected:
     QMap<QString,PropertyList> mapCachedProperties;
     mutable const QMap<QString,QVariantMap>* pmapMetaPropertyCache;
     QString strErrorString;
+    QString strCpuAffinity;
   } *d;
 
   PiiOperation(Data* d);
@@ -17,8 +17,10 @@
 #include "PiiInputSocket.h"
 #include "PiiYdinTypes.h"
 #include "PiiOperation.h"
+#include "PiiProxySocket.h"
 
 #include <PiiUtil.h>
+#include <PiiTimer.h>
 #include <PiiSerializableExport.h> // MSVC
 
 #include <QThread>
@@ -33,7 +35,8 @@ PiiOutputSocket::Data::Data() :
   pFirstController(0),
   bInterrupted(false),
   pbInputCompleted(0),
-  activeThreadId(0)
+  activeThreadId(0),
+  iBlockedTime(0)
 {}
 
 PiiOutputSocket::Data::~Data()
@@ -113,6 +116,23 @@ bool PiiOutputSocket::isConnected() const
   return _d()->bConnected;
 }
 
+double PiiOutputSocket::queueOccupancy() const
+{
+  const PII_D;
+  double dOccupancy = 0;
+  for (int i=0; i<d->lstInputs.size(); ++i)
+    {
+      QList<PiiAbstractInputSocket*> lstInputs(PiiProxySocket::connectedInputs(d->lstInputs.inputAt(i)));
+      for (int j=0; j<lstInputs.size(); ++j)
+        {
+          PiiInputSocket* pInput = qobject_cast<PiiInputSocket*>(lstInputs[j]);
+          if (pInput != 0)
+            dOccupancy = qMax(dOccupancy, pInput->queueOccupancy());
+        }
+    }
+  return dOccupancy;
+}
+
 void PiiOutputSocket::interrupt()
 {
   PII_D;
@@ -129,6 +149,25 @@ void PiiOutputSocket::reset()
   d->freeInputCondition.wakeAll();
   d->lstBuffer.clear();
   d->activeThreadId = 0;
+  QMutexLocker lock(&d->blockedTimeLock);
+  d->iBlockedTime = 0;
+}
+
+qint64 PiiOutputSocket::blockedTime() const
+{
+  const PII_D;
+  QMutexLocker lock(&d->blockedTimeLock);
+  return d->iBlockedTime;
+}
+
+void PiiOutputSocket::waitForFreeInput()
+{
+  PII_D;
+  PiiTimer timer;
+  d->freeInputCondition.wait();
+  qint64 iElapsed = timer.microseconds();
+  QMutexLocker lock(&d->blockedTimeLock);
+  d->iBlockedTime += iElapsed;
 }
 
 bool PiiOutputSocket::flushBuffer()
@@ -220,7 +259,7 @@ void PiiOutputSocket::endEmit(Qt::HANDLE activeThreadId)
     {
       if (tryEndEmit(activeThreadId))
         return;
-      d->freeInputCondition.wait();
+      waitForFreeInput();
     }
   while (!d->bInterrupted);
   throw PiiExecutionException(PiiExecutionException::Interrupted);
@@ -301,7 +340,7 @@ void PiiOutputSocket::emitNonThreaded(const PiiVariant& object)
     {
       if (tryEmit(object))
         return;
-      d->freeInputCondition.wait();
+      waitForFreeInput();
     }
   while (!d->bInterrupted);
   throw PiiExecutionException(PiiExecutionException::Interrupted);
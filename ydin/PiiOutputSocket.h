@@ -274,6 +274,21 @@ public:
    */
   Q_INVOKABLE bool isConnected() const;
 
+  /**
+   * Returns the [occupancy](PiiInputSocket::queueOccupancy()) of the
+   * fullest input queue this output is connected to, either directly
+   * or through proxies. Returns zero if the output is not connected.
+   * A value close to one means that [emitObject()] is likely to block.
+   */
+  Q_INVOKABLE double queueOccupancy() const;
+
+  /**
+   * Returns the total time (in microseconds) threads have been
+   * blocked in this output waiting for the receivers to accept
+   * objects, since the last [reset()].
+   */
+  Q_INVOKABLE qint64 blockedTime() const;
+
   /**
    * Interrupts any ongoing object emission. This function is used
    * when the operation must be cancelled as soon as possible without
@@ -393,6 +408,8 @@ protected:
     ThreadList lstThreads;
     QMutex emitLock;
     QWaitCondition endEmitCondition;
+    mutable QMutex blockedTimeLock;
+    qint64 iBlockedTime;
   };
   PII_UNSAFE_D_FUNC;
 
@@ -403,6 +420,7 @@ private:
   bool flushBuffer();
   void emitThreaded(const PiiVariant& object);
   void emitNonThreaded(const PiiVariant& object);
+  void waitForFreeInput();
 };
 
 Q_DECLARE_METATYPE(PiiOutputSocket*);
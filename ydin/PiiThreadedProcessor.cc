@@ -191,6 +191,8 @@ void PiiThreadedProcessor::run()
         _pParentOp->setState(PiiOperation::Running);
     }
 
+  _pParentOp->bindCurrentThread();
+
   // Run the loop until we get an interrupt signal.
   while (_pParentOp->state() != PiiOperation::Interrupted)
     {